@@ -11,8 +11,10 @@
 #include <QDir>
 #include <QColorDialog>
 #include <QDateTime>
+#include <QEventLoop>
 #include <string>
 #include <array>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include "iconutils.h"
@@ -28,6 +30,7 @@
 #include "srwidget.h"
 #include "loaddicom_t.h"
 #include "loaddicom.h"
+#include "slicecache.h"
 #include <mdcmReader.h>
 #include <mdcmFile.h>
 #include <mdcmDataSet.h>
@@ -82,6 +85,59 @@ struct ClosestRayResultCallback1 : public btCollisionWorld::ClosestRayResultCall
 	}
 };
 
+// LoadDicom or LoadDicom_T
+template<typename T> void append_loaded_series(
+	const T * lt,
+	const QStringList & filenames,
+	QString & message,
+	std::vector<ImageVariant*> & ivariants,
+	QStringList & pdf_files,
+	QStringList & stl_files,
+	QStringList & video_files,
+	QStringList & spectroscopy_files,
+	QStringList & sr_files)
+{
+	const QString & message_ = lt->message;
+	if (!message_.isEmpty())
+	{
+		const int filenames_size = filenames.size();
+		if (!message.isEmpty()) message.append(QChar('\n'));
+		if (filenames_size == 1)
+		{
+			message.append(filenames.at(0) + QString(":\n    "));
+		}
+		else if (filenames_size >= 1)
+		{
+			message.append(filenames.at(0) + QString(" (1st file):\n    "));
+		}
+		message.append(message_ + QString("\n\n"));
+	}
+	for (size_t k = 0; k < lt->ivariants.size(); ++k)
+	{
+		ivariants.push_back(lt->ivariants[k]);
+	}
+	for (int k = 0; k < lt->pdf_files.size(); ++k)
+	{
+		pdf_files.push_back(lt->pdf_files.at(k));
+	}
+	for (int k = 0; k < lt->stl_files.size(); ++k)
+	{
+		stl_files.push_back(lt->stl_files.at(k));
+	}
+	for (int k = 0; k < lt->video_files.size(); ++k)
+	{
+		video_files.push_back(lt->video_files.at(k));
+	}
+	for (int k = 0; k < lt->spectroscopy_files.size(); ++k)
+	{
+		spectroscopy_files.push_back(lt->spectroscopy_files.at(k));
+	}
+	for (int k = 0; k < lt->sr_files.size(); ++k)
+	{
+		sr_files.push_back(lt->sr_files.at(k));
+	}
+}
+
 void search_frame_of_ref(
 	const int id,
 	const QString & frame_uid,
@@ -703,6 +759,7 @@ void Aliza::close_()
 		}
 		scene3dimages.clear();
 	}
+	SliceCache::clear();
 	if (ok3d) glwidget->close_();
 	g_close_physics();
 }
@@ -719,7 +776,7 @@ QString Aliza::load_dicom_series(QProgressDialog * pb)
 	QStringList spectroscopy_files;
 	QStringList sr_files;
 	std::vector<int> rows;
-	QStringList filenames;
+	std::vector<QStringList> series;
 	const bool ok3d = check_3d();
 	if (ok3d)
 	{
@@ -727,7 +784,7 @@ QString Aliza::load_dicom_series(QProgressDialog * pb)
 	}
 	const bool dcm_thread = settingswidget->get_dcm_thread();
 	const QModelIndexList selection =
-		browser2->tableWidget->selectionModel()->selectedRows();
+		browser2->tableView->selectionModel()->selectedRows();
 	for (int x = 0; x < selection.count(); ++x)
 	{
 		const QModelIndex index = selection.at(x);
@@ -743,122 +800,104 @@ QString Aliza::load_dicom_series(QProgressDialog * pb)
 	{
 		const int row = rows.at(x);
 		if (row < 0) continue;
-		const TableWidgetItem * item =
-			static_cast<TableWidgetItem *>(browser2->tableWidget->item(row, 0));
-		if (!item) continue;
-		if ((item->files.empty())) continue;
-		filenames = item->files;
-		if (dcm_thread)
-		{
-			LoadDicom_T * lt = new LoadDicom_T(
-				root,
-				filenames,
-				ok3d,
-				static_cast<const QWidget * const>(
-					const_cast<const SettingsWidget * const>(settingswidget)),
-				0,
-				settingswidget->get_enh_strategy());
-			lt->start();
-			while (!lt->isFinished())
-			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				qApp->processEvents();
-			}
-			const QString message_ = lt->message;
-			if (!message_.isEmpty())
-			{
-				const int filenames_size = filenames.size();
-				if (!message.isEmpty()) message.append(QChar('\n'));
-				if (filenames_size == 1)
-				{
-					message.append(filenames.at(0) + QString(":\n    "));
-				}
-				else if (filenames_size >= 1)
-				{
-					message.append(filenames.at(0) + QString(" (1st file):\n    "));
-				}
-				message.append(message_ + QString("\n\n"));
-			}
-			for (size_t k = 0; k < lt->ivariants.size(); ++k)
-			{
-				ivariants.push_back(lt->ivariants[k]);
-			}
-			for (int k = 0; k < lt->pdf_files.size(); ++k)
-			{
-				pdf_files.push_back(lt->pdf_files.at(k));
-			}
-			for (int k = 0; k < lt->stl_files.size(); ++k)
+		const QStringList files = browser2->get_files(row);
+		if (files.empty()) continue;
+		series.push_back(files);
+	}
+	const QWidget * const wsettings =
+		static_cast<const QWidget * const>(
+			const_cast<const SettingsWidget * const>(settingswidget));
+	const short enh_strategy = settingswidget->get_enh_strategy();
+	if (dcm_thread)
+	{
+		// Series are loaded concurrently, not more than 'max_threads'
+		// at a time, files of series are decoded in one pool shared
+		// by read_series(). Results are merged in the order of the rows,
+		// as soon as all series before are finished. The event loop
+		// runs until a thread has finished.
+		const size_t series_size = series.size();
+		const int max_threads =
+			std::max(1, std::min(QThread::idealThreadCount(), 4));
+		DicomUtils::begin_concurrent_loads(
+			static_cast<int>(std::min(series_size, static_cast<size_t>(max_threads))));
+		std::vector<LoadDicom_T*> threads(series_size, nullptr);
+		QEventLoop loop;
+		size_t next{};
+		size_t merged{};
+		while (merged < series_size)
+		{
+			size_t finished{merged};
+			int running{};
+			for (size_t x = merged; x < next; ++x)
 			{
-				stl_files.push_back(lt->stl_files.at(k));
+				if (threads.at(x)->loaded.load()) ++finished;
+				else ++running;
 			}
-			for (int k = 0; k < lt->video_files.size(); ++k)
+			while (running < max_threads && next < series_size)
 			{
-				video_files.push_back(lt->video_files.at(k));
+				threads[next] = new LoadDicom_T(
+					root,
+					series.at(next),
+					ok3d,
+					wsettings,
+					0,
+					enh_strategy);
+				connect(threads[next], SIGNAL(finished()), &loop, SLOT(quit()));
+				threads[next]->start();
+				++running;
+				++next;
 			}
-			for (int k = 0; k < lt->spectroscopy_files.size(); ++k)
+			while (merged < next && threads.at(merged)->loaded.load())
 			{
-				spectroscopy_files.push_back(lt->spectroscopy_files.at(k));
+				threads.at(merged)->wait();
+				append_loaded_series(
+					threads.at(merged),
+					series.at(merged),
+					message,
+					ivariants,
+					pdf_files,
+					stl_files,
+					video_files,
+					spectroscopy_files,
+					sr_files);
+				delete threads[merged];
+				threads[merged] = nullptr;
+				++merged;
 			}
-			for (int k = 0; k < lt->sr_files.size(); ++k)
+			if (pb && series_size > 1)
 			{
-				sr_files.push_back(lt->sr_files.at(k));
+				pb->setLabelText(
+					QString("Loading ... ") +
+					QString::number(finished) +
+					QString("/") +
+					QString::number(series_size));
 			}
-#if 0
-			lt->quit();
-			lt->wait();
-#endif
-			delete lt;
+			if (merged < series_size) loop.exec();
 		}
-		else
+		DicomUtils::end_concurrent_loads();
+	}
+	else
+	{
+		for (size_t x = 0; x < series.size(); ++x)
 		{
 			LoadDicom * lt = new LoadDicom(
 				root,
-				filenames,
+				series.at(x),
 				ok3d,
-				static_cast<const QWidget * const>(
-					const_cast<const SettingsWidget * const>(settingswidget)),
+				wsettings,
 				0,
-				settingswidget->get_enh_strategy());
+				enh_strategy);
 			lt->run();
-			const QString message_ = lt->message;
-			if (!message_.isEmpty())
-			{
-				const int filenames_size = filenames.size();
-				if (!message.isEmpty()) message.append(QChar('\n'));
-				if (filenames_size == 1)
-				{
-					message.append(filenames.at(0) + QString(":\n    "));
-				}
-				else if (filenames_size >= 1)
-				{
-					message.append(filenames.at(0) + QString(" (1st file):\n    "));
-				}
-				message.append(message_ + QString("\n\n"));
-			}
-			for (size_t k = 0; k < lt->ivariants.size(); ++k)
-			{
-				ivariants.push_back(lt->ivariants[k]);
-			}
-			for (int k = 0; k < lt->pdf_files.size(); ++k)
-			{
-				pdf_files.push_back(lt->pdf_files.at(k));
-			}
-			for (int k = 0; k < lt->stl_files.size(); ++k)
-			{
-				stl_files.push_back(lt->stl_files.at(k));
-			}
-			for (int k = 0; k < lt->video_files.size(); ++k)
-			{
-				video_files.push_back(lt->video_files.at(k));
-			}
-			for (int k = 0; k < lt->spectroscopy_files.size(); ++k)
-			{
-				spectroscopy_files.push_back(lt->spectroscopy_files.at(k));
-			}
-			for (int k = 0; k < lt->sr_files.size(); ++k)
-			{
-				sr_files.push_back(lt->sr_files.at(k));
-			}
+			append_loaded_series(
+				lt,
+				series.at(x),
+				message,
+				ivariants,
+				pdf_files,
+				stl_files,
+				video_files,
+				spectroscopy_files,
+				sr_files);
 			delete lt;
 		}
 	}
@@ -996,6 +1035,7 @@ void Aliza::delete_image()
 	imagesbox->listWidget->reset();
 	remove_from_studyview(ivariant->id);
 	scene3dimages.remove(ivariant->id);
+	SliceCache::remove(ivariant->id);
 	delete ivariant;
 	ivariant = nullptr;
 	update_selection();
@@ -4021,6 +4061,7 @@ void Aliza::delete_checked_unchecked(bool t)
 		{
 			remove_from_studyview(ivariant->id);
 			scene3dimages.remove(ivariant->id);
+			SliceCache::remove(ivariant->id);
 			delete ivariant;
 		}
 	}
@@ -4088,6 +4129,7 @@ void Aliza::delete_group(const int group_id)
 		{
 			remove_from_studyview(ivariant->id);
 			scene3dimages.remove(ivariant->id);
+			SliceCache::remove(ivariant->id);
 			delete ivariant;
 			ivariant = nullptr;
 		}
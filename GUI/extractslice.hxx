@@ -0,0 +1,164 @@
+#ifndef A_EXTRACTSLICE_H
+#define A_EXTRACTSLICE_H
+
+// clang-format off
+
+#include <QString>
+#include <itkImage.h>
+#include <itkImportImageContainer.h>
+#include <algorithm>
+#include <type_traits>
+
+// Pixel container pointing into the buffer of a 3D image,
+// keeps the 3D image alive, never frees the memory.
+template<typename TElement> class SliceViewContainer
+	: public itk::ImportImageContainer<itk::SizeValueType, TElement>
+{
+public:
+	typedef SliceViewContainer Self;
+	typedef itk::ImportImageContainer<itk::SizeValueType, TElement> Superclass;
+	typedef itk::SmartPointer<Self> Pointer;
+	typedef itk::SmartPointer<const Self> ConstPointer;
+	itkNewMacro(Self);
+	void SetSource(const itk::DataObject * s)
+	{
+		source = s;
+	}
+
+protected:
+	SliceViewContainer() = default;
+	~SliceViewContainer() override = default;
+
+private:
+	itk::DataObject::ConstPointer source;
+};
+
+// Same output as itk::ExtractImageFilter with collapsed 'axis'
+// and SetDirectionCollapseToIdentity(), without the pipeline.
+// Axis 2 of scalar images is a non-owning view into the 3D buffer,
+// (not for RGB/RGBA, QImages are painted directly in their buffers),
+// axes 0 and 1 are gathered row by row.
+template<typename Tin, typename Tout> QString extract_slice(
+	const short axis,
+	const typename Tin::Pointer & image,
+	typename Tout::Pointer & out_image,
+	const int idx)
+{
+	typedef typename Tin::PixelType PixelType;
+	if (image.IsNull())
+	{
+		return QString("extract_slice<>() : image.IsNull()");
+	}
+	if (axis < 0 || axis > 2)
+	{
+		return QString("internal error: axis not set");
+	}
+	const typename Tin::RegionType & region = image->GetBufferedRegion();
+	if (region != image->GetLargestPossibleRegion())
+	{
+		return QString("extract_slice<>() : image is not buffered");
+	}
+	PixelType * buffer = image->GetBufferPointer();
+	if (!buffer)
+	{
+		return QString("extract_slice<>() : buffer is null");
+	}
+	const typename Tin::SizeType size = region.GetSize();
+	const typename Tin::IndexType index = region.GetIndex();
+	const long long slice = static_cast<long long>(idx) - index[axis];
+	if (slice < 0 || slice >= static_cast<long long>(size[axis]))
+	{
+		return QString("extract_slice<>() : index is outside of the image");
+	}
+	const typename Tin::SpacingType & in_spacing = image->GetSpacing();
+	const typename Tin::PointType & in_origin = image->GetOrigin();
+	typename Tout::SizeType out_size;
+	typename Tout::IndexType out_index;
+	typename Tout::SpacingType out_spacing;
+	typename Tout::PointType out_origin;
+	typename Tout::DirectionType out_direction;
+	out_direction.SetIdentity();
+	unsigned int k{};
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		if (static_cast<short>(i) == axis) continue;
+		out_size[k] = size[i];
+		out_index[k] = index[i];
+		out_spacing[k] = in_spacing[i];
+		out_origin[k] = in_origin[i];
+		++k;
+	}
+	const size_t size_x = size[0];
+	const size_t size_y = size[1];
+	const size_t size_z = size[2];
+	try
+	{
+		out_image = Tout::New();
+		out_image->SetRegions(typename Tout::RegionType(out_index, out_size));
+		out_image->SetSpacing(out_spacing);
+		out_image->SetOrigin(out_origin);
+		out_image->SetDirection(out_direction);
+		if (axis == 2 && std::is_arithmetic<PixelType>::value)
+		{
+			typename SliceViewContainer<PixelType>::Pointer container =
+				SliceViewContainer<PixelType>::New();
+			container->SetImportPointer(
+				buffer + slice * size_x * size_y, size_x * size_y, false);
+			container->SetSource(image.GetPointer());
+			out_image->SetPixelContainer(container);
+			return QString();
+		}
+		out_image->Allocate();
+	}
+	catch (const itk::ExceptionObject & ex)
+	{
+		out_image = nullptr;
+		return QString(ex.GetDescription());
+	}
+	catch (const std::bad_alloc&)
+	{
+		out_image = nullptr;
+		return QString("std::bad_alloc exception");
+	}
+	PixelType * out = out_image->GetBufferPointer();
+	switch (axis)
+	{
+	case 0:
+		{
+			// One pixel per source row, rows of a z plane are visited in order.
+			const PixelType * in = buffer + slice;
+			for (size_t z = 0; z < size_z; ++z)
+			{
+				for (size_t y = 0; y < size_y; ++y)
+				{
+					*out++ = *in;
+					in += size_x;
+				}
+			}
+		}
+		break;
+	case 1:
+		{
+			const PixelType * in = buffer + slice * size_x;
+			for (size_t z = 0; z < size_z; ++z)
+			{
+				std::copy(in, in + size_x, out);
+				out += size_x;
+				in += size_x * size_y;
+			}
+		}
+		break;
+	case 2:
+		{
+			const PixelType * in = buffer + slice * size_x * size_y;
+			std::copy(in, in + size_x * size_y, out);
+		}
+		break;
+	default:
+		break;
+	}
+	return QString();
+}
+
+#endif
+
@@ -17,9 +17,10 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QScrollBar>
-#include <itkExtractImageFilter.h>
 #include <itkImageRegionConstIterator.h>
 #include "processimagethreadLUT.hxx"
+#include "extractslice.hxx"
+#include "slicecache.h"
 #include "graphicsutils.h"
 #include "commonutils.h"
 #include "contourutils.h"
@@ -27,7 +28,6 @@
 #include "updateqtcommand.h"
 #include <climits>
 #include <chrono>
-#include <thread>
 
 //#define A_TMP_BENCHMARK
 
@@ -189,70 +189,162 @@ void draw_contours(
 	}
 }
 
-template<typename Tin, typename Tout> QString get_slice_(
-	short axis,
-	const typename Tin::Pointer & image,
-	ImageVariant2D * v2d,
-	typename Tout::Pointer & out_image,
-	int idx)
+unsigned long long get_image_mtime(const ImageVariant * v)
 {
-	if (image.IsNull())
+	const itk::Object * o{};
+	switch (v->image_type)
 	{
-		return QString("get_slice_<>() : image.IsNull()");
+	case 0: o = v->pSS.GetPointer();
+		break;
+	case 1: o = v->pUS.GetPointer();
+		break;
+	case 2: o = v->pSI.GetPointer();
+		break;
+	case 3: o = v->pUI.GetPointer();
+		break;
+	case 4: o = v->pUC.GetPointer();
+		break;
+	case 5: o = v->pF.GetPointer();
+		break;
+	case 6: o = v->pD.GetPointer();
+		break;
+	case 7: o = v->pSLL.GetPointer();
+		break;
+	case 8: o = v->pULL.GetPointer();
+		break;
+	default:
+		break;
 	}
-	typedef itk::ExtractImageFilter<Tin, Tout> FilterType;
-	const typename Tin::RegionType inRegion =
-		image->GetLargestPossibleRegion();
-	const typename Tin::SizeType size = inRegion.GetSize();
-	typename Tin::IndexType index     = inRegion.GetIndex();
-	typename Tin::RegionType outRegion;
-	typename Tin::SizeType out_size;
-	typename FilterType::Pointer filter = FilterType::New();
-	switch (axis)
+	return o ? static_cast<unsigned long long>(o->GetMTime()) : 0;
+}
+
+// Window, LUT and image for the slice, exactly what load_image() uses.
+SliceCacheKey get_slice_cache_key(
+	const ImageVariant * ivariant,
+	const short axis,
+	const int slice,
+	const bool alt_mode,
+	const bool per_frame_level_found)
+{
+	SliceCacheKey key;
+	key.id = ivariant->id;
+	key.axis = axis;
+	key.slice = slice;
+	key.lut = ivariant->di->selected_lut;
+	key.alt_mode = alt_mode;
+	key.rmin = ivariant->di->rmin;
+	key.rmax = ivariant->di->rmax;
+	key.mtime = get_image_mtime(ivariant);
+	if (axis == 2 && ivariant->di->lock_level2D)
 	{
-	case 0:
+		if (per_frame_level_found || ivariant->frame_levels.contains(slice))
 		{
-			index[0] = idx;
-			out_size[0] = 0;
-			out_size[1] = size[1];
-			out_size[2] = size[2];
+			const FrameLevel & fl = ivariant->frame_levels.value(slice);
+			key.window_center = fl.us_window_center;
+			key.window_width = fl.us_window_width;
+			key.lut_function = fl.lut_function;
 		}
-		break;
-	case 1:
-		{
-			index[1] = idx;
-			out_size[0] = size[0];
-			out_size[1] = 0;
-			out_size[2] = size[2];
-		}
-		break;
-	case 2:
+		else
 		{
-			index[2] = idx;
-			out_size[0] = size[0];
-			out_size[1] = size[1];
-			out_size[2] = 0;
+			key.window_center = ivariant->di->default_us_window_center;
+			key.window_width = ivariant->di->default_us_window_width;
+			key.lut_function = ivariant->di->default_lut_function;
 		}
-		break;
-	default :
-		return QString("internal error: axis not set");
 	}
-	outRegion.SetSize(out_size);
-	outRegion.SetIndex(index);
+	else
+	{
+		key.window_center = ivariant->di->us_window_center;
+		key.window_width = ivariant->di->us_window_width;
+		key.lut_function = ivariant->di->lut_function;
+	}
+	return key;
+}
+
+template<typename T> QImage render_slice(
+	const typename T::Pointer & image,
+	const SliceCacheKey & key)
+{
+	const typename T::SizeType size = image->GetLargestPossibleRegion().GetSize();
+	const unsigned int p_size = 3 * size[0] * size[1];
+	unsigned char * p;
 	try
 	{
-		filter->SetInput(image);
-		filter->SetExtractionRegion(outRegion);
-		filter->SetDirectionCollapseToIdentity();
-		filter->Update();
+		p = new unsigned char[p_size];
+	}
+	catch (const std::bad_alloc&)
+	{
+		return QImage();
+	}
+	process_image_LUT<T>(
+		image,
+		p,
+		size[0], size[1],
+		key.window_center, key.window_width,
+		key.lut, key.alt_mode, key.lut_function,
+		key.rmin, key.rmax);
+#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
+	return QImage(p, size[0], size[1], 3 * size[0], QImage::Format_RGB888, gImageCleanupHandler, p);
+#else
+	// no cleanup function in Qt4, the copy owns its buffer
+	const QImage tmpi = QImage(p, size[0], size[1], 3 * size[0], QImage::Format_RGB888).copy();
+	delete [] p;
+	return tmpi;
+#endif
+}
+
+// Renders a slice into SliceCache, the smart pointer
+// keeps the 3D image alive if it is closed meanwhile.
+template<typename Tin, typename Tout> class PrefetchSlice_ : public QRunnable
+{
+public:
+	PrefetchSlice_(
+		const typename Tin::Pointer & image_,
+		const SliceCacheKey & key_)
+		:
+		image(image_),
+		key(key_)
+	{
 	}
-	catch (const itk::ExceptionObject & ex)
+
+	void run() override
 	{
-		return QString(ex.GetDescription());
+		QImage tmpi;
+		typename Tout::Pointer slice;
+		const QString error = extract_slice<Tin, Tout>(key.axis, image, slice, key.slice);
+		if (error.isEmpty() && slice.IsNotNull())
+		{
+			tmpi = render_slice<Tout>(slice, key);
+		}
+		SliceCache::end_prefetch(key, tmpi);
 	}
-	out_image = filter->GetOutput();
-	if (out_image.IsNotNull()) out_image->DisconnectPipeline();
-	else return QString("Out image is null");
+
+private:
+	const typename Tin::Pointer image;
+	const SliceCacheKey key;
+};
+
+template<typename Tin, typename Tout> void start_prefetch(
+	const typename Tin::Pointer & image,
+	const SliceCacheKey & key)
+{
+	if (image.IsNull())
+	{
+		SliceCache::end_prefetch(key, QImage());
+		return;
+	}
+	RenderPool::prefetch_instance()->start(new PrefetchSlice_<Tin, Tout>(image, key));
+}
+
+template<typename Tin, typename Tout> QString get_slice_(
+	short axis,
+	const typename Tin::Pointer & image,
+	ImageVariant2D * v2d,
+	typename Tout::Pointer & out_image,
+	int idx)
+{
+	const QString error = extract_slice<Tin, Tout>(axis, image, out_image, idx);
+	if (!error.isEmpty()) return error;
+	if (out_image.IsNull()) return QString("Out image is null");
 	if (v2d)
 	{
 		v2d->idimx = out_image->GetLargestPossibleRegion().GetSize()[0];
@@ -1239,162 +1331,40 @@ template<typename T> void load_image(
 	const typename T::SpacingType spacing = image->GetSpacing();
 	const typename T::RegionType region   = image->GetLargestPossibleRegion();
 	const typename T::SizeType size       = region.GetSize();
-	const short lut = ivariant->di->selected_lut;
 	const bool alt_mode = widget->get_alt_mode();
 	//
-	const unsigned int p_size = 3 * size[0] * size[1];
-	unsigned char * p;
-	try
-	{
-		p = new unsigned char[p_size];
-	}
-	catch (const std::bad_alloc&)
-	{
-		return;
-	}
-	//
 	const short axis = widget->get_axis();
-	double window_center, window_width;
-	short lut_function;
-	if (axis == 2)
-	{
-		if (ivariant->di->lock_level2D)
-		{
-			if (per_frame_level_found ||
-				ivariant->frame_levels.contains(ivariant->di->selected_z_slice))
-			{
-				const FrameLevel & fl =
-					ivariant->frame_levels.value(ivariant->di->selected_z_slice);
-				window_center = fl.us_window_center;
-				window_width = fl.us_window_width;
-				lut_function = fl.lut_function;
-			}
-			else
-			{
-				window_center = ivariant->di->default_us_window_center;
-				window_width = ivariant->di->default_us_window_width;
-				lut_function = ivariant->di->default_lut_function;
-			}
-		}
-		else
-		{
-			window_center = ivariant->di->us_window_center;
-			window_width = ivariant->di->us_window_width;
-			lut_function = ivariant->di->lut_function;
-		}
-	}
-	else
+	int slice;
+	switch (axis)
 	{
-		window_center = ivariant->di->us_window_center;
-		window_width = ivariant->di->us_window_width;
-		lut_function = ivariant->di->lut_function;
+	case 0: slice = ivariant->di->selected_x_slice;
+		break;
+	case 1: slice = ivariant->di->selected_y_slice;
+		break;
+	default: slice = ivariant->di->selected_z_slice;
+		break;
 	}
+	const SliceCacheKey key =
+		get_slice_cache_key(ivariant, axis, slice, alt_mode, per_frame_level_found);
 	//
 	const bool global_flip_x = widget->graphicsview->global_flip_x;
 	const bool global_flip_y = widget->graphicsview->global_flip_y;
-	const int num_threads = QThread::idealThreadCount();
-	const int tmp99 = size[1] % num_threads;
-	std::vector<QThread*> threadsLUT_;
 #ifdef A_TMP_BENCHMARK
-#if 0
-	std::cout << num_threads << " threads" << std::endl;
-#endif
 	const auto start2{ now() };
 #endif
-	if (tmp99 == 0)
-	{
-		unsigned int j = 0;
-		for (int i = 0; i < num_threads; ++i)
-		{
-			const int size_0 = size[0];
-			const int size_1 = size[1] / num_threads;
-			const int index_0 = 0;
-			const int index_1 = i * size_1;
-			ProcessImageThreadLUT_<T> * t__ = new ProcessImageThreadLUT_<T>(
-						image,
-						p,
-						size_0,  size_1,
-						index_0, index_1, j,
-						window_center, window_width,
-						lut, alt_mode,lut_function);
-			j += 3 * size_0 * size_1;
-			threadsLUT_.push_back(static_cast<QThread*>(t__));
-			t__->start();
-		}
-	}
-	else
-	{
-		unsigned int j = 0;
-		unsigned int block = 64;
-		if (static_cast<float>(size[1]) / static_cast<float>(block) > 16.0f)
-		{
-			block = 128;
-		}
-		const int tmp100 = size[1] % block;
-		const int incr = static_cast<int>(floor(size[1] / static_cast<double>(block)));
-		if (size[1] > block)
-		{
-			for (int i = 0; i < incr; ++i)
-			{
-				const int size_0 = size[0];
-				const int index_0 = 0;
-				const int index_1 = i * block;
-				ProcessImageThreadLUT_<T> * t__ = new ProcessImageThreadLUT_<T>(
-							image,
-							p,
-							size_0, block,
-							index_0, index_1, j,
-							window_center, window_width,
-							lut, alt_mode,lut_function);
-				j += 3 * size_0 * block;
-				threadsLUT_.push_back(static_cast<QThread*>(t__));
-				t__->start();
-			}
-			ProcessImageThreadLUT_<T> * lt__ = new ProcessImageThreadLUT_<T>(
-						image,
-						p,
-						size[0], tmp100,
-						0, incr * block, j,
-						window_center, window_width,
-						lut, alt_mode,lut_function);
-			threadsLUT_.push_back(static_cast<QThread*>(lt__));
-			lt__->start();
-		}
-		else
-		{
-			ProcessImageThreadLUT_<T> * lt__ = new ProcessImageThreadLUT_<T>(
-						image,
-						p,
-						size[0], size[1],
-						0, 0, 0,
-						window_center, window_width,
-						lut, alt_mode,lut_function);
-			threadsLUT_.push_back(static_cast<QThread*>(lt__));
-			lt__->start();
-		}
-	}
-	//
-	const size_t threadsLUT_size = threadsLUT_.size();
-	while (true)
+	QImage tmpi;
+	if (!(SliceCache::find(key, tmpi) &&
+		tmpi.width() == static_cast<int>(size[0]) &&
+		tmpi.height() == static_cast<int>(size[1])))
 	{
-		std::this_thread::sleep_for(std::chrono::milliseconds(2));
-		size_t b__ = 0;
-		for (size_t i = 0; i < threadsLUT_size; ++i)
-		{
-			if (threadsLUT_.at(i)->isFinished()) ++b__;
-		}
-		if (b__ == threadsLUT_size) break;
+		tmpi = render_slice<T>(image, key);
+		if (tmpi.isNull()) return;
+		SliceCache::insert(key, tmpi);
 	}
 #ifdef A_TMP_BENCHMARK
 	const std::chrono::duration<double, std::milli> elapsed2{ now() - start2 };
 	std::cout << "spent for image " << elapsed2.count() << " ms, w_times = " << w_times << std::endl;
 #endif
-	for (size_t i = 0; i < threadsLUT_size; ++i)
-	{
-		delete threadsLUT_[i];
-		threadsLUT_[i] = nullptr;
-	}
-	threadsLUT_.clear();
 	//
 	double coeff_size_0 = 1.0, coeff_size_1 = 1.0;
 	const QRectF rectf(0, 0, size[0], size[1]);
@@ -1428,12 +1398,7 @@ template<typename T> void load_image(
 	widget->graphicsview->image_item->setZValue(-1.0);
 	widget->graphicsview->scene()->addItem(widget->graphicsview->image_item);
 #endif
-#if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
-	QImage tmpi(p, size[0], size[1], 3 * size[0], QImage::Format_RGB888, gImageCleanupHandler, p);
-#else
-	QImage tmpi(p, size[0], size[1], 3 * size[0], QImage::Format_RGB888);
-#endif
-	//
+	// overlays are drawn into a detached copy, the cached image is not changed
 	if (axis == 2)
 	{
 		if (widget->get_enable_overlays())
@@ -1490,15 +1455,6 @@ template<typename T> void load_image(
 	widget->graphicsview->draw_prtexts(ivariant);
 	//
 	widget->graphicsview->setTransform(t);
-	//
-#if QT_VERSION < QT_VERSION_CHECK(5,0,0)
-	tmpi = QImage();
-	if (p)
-	{
-		delete [] p;
-		p = nullptr;
-	}
-#endif
 #ifdef A_TMP_BENCHMARK
 	const std::chrono::duration<double, std::milli> elapsed1{ now() - start1 };
 	std::cout << "spent total " << elapsed1.count() << " ms" << std::endl;
@@ -2476,6 +2432,7 @@ void GraphicsWidget::set_slice_2D(
 		break;
 	}
 	update_image(fit, true, per_frame_level_found);
+	prefetch_slices(v, x);
 	//
 	if (alw_usregs) graphicsview->draw_us_regions();
 	graphicsview->update_selection_rect_width();
@@ -2651,6 +2608,74 @@ void GraphicsWidget::animate_()
 	}
 }
 
+// Renders next slices in the direction of animation or scrolling
+// in background, animation restarts from the first slice.
+void GraphicsWidget::prefetch_slices(const ImageVariant * v, const int x)
+{
+	if (!v) return;
+	int step{};
+	if (run__)
+	{
+		step = 1;
+	}
+	else if (v->id == prefetch_id && axis == prefetch_axis && x != prefetch_slice)
+	{
+		step = (x > prefetch_slice) ? 1 : -1;
+	}
+	prefetch_id = v->id;
+	prefetch_axis = axis;
+	prefetch_slice = x;
+	if (step == 0) return;
+	if (v->image_type < 0 || v->image_type > 8) return;
+	if (SliceCache::get_max_size() <= 0) return;
+	int dim;
+	switch (axis)
+	{
+	case 0: dim = v->di->idimx;
+		break;
+	case 1: dim = v->di->idimy;
+		break;
+	case 2: dim = v->di->idimz;
+		break;
+	default:
+		return;
+	}
+	if (dim < 2) return;
+	const int count = qMin(8, dim - 1);
+	for (int i = 1; i <= count; ++i)
+	{
+		int k = x + i * step;
+		if (run__) k %= dim;
+		else if (k < 0 || k >= dim) break;
+		const SliceCacheKey key = get_slice_cache_key(v, axis, k, alt_mode, false);
+		if (!SliceCache::begin_prefetch(key)) continue;
+		switch (v->image_type)
+		{
+		case 0: start_prefetch<ImageTypeSS, Image2DTypeSS>(v->pSS, key);
+			break;
+		case 1: start_prefetch<ImageTypeUS, Image2DTypeUS>(v->pUS, key);
+			break;
+		case 2: start_prefetch<ImageTypeSI, Image2DTypeSI>(v->pSI, key);
+			break;
+		case 3: start_prefetch<ImageTypeUI, Image2DTypeUI>(v->pUI, key);
+			break;
+		case 4: start_prefetch<ImageTypeUC, Image2DTypeUC>(v->pUC, key);
+			break;
+		case 5: start_prefetch<ImageTypeF, Image2DTypeF>(v->pF, key);
+			break;
+		case 6: start_prefetch<ImageTypeD, Image2DTypeD>(v->pD, key);
+			break;
+		case 7: start_prefetch<ImageTypeSLL, Image2DTypeSLL>(v->pSLL, key);
+			break;
+		case 8: start_prefetch<ImageTypeULL, Image2DTypeULL>(v->pULL, key);
+			break;
+		default:
+			SliceCache::end_prefetch(key, QImage());
+			break;
+		}
+	}
+}
+
 void GraphicsWidget::set_top_label_text(const QString & s)
 {
 	top_label->setText(s);
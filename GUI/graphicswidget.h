@@ -145,6 +145,10 @@ private:
 	QWidget * multi_frame_ptr;
 	bool alt_mode{};
 	bool show_cursor{};
+	int   prefetch_id{-1};
+	short prefetch_axis{-1};
+	int   prefetch_slice{-1};
+	void  prefetch_slices(const ImageVariant*, const int);
 };
 
 #endif
@@ -443,7 +443,7 @@ MainWindow::MainWindow(
 	slider_frame->hide();
 	//
 	connect(browser2->load_pushButton,SIGNAL(clicked()),this,SLOT(load_dicom_series2()));
-	connect(browser2->tableWidget,SIGNAL(itemDoubleClicked(QTableWidgetItem*)),this,SLOT(load_dicom_series2()));
+	connect(browser2->tableView,SIGNAL(doubleClicked(const QModelIndex&)),this,SLOT(load_dicom_series2()));
 	if (!hide_zoom)
 	{
 		if (zoomwidget2D)
@@ -1716,7 +1716,7 @@ void MainWindow::load_dicom_series2()
 	lock0 = true;
 	const bool dcm_thread = settingswidget->get_dcm_thread();
 	const bool selection =
-		browser2->tableWidget->selectionModel()->hasSelection();
+		browser2->tableView->selectionModel()->hasSelection();
 	if (!selection)
 	{
 		lock0 = false;
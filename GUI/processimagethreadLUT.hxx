@@ -3,52 +3,39 @@
 
 // clang-format off
 
-#include <QThread>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QMutex>
+#include <QMutexLocker>
 #include <itkImage.h>
 #include <itkImageRegionConstIterator.h>
+#include <cmath>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
 #include "luts.h"
+#include "renderpool.h"
+#include "windowlutsimd.h"
 
-template<typename T> class ProcessImageThreadLUT_ : public QThread
+// Window/level transfer function and color LUT,
+// maps one scalar value to RGB.
+class WindowLUT
 {
 public:
-	ProcessImageThreadLUT_(
-		const typename T::Pointer & image_,
-		unsigned char * p_,
-		const int size_0_, const int size_1_,
-		const int index_0_, const int index_1_,
-		const unsigned int j_,
+	WindowLUT(
 		const double window_center_, const double window_width_,
 		const short lut_,
 		const bool alt_mode_,
 		const short lut_function_)
 		:
-		image(image_),
-		p(p_),
-		size_0(size_0_), size_1(size_1_),
-		index_0(index_0_), index_1(index_1_),
-		j(j_),
-		window_center(window_center_), window_width(window_width_),
+		window_center(window_center_),
 		lut(lut_),
-		alt_mode(alt_mode_),
-		lut_function(lut_function_)
+		alt_mode(alt_mode_)
 	{
-	}
-
-	~ProcessImageThreadLUT_()
-	{
-	}
-
-	void run() override
-	{
-		typename T::SizeType size;
-		size[0] = size_0;
-		size[1] = size_1;
-		typename T::IndexType index;
-		index[0] = index_0;
-		index[1] = index_1;
-		const typename T::RegionType region(index, size);
-		const unsigned char * tmp_p1{};
-		int tmp__size{};
 		switch (lut)
 		{
 		case 0:
@@ -105,11 +92,8 @@ public:
 			return;
 		}
 		//
-		short tmp_lut_function;
-		double wmin, wmax, div_;
-		double window_center_minus_0_point_5{}; // used only for LINEAR
-		const double window_width_minus_one = window_width - 1.0;
-		if (lut_function == 1)
+		const double window_width_minus_one = window_width_ - 1.0;
+		if (lut_function_ == 1)
 		{
 			// DICOM LINEAR works with window_width >= 1,
 			// fallback to LINEAR_EXACT otherwise,
@@ -124,9 +108,9 @@ public:
 			}
 			else
 			{
-				wmin = window_center - window_width * 0.5;
-				wmax = window_center + window_width * 0.5;
-				div_ = (window_width > 0.0) ? window_width : 0.00001;
+				wmin = window_center - window_width_ * 0.5;
+				wmax = window_center + window_width_ * 0.5;
+				div_ = (window_width_ > 0.0) ? window_width_ : 0.00001;
 				tmp_lut_function = 0;
 #if 0
 				std::cout << "Warning: forced LUT function to LINEAR_EXACT" << std::endl;
@@ -135,158 +119,463 @@ public:
 		}
 		else
 		{
-			wmin = window_center - window_width * 0.5;
-			wmax = window_center + window_width * 0.5;
-			div_ = (window_width > 0.0) ? window_width : 0.00001;
-			tmp_lut_function = lut_function;
+			wmin = window_center - window_width_ * 0.5;
+			wmax = window_center + window_width_ * 0.5;
+			div_ = (window_width_ > 0.0) ? window_width_ : 0.00001;
+			tmp_lut_function = lut_function_;
 		}
-		//
-		typename itk::ImageRegionConstIterator<T> iterator(image, region);
-		iterator.GoToBegin();
-		while (!iterator.IsAtEnd())
+		valid = true;
+	}
+
+	bool is_valid() const
+	{
+		return valid;
+	}
+
+	// Parameters for WindowLUTSIMD, only linear functions,
+	// colors: LUT entries, then low and high colors.
+	bool get_simd_params(
+		WindowLUTSIMDParams & params,
+		std::vector<unsigned char> & colors) const
+	{
+		if (!valid) return false;
+		if (tmp_lut_function != 0 && tmp_lut_function != 1) return false;
+		const int n = (lut == 0) ? (UCHAR_MAX + 1) : tmp__size;
+		try
 		{
-			const double v = iterator.Get();
-			if (v > wmin && v <= wmax)
+			colors.resize(3 * (n + 2));
+		}
+		catch (const std::bad_alloc&)
+		{
+			return false;
+		}
+		if (lut == 0)
+		{
+			for (int x = 0; x < n; ++x)
 			{
-				double r;
-				if (tmp_lut_function == 2) // SIGMOID
-				{
-					const double x = -4.0 * ((v - window_center) / div_);
-					r = 1.0 / (1.0 + exp(x));
-				}
-				else if (tmp_lut_function == 1) // LINEAR
+				const unsigned char c = static_cast<unsigned char>(x);
+				colors[3 * x]     = c;
+				colors[3 * x + 1] = c;
+				colors[3 * x + 2] = c;
+			}
+		}
+		else
+		{
+			memcpy(colors.data(), tmp_p1, 3 * n);
+		}
+		unsigned char * low  = &colors[3 * n];
+		unsigned char * high = &colors[3 * (n + 1)];
+		if (lut == 0)
+		{
+			memset(low, 0, 3);
+			memset(high, alt_mode ? 0 : UCHAR_MAX, 3);
+		}
+		else
+		{
+			memcpy(low, tmp_p1, 3);
+			memcpy(high, alt_mode ? tmp_p1 : &tmp_p1[3 * (tmp__size - 1)], 3);
+		}
+		params.wmin = wmin;
+		params.wmax = wmax;
+		params.sub = (tmp_lut_function == 1) ? window_center_minus_0_point_5 : window_center;
+		params.div = div_;
+		params.scale = (lut == 0) ? static_cast<double>(UCHAR_MAX) : static_cast<double>(tmp__size);
+		params.index_max = n - 1;
+		params.low = n;
+		params.high = n + 1;
+		params.labels = (lut == 8);
+		params.colors = colors.data();
+		return true;
+	}
+
+	void apply(const double v, unsigned char * p) const
+	{
+		if (v > wmin && v <= wmax)
+		{
+			double r;
+			if (tmp_lut_function == 2) // SIGMOID
+			{
+				const double x = -4.0 * ((v - window_center) / div_);
+				r = 1.0 / (1.0 + exp(x));
+			}
+			else if (tmp_lut_function == 1) // LINEAR
+			{
+				// if (x <= c - 0.5 - (w - 1) / 2), then y = ymin
+				// else if (x > c - 0.5 + (w - 1) / 2), then y = ymax
+				// else y = ((x - (c - 0.5)) / (w - 1) + 0.5) * (ymax - ymin) + ymin
+				r = (v - window_center_minus_0_point_5) / div_ + 0.5;
+			}
+			else // LINEAR_EXACT
+			{
+				// if (x <= c - w / 2), then y = ymin
+				// else if (x > c + w / 2), then y = ymax
+				// else y = ((x - c) / w + 0.5) * (ymax - ymin) + ymin
+				r = ((v - window_center) / div_) + 0.5;
+			}
+			switch (lut)
+			{
+			case 0:
 				{
-					// if (x <= c - 0.5 - (w - 1) / 2), then y = ymin
-					// else if (x > c - 0.5 + (w - 1) / 2), then y = ymax
-					// else y = ((x - (c - 0.5)) / (w - 1) + 0.5) * (ymax - ymin) + ymin
-					r = (v - window_center_minus_0_point_5) / div_ + 0.5;
+					const unsigned char c = static_cast<unsigned char>(UCHAR_MAX * r);
+					p[0] = c;
+					p[1] = c;
+					p[2] = c;
 				}
-				else // LINEAR_EXACT
+				break;
+			case 1:
+			case 2:
+			case 3:
+			case 4:
+			case 5:
+			case 6:
+			case 7:
 				{
-					// if (x <= c - w / 2), then y = ymin
-					// else if (x > c + w / 2), then y = ymax
-					// else y = ((x - c) / w + 0.5) * (ymax - ymin) + ymin
-					r = ((v - window_center) / div_) + 0.5;
+					int z = static_cast<int>(r * tmp__size);
+					if (z < 0) z = 0;
+					if (z > (tmp__size - 1)) z = tmp__size - 1;
+					p[0] = tmp_p1[z * 3];
+					p[1] = tmp_p1[z * 3 + 1];
+					p[2] = tmp_p1[z * 3 + 2];
 				}
-				switch (lut)
+				break;
+			case 8:
 				{
-				case 0:
-					{
-						const unsigned char c = static_cast<unsigned char>(UCHAR_MAX * r);
-						p[j]     = c;
-						p[j + 1] = c;
-						p[j + 2] = c;
-					}
-					break;
-				case 1:
-				case 2:
-				case 3:
-				case 4:
-				case 5:
-				case 6:
-				case 7:
-					{
-						int z = static_cast<int>(r * tmp__size);
-						if (z < 0) z = 0;
-						if (z > (tmp__size - 1)) z = tmp__size - 1;
-						p[j]     = tmp_p1[z * 3];
-						p[j + 1] = tmp_p1[z * 3 + 1];
-						p[j + 2] = tmp_p1[z * 3 + 2];
-					}
-					break;
-				case 8:
-					{
-						int z = static_cast<int>(v);
-						if (z < 0) z = 0;
-						if (z > (tmp__size - 1)) z = tmp__size - 1;
-						p[j + 0] = tmp_p1[z * 3];
-						p[j + 1] = tmp_p1[z * 3 + 1];
-						p[j + 2] = tmp_p1[z * 3 + 2];
-					}
-					break;
-				default:
-					break;
+					int z = static_cast<int>(v);
+					if (z < 0) z = 0;
+					if (z > (tmp__size - 1)) z = tmp__size - 1;
+					p[0] = tmp_p1[z * 3];
+					p[1] = tmp_p1[z * 3 + 1];
+					p[2] = tmp_p1[z * 3 + 2];
 				}
+				break;
+			default:
+				break;
+			}
+		}
+		else if (v <= wmin)
+		{
+			if (lut == 0)
+			{
+				p[0] = 0;
+				p[1] = 0;
+				p[2] = 0;
 			}
-			else if (v <= wmin)
+			else
+			{
+				p[0] = tmp_p1[0];
+				p[1] = tmp_p1[1];
+				p[2] = tmp_p1[2];
+			}
+		}
+		else if (v > wmax)
+		{
+			if (lut == 0)
 			{
-				switch (lut)
+				if (alt_mode)
+				{
+					p[0] = 0;
+					p[1] = 0;
+					p[2] = 0;
+				}
+				else
 				{
-				case 0:
-					{
-						p[j]     = 0;
-						p[j + 1] = 0;
-						p[j + 2] = 0;
-					}
-					break;
-				case 1:
-				case 2:
-				case 3:
-				case 4:
-				case 5:
-				case 6:
-				case 7:
-				case 8:
-					{
-						p[j]     = tmp_p1[0];
-						p[j + 1] = tmp_p1[1];
-						p[j + 2] = tmp_p1[2];
-					}
-					break;
-				default:
-					break;
+					p[0] = UCHAR_MAX;
+					p[1] = UCHAR_MAX;
+					p[2] = UCHAR_MAX;
 				}
 			}
-			else if (v > wmax)
+			else
 			{
-				switch (lut)
+				if (alt_mode)
+				{
+					p[0] = tmp_p1[0];
+					p[1] = tmp_p1[1];
+					p[2] = tmp_p1[2];
+				}
+				else
 				{
-				case 0:
-					if (alt_mode)
-					{
-						p[j]     = 0;
-						p[j + 1] = 0;
-						p[j + 2] = 0;
-					}
-					else
-					{
-						p[j]     = UCHAR_MAX;
-						p[j + 1] = UCHAR_MAX;
-						p[j + 2] = UCHAR_MAX;
-					}
-					break;
-				case 1:
-				case 2:
-				case 3:
-				case 4:
-				case 5:
-				case 6:
-				case 7:
-				case 8:
-					if (alt_mode)
-					{
-						p[j]     = tmp_p1[0];
-						p[j + 1] = tmp_p1[1];
-						p[j + 2] = tmp_p1[2];
-					}
-					else
-					{
-						const unsigned int z = tmp__size - 1;
-						p[j]     = tmp_p1[z * 3];
-						p[j + 1] = tmp_p1[z * 3 + 1];
-						p[j + 2] = tmp_p1[z * 3 + 2];
-					}
-					break;
-				default:
-					break;
+					const unsigned int z = tmp__size - 1;
+					p[0] = tmp_p1[z * 3];
+					p[1] = tmp_p1[z * 3 + 1];
+					p[2] = tmp_p1[z * 3 + 2];
 				}
 			}
+		}
+	}
+
+private:
+	const double window_center;
+	const short lut;
+	const bool alt_mode;
+	const unsigned char * tmp_p1{};
+	int tmp__size{};
+	short tmp_lut_function{};
+	double wmin{};
+	double wmax{};
+	double div_{1.0};
+	double window_center_minus_0_point_5{}; // used only for LINEAR
+	bool valid{};
+};
+
+// Precomputed packed RGB for every integer value in [lo, hi],
+// for 8/16-bit pixel types.
+class WindowLUTTable
+{
+public:
+	double window_center{};
+	double window_width{};
+	short lut{};
+	bool alt_mode{};
+	short lut_function{};
+	int lo{};
+	int hi{-1};
+	std::vector<unsigned char> rgb;
+};
+
+template<typename T> struct WindowLUTTableType
+{
+	typedef typename T::PixelType PixelType;
+	static constexpr bool value =
+		std::is_same<PixelType, unsigned char>::value  ||
+		std::is_same<PixelType, signed short>::value   ||
+		std::is_same<PixelType, unsigned short>::value;
+};
+
+// Returns the table for the parameters, built once per
+// (center, width, lut, alt mode, lut function, range) change,
+// a few recent tables are kept per pixel type (views with different levels).
+template<typename T> std::shared_ptr<const WindowLUTTable> get_window_LUT_table(
+	const double window_center, const double window_width,
+	const short lut,
+	const bool alt_mode,
+	const short lut_function,
+	const double rmin, const double rmax)
+{
+	typedef typename T::PixelType PixelType;
+	static QMutex mutex;
+	static std::vector<std::shared_ptr<const WindowLUTTable>> tables;
+	const size_t max_tables = 8;
+	const double type_min = static_cast<double>(std::numeric_limits<PixelType>::min());
+	const double type_max = static_cast<double>(std::numeric_limits<PixelType>::max());
+	int lo = static_cast<int>(type_min);
+	int hi = static_cast<int>(type_max);
+	if (rmin <= rmax)
+	{
+		if (floor(rmin) > type_min) lo = static_cast<int>(floor(rmin));
+		if (ceil(rmax)  < type_max) hi = static_cast<int>(ceil(rmax));
+		if (lo > hi) return std::shared_ptr<const WindowLUTTable>();
+	}
+	QMutexLocker locker(&mutex);
+	for (size_t x = 0; x < tables.size(); ++x)
+	{
+		const WindowLUTTable & t = *(tables.at(x));
+		if (t.window_center == window_center &&
+			t.window_width == window_width &&
+			t.lut == lut &&
+			t.alt_mode == alt_mode &&
+			t.lut_function == lut_function &&
+			t.lo == lo &&
+			t.hi == hi)
+		{
+			std::shared_ptr<const WindowLUTTable> r = tables.at(x);
+			if (x > 0)
+			{
+				tables.erase(tables.begin() + x);
+				tables.insert(tables.begin(), r);
+			}
+			return r;
+		}
+	}
+	const WindowLUT wl(window_center, window_width, lut, alt_mode, lut_function);
+	if (!wl.is_valid()) return std::shared_ptr<const WindowLUTTable>();
+	std::shared_ptr<WindowLUTTable> t;
+	try
+	{
+		t = std::make_shared<WindowLUTTable>();
+		t->rgb.resize(3 * (static_cast<size_t>(hi - lo) + 1));
+	}
+	catch (const std::bad_alloc&)
+	{
+		return std::shared_ptr<const WindowLUTTable>();
+	}
+	t->window_center = window_center;
+	t->window_width = window_width;
+	t->lut = lut;
+	t->alt_mode = alt_mode;
+	t->lut_function = lut_function;
+	t->lo = lo;
+	t->hi = hi;
+	unsigned char * p = t->rgb.data();
+	for (int v = lo; v <= hi; ++v)
+	{
+		wl.apply(static_cast<double>(v), p);
+		p += 3;
+	}
+	tables.insert(tables.begin(), t);
+	if (tables.size() > max_tables) tables.pop_back();
+	return t;
+}
+
+template<typename P> struct WindowLUTSIMDType
+{
+	static constexpr bool value = false;
+	static size_t process(
+		const P*, size_t, unsigned char*, const WindowLUTSIMDParams&)
+	{
+		return 0;
+	}
+};
+
+template<> struct WindowLUTSIMDType<float>
+{
+	static constexpr bool value = true;
+	static size_t process(
+		const float * in, size_t n, unsigned char * out, const WindowLUTSIMDParams & p)
+	{
+		return WindowLUTSIMD::process(in, n, out, p);
+	}
+};
+
+template<> struct WindowLUTSIMDType<double>
+{
+	static constexpr bool value = true;
+	static size_t process(
+		const double * in, size_t n, unsigned char * out, const WindowLUTSIMDParams & p)
+	{
+		return WindowLUTSIMD::process(in, n, out, p);
+	}
+};
+
+template<typename T> class ProcessImageThreadLUT_ : public QRunnable
+{
+public:
+	ProcessImageThreadLUT_(
+		const typename T::Pointer & image_,
+		unsigned char * p_,
+		const int size_0_, const int size_1_,
+		const int index_0_, const int index_1_,
+		const unsigned int j_,
+		const double window_center_, const double window_width_,
+		const short lut_,
+		const bool alt_mode_,
+		const short lut_function_,
+		QSemaphore * done_ = nullptr,
+		const WindowLUTTable * table_ = nullptr,
+		const WindowLUTSIMDParams * simd_ = nullptr)
+		:
+		image(image_),
+		p(p_),
+		size_0(size_0_), size_1(size_1_),
+		index_0(index_0_), index_1(index_1_),
+		j(j_),
+		window_center(window_center_), window_width(window_width_),
+		lut(lut_),
+		alt_mode(alt_mode_),
+		lut_function(lut_function_),
+		done(done_),
+		table(table_),
+		simd(simd_)
+	{
+		setAutoDelete(false);
+	}
+
+	~ProcessImageThreadLUT_()
+	{
+	}
+
+	void run() override
+	{
+		if (table)     process_table();
+		else if (simd) process_simd();
+		else           process();
+		if (done) done->release();
+	}
+
+private:
+	void process()
+	{
+		const WindowLUT wl(window_center, window_width, lut, alt_mode, lut_function);
+		if (!wl.is_valid()) return;
+		typename T::SizeType size;
+		size[0] = size_0;
+		size[1] = size_1;
+		typename T::IndexType index;
+		index[0] = index_0;
+		index[1] = index_1;
+		const typename T::RegionType region(index, size);
+		typename itk::ImageRegionConstIterator<T> iterator(image, region);
+		iterator.GoToBegin();
+		while (!iterator.IsAtEnd())
+		{
+			wl.apply(iterator.Get(), &p[j]);
 			j += 3;
 			++iterator;
 		}
 	}
 
-private:
+	// Single gather per pixel, values outside of the table
+	// (should not happen if the range is correct) are computed.
+	void process_table()
+	{
+		const WindowLUT wl(window_center, window_width, lut, alt_mode, lut_function);
+		if (!wl.is_valid()) return;
+		const typename T::PixelType * buffer = image->GetBufferPointer();
+		if (!buffer) return;
+		const typename T::RegionType & buffered = image->GetBufferedRegion();
+		const size_t width = buffered.GetSize()[0];
+		const int offset_0 = index_0 - static_cast<int>(buffered.GetIndex()[0]);
+		const int offset_1 = index_1 - static_cast<int>(buffered.GetIndex()[1]);
+		const int lo = table->lo;
+		const int hi = table->hi;
+		const unsigned char * rgb = table->rgb.data();
+		unsigned char * out = &p[j];
+		for (int y = 0; y < size_1; ++y)
+		{
+			const typename T::PixelType * row =
+				buffer + (static_cast<size_t>(offset_1 + y) * width + offset_0);
+			for (int x = 0; x < size_0; ++x)
+			{
+				const int v = static_cast<int>(row[x]);
+				if (v >= lo && v <= hi)
+				{
+					memcpy(out, &rgb[3 * (v - lo)], 3);
+				}
+				else
+				{
+					wl.apply(static_cast<double>(v), out);
+				}
+				out += 3;
+			}
+		}
+	}
+
+	// Linear functions for float/double images, s. WindowLUTSIMD,
+	// the tail of each row is processed with the scalar code.
+	void process_simd()
+	{
+		const WindowLUT wl(window_center, window_width, lut, alt_mode, lut_function);
+		if (!wl.is_valid()) return;
+		const typename T::PixelType * buffer = image->GetBufferPointer();
+		if (!buffer) return;
+		const typename T::RegionType & buffered = image->GetBufferedRegion();
+		const size_t width = buffered.GetSize()[0];
+		const int offset_0 = index_0 - static_cast<int>(buffered.GetIndex()[0]);
+		const int offset_1 = index_1 - static_cast<int>(buffered.GetIndex()[1]);
+		unsigned char * out = &p[j];
+		for (int y = 0; y < size_1; ++y)
+		{
+			const typename T::PixelType * row =
+				buffer + (static_cast<size_t>(offset_1 + y) * width + offset_0);
+			size_t x = WindowLUTSIMDType<typename T::PixelType>::process(
+				row, size_0, out, *simd);
+			for (; x < static_cast<size_t>(size_0); ++x)
+			{
+				wl.apply(row[x], &out[3 * x]);
+			}
+			out += 3 * size_0;
+		}
+	}
+
 	const typename T::Pointer image;
 	unsigned char * p;
 	const int size_0;
@@ -299,7 +588,78 @@ private:
 	const short lut;
 	const bool  alt_mode;
 	const short lut_function;
+	QSemaphore * done;
+	const WindowLUTTable * table;
+	const WindowLUTSIMDParams * simd;
 };
 
+// Splits the image into row tiles and processes them in RenderPool,
+// the calling thread takes the last tile, returns when all are done.
+// For 8/16-bit images a precomputed table over [rmin, rmax] is used,
+// pass rmin > rmax if the range is unknown. For float/double images
+// with linear functions the vectorized kernel is used, if available.
+template<typename T> void process_image_LUT(
+	const typename T::Pointer & image,
+	unsigned char * p,
+	const int size_0, const int size_1,
+	const double window_center, const double window_width,
+	const short lut,
+	const bool alt_mode,
+	const short lut_function,
+	const double rmin = 1.0, const double rmax = 0.0)
+{
+	const int tiles = RenderPool::tiles_count(size_1);
+	if (tiles < 1 || size_0 < 1) return;
+	std::shared_ptr<const WindowLUTTable> table;
+	if (WindowLUTTableType<T>::value)
+	{
+		table = get_window_LUT_table<T>(
+			window_center, window_width,
+			lut, alt_mode, lut_function,
+			rmin, rmax);
+	}
+	WindowLUTSIMDParams simd_params;
+	std::vector<unsigned char> simd_colors;
+	bool simd{};
+	if (WindowLUTSIMDType<typename T::PixelType>::value && WindowLUTSIMD::level() > 0)
+	{
+		const WindowLUT wl(window_center, window_width, lut, alt_mode, lut_function);
+		simd = wl.get_simd_params(simd_params, simd_colors);
+	}
+	QSemaphore done;
+	std::vector<ProcessImageThreadLUT_<T>*> tasks;
+	tasks.reserve(tiles);
+	const int rows = size_1 / tiles;
+	const int rest = size_1 % tiles;
+	int index_1{};
+	for (int i = 0; i < tiles; ++i)
+	{
+		const int size_1_ = (i < rest) ? rows + 1 : rows;
+		const unsigned int j = 3 * size_0 * index_1;
+		tasks.push_back(new ProcessImageThreadLUT_<T>(
+			image,
+			p,
+			size_0, size_1_,
+			0, index_1, j,
+			window_center, window_width,
+			lut, alt_mode, lut_function,
+			&done,
+			table.get(),
+			simd ? &simd_params : nullptr));
+		index_1 += size_1_;
+	}
+	QThreadPool * pool = RenderPool::instance();
+	for (int i = 0; i < tiles - 1; ++i)
+	{
+		pool->start(tasks[i]);
+	}
+	tasks[tiles - 1]->run();
+	done.acquire(tiles);
+	for (int i = 0; i < tiles; ++i)
+	{
+		delete tasks[i];
+	}
+}
+
 #endif
 
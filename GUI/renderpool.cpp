@@ -0,0 +1,45 @@
+#include "renderpool.h"
+#include <QThread>
+#include <QThreadPool>
+
+QThreadPool * RenderPool::instance()
+{
+	static QThreadPool pool;
+	static const bool initialized = []()
+	{
+		const int num_threads = QThread::idealThreadCount();
+		pool.setMaxThreadCount(num_threads > 1 ? num_threads : 1);
+		pool.setExpiryTimeout(-1);
+		return true;
+	}();
+	(void)initialized;
+	return &pool;
+}
+
+QThreadPool * RenderPool::prefetch_instance()
+{
+	static QThreadPool pool;
+	static const bool initialized = []()
+	{
+		pool.setMaxThreadCount(QThread::idealThreadCount() > 2 ? 2 : 1);
+		pool.setExpiryTimeout(-1);
+		return true;
+	}();
+	(void)initialized;
+	return &pool;
+}
+
+// Number of tiles (row blocks) for an image with 'rows' rows,
+// more tiles than threads to balance uneven work between them.
+int RenderPool::tiles_count(const int rows)
+{
+	if (rows < 1) return 0;
+	const int num_threads = instance()->maxThreadCount() + 1;
+	int tiles = 4 * num_threads;
+	const int min_rows = 16;
+	if (rows / tiles < min_rows) tiles = rows / min_rows;
+	if (tiles < 1) tiles = 1;
+	if (tiles > rows) tiles = rows;
+	return tiles;
+}
+
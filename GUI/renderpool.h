@@ -0,0 +1,19 @@
+#ifndef A_RENDERPOOL_H
+#define A_RENDERPOOL_H
+
+class QThreadPool;
+
+// Long-lived worker threads for 2D rendering (window/level LUT tiles),
+// shared by all views, threads are created once and never expire.
+// Prefetch jobs run in a separate small pool, they wait for their
+// tiles in the render pool, so they must not occupy its threads.
+class RenderPool
+{
+public:
+	static QThreadPool * instance();
+	static QThreadPool * prefetch_instance();
+	static int tiles_count(const int);
+};
+
+#endif
+
@@ -22,6 +22,7 @@
 #include "commonutils.h"
 #include "dicomutils.h"
 #include "codecutils.h"
+#include "slicecache.h"
 
 SettingsWidget::SettingsWidget(float si) : scale_icons(si)
 {
@@ -42,6 +43,8 @@ SettingsWidget::SettingsWidget(float si) : scale_icons(si)
 	connect(reload_pushButton, SIGNAL(clicked()),           this, SLOT(set_default()));
 	connect(pt_doubleSpinBox,  SIGNAL(valueChanged(double)),this, SLOT(update_font_pt(double)));
 	connect(cp1251_checkBox,   SIGNAL(toggled(bool)),       this, SLOT(set_force_cp1251(bool)));
+	connect(slicecache_spinBox,SIGNAL(valueChanged(int)),   this, SLOT(set_slice_cache(int)));
+	connect(mmap_checkBox,     SIGNAL(toggled(bool)),       this, SLOT(set_memory_mapping(bool)));
 }
 
 short SettingsWidget::get_filtering() const
@@ -168,11 +171,16 @@ void SettingsWidget::set_default()
 	set_force_cp1251(false);
 	cp1251_checkBox->blockSignals(false);
 	mvsep_checkBox->setChecked(false);
+	slicecache_spinBox->setValue(256);
 #if defined _WIN32 || defined __APPLE__
 	dcmthread_checkBox->setChecked(true);
 #else
 	dcmthread_checkBox->setChecked(false);
 #endif
+	mmap_checkBox->blockSignals(true);
+	mmap_checkBox->setChecked(false);
+	set_memory_mapping(false);
+	mmap_checkBox->blockSignals(false);
 }
 
 void SettingsWidget::set_force_cp1251(bool b)
@@ -180,6 +188,16 @@ void SettingsWidget::set_force_cp1251(bool b)
 	CodecUtils::set_force_cp1251(b);
 }
 
+void SettingsWidget::set_slice_cache(int mb)
+{
+	SliceCache::set_max_size(static_cast<long long>(mb) * 1024 * 1024);
+}
+
+void SettingsWidget::set_memory_mapping(bool b)
+{
+	DicomUtils::set_memory_mapping(b);
+}
+
 int SettingsWidget::get_time_unit() const
 {
 	if (time_s__checkBox->isChecked()) return 1;
@@ -255,6 +273,8 @@ void SettingsWidget::readSettings()
 	const int tmp14 = settings.value(QString("force_cp1251"),    0).toInt();
 	const int tmp15 = settings.value(QString("apply_suppl"),     1).toInt();
 	const int tmp16 = settings.value(QString("mvsep"),           0).toInt();
+	const int tmp18 = settings.value(QString("slice_cache_mb"),256).toInt();
+	const int tmp19 = settings.value(QString("mmap"),            0).toInt();
 #if defined _WIN32 || defined __APPLE__
 	const int tmp17 = settings.value(QString("dcm_thread"),      1).toInt();
 #else
@@ -330,6 +350,14 @@ void SettingsWidget::readSettings()
 	cp1251_checkBox->blockSignals(false);
 	mvsep_checkBox->setChecked((tmp16 == 1));
 	dcmthread_checkBox->setChecked((tmp17 == 1));
+	slicecache_spinBox->blockSignals(true);
+	slicecache_spinBox->setValue(tmp18 >= 0 ? tmp18 : 256);
+	set_slice_cache(slicecache_spinBox->value());
+	slicecache_spinBox->blockSignals(false);
+	mmap_checkBox->blockSignals(true);
+	mmap_checkBox->setChecked((tmp19 == 1));
+	set_memory_mapping(mmap_checkBox->isChecked());
+	mmap_checkBox->blockSignals(false);
 }
 
 void SettingsWidget::writeSettings(QSettings & s)
@@ -353,6 +381,8 @@ void SettingsWidget::writeSettings(QSettings & s)
 	s.setValue(QString("force_cp1251"),  QVariant(cp1251_checkBox->isChecked() ? 1 : 0));
 	s.setValue(QString("mvsep"),         QVariant(mvsep_checkBox->isChecked() ? 1 : 0));
 	s.setValue(QString("dcm_thread"),    QVariant(dcmthread_checkBox->isChecked() ? 1 : 0));
+	s.setValue(QString("slice_cache_mb"),QVariant(slicecache_spinBox->value()));
+	s.setValue(QString("mmap"),          QVariant(mmap_checkBox->isChecked() ? 1 : 0));
 	if (enh_dim_skip_radioButton->isChecked())
 	{
 		s.setValue(QString("enh_strategy"), QVariant(4));
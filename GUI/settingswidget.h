@@ -46,6 +46,8 @@ private:
 
 private slots:
 	void set_force_cp1251(bool);
+	void set_slice_cache(int);
+	void set_memory_mapping(bool);
 
 public slots:
 	void set_default();
@@ -0,0 +1,209 @@
+#include "slicecache.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+
+struct SliceCacheEntry
+{
+	SliceCacheKey key;
+	QImage image;
+	long long size{};
+};
+
+typedef std::list<SliceCacheEntry> SliceCacheList;
+
+// Not more pending prefetch requests, older are still in the queue
+// if the requests come faster than the workers can render.
+const size_t max_pending = 16;
+
+struct SliceCacheData
+{
+	QMutex mutex;
+	SliceCacheList entries; // most recently used first
+	std::unordered_map<unsigned long long, SliceCacheList::iterator> map;
+	std::unordered_set<unsigned long long> pending;
+	long long size{};
+	long long max_size{256LL * 1024 * 1024};
+};
+
+SliceCacheData & get_data()
+{
+	static SliceCacheData data;
+	return data;
+}
+
+unsigned long long slice_id(const SliceCacheKey & k)
+{
+	return
+		(static_cast<unsigned long long>(static_cast<unsigned int>(k.id)) << 32) |
+		(static_cast<unsigned long long>(k.axis & 0x3) << 30) |
+		(static_cast<unsigned long long>(k.slice) & 0x3fffffffULL);
+}
+
+long long image_size(const QImage & i)
+{
+	return static_cast<long long>(i.bytesPerLine()) * i.height();
+}
+
+void erase_entry(SliceCacheData & d, const SliceCacheList::iterator it)
+{
+	d.size -= it->size;
+	d.map.erase(slice_id(it->key));
+	d.entries.erase(it);
+}
+
+void trim(SliceCacheData & d)
+{
+	while (d.size > d.max_size && !d.entries.empty())
+	{
+		erase_entry(d, std::prev(d.entries.end()));
+	}
+}
+
+void insert_entry(SliceCacheData & d, const SliceCacheKey & key, const QImage & image)
+{
+	const long long size = image_size(image);
+	if (size <= 0 || size > d.max_size) return;
+	const unsigned long long sid = slice_id(key);
+	const auto it = d.map.find(sid);
+	if (it != d.map.end()) erase_entry(d, it->second);
+	SliceCacheEntry e;
+	e.key = key;
+	e.image = image;
+	e.size = size;
+	d.entries.push_front(e);
+	d.map[sid] = d.entries.begin();
+	d.size += size;
+	trim(d);
+}
+
+}
+
+bool SliceCacheKey::operator==(const SliceCacheKey & k) const
+{
+	return (
+		id            == k.id &&
+		axis          == k.axis &&
+		slice         == k.slice &&
+		window_center == k.window_center &&
+		window_width  == k.window_width &&
+		lut           == k.lut &&
+		lut_function  == k.lut_function &&
+		alt_mode      == k.alt_mode &&
+		rmin          == k.rmin &&
+		rmax          == k.rmax &&
+		mtime         == k.mtime);
+}
+
+bool SliceCacheKey::operator!=(const SliceCacheKey & k) const
+{
+	return !(*this == k);
+}
+
+bool SliceCache::find(const SliceCacheKey & key, QImage & image)
+{
+	SliceCacheData & d = get_data();
+	QMutexLocker locker(&d.mutex);
+	const auto it = d.map.find(slice_id(key));
+	if (it == d.map.end()) return false;
+	if (it->second->key != key)
+	{
+		// level, LUT or image were changed
+		erase_entry(d, it->second);
+		return false;
+	}
+	d.entries.splice(d.entries.begin(), d.entries, it->second);
+	image = it->second->image;
+	return true;
+}
+
+void SliceCache::insert(const SliceCacheKey & key, const QImage & image)
+{
+	if (image.isNull()) return;
+	SliceCacheData & d = get_data();
+	QMutexLocker locker(&d.mutex);
+	insert_entry(d, key, image);
+}
+
+// Returns true if the caller should render the slice
+// and pass the result to end_prefetch().
+bool SliceCache::begin_prefetch(const SliceCacheKey & key)
+{
+	SliceCacheData & d = get_data();
+	QMutexLocker locker(&d.mutex);
+	if (d.max_size <= 0) return false;
+	if (d.pending.size() >= max_pending) return false;
+	const unsigned long long sid = slice_id(key);
+	if (d.pending.count(sid) > 0) return false;
+	const auto it = d.map.find(sid);
+	if (it != d.map.end() && it->second->key == key) return false;
+	d.pending.insert(sid);
+	return true;
+}
+
+// The image may be null (failed), a slice rendered
+// in the GUI thread meanwhile is not replaced.
+void SliceCache::end_prefetch(const SliceCacheKey & key, const QImage & image)
+{
+	SliceCacheData & d = get_data();
+	QMutexLocker locker(&d.mutex);
+	const unsigned long long sid = slice_id(key);
+	if (d.pending.erase(sid) < 1) return;
+	if (image.isNull()) return;
+	if (d.map.find(sid) != d.map.end()) return;
+	insert_entry(d, key, image);
+}
+
+void SliceCache::remove(const int id)
+{
+	SliceCacheData & d = get_data();
+	QMutexLocker locker(&d.mutex);
+	SliceCacheList::iterator it = d.entries.begin();
+	while (it != d.entries.end())
+	{
+		SliceCacheList::iterator tmp = it;
+		++it;
+		if (tmp->key.id == id) erase_entry(d, tmp);
+	}
+	auto p = d.pending.begin();
+	while (p != d.pending.end())
+	{
+		if (static_cast<int>(static_cast<unsigned int>(*p >> 32)) == id)
+			p = d.pending.erase(p);
+		else
+			++p;
+	}
+}
+
+void SliceCache::clear()
+{
+	SliceCacheData & d = get_data();
+	QMutexLocker locker(&d.mutex);
+	d.entries.clear();
+	d.map.clear();
+	d.pending.clear();
+	d.size = 0;
+}
+
+// Size in bytes, 0 disables the cache.
+void SliceCache::set_max_size(const long long s)
+{
+	SliceCacheData & d = get_data();
+	QMutexLocker locker(&d.mutex);
+	d.max_size = (s > 0) ? s : 0;
+	trim(d);
+}
+
+long long SliceCache::get_max_size()
+{
+	SliceCacheData & d = get_data();
+	QMutexLocker locker(&d.mutex);
+	return d.max_size;
+}
+
@@ -0,0 +1,43 @@
+#ifndef A_SLICECACHE_H
+#define A_SLICECACHE_H
+
+#include <QImage>
+
+// Everything a rendered 2D slice depends on,
+// 'mtime' is the modification time of the 3D ITK image.
+struct SliceCacheKey
+{
+	int    id{-1};
+	short  axis{-1};
+	int    slice{-1};
+	double window_center{};
+	double window_width{};
+	short  lut{};
+	short  lut_function{};
+	bool   alt_mode{};
+	double rmin{1.0};
+	double rmax{};
+	unsigned long long mtime{};
+	bool operator==(const SliceCacheKey&) const;
+	bool operator!=(const SliceCacheKey&) const;
+};
+
+// LRU cache of rendered slices (window/level and LUT applied, without
+// overlays), shared by 2D views and prefetch workers, thread-safe.
+// One image per slice, rendering with other settings replaces it,
+// an entry with outdated settings is dropped on lookup.
+class SliceCache
+{
+public:
+	static bool find(const SliceCacheKey&, QImage&);
+	static void insert(const SliceCacheKey&, const QImage&);
+	static bool begin_prefetch(const SliceCacheKey&);
+	static void end_prefetch(const SliceCacheKey&, const QImage&);
+	static void remove(const int);
+	static void clear();
+	static void set_max_size(const long long);
+	static long long get_max_size();
+};
+
+#endif
+
@@ -12,16 +12,14 @@
 #include <QMap>
 #include <QListWidget>
 #include <QListWidgetItem>
-#include <itkExtractImageFilter.h>
 #include <itkImageRegionConstIterator.h>
 #include "processimagethreadLUT.hxx"
+#include "extractslice.hxx"
 #include "graphicsutils.h"
 #include "commonutils.h"
 #include "updateqtcommand.h"
 #include "imagesbox.h"
 #include <climits>
-#include <chrono>
-#include <thread>
 
 namespace
 {
@@ -40,41 +38,12 @@ template<typename Tin, typename Tout> QString get_slice2_(
 	typename Tout::Pointer & out_image,
 	int idx)
 {
-	if (image.IsNull())
-	{
-		return QString("get_slice2_<>() : image.IsNull()");
-	}
-	typedef itk::ExtractImageFilter<Tin, Tout> FilterType;
-	const typename Tin::RegionType inRegion =
-		image->GetLargestPossibleRegion();
-	const typename Tin::SizeType size = inRegion.GetSize();
-	typename Tin::IndexType index = inRegion.GetIndex();
-	typename Tin::RegionType outRegion;
-	typename Tin::SizeType out_size;
-	typename FilterType::Pointer filter = FilterType::New();
-	index[2] = idx;
-	out_size[0] = size[0];
-	out_size[1] = size[1];
-	out_size[2] = 0;
-	outRegion.SetSize(out_size);
-	outRegion.SetIndex(index);
-	try
-	{
-		filter->SetInput(image);
-		filter->SetExtractionRegion(outRegion);
-		filter->SetDirectionCollapseToIdentity();
-		filter->Update();
-	}
-	catch (const itk::ExceptionObject & ex)
-	{
-		return QString(ex.GetDescription());
-	}
-	out_image = filter->GetOutput();
-	if (out_image.IsNotNull())
+	const QString error = extract_slice<Tin, Tout>(2, image, out_image, idx);
+	if (!error.isEmpty())
 	{
-		out_image->DisconnectPipeline();
+		return error;
 	}
-	else
+	if (out_image.IsNull())
 	{
 		return QString("Out image is nullptr");
 	}
@@ -862,99 +831,13 @@ template<typename T> void load_image2(
 	//
 	const bool global_flip_x = widget->graphicsview->global_flip_x;
 	const bool global_flip_y = widget->graphicsview->global_flip_y;
-	const int num_threads = QThread::idealThreadCount();
-	const int tmp99 = size[1] % num_threads;
-	std::vector<QThread*> threadsLUT_;
-	if (tmp99 == 0)
-	{
-		unsigned int j = 0;
-		for (int i = 0; i < num_threads; ++i)
-		{
-			const int size_0 = size[0];
-			const int size_1 = size[1] / num_threads;
-			const int index_0 = 0;
-			const int index_1 = i * size_1;
-			ProcessImageThreadLUT_<T> * t__ = new ProcessImageThreadLUT_<T>(
-						image,
-						p,
-						size_0, size_1,
-						index_0, index_1, j,
-						window_center, window_width,
-						lut, false, lut_function);
-			j += 3 * size_0 * size_1;
-			threadsLUT_.push_back(static_cast<QThread*>(t__));
-			t__->start();
-		}
-	}
-	else
-	{
-		unsigned int j = 0;
-		unsigned int block = 64;
-		if (static_cast<float>(size[1]) / static_cast<float>(block) > 16.0f)
-		{
-			block = 128;
-		}
-		const int tmp100 = size[1] % block;
-		const int incr = static_cast<int>(floor(size[1] / static_cast<double>(block)));
-		if (size[1] > block)
-		{
-			for (int i = 0; i < incr; ++i)
-			{
-				const int size_0 = size[0];
-				const int index_0 = 0;
-				const int index_1 = i * block;
-				ProcessImageThreadLUT_<T> * t__ = new ProcessImageThreadLUT_<T>(
-							image,
-							p,
-							size_0, block,
-							index_0, index_1, j,
-							window_center, window_width,
-							lut, false, lut_function);
-				j += 3 * size_0 * block;
-				threadsLUT_.push_back(static_cast<QThread*>(t__));
-				t__->start();
-			}
-			ProcessImageThreadLUT_<T> * lt__ = new ProcessImageThreadLUT_<T>(
-						image,
-						p,
-						size[0], tmp100,
-						0, incr * block, j,
-						window_center, window_width,
-						lut, false, lut_function);
-			threadsLUT_.push_back(static_cast<QThread*>(lt__));
-			lt__->start();
-		}
-		else
-		{
-			ProcessImageThreadLUT_<T> * lt__ = new ProcessImageThreadLUT_<T>(
-						image,
-						p,
-						size[0], size[1],
-						0, 0, 0,
-						window_center, window_width,
-						lut, false, lut_function);
-			threadsLUT_.push_back(static_cast<QThread*>(lt__));
-			lt__->start();
-		}
-	}
-	//
-	const size_t threadsLUT_size = threadsLUT_.size();
-	while (true)
-	{
-		std::this_thread::sleep_for(std::chrono::milliseconds(2));
-		size_t b__ = 0;
-		for (size_t i = 0; i < threadsLUT_size; ++i)
-		{
-			if (threadsLUT_.at(i)->isFinished()) ++b__;
-		}
-		if (b__ == threadsLUT_size) break;
-	}
-	for (size_t i = 0; i < threadsLUT_size; ++i)
-	{
-		delete threadsLUT_[i];
-		threadsLUT_[i] = nullptr;
-	}
-	threadsLUT_.clear();
+	process_image_LUT<T>(
+		image,
+		p,
+		size[0], size[1],
+		window_center, window_width,
+		lut, false, lut_function,
+		ivariant->di->rmin, ivariant->di->rmax);
 	//
 	double coeff_size_0 = 1.0, coeff_size_1 = 1.0;
 	const QRectF rectf(0, 0, size[0], size[1]);
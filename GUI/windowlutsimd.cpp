@@ -0,0 +1,292 @@
+#include "windowlutsimd.h"
+#include <atomic>
+#include <cstring>
+
+// Only x86-64, on 32-bit x86 the scalar code may use x87
+// and the results would not be bit-exact.
+#if !defined(DISABLE_SIMDMATH) && (defined(__x86_64__) || defined(_M_X64))
+#define A_WINDOWLUT_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define A_WINDOWLUT_AVX2
+#define A_WINDOWLUT_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER)
+#define A_WINDOWLUT_AVX2
+#define A_WINDOWLUT_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+
+int detect_level()
+{
+#ifdef A_WINDOWLUT_AVX2
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return 2;
+#else
+	int r[4];
+	__cpuid(r, 0);
+	if (r[0] >= 7)
+	{
+		__cpuid(r, 1);
+		const bool osxsave = (r[2] & (1 << 27)) != 0;
+		const bool avx     = (r[2] & (1 << 28)) != 0;
+		__cpuidex(r, 7, 0);
+		const bool avx2    = (r[1] & (1 << 5)) != 0;
+		if (osxsave && avx && avx2 && ((_xgetbv(0) & 6) == 6)) return 2;
+	}
+#endif
+#endif
+#ifdef A_WINDOWLUT_SSE2
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+#if defined(A_WINDOWLUT_SSE2) || defined(A_WINDOWLUT_AVX2)
+inline void write_rgb(
+	const int * idx,
+	const int n,
+	unsigned char * out,
+	const unsigned char * colors)
+{
+	for (int k = 0; k < n; ++k)
+	{
+		if (idx[k] >= 0)
+		{
+			memcpy(out + 3 * k, colors + 3 * idx[k], 3);
+		}
+	}
+}
+#endif
+
+#ifdef A_WINDOWLUT_SSE2
+struct ConstantsSSE2
+{
+	ConstantsSSE2(const WindowLUTSIMDParams & p)
+		:
+		wmin(_mm_set1_pd(p.wmin)),
+		wmax(_mm_set1_pd(p.wmax)),
+		sub(_mm_set1_pd(p.sub)),
+		div(_mm_set1_pd(p.div)),
+		scale(_mm_set1_pd(p.scale)),
+		index_max(_mm_set1_pd(p.index_max)),
+		low(_mm_set1_pd(p.low)),
+		high(_mm_set1_pd(p.high)),
+		half(_mm_set1_pd(0.5)),
+		zero(_mm_setzero_pd()),
+		minus_one(_mm_set1_pd(-1.0)),
+		labels(p.labels)
+	{
+	}
+	const __m128d wmin;
+	const __m128d wmax;
+	const __m128d sub;
+	const __m128d div;
+	const __m128d scale;
+	const __m128d index_max;
+	const __m128d low;
+	const __m128d high;
+	const __m128d half;
+	const __m128d zero;
+	const __m128d minus_one;
+	const bool labels;
+};
+
+inline __m128i index_sse2(const __m128d v, const ConstantsSSE2 & c)
+{
+	const __m128d in = _mm_and_pd(_mm_cmpgt_pd(v, c.wmin), _mm_cmple_pd(v, c.wmax));
+	const __m128d lo = _mm_cmple_pd(v, c.wmin);
+	const __m128d hi = _mm_cmpgt_pd(v, c.wmax);
+	__m128d x = c.labels
+		? v
+		: _mm_mul_pd(_mm_add_pd(_mm_div_pd(_mm_sub_pd(v, c.sub), c.div), c.half), c.scale);
+	x = _mm_min_pd(_mm_max_pd(x, c.zero), c.index_max);
+	__m128d r = _mm_and_pd(in, x);
+	r = _mm_or_pd(r, _mm_and_pd(lo, c.low));
+	r = _mm_or_pd(r, _mm_and_pd(hi, c.high));
+	r = _mm_or_pd(r, _mm_andnot_pd(_mm_or_pd(in, _mm_or_pd(lo, hi)), c.minus_one));
+	return _mm_cvttpd_epi32(r);
+}
+
+size_t process_sse2(
+	const double * in, const size_t n,
+	unsigned char * out,
+	const WindowLUTSIMDParams & p)
+{
+	const ConstantsSSE2 c(p);
+	int idx[4];
+	size_t i{};
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128i i0 = index_sse2(_mm_loadu_pd(in + i),     c);
+		const __m128i i1 = index_sse2(_mm_loadu_pd(in + i + 2), c);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(idx), _mm_unpacklo_epi64(i0, i1));
+		write_rgb(idx, 4, out + 3 * i, p.colors);
+	}
+	return i;
+}
+
+size_t process_sse2(
+	const float * in, const size_t n,
+	unsigned char * out,
+	const WindowLUTSIMDParams & p)
+{
+	const ConstantsSSE2 c(p);
+	int idx[4];
+	size_t i{};
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 f = _mm_loadu_ps(in + i);
+		const __m128i i0 = index_sse2(_mm_cvtps_pd(f), c);
+		const __m128i i1 = index_sse2(_mm_cvtps_pd(_mm_movehl_ps(f, f)), c);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(idx), _mm_unpacklo_epi64(i0, i1));
+		write_rgb(idx, 4, out + 3 * i, p.colors);
+	}
+	return i;
+}
+#endif
+
+#ifdef A_WINDOWLUT_AVX2
+A_WINDOWLUT_TARGET_AVX2 inline __m128i index_avx2(
+	const __m256d v,
+	const WindowLUTSIMDParams & p)
+{
+	const __m256d wmin = _mm256_set1_pd(p.wmin);
+	const __m256d wmax = _mm256_set1_pd(p.wmax);
+	const __m256d in = _mm256_and_pd(
+		_mm256_cmp_pd(v, wmin, _CMP_GT_OQ),
+		_mm256_cmp_pd(v, wmax, _CMP_LE_OQ));
+	const __m256d lo = _mm256_cmp_pd(v, wmin, _CMP_LE_OQ);
+	const __m256d hi = _mm256_cmp_pd(v, wmax, _CMP_GT_OQ);
+	__m256d x = p.labels
+		? v
+		: _mm256_mul_pd(
+			_mm256_add_pd(
+				_mm256_div_pd(
+					_mm256_sub_pd(v, _mm256_set1_pd(p.sub)),
+					_mm256_set1_pd(p.div)),
+				_mm256_set1_pd(0.5)),
+			_mm256_set1_pd(p.scale));
+	x = _mm256_min_pd(
+		_mm256_max_pd(x, _mm256_setzero_pd()),
+		_mm256_set1_pd(p.index_max));
+	__m256d r = _mm256_and_pd(in, x);
+	r = _mm256_or_pd(r, _mm256_and_pd(lo, _mm256_set1_pd(p.low)));
+	r = _mm256_or_pd(r, _mm256_and_pd(hi, _mm256_set1_pd(p.high)));
+	r = _mm256_or_pd(r, _mm256_andnot_pd(
+		_mm256_or_pd(in, _mm256_or_pd(lo, hi)), _mm256_set1_pd(-1.0)));
+	return _mm256_cvttpd_epi32(r);
+}
+
+A_WINDOWLUT_TARGET_AVX2 size_t process_avx2(
+	const double * in, const size_t n,
+	unsigned char * out,
+	const WindowLUTSIMDParams & p)
+{
+	int idx[8];
+	size_t i{};
+	for (; i + 8 <= n; i += 8)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(idx),
+			index_avx2(_mm256_loadu_pd(in + i), p));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(idx + 4),
+			index_avx2(_mm256_loadu_pd(in + i + 4), p));
+		write_rgb(idx, 8, out + 3 * i, p.colors);
+	}
+	return i;
+}
+
+A_WINDOWLUT_TARGET_AVX2 size_t process_avx2(
+	const float * in, const size_t n,
+	unsigned char * out,
+	const WindowLUTSIMDParams & p)
+{
+	int idx[8];
+	size_t i{};
+	for (; i + 8 <= n; i += 8)
+	{
+		const __m256 f = _mm256_loadu_ps(in + i);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(idx),
+			index_avx2(_mm256_cvtps_pd(_mm256_castps256_ps128(f)), p));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(idx + 4),
+			index_avx2(_mm256_cvtps_pd(_mm256_extractf128_ps(f, 1)), p));
+		write_rgb(idx, 8, out + 3 * i, p.colors);
+	}
+	return i;
+}
+#endif
+
+int detected_level()
+{
+	static const int l = detect_level();
+	return l;
+}
+
+std::atomic<int> forced_level(-1);
+
+}
+
+int WindowLUTSIMD::level()
+{
+	const int l = forced_level.load();
+	return (l >= 0) ? l : detected_level();
+}
+
+bool WindowLUTSIMD::set_level(int l)
+{
+	if (l > detected_level()) return false;
+	forced_level.store((l >= 0) ? l : -1);
+	return true;
+}
+
+size_t WindowLUTSIMD::process(
+	const float * in, const size_t n,
+	unsigned char * out,
+	const WindowLUTSIMDParams & p)
+{
+	if (!in || !out || !p.colors) return 0;
+	switch (level())
+	{
+#ifdef A_WINDOWLUT_AVX2
+	case 2:
+		return process_avx2(in, n, out, p);
+#endif
+#ifdef A_WINDOWLUT_SSE2
+	case 1:
+		return process_sse2(in, n, out, p);
+#endif
+	default:
+		break;
+	}
+	return 0;
+}
+
+size_t WindowLUTSIMD::process(
+	const double * in, const size_t n,
+	unsigned char * out,
+	const WindowLUTSIMDParams & p)
+{
+	if (!in || !out || !p.colors) return 0;
+	switch (level())
+	{
+#ifdef A_WINDOWLUT_AVX2
+	case 2:
+		return process_avx2(in, n, out, p);
+#endif
+#ifdef A_WINDOWLUT_SSE2
+	case 1:
+		return process_sse2(in, n, out, p);
+#endif
+	default:
+		break;
+	}
+	return 0;
+}
+
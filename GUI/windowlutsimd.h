@@ -0,0 +1,45 @@
+#ifndef A_WINDOWLUTSIMD_H
+#define A_WINDOWLUTSIMD_H
+
+#include <cstddef>
+
+// Parameters of a linear window/level mapping, s. WindowLUT::get_simd_params().
+// In window:   index = clamp(((v - sub) / div + 0.5) * scale, 0, index_max),
+//              or clamp(v, 0, index_max) if 'labels' is set,
+// v <= wmin:   index = low,
+// v > wmax:    index = high,
+// NaN:         pixel is not written.
+// Colors are packed RGB triplets, indexed by 'index'.
+struct WindowLUTSIMDParams
+{
+	double wmin{};
+	double wmax{};
+	double sub{};
+	double div{1.0};
+	double scale{};
+	double index_max{};
+	int low{};
+	int high{};
+	bool labels{};
+	const unsigned char * colors{};
+};
+
+class WindowLUTSIMD
+{
+public:
+	// 0 - scalar, 1 - SSE2, 2 - AVX2
+	static int level();
+	// Limits the code to the level, for tests, returns false if
+	// the level is not supported, -1 restores the detected level.
+	static bool set_level(int);
+	// Process as many values as possible from the beginning,
+	// returns the number of values processed, the rest
+	// must be processed by the scalar code.
+	static size_t process(
+		const float*, size_t, unsigned char*, const WindowLUTSIMDParams&);
+	static size_t process(
+		const double*, size_t, unsigned char*, const WindowLUTSIMDParams&);
+};
+
+#endif
+
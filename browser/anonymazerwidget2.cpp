@@ -85,13 +85,17 @@ bool find_duplicated_recursive__(
 	return false;
 }
 
-void replace__(
-	mdcm::DataSet & ds,
+// Elements of a data set are not replaced while it is iterated,
+// inserting may invalidate iterators. The new element is appended to
+// 'tmp1', see replace_elements__().
+void replacement__(
+	const mdcm::DataSet & ds,
 	const mdcm::Tag & t,
 	const char * value,
 	const size_t size_,
 	const bool implicit,
-	const mdcm::Dicts & dicts)
+	const mdcm::Dicts & dicts,
+	std::vector<mdcm::DataElement> & tmp1)
 {
 	if (t.GetGroup() < 0x0008) return;
 	mdcm::VR vr = DicomUtils::get_vr(ds, t, implicit, dicts);
@@ -117,14 +121,14 @@ void replace__(
 			if (!implicit) de.SetVR(vr);
 			mdcm::VL paddedSize = static_cast<mdcm::VL::Type>(padded.size());
 			de.SetByteValue(padded.c_str(), paddedSize);
-			ds.Replace(de);
+			tmp1.push_back(de);
 		}
 		else // should not happen
 		{
 			mdcm::DataElement de(t);
 			if (!implicit) de.SetVR(vr);
 			de.SetByteValue("", 0);
-			ds.Replace(de);
+			tmp1.push_back(de);
 		}
 	}
 	else // should not happen
@@ -153,10 +157,30 @@ void replace__(
 			}
 		}
 		de.SetByteValue("", 0);
-		ds.Replace(de);
+		tmp1.push_back(de);
 	}
 }
 
+void replace_elements__(
+	mdcm::DataSet & ds,
+	const std::vector<mdcm::DataElement> & tmp1)
+{
+	for (unsigned int x = 0; x < tmp1.size(); ++x) ds.Replace(tmp1.at(x));
+}
+
+void replace__(
+	mdcm::DataSet & ds,
+	const mdcm::Tag & t,
+	const char * value,
+	const size_t size_,
+	const bool implicit,
+	const mdcm::Dicts & dicts)
+{
+	std::vector<mdcm::DataElement> tmp1;
+	replacement__(ds, t, value, size_, implicit, dicts, tmp1);
+	replace_elements__(ds, tmp1);
+}
+
 void replace_uid_recurs__(
 	mdcm::DataSet & ds,
 	const std::set<mdcm::Tag> & ts,
@@ -164,6 +188,7 @@ void replace_uid_recurs__(
 	const bool implicit,
 	const mdcm::Dicts & dicts)
 {
+	std::vector<mdcm::DataElement> tmp1;
 	for (mdcm::DataSet::Iterator it = ds.Begin(); it != ds.End();)
 	{
 		const mdcm::DataElement & de1 = *it;
@@ -185,7 +210,7 @@ void replace_uid_recurs__(
 					if (m.contains(s))
 					{
 						const QString v = m.value(s);
-						replace__(ds, t, v.toLatin1().constData(), v.size(), implicit, dicts);
+						replacement__(ds, t, v.toLatin1().constData(), v.size(), implicit, dicts, tmp1);
 					}
 				}
 			}
@@ -207,11 +232,12 @@ void replace_uid_recurs__(
 					mdcm::DataElement de_dup = *dup;
 					de_dup.SetValue(*sq);
 					de_dup.SetVLToUndefined();
-					ds.Replace(de_dup);
+					tmp1.push_back(de_dup);
 				}
 			}
 		}
 	}
+	replace_elements__(ds, tmp1);
 }
 
 void replace_pn_recurs__(
@@ -224,6 +250,7 @@ void replace_pn_recurs__(
 	const QString & charset,
 	const mdcm::Dicts & dicts)
 {
+	std::vector<mdcm::DataElement> tmp1;
 	for (mdcm::DataSet::Iterator it = ds.Begin(); it != ds.End();)
 	{
 		const mdcm::DataElement & de1 = *it;
@@ -251,11 +278,11 @@ void replace_pn_recurs__(
 						std::cout << "Warning: provided Patient Name may be incorrectly encoded" << std::endl;
 #endif
 					}
-					replace__(ds, t, ba.constData(), ba.size(), implicit, dicts);
+					replacement__(ds, t, ba.constData(), ba.size(), implicit, dicts, tmp1);
 				}
 				else
 				{
-					replace__(ds, t, sn.toLatin1().constData(), sn.toLatin1().size(), implicit, dicts);
+					replacement__(ds, t, sn.toLatin1().constData(), sn.toLatin1().size(), implicit, dicts, tmp1);
 				}
 			}
 			else
@@ -271,8 +298,8 @@ void replace_pn_recurs__(
 						if (m.contains(s))
 						{
 							const QString v = m.value(s);
-							replace__(
-								ds, t, v.toUtf8().constData(), v.size(), implicit, dicts);
+							replacement__(
+								ds, t, v.toUtf8().constData(), v.size(), implicit, dicts, tmp1);
 						}
 					}
 				}
@@ -301,11 +328,12 @@ void replace_pn_recurs__(
 					mdcm::DataElement de_dup = *dup;
 					de_dup.SetValue(*sq);
 					de_dup.SetVLToUndefined();
-					ds.Replace(de_dup);
+					tmp1.push_back(de_dup);
 				}
 			}
 		}
 	}
+	replace_elements__(ds, tmp1);
 }
 
 void replace_id_recurs__(
@@ -318,6 +346,7 @@ void replace_id_recurs__(
 	const QString & charset,
 	const mdcm::Dicts & dicts)
 {
+	std::vector<mdcm::DataElement> tmp1;
 	for (mdcm::DataSet::Iterator it = ds.Begin(); it != ds.End();)
 	{
 		const mdcm::DataElement & de1 = *it;
@@ -345,11 +374,11 @@ void replace_id_recurs__(
 						std::cout << "Warning: provided Patient ID may be incorrectly encoded" << std::endl;
 #endif
 					}
-					replace__(ds, t, ba.constData(), ba.size(), implicit, dicts);
+					replacement__(ds, t, ba.constData(), ba.size(), implicit, dicts, tmp1);
 				}
 				else
 				{
-					replace__(ds, t, si.toLatin1().constData(), si.toLatin1().size(), implicit, dicts);
+					replacement__(ds, t, si.toLatin1().constData(), si.toLatin1().size(), implicit, dicts, tmp1);
 				}
 			}
 			else
@@ -365,8 +394,8 @@ void replace_id_recurs__(
 						if (m.contains(s))
 						{
 							const QString v = m.value(s);
-							replace__(
-								ds, t, v.toUtf8().constData(), v.size(), implicit, dicts);
+							replacement__(
+								ds, t, v.toUtf8().constData(), v.size(), implicit, dicts, tmp1);
 						}
 					}
 				}
@@ -395,11 +424,12 @@ void replace_id_recurs__(
 					mdcm::DataElement de_dup = *dup;
 					de_dup.SetValue(*sq);
 					de_dup.SetVLToUndefined();
-					ds.Replace(de_dup);
+					tmp1.push_back(de_dup);
 				}
 			}
 		}
 	}
+	replace_elements__(ds, tmp1);
 }
 
 void remove_recurs__(
@@ -408,6 +438,7 @@ void remove_recurs__(
 	const bool implicit,
 	const mdcm::Dicts & dicts)
 {
+	std::vector<mdcm::DataElement> tmp1;
 	for (mdcm::DataSet::Iterator it = ds.Begin(); it != ds.End();)
 	{
 		const mdcm::DataElement & de1 = *it;
@@ -416,7 +447,7 @@ void remove_recurs__(
 		++it;
 		if (ts.find(t) != ts.end())
 		{
-			ds.GetDES().erase(dup);
+			it = ds.GetDES().erase(dup);
 		}
 		else
 		{
@@ -436,11 +467,12 @@ void remove_recurs__(
 					mdcm::DataElement de_dup = *dup;
 					de_dup.SetValue(*sq);
 					de_dup.SetVLToUndefined();
-					ds.Replace(de_dup);
+					tmp1.push_back(de_dup);
 				}
 			}
 		}
 	}
+	replace_elements__(ds, tmp1);
 }
 
 void zero_sq_recurs__(
@@ -449,6 +481,7 @@ void zero_sq_recurs__(
 	const bool implicit,
 	const mdcm::Dicts & dicts)
 {
+	std::vector<mdcm::DataElement> tmp1;
 	for (mdcm::DataSet::Iterator it = ds.Begin(); it != ds.End();)
 	{
 		const mdcm::DataElement & de1 = *it;
@@ -465,7 +498,7 @@ void zero_sq_recurs__(
 			if (!implicit) e.SetVR(mdcm::VR::SQ);
 			e.SetValue(*sq);
 			e.SetVLToUndefined();
-			ds.Replace(e);
+			tmp1.push_back(e);
 		}
 		else
 		{
@@ -485,11 +518,12 @@ void zero_sq_recurs__(
 					mdcm::DataElement de_dup = *dup;
 					de_dup.SetValue(*sq);
 					de_dup.SetVLToUndefined();
-					ds.Replace(de_dup);
+					tmp1.push_back(de_dup);
 				}
 			}
 		}
 	}
+	replace_elements__(ds, tmp1);
 }
 
 #if 0
@@ -499,6 +533,7 @@ void remove_date_time_recurs__(
 	const bool implicit,
 	const mdcm::Dicts & dicts)
 {
+	std::vector<mdcm::DataElement> tmp1;
 	for (mdcm::DataSet::Iterator it = ds.Begin(); it != ds.End();)
 	{
 		const mdcm::DataElement & de1 = *it;
@@ -508,23 +543,23 @@ void remove_date_time_recurs__(
 		++it;
 		if (t == mdcm::Tag(0x0008,0x0021))
 		{
-			replace__(ds, mdcm::Tag(0x0008,0x0021), "", 0, implicit, dicts);
+			replacement__(ds, mdcm::Tag(0x0008,0x0021), "", 0, implicit, dicts, tmp1);
 		}
 		else if (t == mdcm::Tag(0x0008,0x0031))
 		{
-			replace__(ds, mdcm::Tag(0x0008,0x0031), "", 0, implicit, dicts);
+			replacement__(ds, mdcm::Tag(0x0008,0x0031), "", 0, implicit, dicts, tmp1);
 		}
 		else if (t == mdcm::Tag(0x0008,0x0020))
 		{
-			replace__(ds, mdcm::Tag(0x0008,0x0020), "", 0, implicit, dicts);
+			replacement__(ds, mdcm::Tag(0x0008,0x0020), "", 0, implicit, dicts, tmp1);
 		}
 		else if (t == mdcm::Tag(0x0008,0x0030))
 		{
-			replace__(ds, mdcm::Tag(0x0008,0x0030), "", 0, implicit, dicts);
+			replacement__(ds, mdcm::Tag(0x0008,0x0030), "", 0, implicit, dicts, tmp1);
 		}
 		else if (is_date_time(vr, t) || (ts.find(t) != ts.end()))
 		{
-			ds.GetDES().erase(dup);
+			it = ds.GetDES().erase(dup);
 		}
 		else
 		{
@@ -544,11 +579,12 @@ void remove_date_time_recurs__(
 					mdcm::DataElement de_dup = *dup;
 					de_dup.SetValue(*sq);
 					de_dup.SetVLToUndefined();
-					ds.Replace(de_dup);
+					tmp1.push_back(de_dup);
 				}
 			}
 		}
 	}
+	replace_elements__(ds, tmp1);
 }
 #endif
 
@@ -654,6 +690,7 @@ void modify_date_time_recurs__(
 	const int d_off,
 	const int s_off)
 {
+	std::vector<mdcm::DataElement> tmp1;
 	for (mdcm::DataSet::Iterator it = ds.Begin(); it != ds.End();)
 	{
 		const mdcm::DataElement & de1 = *it;
@@ -671,7 +708,7 @@ void modify_date_time_recurs__(
 				mdcm::DataElement de2(t);
 				if (!implicit) de2.SetVR(mdcm::VR::SH);
 				de2.SetByteValue(r.toLatin1(), r.length());
-				ds.Replace(de2);
+				tmp1.push_back(de2);
 			}
 			else
 			{
@@ -879,7 +916,7 @@ void modify_date_time_recurs__(
 						mdcm::DataElement de2(t);
 						if (!implicit) de2.SetVR(vr);
 						de2.SetByteValue(r.toLatin1(), r.length());
-						ds.Replace(de2);
+						tmp1.push_back(de2);
 					}
 				}
 			}
@@ -903,11 +940,12 @@ void modify_date_time_recurs__(
 					mdcm::DataElement de_dup = *dup;
 					de_dup.SetValue(*sq);
 					de_dup.SetVLToUndefined();
-					ds.Replace(de_dup);
+					tmp1.push_back(de_dup);
 				}
 			}
 		}
 	}
+	replace_elements__(ds, tmp1);
 }
 
 void empty_recurs__(
@@ -916,6 +954,7 @@ void empty_recurs__(
 	const bool implicit,
 	const mdcm::Dicts & dicts)
 {
+	std::vector<mdcm::DataElement> tmp1;
 	for (mdcm::DataSet::Iterator it = ds.Begin(); it != ds.End();)
 	{
 		const mdcm::DataElement & de1 = *it;
@@ -924,7 +963,7 @@ void empty_recurs__(
 		++it;
 		if (ts.find(t) != ts.end())
 		{
-			replace__(ds, t, "", 0, implicit, dicts);
+			replacement__(ds, t, "", 0, implicit, dicts, tmp1);
 		}
 		else
 		{
@@ -944,11 +983,12 @@ void empty_recurs__(
 					mdcm::DataElement de_dup = *dup;
 					de_dup.SetValue(*sq);
 					de_dup.SetVLToUndefined();
-					ds.Replace(de_dup);
+					tmp1.push_back(de_dup);
 				}
 			}
 		}
 	}
+	replace_elements__(ds, tmp1);
 }
 
 void remove_private__(
@@ -956,6 +996,7 @@ void remove_private__(
 	const bool implicit,
 	const mdcm::Dicts & dicts)
 {
+	std::vector<mdcm::DataElement> tmp1;
 	for (mdcm::DataSet::Iterator it = ds.Begin();it != ds.End();)
 	{
 		const mdcm::DataElement & de1 = *it;
@@ -963,7 +1004,7 @@ void remove_private__(
 		++it;
 		if (de1.GetTag().IsPrivate())
 		{
-			ds.GetDES().erase(dup);
+			it = ds.GetDES().erase(dup);
 		}
 		else
 		{
@@ -984,11 +1025,12 @@ void remove_private__(
 					mdcm::DataElement de_dup = *dup;
 					de_dup.SetValue(*sq);
 					de_dup.SetVLToUndefined();
-					ds.Replace(de_dup);
+					tmp1.push_back(de_dup);
 				}
 			}
 		}
 	}
+	replace_elements__(ds, tmp1);
 }
 
 bool check_overlay_in_pixeldata(const mdcm::DataSet & ds)
@@ -1063,6 +1105,7 @@ void remove_group_length__(
 	const bool implicit,
 	const mdcm::Dicts & dicts)
 {
+	std::vector<mdcm::DataElement> tmp1;
 	for (mdcm::DataSet::Iterator it = ds.Begin(); it != ds.End();)
 	{
 		const mdcm::DataElement & de1 = *it;
@@ -1070,7 +1113,7 @@ void remove_group_length__(
 		++it;
 		if (de1.GetTag().IsGroupLength())
 		{
-			ds.GetDES().erase(dup);
+			it = ds.GetDES().erase(dup);
 		}
 		else
 		{
@@ -1091,11 +1134,12 @@ void remove_group_length__(
 					mdcm::DataElement de_dup = *dup;
 					de_dup.SetValue(*sq);
 					de_dup.SetVLToUndefined();
-					ds.Replace(de_dup);
+					tmp1.push_back(de_dup);
 				}
 			}
 		}
 	}
+	replace_elements__(ds, tmp1);
 }
 
 QString generate_random_name(const bool random_names)
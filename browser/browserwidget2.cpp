@@ -11,34 +11,42 @@
 #include <QMimeData>
 #include <QTextCodec>
 #include <QByteArray>
-#include <QTableWidgetItem>
+#include <QHeaderView>
+#include <QItemSelectionModel>
 #include <QMessageBox>
 #include <QFileInfo>
 #include <QMap>
 #include <QVector>
 #include <QDir>
 #include <QApplication>
+#include <QEventLoop>
+#include <QSet>
+#include <QThread>
 #ifdef USE_WORKSTATION_MODE
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QSqlError>
 #include "ctkdialog.h"
+#include "scanindex.h"
 #endif
 #include <mdcmReader.h>
-#include <mdcmScanner.h>
 #include <mdcmAttribute.h>
 #include <mdcmMediaStorage.h>
 #include <mdcmExplicitDataElement.h>
 #include <mdcmFileMetaInformation.h>
-#include <mdcmGlobal.h>
-#include <mdcmDicts.h>
 #include <mdcmParseException.h>
 #include "codecutils.h"
 #include "dicomutils.h"
+#include "scandirectory_t.h"
+#include "seriestablemodel.h"
+#ifdef USE_WATCH_DIRECTORY
+#include "watchdirectory_t.h"
+#endif
 #include <vector>
 #include <string>
 #include <exception>
+#include <algorithm>
 
 namespace
 {
@@ -50,7 +58,6 @@ const mdcm::Tag tOffsetOfReferencedLowerLevelDirectoryEntity(0x0004,0x1420);
 const mdcm::Tag tDirectoryRecordType                        (0x0004,0x1430);
 const mdcm::Tag tReferencedFileID                           (0x0004,0x1500);
 const mdcm::Tag tSpecificCharacterSet                       (0x0008,0x0005);
-const mdcm::Tag tSOPClassUID                                (0x0008,0x0016);
 const mdcm::Tag tStudyDate                                  (0x0008,0x0020);
 const mdcm::Tag tSeriesDate                                 (0x0008,0x0021);
 const mdcm::Tag tModality                                   (0x0008,0x0060);
@@ -58,11 +65,6 @@ const mdcm::Tag tStudyDescription                           (0x0008,0x1030);
 const mdcm::Tag tSeriesDescription                          (0x0008,0x103e);
 const mdcm::Tag tPatientsName                               (0x0010,0x0010);
 const mdcm::Tag tPatientsBirthDate                          (0x0010,0x0030);
-const mdcm::Tag tSeriesInstanceUID                          (0x0020,0x000e);
-const mdcm::Tag tRows                                       (0x0028,0x0010);
-const mdcm::Tag tColumns                                    (0x0028,0x0011);
-const mdcm::Tag tBitsAllocated                              (0x0028,0x0100);
-const mdcm::Tag tPixelRepresentation                        (0x0028,0x0103);
 
 }
 
@@ -117,30 +119,17 @@ BrowserWidget2::BrowserWidget2(float si)
 	copy_pushButton->setIconSize(s);
 	load_pushButton->setIconSize(s);
 	//
-	tableWidget->hideColumn(0);
-	tableWidget->setColumnWidth(1, 24);
-	tableWidget->setColumnWidth(3, 160);
-	tableWidget->setColumnWidth(5, 200);
-	tableWidget->setColumnWidth(7, 200);
-	//
-	selected_tags.insert(mdcm::Tag(0x0008,0x0005));
-	selected_tags.insert(mdcm::Tag(0x0008,0x0016));
-	selected_tags.insert(mdcm::Tag(0x0008,0x0020));
-	selected_tags.insert(mdcm::Tag(0x0008,0x0021));
-	selected_tags.insert(mdcm::Tag(0x0008,0x0060));
-	selected_tags.insert(mdcm::Tag(0x0008,0x1030));
-	selected_tags.insert(mdcm::Tag(0x0008,0x103e));
-	selected_tags.insert(mdcm::Tag(0x0010,0x0010));
-	selected_tags.insert(mdcm::Tag(0x0010,0x0030));
-	selected_tags.insert(mdcm::Tag(0x0028,0x0010));
-	selected_tags.insert(mdcm::Tag(0x0028,0x0011));
-	selected_tags.insert(mdcm::Tag(0x0028,0x0100));
-	selected_tags.insert(mdcm::Tag(0x0028,0x0103));
-	selected_tags_short.insert(mdcm::Tag(0x0008,0x0016));
-	selected_tags_short.insert(mdcm::Tag(0x0028,0x0010));
-	selected_tags_short.insert(mdcm::Tag(0x0028,0x0011));
-	selected_tags_short.insert(mdcm::Tag(0x0028,0x0100));
-	selected_tags_short.insert(mdcm::Tag(0x0028,0x0103));
+	model = new SeriesTableModel(this);
+	model->set_icons(eye_icon, eye2_icon);
+	tableView->setModel(model);
+	tableView->hideColumn(0);
+	tableView->setColumnWidth(1, 24);
+	tableView->setColumnWidth(3, 160);
+	tableView->setColumnWidth(5, 200);
+	tableView->setColumnWidth(7, 200);
+	// Column 0 is the order of series found
+	tableView->horizontalHeader()->setSortIndicator(0, Qt::AscendingOrder);
+	tableView->setSortingEnabled(true);
 	//
 	readSettings();
 	//
@@ -148,15 +137,28 @@ BrowserWidget2::BrowserWidget2(float si)
 	connect(dicomdir_pushButton, SIGNAL(clicked()), this, SLOT(open_DICOMDIR()));
 	connect(reload_pushButton,   SIGNAL(clicked()), this, SLOT(reload_dir()));
 	connect(copy_pushButton,     SIGNAL(clicked()), this, SLOT(copy_files()));
+	connect(filter_lineEdit,     SIGNAL(textChanged(const QString&)), model, SLOT(set_filter(const QString&)));
 #ifdef USE_WORKSTATION_MODE
 	connect(ctk_pushButton,      SIGNAL(clicked()), this, SLOT(open_CTK_db()));
 #else
 	ctk_pushButton->hide();
+#endif
+#ifdef USE_WATCH_DIRECTORY
+	connect(watch_checkBox,      SIGNAL(toggled(bool)), this, SLOT(toggle_watch(bool)));
+#else
+	watch_checkBox->hide();
 #endif
 	refresh_sc = new QShortcut(QKeySequence::Refresh, this, SLOT(reload_dir()));
 	refresh_sc->setAutoRepeat(false);
 }
 
+BrowserWidget2::~BrowserWidget2()
+{
+#ifdef USE_WATCH_DIRECTORY
+	stop_watch();
+#endif
+}
+
 void BrowserWidget2::closeEvent(QCloseEvent * e)
 {
 	e->accept();
@@ -165,8 +167,9 @@ void BrowserWidget2::closeEvent(QCloseEvent * e)
 void BrowserWidget2::read_directory(const QString & p)
 {
 	if (!once) once = true;
-	tableWidget->clearContents();
-	tableWidget->setRowCount(0);
+	if (scanner) return;
+	clear_table();
+	if (p.isEmpty()) return;
 	QProgressDialog * pb = new QProgressDialog(
 		QString("Recursive scan"),
 		QString("Stop"),
@@ -180,258 +183,164 @@ void BrowserWidget2::read_directory(const QString & p)
 #if QT_VERSION < QT_VERSION_CHECK(5,0,0)
 	pb->show();
 #endif
-	qApp->processEvents();
-	try
-	{
-		const mdcm::Global & g = mdcm::GlobalInstance;
-		const mdcm::Dicts & dicts = g.GetDicts();
-		const mdcm::Dict & dict = dicts.GetPublicDict();
-		process_directory(p, dict, pb);
-	}
-	catch (const mdcm::ParseException & pe)
-	{
-#ifdef ALIZA_VERBOSE
-		std::cout << "mdcm::ParseException in BrowserWidget2::read_directory:\n"
-			<< pe.GetLastElement().GetTag() << std::endl;
+	// The directory is walked and the files are read in other threads,
+	// rows are added or updated when a batch of files is ready.
+	// Files not changed since the last scan are taken from the index.
+	const int threads = std::max(1, std::min(QThread::idealThreadCount(), 16));
+#ifdef USE_WORKSTATION_MODE
+	scanner = new ScanDirectory_T(p, threads, ScanIndex::default_file());
 #else
-		(void)pe;
+	scanner = new ScanDirectory_T(p, threads);
 #endif
+	scan_pb = pb;
+	QEventLoop loop;
+	connect(scanner, SIGNAL(results_ready()), this, SLOT(process_scan_results()));
+	connect(scanner, SIGNAL(finished()), &loop, SLOT(quit()));
+	connect(pb, SIGNAL(canceled()), scanner, SLOT(cancel()));
+#ifdef USE_WATCH_DIRECTORY
+	// The watch is started before the scan, files that arrive while
+	// the scan runs are not lost. Its results are held until the scan
+	// ends, then files already read by the scan are skipped.
+	watch_root = p;
+	if (watch_checkBox->isChecked())
+	{
+		start_watch();
+		if (watcher)
+		{
+			QEventLoop loop0;
+			connect(watcher, SIGNAL(watching()), &loop0, SLOT(quit()));
+			connect(pb, SIGNAL(canceled()), &loop0, SLOT(quit()));
+			if (!watcher->is_watching()) loop0.exec();
+		}
 	}
-	catch (const std::exception & ex)
-	{
-#ifdef ALIZA_VERBOSE
-		std::cout << "Exception in BrowserWidget2::read_directory:\n" << ex.what() << std::endl;
-#else
-		(void)ex;
 #endif
-	}
+	scanner->start();
+	loop.exec();
+	scanner->wait();
+	process_scan_results();
+	scan_pb = nullptr;
 	pb->close();
 	delete pb;
+	delete scanner;
+	scanner = nullptr;
+#ifdef USE_WATCH_DIRECTORY
+	process_watch_results();
+#endif
 }
 
-void BrowserWidget2::process_directory(
-	const QString & p,
-	const mdcm::Dict & dict,
-	QProgressDialog * pb)
+void BrowserWidget2::process_scan_results()
 {
-	if (p.isEmpty()) return;
-	QDir dir(p);
-	QStringList dlist = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-	QStringList flist = dir.entryList(QDir::Files | QDir::Readable, QDir::Name);
-	std::vector<std::string> filenames;
-	QStringList filenames_no_series_uid;
-	for (int x = 0; x < flist.size(); ++x)
-	{
-		qApp->processEvents();
-		if (pb->wasCanceled()) return;
-		const QString tmp0 = dir.absolutePath() + QString("/") + flist.at(x);
+	if (!scanner) return;
+	std::vector<ScanRecord> l;
+	scanner->take_results(l);
+	if (scan_pb)
+	{
+		QString s =
+			QString("Recursive scan\n") +
+			QVariant(scanner->get_count_read()).toString() +
+			QString(" / ") +
+			QVariant(scanner->get_count_found()).toString() +
+			QString(" files");
+		const unsigned long long count_indexed = scanner->get_count_indexed();
+		if (count_indexed > 0)
 		{
-			mdcm::Reader reader;
-#ifdef _WIN32
-#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-			reader.SetFileName(QDir::toNativeSeparators(tmp0).toUtf8().constData());
-#else
-			reader.SetFileName(QDir::toNativeSeparators(tmp0).toLocal8Bit().constData());
-#endif
-#else
-			reader.SetFileName(tmp0.toLocal8Bit().constData());
-#endif
-			if (reader.ReadUpToTag(tSeriesInstanceUID))
-			{
-				const mdcm::DataSet & ds = reader.GetFile().GetDataSet();
-				if (ds.FindDataElement(tSeriesInstanceUID))
-				{
-#ifdef _WIN32
-#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-					filenames.push_back(std::string(QDir::toNativeSeparators(tmp0).toUtf8().constData()));
-#else
-					filenames.push_back(std::string(QDir::toNativeSeparators(tmp0).toLocal8Bit().constData()));
-#endif
-#else
-					filenames.push_back(std::string(tmp0.toLocal8Bit().constData()));
-#endif
-				}
-				else
-				{
-					filenames_no_series_uid.push_back(tmp0);
-				}
-			}
+			s.append(QString(", ") + QVariant(count_indexed).toString() + QString(" not changed"));
 		}
+		scan_pb->setLabelText(s);
 	}
-	flist.clear();
-	//
-	{
-		mdcm::SmartPointer<mdcm::Scanner> sp = new mdcm::Scanner;
-		mdcm::Scanner & s0 = *sp;
-		ScannerWatcher sw(&s0);
-		s0.AddTag(tSeriesInstanceUID);
-		s0.Scan(filenames, dict);
-		if (pb->wasCanceled()) return;
-		mdcm::Scanner::ValuesType v = s0.GetValues();
-		mdcm::Scanner::ValuesType::iterator vi = v.begin();
-		for (; vi != v.end(); ++vi)
-		{
-			QString modality;
-			QString name;
-			QString birthdate;
-			QString study;
-			QString study_date;
-			QString series;
-			QString series_date;
-			bool is_image = false;
-			bool is_softcopy = false;
-			const int idx = tableWidget->rowCount();
-			QString idxs;
-#if QT_VERSION >= QT_VERSION_CHECK(5,14,0)
-			idxs = QString::asprintf("%010d", idx);
-#else
-			idxs.sprintf("%010d", idx);
-#endif
-			TableWidgetItem * i = new TableWidgetItem(idxs);
-			std::vector<std::string> files__(
-				s0.GetAllFilenamesFromTagToValue(
-					tSeriesInstanceUID, (*vi).c_str()));
-			for (unsigned int z = 0; z < files__.size(); ++z)
-			{
+	add_records(l);
+}
 
-				const QString tmp_filename =
-#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-					QString::fromUtf8(files__.at(z).c_str());
-#else
-					QString::fromLocal8Bit(files__.at(z).c_str());
-#endif
-				i->files.push_back(tmp_filename);
-			}
-			const unsigned int series_size = i->files.size();
-			if (series_size > 0)
-			{
-				read_tags_(
-					i->files.at(0),
-					name,birthdate,
-					modality,
-					study,study_date,
-					series,series_date,
-					&is_image,&is_softcopy);
-			}
-			qApp->processEvents();
-			if (pb->wasCanceled()) return;
-			//
-			if (!is_image && series_size > 1)
-			{
-				size_t series_idx = 0;
-				do
-				{
-					++series_idx;
-					qApp->processEvents();
-					if (pb->wasCanceled()) return;
-					bool is_image_tmp = false;
-					read_tags_short_(
-						i->files.at(series_idx),
-						&is_image_tmp,&is_softcopy);
-					if (is_image_tmp)
-					{
-						is_image = true;
-						break;
-					}
-					else if (is_softcopy)
-					{
-						break;
-					}
-				}
-				while (series_idx < (series_size - 1));
-			}
-			//
-			tableWidget->setRowCount(idx + 1);
-			tableWidget->setItem(idx, 0, static_cast<QTableWidgetItem*>(i));
-			if (is_image)
-			{
-				tableWidget->setItem(idx, 1, new QTableWidgetItem(eye_icon, QString("")));
-			}
-			else if (is_softcopy)
-			{
-				tableWidget->setItem(idx, 1, new QTableWidgetItem(eye2_icon, QString("")));
-			}
-			tableWidget->setItem(idx, 2, new QTableWidgetItem(modality));
-			tableWidget->setItem(idx, 3, new QTableWidgetItem(
-				DicomUtils::convert_pn_value(name.remove(QChar('\0')))));
-			tableWidget->setItem(idx, 4, new QTableWidgetItem(birthdate));
-			tableWidget->setItem(idx, 5, new QTableWidgetItem(study.remove(QChar('\0'))));
-			tableWidget->setItem(idx, 6, new QTableWidgetItem(study_date));
-			tableWidget->setItem(idx, 7, new QTableWidgetItem(series.remove(QChar('\0'))));
-			tableWidget->setItem(idx, 8, new QTableWidgetItem(series_date));
-			tableWidget->setItem(idx, 9, new QTableWidgetItem(QVariant(i->files.size()).toString()));
-			//
-			qApp->processEvents();
-			if (pb->wasCanceled()) return;
-		}
-	}
-	//
-	for (int x = 0; x < filenames_no_series_uid.size(); ++x)
-	{
-		const QString tmp1 = filenames_no_series_uid.at(x);
-		QString modality;
-		QString name;
-		QString birthdate;
-		QString study;
-		QString study_date;
-		QString series;
-		QString series_date;
-		bool is_image = false;
-		bool is_softcopy = false;
-		const int idx = tableWidget->rowCount();
-		QString ids;
-#if QT_VERSION >= QT_VERSION_CHECK(5,14,0)
-		ids = QString::asprintf("%010d", idx);
-#else
-		ids.sprintf("%010d", idx);
-#endif
-		TableWidgetItem * i = new TableWidgetItem(ids);
-		i->files.push_back(tmp1);
-		read_tags_(
-			tmp1,
-			name, birthdate,
-			modality,
-			study, study_date,
-			series, series_date,
-			&is_image, &is_softcopy);
-		tableWidget->setRowCount(idx + 1);
-		tableWidget->setItem(idx, 0, static_cast<QTableWidgetItem*>(i));
-		if (is_image)
+// Files with the same Series Instance UID in the same directory are
+// one row, a file without the UID is a row.
+// With 'check_files' a file already in its series is skipped,
+// the watch may read a file again.
+void BrowserWidget2::add_records(const std::vector<ScanRecord> & l, bool check_files)
+{
+	if (l.empty()) return;
+	for (size_t x = 0; x < l.size(); ++x)
+	{
+		const ScanRecord & r = l.at(x);
+		if (!r.ok) continue;
+		int icon = 0;
+		if (r.is_image)         icon = 1;
+		else if (r.is_softcopy) icon = 2;
+		int id = -1;
+		QString key;
+		if (!r.series_uid.isEmpty())
 		{
-			tableWidget->setItem(idx, 1, new QTableWidgetItem(eye_icon, QString("")));
+			key = r.file.left(r.file.lastIndexOf(QDir::separator()) + 1) + r.series_uid;
+			QHash<QString, int>::const_iterator it = scan_rows.constFind(key);
+			if (it != scan_rows.constEnd()) id = it.value();
 		}
-		else if (is_softcopy)
+		if (id >= 0)
 		{
-			tableWidget->setItem(idx, 1, new QTableWidgetItem(eye2_icon, QString("")));
+			if (check_files && model->has_file(id, r.file)) continue;
+			const int icon0 = model->get_icon(id);
+			if (icon == 1 || (icon == 2 && icon0 == 0)) model->set_icon(id, icon);
 		}
-		tableWidget->setItem(idx, 2, new QTableWidgetItem(modality));
-		tableWidget->setItem(idx, 3, new QTableWidgetItem(
-			DicomUtils::convert_pn_value(name.remove(QChar('\0')))));
-		tableWidget->setItem(idx, 4, new QTableWidgetItem(birthdate));
-		tableWidget->setItem(idx, 5, new QTableWidgetItem(study.remove(QChar('\0'))));
-		tableWidget->setItem(idx, 6, new QTableWidgetItem(study_date));
-		tableWidget->setItem(idx, 7, new QTableWidgetItem(series.remove(QChar('\0'))));
-		tableWidget->setItem(idx, 8, new QTableWidgetItem(series_date));
-		tableWidget->setItem(idx, 9, new QTableWidgetItem(QString("1")));
-		qApp->processEvents();
-		if (pb->wasCanceled()) return;
-	}
-	filenames.clear();
-	filenames_no_series_uid.clear();
-	//
-	if (!pb->wasCanceled())
-	{
-		for (int j = 0; j < dlist.size(); ++j)
+		else
 		{
-			process_directory(
-				dir.absolutePath() + QString("/") + dlist.at(j),
-				dict,
-				pb);
+			id = model->add_series(
+				r.modality,
+				r.patient,
+				r.birthdate,
+				r.study,
+				r.study_date,
+				r.series,
+				r.series_date,
+				icon);
+			if (!key.isEmpty()) scan_rows.insert(key, id);
 		}
+		model->add_file(id, r.file);
 	}
-	dlist.clear();
+	model->update();
+}
+
+void BrowserWidget2::clear_table()
+{
+#ifdef USE_WATCH_DIRECTORY
+	stop_watch();
+	watch_root.clear();
+#endif
+	model->clear();
+	scan_rows.clear();
 }
 
+#ifdef USE_WATCH_DIRECTORY
+void BrowserWidget2::start_watch()
+{
+	if (watcher || watch_root.isEmpty()) return;
+	watcher = new WatchDirectory_T(watch_root);
+	connect(watcher, SIGNAL(results_ready()), this, SLOT(process_watch_results()));
+	watcher->start();
+}
+
+void BrowserWidget2::stop_watch()
+{
+	if (!watcher) return;
+	watcher->cancel();
+	watcher->wait();
+	delete watcher;
+	watcher = nullptr;
+}
+
+// Held while a scan runs, read_directory() takes them after it.
+void BrowserWidget2::process_watch_results()
+{
+	if (!watcher || scanner) return;
+	std::vector<ScanRecord> l;
+	watcher->take_results(l);
+	add_records(l, true);
+}
+
+void BrowserWidget2::toggle_watch(bool t)
+{
+	if (t) start_watch();
+	else   stop_watch();
+}
+#endif
+
 void BrowserWidget2::open_dicom_dir()
 {
 	QFileInfo fi(directory_lineEdit->text());
@@ -536,8 +445,7 @@ void BrowserWidget2::dropEvent(QDropEvent * e)
 		}
 		else
 		{
-			tableWidget->clearContents();
-			tableWidget->setRowCount(0);
+			clear_table();
 		}
 	}
 }
@@ -635,24 +543,21 @@ void BrowserWidget2::reload_dir()
 	}
 	else
 	{
-		tableWidget->clearContents();
-		tableWidget->setRowCount(0);
+		clear_table();
 	}
 }
 
 QStringList BrowserWidget2::get_files_of_1st()
 {
-	const QList<QTableWidgetItem *> selected_items =
-		tableWidget->selectedItems();
-	if (selected_items.empty()) return QStringList();
-	if (!selected_items.at(0))  return QStringList();
-	const int current_row = selected_items.at(0)->row();
-	if (current_row < 0) return QStringList();
-	const TableWidgetItem * current_item =
-		static_cast<TableWidgetItem *>(tableWidget->item(current_row, 0));
-	if (!current_item) return QStringList();
-	if (current_item->files.empty()) return QStringList();
-	return current_item->files;
+	const QModelIndexList selection =
+		tableView->selectionModel()->selectedRows();
+	if (selection.empty()) return QStringList();
+	return model->get_files(selection.at(0).row());
+}
+
+QStringList BrowserWidget2::get_files(int row) const
+{
+	return model->get_files(row);
 }
 
 QString BrowserWidget2::get_root() const
@@ -679,7 +584,7 @@ void BrowserWidget2::copy_files()
 	static unsigned long long count2 = 0;
 	std::vector<int> rows;
 	QModelIndexList selection =
-		tableWidget->selectionModel()->selectedRows();
+		tableView->selectionModel()->selectedRows();
 	for(int x = 0; x < selection.count(); ++x)
 	{
 		const QModelIndex index = selection.at(x);
@@ -700,11 +605,9 @@ void BrowserWidget2::copy_files()
 	{
 		const int row = rows.at(x);
 		if (row < 0) continue;
-		const TableWidgetItem * item =
-			static_cast<TableWidgetItem *>(tableWidget->item(row, 0));
-		if (!item) continue;
-		if ((item->files.empty())) continue;
-		files << item->files;
+		const QStringList l = model->get_files(row);
+		if (l.empty()) continue;
+		files << l;
 	}
 	for (int x = 0; x < files.size(); ++x)
 	{
@@ -790,8 +693,7 @@ void BrowserWidget2::open_DICOMDIR()
 const QString BrowserWidget2::read_DICOMDIR(const QString & f)
 {
 	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-	tableWidget->clearContents();
-	tableWidget->setRowCount(0);
+	clear_table();
 	//
 	mdcm::Reader reader;
 #ifdef _WIN32
@@ -855,7 +757,7 @@ const QString BrowserWidget2::read_DICOMDIR(const QString & f)
 				&first_root_off);
 	}
 	//
-	std::set<mdcm::DataElement>::const_iterator it = ds.GetDES().cbegin();
+	mdcm::DataSet::ConstIterator it = ds.GetDES().cbegin();
 	while (it != ds.GetDES().cend())
 	{
 		if (it->GetTag() == tDirectoryRecordSequence)
@@ -1170,37 +1072,24 @@ const QString BrowserWidget2::read_DICOMDIR(const QString & f)
 	//
 	for (int x = 0; x < series.size(); ++x)
 	{
-		const int idx = tableWidget->rowCount();
-		QString ids;
-#if QT_VERSION >= QT_VERSION_CHECK(5,14,0)
-	 	ids = QString::asprintf("%010d", idx);
-#else
-	 	ids.sprintf("%010d", idx);
-#endif
-		TableWidgetItem * i = new TableWidgetItem(ids);
+		int icon = 0;
+		if (series.at(x).eye)       icon = 1;
+		else if (series.at(x).eye2) icon = 2;
+		const int id = model->add_series(
+			series.at(x).modality,
+			series.at(x).patient,
+			series.at(x).birthdate,
+			series.at(x).study,
+			series.at(x).study_date,
+			series.at(x).series,
+			series.at(x).series_date,
+			icon);
 		for (int z = 0; z < series.at(x).files.size(); ++z)
 		{
-			i->files.push_back(dir_ + QString("/") + series.at(x).files.at(z));
-		}
-		tableWidget->setRowCount(idx + 1);
-		tableWidget->setItem(idx, 0, static_cast<QTableWidgetItem*>(i));
-		if (series.at(x).eye)
-		{
-			tableWidget->setItem(idx, 1, new QTableWidgetItem(eye_icon, QString("")));
+			model->add_file(id, dir_ + QString("/") + series.at(x).files.at(z));
 		}
-		else if (series.at(x).eye2)
-		{
-			tableWidget->setItem(idx, 1, new QTableWidgetItem(eye2_icon, QString("")));
-		}
-		tableWidget->setItem(idx, 2, new QTableWidgetItem(series.at(x).modality));
-		tableWidget->setItem(idx, 3, new QTableWidgetItem(series.at(x).patient));
-		tableWidget->setItem(idx, 4, new QTableWidgetItem(series.at(x).birthdate));
-		tableWidget->setItem(idx, 5, new QTableWidgetItem(series.at(x).study));
-		tableWidget->setItem(idx, 6, new QTableWidgetItem(series.at(x).study_date));
-		tableWidget->setItem(idx, 7, new QTableWidgetItem(series.at(x).series));
-		tableWidget->setItem(idx, 8, new QTableWidgetItem(series.at(x).series_date));
-		tableWidget->setItem(idx, 9, new QTableWidgetItem(QVariant(i->files.size()).toString()));
 	}
+	model->update();
 	//
 	QApplication::restoreOverrideCursor();
 	//
@@ -1339,278 +1228,6 @@ unsigned int BrowserWidget2::add_file(
 	return e.offsetOfTheNextDirectoryRecord;
 }
 
-void BrowserWidget2::read_tags_(
-	const QString & f,
-	QString & patient_name_,
-	QString & birthdate_,
-	QString & modality_,
-	QString & studydesc_,
-	QString & study_date_,
-	QString & seriesdesc_,
-	QString & series_date_,
-	bool * is_image,
-	bool * is_softcopy)
-{
-	mdcm::Reader reader;
-#ifdef _WIN32
-#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-	reader.SetFileName(QDir::toNativeSeparators(f).toUtf8().constData());
-#else
-	reader.SetFileName(QDir::toNativeSeparators(f).toLocal8Bit().constData());
-#endif
-#else
-	reader.SetFileName(f.toLocal8Bit().constData());
-#endif
-	bool f_ok = reader.ReadSelectedTags(selected_tags);
-	if (!f_ok) return;
-	const mdcm::DataSet & ds = reader.GetFile().GetDataSet();
-	if (ds.IsEmpty()) return;
-	QString charset;
-	QString sop;
-	//
-	if (ds.FindDataElement(tSpecificCharacterSet))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tSpecificCharacterSet);
-		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
-		{
-			charset = QString::fromLatin1(
-				e.GetByteValue()->GetPointer(), e.GetByteValue()->GetLength());
-		}
-	}
-	//
-	if (ds.FindDataElement(tSOPClassUID))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tSOPClassUID);
-		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
-		{
-			sop = QString::fromLatin1(
-				e.GetByteValue()->GetPointer(),
-				e.GetByteValue()->GetLength()).trimmed().remove(QChar('\0'));
-		}
-	}
-	//
-	if (ds.FindDataElement(tStudyDate))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tStudyDate);
-		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
-		{
-			const QString date_s =
-				QString::fromLatin1(e.GetByteValue()->GetPointer(),
-									e.GetByteValue()->GetLength()).trimmed();
-			const QDate qd = QDate::fromString(date_s, QString("yyyyMMdd"));
-			study_date_ = qd.toString(QString("d MMM yyyy")) + QString("\n");
-		}
-	}
-	//
-	if (ds.FindDataElement(tModality))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tModality);
-		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
-		{
-			modality_ = QString::fromLatin1(
-				e.GetByteValue()->GetPointer(), e.GetByteValue()->GetLength());
-		}
-	}
-	//
-	if (ds.FindDataElement(tStudyDescription))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tStudyDescription);
-		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
-		{
-			QByteArray ba(e.GetByteValue()->GetPointer(), e.GetByteValue()->GetLength());
-			const QString tmp0 = CodecUtils::toUTF8(&ba, charset.toLatin1().constData());
-			if (!tmp0.isEmpty()) studydesc_ = tmp0.simplified();
-		}
-	}
-	//
-	if (ds.FindDataElement(tSeriesDescription))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tSeriesDescription);
-		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
-		{
-			QByteArray ba(e.GetByteValue()->GetPointer(), e.GetByteValue()->GetLength());
-			const QString tmp0 = CodecUtils::toUTF8(&ba, charset.toLatin1().constData());
-			if (!tmp0.isEmpty()) seriesdesc_ = tmp0.simplified();
-		}
-	}
-	//
-	if (ds.FindDataElement(tSeriesDate))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tSeriesDate);
-		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
-		{
-			const QString date_s = QString::fromLatin1(
-				e.GetByteValue()->GetPointer(),
-				e.GetByteValue()->GetLength()).trimmed();
-			const QDate qd = QDate::fromString(date_s, QString("yyyyMMdd"));
-			series_date_ = qd.toString(QString("d MMM yyyy")) + QString("\n");
-		}
-	}
-	//
-	if (ds.FindDataElement(tPatientsName))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tPatientsName);
-		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
-		{
-			QByteArray ba(e.GetByteValue()->GetPointer(), e.GetByteValue()->GetLength());
-			const QString tmp0 = CodecUtils::toUTF8(&ba, charset.toLatin1().constData());
-			if (!tmp0.isEmpty()) patient_name_ = tmp0;
-		}
-	}
-	//
-	if (ds.FindDataElement(tPatientsBirthDate))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tPatientsBirthDate);
-		std::stringstream ss;
-		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
-		{
-			const QString birthdate_s = QString::fromLatin1(
-				e.GetByteValue()->GetPointer(),
-				e.GetByteValue()->GetLength()).trimmed();
-			const QDate qd = QDate::fromString(birthdate_s, QString("yyyyMMdd"));
-			birthdate_ = qd.toString(QString("d MMM yyyy")) + QString("\n");
-		}
-	}
-	//
-	bool has_rows         = false;
-	bool has_colums       = false;
-	bool has_bitallocated = false;
-	if (ds.FindDataElement(tRows))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tRows);
-		if (!e.IsEmpty()) has_rows = true;
-	}
-	if (ds.FindDataElement(tColumns))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tColumns);
-		if (!e.IsEmpty()) has_colums = true;
-	}
-	if (ds.FindDataElement(tBitsAllocated))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tBitsAllocated);
-		if (!e.IsEmpty()) has_bitallocated = true;
-	}
-	bool is_image_tmp = has_rows && has_colums && has_bitallocated;
-	//
-	// RTSTRUCT, spectroscopy, meshes
-	if (sop == QString("1.2.840.10008.5.1.4.1.1.481.3") ||
-		sop == QString("1.2.840.10008.5.1.4.1.1.4.2")   ||
-		sop == QString("1.2.840.10008.5.1.4.1.1.68.1")  ||
-		sop == QString("1.2.840.10008.5.1.4.1.1.66.5"))
-	{
-		is_image_tmp = true;
-	}
-	*is_image = is_image_tmp;
-	// Presentation, SR
-	if (   sop == QString("1.2.840.10008.5.1.4.1.1.11.1")  // Grayscale Softcopy Presentation State Storage
-#if 0
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.2")  // Color Softcopy Presentation State Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.3")  // Pseudo-Color Softcopy Presentation State Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.4")  // Blending Softcopy Presentation State Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.5")  // XA/XRF Grayscale Softcopy Presentation State Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.6")  // Grayscale Planar MPR Volumetric Presentation State Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.7")  // Compositing Planar MPR Volumetric Presentation State Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.8")  // Advanced Blending Presentation State Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.9")  // Volume Rendering Volumetric Presentation State Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.10") // Segmented Volume Rendering Volumetric Presentation State Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.11") // Multiple Volume Rendering Volumetric Presentation State Storage
-#endif
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.11") // Basic Text SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.22") // Enhanced SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.33") // Comprehensive SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.34") // Comprehensive 3D SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.35") // Extensible SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.40") // Procedure Log Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.50") // Mammography CAD SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.59") // Key Object Selection Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.65") // Chest CAD SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.67") // X-Ray Radiation Dose SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.68") // Radiopharmaceutical Radiation Dose SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.69") // Colon CAD SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.70") // Implantation Plan SR Document Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.71") // Acquisition Context SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.72") // Simplified Adult Echo SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.73") // Patient Radiation Dose SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.74") // Planned Imaging Agent Administration SR Storage
-		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.75") // Performed Imaging Agent Administration SR Storage
-		)
-		{
-			*is_softcopy = true;
-		}
-}
-
-void BrowserWidget2::read_tags_short_(
-	const QString & f,
-	bool * is_image,
-	bool * is_softcopy)
-{
-	mdcm::Reader reader;
-#ifdef _WIN32
-#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-	reader.SetFileName(QDir::toNativeSeparators(f).toUtf8().constData());
-#else
-	reader.SetFileName(QDir::toNativeSeparators(f).toLocal8Bit().constData());
-#endif
-#else
-	reader.SetFileName(f.toLocal8Bit().constData());
-#endif
-	bool f_ok = reader.ReadSelectedTags(selected_tags_short);
-	if (!f_ok) return;
-	const mdcm::DataSet & ds = reader.GetFile().GetDataSet();
-	if (ds.IsEmpty()) return;
-	bool has_rows         = false;
-	bool has_colums       = false;
-	bool has_bitallocated = false;
-	bool has_pixelrepres  = false;
-	if (ds.FindDataElement(tRows))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tRows);
-		if (!e.IsEmpty()) has_rows = true;
-	}
-	if (ds.FindDataElement(tColumns))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tColumns);
-		if (!e.IsEmpty()) has_colums = true;
-	}
-	if (ds.FindDataElement(tBitsAllocated))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tBitsAllocated);
-		if (!e.IsEmpty()) has_bitallocated = true;
-	}
-	if (ds.FindDataElement(tPixelRepresentation))
-	{
-		const mdcm::DataElement & e = ds.GetDataElement(tPixelRepresentation);
-		if (!e.IsEmpty()) has_pixelrepres = true;
-	}
-	bool is_image_tmp = has_rows && has_colums && has_bitallocated && has_pixelrepres;
-	if (!is_image_tmp)
-	{
-		if (ds.FindDataElement(tSOPClassUID))
-		{
-			const mdcm::DataElement & e = ds.GetDataElement(tSOPClassUID);
-			if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
-			{
-				const QString sop =
-					QString::fromLatin1(
-						e.GetByteValue()->GetPointer(),
-						e.GetByteValue()->GetLength()).trimmed().remove(QChar('\0'));
-				// RTSTRUCT
-				if (sop == QString("1.2.840.10008.5.1.4.1.1.481.3"))
-				{
-					is_image_tmp = true;
-				}
-				// Softcopy
-				else if (sop == QString("1.2.840.10008.5.1.4.1.1.11.1") ||
-					sop == QString("1.2.840.10008.5.1.4.1.1.11.2"))
-				{
-					*is_softcopy = true;
-				}
-			}
-		}
-	}
-	*is_image = is_image_tmp;
-}
-
 void BrowserWidget2::writeSettings(QSettings & settings)
 {
 #ifdef USE_WORKSTATION_MODE
@@ -1697,8 +1314,7 @@ void BrowserWidget2::readSettings()
 void BrowserWidget2::open_CTK_db()
 {
 	if (!once) once = true;
-	tableWidget->clearContents();
-	tableWidget->setRowCount(0);
+	clear_table();
 	directory_lineEdit->clear();
 	QString warning;
 	bool ok = false;
@@ -1931,14 +1547,15 @@ void BrowserWidget2::open_CTK_db()
 	}
 	for (int x = 0; x < series.size(); ++x)
 	{
-		const int idx = tableWidget->rowCount();
-		QString idxs;
-#if QT_VERSION >= QT_VERSION_CHECK(5,14,0)
-		idxs = QString::asprintf("%010d", idx);
-#else
-		idxs.sprintf("%010d", idx);
-#endif
-		TableWidgetItem * i = new TableWidgetItem(idxs);
+		const int id = model->add_series(
+			series.at(x).modality,
+			series.at(x).patient,
+			series.at(x).birthdate,
+			series.at(x).study,
+			series.at(x).study_date,
+			series.at(x).series,
+			series.at(x).series_date,
+			0);
 		for (int z = 0; z < series.at(x).files.size(); ++z)
 		{
 			QString f = series.at(x).files.at(z);
@@ -1958,25 +1575,10 @@ void BrowserWidget2::open_CTK_db()
 				std::cout << "File not found: " << f1.toStdString() << std::endl;
 #endif
 			}
-			i->files.push_back(QDir::toNativeSeparators(f1));
+			model->add_file(id, QDir::toNativeSeparators(f1));
 		}
-		tableWidget->setRowCount(idx + 1);
-		tableWidget->setItem(idx, 0, static_cast<QTableWidgetItem*>(i));
-#if 0
-		if (series.at(x).eye)
-			tableWidget->setItem(idx, 1, new QTableWidgetItem(eye_icon, QString("")));
-		else if (series.at(x).eye2)
-			tableWidget->setItem(idx, 1, new QTableWidgetItem(eye2_icon, QString("")));
-#endif
-		tableWidget->setItem(idx, 2, new QTableWidgetItem(series.at(x).modality));
-		tableWidget->setItem(idx, 3, new QTableWidgetItem(series.at(x).patient));
-		tableWidget->setItem(idx, 4, new QTableWidgetItem(series.at(x).birthdate));
-		tableWidget->setItem(idx, 5, new QTableWidgetItem(series.at(x).study));
-		tableWidget->setItem(idx, 6, new QTableWidgetItem(series.at(x).study_date));
-		tableWidget->setItem(idx, 7, new QTableWidgetItem(series.at(x).series));
-		tableWidget->setItem(idx, 8, new QTableWidgetItem(series.at(x).series_date));
-		tableWidget->setItem(idx, 9, new QTableWidgetItem(QVariant(i->files.size()).toString()));
 	}
+	model->update();
 	db.close();
 quit__:
 	QApplication::restoreOverrideCursor();
@@ -14,33 +14,18 @@
 #include <QSettings>
 #include <QShortcut>
 #include <QProgressDialog>
-#include <set>
+#include <QHash>
+#include <vector>
 #include <mdcmTag.h>
 #include <mdcmVL.h>
-#include <mdcmSimpleSubjectWatcher.h>
-#include <mdcmEvent.h>
 #include <mdcmDataSet.h>
-#include <mdcmDict.h>
 
-class ScannerWatcher : public mdcm::SimpleSubjectWatcher
-{
-public:
-	ScannerWatcher(mdcm::Subject * s, const char * comment = "")
-		: mdcm::SimpleSubjectWatcher(s, comment) {}
-	void StartFilter() override
-	{
-		QApplication::processEvents();
-	}
-	void EndFilter() override
-	{
-		QApplication::processEvents();
-	}
-	void ShowProgress(mdcm::Subject*, const mdcm::Event&) override
-	{
-		QApplication::processEvents();
-	}
-	void ShowFileName(mdcm::Subject*, const mdcm::Event&) override {}
-};
+class ScanDirectory_T;
+class ScanRecord;
+class SeriesTableModel;
+#ifdef USE_WATCH_DIRECTORY
+class WatchDirectory_T;
+#endif
 
 class EntryDICOMDIR
 {
@@ -74,26 +59,16 @@ public:
 	QStringList files;
 };
 
-class TableWidgetItem : public QTableWidgetItem
-{
-public:
-	TableWidgetItem()
-		: QTableWidgetItem(QTableWidgetItem::UserType + 1) {}
-	TableWidgetItem(const QString & s)
-		: QTableWidgetItem(s, QTableWidgetItem::UserType + 1) {}
-	~TableWidgetItem() = default;
-	QStringList files;
-};
-
 class BrowserWidget2: public QWidget, public Ui::BrowserWidget2
 {
 Q_OBJECT
 public:
 	BrowserWidget2(float);
-	~BrowserWidget2() = default;
+	~BrowserWidget2();
 	bool          is_first_run() const;
 	const QString read_DICOMDIR(const QString&);
 	QStringList   get_files_of_1st();
+	QStringList   get_files(int) const;
 	void          writeSettings(QSettings&);
 	QString       get_root() const;
 
@@ -117,22 +92,35 @@ public slots:
 	void open_CTK_db();
 #endif
 
+private slots:
+	void process_scan_results();
+#ifdef USE_WATCH_DIRECTORY
+	void process_watch_results();
+	void toggle_watch(bool);
+#endif
+
 private:
 	bool once{};
 	QString saved_copy_dir;
 	QIcon eye_icon;
 	QIcon eye2_icon;
-	std::set<mdcm::Tag> selected_tags;
-	std::set<mdcm::Tag> selected_tags_short;
+	SeriesTableModel * model{};
+	ScanDirectory_T * scanner{};
+	QProgressDialog * scan_pb{};
+	QHash<QString, int> scan_rows;
+#ifdef USE_WATCH_DIRECTORY
+	WatchDirectory_T * watcher{};
+	QString watch_root;
+	void start_watch();
+	void stop_watch();
+#endif
+	void clear_table();
+	void add_records(const std::vector<ScanRecord>&, bool = false);
 	mdcm::VL compute_offset0(const mdcm::DataSet&);
 	void compute_offsets(
 		const mdcm::SequenceOfItems*,
 		mdcm::VL,
 		std::vector<unsigned int> &);
-	void process_directory(
-		const QString&,
-		const mdcm::Dict&,
-		QProgressDialog*);
 	unsigned int add_roots(
 		const QMap<unsigned int, EntryDICOMDIR> &,
 		unsigned int,
@@ -158,12 +146,6 @@ private:
 		const QMap<unsigned int, EntryDICOMDIR> &,
 		unsigned int,
 		SeriesDICOMDIR&);
-	void read_tags_(
-		const QString &,
-		QString&,QString&,QString&,
-		QString&,QString&,QString&,QString&,
-		bool*,bool*);
-	void read_tags_short_(const QString&, bool*, bool*);
 #ifdef USE_WORKSTATION_MODE
 	QString ctk_dir;
 	QString ctk_pname;
@@ -0,0 +1,416 @@
+#include "scandirectory_t.h"
+#include <QDir>
+#include <QDate>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QByteArray>
+#include <QStringList>
+#include <mdcmReader.h>
+#include <mdcmDataSet.h>
+#include <mdcmTag.h>
+#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
+#include <mdcmSystem.h>
+#endif
+#include "codecutils.h"
+#include "dicomutils.h"
+#ifdef USE_WORKSTATION_MODE
+#include "scanindex.h"
+#endif
+#include <chrono>
+#include <fstream>
+#include <set>
+#include <thread>
+#include <exception>
+
+namespace
+{
+
+const mdcm::Tag tSpecificCharacterSet(0x0008,0x0005);
+const mdcm::Tag tSOPClassUID         (0x0008,0x0016);
+const mdcm::Tag tStudyDate           (0x0008,0x0020);
+const mdcm::Tag tSeriesDate          (0x0008,0x0021);
+const mdcm::Tag tModality            (0x0008,0x0060);
+const mdcm::Tag tStudyDescription    (0x0008,0x1030);
+const mdcm::Tag tSeriesDescription   (0x0008,0x103e);
+const mdcm::Tag tPatientsName        (0x0010,0x0010);
+const mdcm::Tag tPatientsBirthDate   (0x0010,0x0030);
+const mdcm::Tag tSeriesInstanceUID   (0x0020,0x000e);
+const mdcm::Tag tRows                (0x0028,0x0010);
+const mdcm::Tag tColumns             (0x0028,0x0011);
+const mdcm::Tag tBitsAllocated       (0x0028,0x0100);
+
+// Records are sent to the UI in batches of at least this size,
+// smaller batches are sent after each directory and at the end.
+constexpr size_t batch_size = 256;
+
+QString get_latin1_value(const mdcm::DataSet & ds, const mdcm::Tag & t)
+{
+	if (ds.FindDataElement(t))
+	{
+		const mdcm::DataElement & e = ds.GetDataElement(t);
+		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
+		{
+			return QString::fromLatin1(
+				e.GetByteValue()->GetPointer(),
+				e.GetByteValue()->GetLength());
+		}
+	}
+	return QString();
+}
+
+QString get_text_value(
+	const mdcm::DataSet & ds,
+	const mdcm::Tag & t,
+	const QString & charset)
+{
+	if (ds.FindDataElement(t))
+	{
+		const mdcm::DataElement & e = ds.GetDataElement(t);
+		if (!e.IsEmpty() && !e.IsUndefinedLength() && e.GetByteValue())
+		{
+			QByteArray ba(e.GetByteValue()->GetPointer(), e.GetByteValue()->GetLength());
+			return CodecUtils::toUTF8(&ba, charset.toLatin1().constData());
+		}
+	}
+	return QString();
+}
+
+QString get_date_value(const mdcm::DataSet & ds, const mdcm::Tag & t)
+{
+	const QString date_s = get_latin1_value(ds, t).trimmed();
+	if (date_s.isEmpty()) return QString();
+	const QDate qd = QDate::fromString(date_s, QString("yyyyMMdd"));
+	return qd.toString(QString("d MMM yyyy")) + QString("\n");
+}
+
+bool has_value(const mdcm::DataSet & ds, const mdcm::Tag & t)
+{
+	if (ds.FindDataElement(t))
+	{
+		const mdcm::DataElement & e = ds.GetDataElement(t);
+		if (!e.IsEmpty()) return true;
+	}
+	return false;
+}
+
+bool is_image_sop(const QString & sop)
+{
+	// RTSTRUCT, spectroscopy, meshes
+	return (sop == QString("1.2.840.10008.5.1.4.1.1.481.3") ||
+		sop == QString("1.2.840.10008.5.1.4.1.1.4.2")   ||
+		sop == QString("1.2.840.10008.5.1.4.1.1.68.1")  ||
+		sop == QString("1.2.840.10008.5.1.4.1.1.66.5"));
+}
+
+bool is_softcopy_sop(const QString & sop)
+{
+	// Presentation, SR
+	return (sop == QString("1.2.840.10008.5.1.4.1.1.11.1")  // Grayscale Softcopy Presentation State Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.11.2")  // Color Softcopy Presentation State Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.11") // Basic Text SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.22") // Enhanced SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.33") // Comprehensive SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.34") // Comprehensive 3D SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.35") // Extensible SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.40") // Procedure Log Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.50") // Mammography CAD SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.59") // Key Object Selection Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.65") // Chest CAD SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.67") // X-Ray Radiation Dose SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.68") // Radiopharmaceutical Radiation Dose SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.69") // Colon CAD SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.70") // Implantation Plan SR Document Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.71") // Acquisition Context SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.72") // Simplified Adult Echo SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.73") // Patient Radiation Dose SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.74") // Planned Imaging Agent Administration SR Storage
+		|| sop == QString("1.2.840.10008.5.1.4.1.1.88.75") // Performed Imaging Agent Administration SR Storage
+		);
+}
+
+}
+
+ScanDirectory_T::ScanDirectory_T(
+	const QString & root_,
+	int threads_,
+	const QString & index_file_)
+	:
+	root(root_),
+	threads(threads_ > 1 ? threads_ : 1),
+	index_file(index_file_)
+{
+}
+
+// One pass over the file, all values needed by the table are read.
+void ScanDirectory_T::read_record(const QString & f, ScanRecord & r)
+{
+	static const std::set<mdcm::Tag> tags
+	{
+		tSpecificCharacterSet,
+		tSOPClassUID,
+		tStudyDate,
+		tSeriesDate,
+		tModality,
+		tStudyDescription,
+		tSeriesDescription,
+		tPatientsName,
+		tPatientsBirthDate,
+		tSeriesInstanceUID,
+		tRows,
+		tColumns,
+		tBitsAllocated
+	};
+	r.ok = false;
+	// The file is opened once, other files than DICOM are rejected
+	// after few bytes, without parsing.
+	std::ifstream fs;
+#ifdef _WIN32
+#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
+	const std::wstring uncpath =
+		mdcm::System::ConvertToUtf16((QDir::toNativeSeparators(f)).toUtf8().constData());
+	fs.open(uncpath.c_str(), std::ios::in | std::ios::binary);
+#else
+	fs.open((QDir::toNativeSeparators(f)).toLocal8Bit().constData(), std::ios::in | std::ios::binary);
+#endif
+#else
+	fs.open(f.toLocal8Bit().constData(), std::ios::in | std::ios::binary);
+#endif
+	if (!fs.is_open()) return;
+	if (!DicomUtils::is_dicom_stream(fs)) return;
+	fs.clear();
+	fs.seekg(0, std::ios_base::beg);
+	mdcm::Reader reader;
+	reader.SetStream(fs);
+	if (!reader.ReadSelectedTags(tags)) return;
+	r.ok = true;
+	const mdcm::DataSet & ds = reader.GetFile().GetDataSet();
+	if (ds.IsEmpty()) return;
+	const QString charset = get_latin1_value(ds, tSpecificCharacterSet);
+	const QString sop =
+		get_latin1_value(ds, tSOPClassUID).trimmed().remove(QChar('\0'));
+	r.series_uid =
+		get_latin1_value(ds, tSeriesInstanceUID).trimmed().remove(QChar('\0'));
+	r.modality    = get_latin1_value(ds, tModality);
+	r.study_date  = get_date_value(ds, tStudyDate);
+	r.series_date = get_date_value(ds, tSeriesDate);
+	r.birthdate   = get_date_value(ds, tPatientsBirthDate);
+	r.study  = get_text_value(ds, tStudyDescription,  charset).simplified().remove(QChar('\0'));
+	r.series = get_text_value(ds, tSeriesDescription, charset).simplified().remove(QChar('\0'));
+	QString name = get_text_value(ds, tPatientsName, charset);
+	r.patient = DicomUtils::convert_pn_value(name.remove(QChar('\0')));
+	r.is_image =
+		(has_value(ds, tRows) && has_value(ds, tColumns) && has_value(ds, tBitsAllocated)) ||
+		is_image_sop(sop);
+	r.is_softcopy = is_softcopy_sop(sop);
+}
+
+void ScanDirectory_T::run()
+{
+#ifdef USE_WORKSTATION_MODE
+	ScanIndex index;
+	if (!root.isEmpty() && index.open(index_file))
+	{
+		use_index = true;
+		index.load(
+			QDir::toNativeSeparators(QDir(root).absolutePath() + QString("/")),
+			indexed);
+	}
+#endif
+	std::vector<std::thread> workers;
+	for (int x = 0; x < threads; ++x)
+	{
+		try
+		{
+			workers.push_back(std::thread(&ScanDirectory_T::work, this));
+		}
+		catch (const std::exception &)
+		{
+			break;
+		}
+	}
+	walk(root);
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		walk_done = true;
+	}
+	queue_cv.notify_all();
+	if (workers.empty())
+	{
+		work();
+	}
+	else
+	{
+		// Small batches are sent while the last files are read.
+		while (!canceled.load() && count_read.load() < count_found.load())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			flush();
+		}
+		for (size_t x = 0; x < workers.size(); ++x)
+		{
+			workers[x].join();
+		}
+	}
+	flush();
+#ifdef USE_WORKSTATION_MODE
+	if (use_index)
+	{
+		// Files of the index not found in a complete walk were removed.
+		index.store(to_index);
+		if (!canceled.load()) index.remove(indexed.keys());
+	}
+#endif
+}
+
+void ScanDirectory_T::walk(const QString & p)
+{
+	if (canceled.load() || p.isEmpty()) return;
+	QDir dir(p);
+	const QStringList dlist = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+	const QFileInfoList flist = dir.entryInfoList(QDir::Files | QDir::Readable, QDir::Name);
+	const QString path = dir.absolutePath() + QString("/");
+	for (int x = 0; x < flist.size(); ++x)
+	{
+		if (canceled.load()) return;
+		const QFileInfo & fi = flist.at(x);
+		Job j;
+		j.index = count_found.load();
+		j.size = fi.size();
+		j.mtime = fi.lastModified().toMSecsSinceEpoch();
+		j.file = QDir::toNativeSeparators(path + fi.fileName());
+		if (use_index)
+		{
+			QHash<QString, ScanRecord>::iterator it = indexed.find(j.file);
+			if (it != indexed.end())
+			{
+				if (it.value().size == j.size && it.value().mtime == j.mtime)
+				{
+					ScanRecord r = it.value();
+					indexed.erase(it);
+					r.index = j.index;
+					++count_found;
+					++count_indexed;
+					release(r);
+					++count_read;
+					continue;
+				}
+				indexed.erase(it);
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			queue.push_back(std::move(j));
+		}
+		queue_cv.notify_one();
+		++count_found;
+	}
+	flush();
+	for (int x = 0; x < dlist.size(); ++x)
+	{
+		walk(path + dlist.at(x));
+	}
+}
+
+void ScanDirectory_T::work()
+{
+	while (true)
+	{
+		Job j;
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			queue_cv.wait(lock, [this]() { return (!queue.empty() || walk_done || canceled.load()); });
+			if (canceled.load() || queue.empty()) return;
+			j = std::move(queue.front());
+			queue.pop_front();
+		}
+		ScanRecord r;
+		r.index = j.index;
+		r.size = j.size;
+		r.mtime = j.mtime;
+		r.file = j.file;
+		try
+		{
+			read_record(j.file, r);
+		}
+		catch (...)
+		{
+			r.ok = false;
+		}
+		if (use_index)
+		{
+			std::lock_guard<std::mutex> lock(results_mutex);
+			to_index.push_back(r);
+		}
+		release(r);
+		++count_read;
+	}
+}
+
+// Records are kept until all files found before are read.
+void ScanDirectory_T::release(ScanRecord & r)
+{
+	bool full = false;
+	{
+		std::lock_guard<std::mutex> lock(results_mutex);
+		if (r.index == next_index)
+		{
+			ready.push_back(std::move(r));
+			++next_index;
+			std::map<unsigned long long, ScanRecord>::iterator it = pending.begin();
+			while (it != pending.end() && it->first == next_index)
+			{
+				ready.push_back(std::move(it->second));
+				it = pending.erase(it);
+				++next_index;
+			}
+		}
+		else
+		{
+			pending.insert(std::make_pair(r.index, std::move(r)));
+		}
+		full = ready.size() >= batch_size;
+	}
+	if (full) flush();
+}
+
+void ScanDirectory_T::flush()
+{
+	{
+		std::lock_guard<std::mutex> lock(results_mutex);
+		if (ready.empty() || notified) return;
+		notified = true;
+	}
+	emit results_ready();
+}
+
+void ScanDirectory_T::take_results(std::vector<ScanRecord> & l)
+{
+	std::lock_guard<std::mutex> lock(results_mutex);
+	if (l.empty()) l.swap(ready);
+	else l.insert(l.end(), ready.begin(), ready.end());
+	ready.clear();
+	notified = false;
+}
+
+unsigned long long ScanDirectory_T::get_count_found() const
+{
+	return count_found.load();
+}
+
+unsigned long long ScanDirectory_T::get_count_read() const
+{
+	return count_read.load();
+}
+
+unsigned long long ScanDirectory_T::get_count_indexed() const
+{
+	return count_indexed.load();
+}
+
+void ScanDirectory_T::cancel()
+{
+	canceled.store(true);
+	std::lock_guard<std::mutex> lock(queue_mutex);
+	queue_cv.notify_all();
+}
+
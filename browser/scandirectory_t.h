@@ -0,0 +1,96 @@
+#ifndef A_SCANDIRECTORY_T_H
+#define A_SCANDIRECTORY_T_H
+
+#include <QThread>
+#include <QString>
+#include <QHash>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Values of one file for the browser table, 'ok' is false if the file
+// could not be read.
+class ScanRecord
+{
+public:
+	unsigned long long index{};
+	qint64  size{};
+	qint64  mtime{};
+	bool    ok{};
+	bool    is_image{};
+	bool    is_softcopy{};
+	QString file;
+	QString series_uid;
+	QString modality;
+	QString patient;
+	QString birthdate;
+	QString study;
+	QString study_date;
+	QString series;
+	QString series_date;
+};
+
+// Recursive scan of a directory. The thread walks the tree (files of a
+// directory sorted by name, then sub-directories) and a pool of worker
+// threads reads the selected tags of each file once. Records are
+// released in walk order, results_ready() is emitted for a new batch,
+// take_results() moves the batch out.
+// With an index file, files with the same size and modification time
+// as in the index are not read again, the index is updated at the end.
+class ScanDirectory_T : public QThread
+{
+Q_OBJECT
+public:
+	ScanDirectory_T(const QString&, int, const QString& = QString());
+	~ScanDirectory_T() = default;
+	void run() override;
+	void take_results(std::vector<ScanRecord>&);
+	unsigned long long get_count_found() const;
+	unsigned long long get_count_read() const;
+	unsigned long long get_count_indexed() const;
+	static void read_record(const QString&, ScanRecord&);
+
+public slots:
+	void cancel();
+
+signals:
+	void results_ready();
+
+private:
+	struct Job
+	{
+		unsigned long long index;
+		qint64 size;
+		qint64 mtime;
+		QString file;
+	};
+	void walk(const QString&);
+	void work();
+	void release(ScanRecord&);
+	void flush();
+	const QString root;
+	const int threads;
+	const QString index_file;
+	bool use_index{};
+	QHash<QString, ScanRecord> indexed;
+	std::vector<ScanRecord> to_index;
+	std::atomic<bool> canceled{};
+	std::atomic<unsigned long long> count_found{};
+	std::atomic<unsigned long long> count_read{};
+	std::atomic<unsigned long long> count_indexed{};
+	std::mutex queue_mutex;
+	std::condition_variable queue_cv;
+	std::deque<Job> queue;
+	bool walk_done{};
+	std::mutex results_mutex;
+	std::map<unsigned long long, ScanRecord> pending;
+	std::vector<ScanRecord> ready;
+	unsigned long long next_index{};
+	bool notified{};
+};
+
+#endif
+
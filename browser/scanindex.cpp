@@ -0,0 +1,184 @@
+#include "scanindex.h"
+#include <QApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace
+{
+
+// Increment if the table or the format of values change,
+// an index of other version is dropped.
+const int index_version = 1;
+
+}
+
+ScanIndex::~ScanIndex()
+{
+	close();
+}
+
+bool ScanIndex::open(const QString & f)
+{
+	close();
+	if (f.isEmpty()) return false;
+	connection =
+		QString("ScanIndex") +
+		QString::number(reinterpret_cast<quintptr>(this));
+	bool ok = false;
+	{
+		QSqlDatabase db = QSqlDatabase::addDatabase(QString("QSQLITE"), connection);
+		db.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=5000"));
+		db.setDatabaseName(f);
+		if (db.open())
+		{
+			QSqlQuery q(db);
+			int version = 0;
+			if (q.exec(QString("pragma user_version")) && q.next())
+			{
+				version = q.value(0).toInt();
+			}
+			q.finish();
+			ok = true;
+			if (version != index_version)
+			{
+				ok = q.exec(QString("drop table if exists files")) &&
+					q.exec(QString(
+						"create table files ("
+						"path text primary key,"
+						"size integer,"
+						"mtime integer,"
+						"ok integer,"
+						"is_image integer,"
+						"is_softcopy integer,"
+						"series_uid text,"
+						"modality text,"
+						"patient text,"
+						"birthdate text,"
+						"study text,"
+						"study_date text,"
+						"series text,"
+						"series_date text)")) &&
+					q.exec(QString("pragma user_version = ") + QString::number(index_version));
+			}
+		}
+	}
+	if (!ok) close();
+	return ok;
+}
+
+void ScanIndex::close()
+{
+	if (connection.isEmpty()) return;
+	{
+		QSqlDatabase db = QSqlDatabase::database(connection, false);
+		if (db.isOpen()) db.close();
+	}
+	QSqlDatabase::removeDatabase(connection);
+	connection.clear();
+}
+
+// Loads the files with the path starting with 'prefix'.
+void ScanIndex::load(const QString & prefix, QHash<QString, ScanRecord> & h)
+{
+	if (connection.isEmpty() || prefix.isEmpty()) return;
+	QSqlDatabase db = QSqlDatabase::database(connection, false);
+	// SQLite compares text as bytes, all paths with the prefix
+	// are in the range [prefix, prefix with the last char + 1).
+	QString upper = prefix;
+	upper[upper.size() - 1] = QChar(upper.at(upper.size() - 1).unicode() + 1);
+	QSqlQuery q(db);
+	q.setForwardOnly(true);
+	q.prepare(QString(
+		"select path,size,mtime,ok,is_image,is_softcopy,series_uid,modality,"
+		"patient,birthdate,study,study_date,series,series_date"
+		" from files where path >= ? and path < ?"));
+	q.addBindValue(prefix);
+	q.addBindValue(upper);
+	if (!q.exec()) return;
+	while (q.next())
+	{
+		ScanRecord r;
+		r.file        = q.value(0).toString();
+		r.size        = q.value(1).toLongLong();
+		r.mtime       = q.value(2).toLongLong();
+		r.ok          = (q.value(3).toInt() != 0);
+		r.is_image    = (q.value(4).toInt() != 0);
+		r.is_softcopy = (q.value(5).toInt() != 0);
+		r.series_uid  = q.value(6).toString();
+		r.modality    = q.value(7).toString();
+		r.patient     = q.value(8).toString();
+		r.birthdate   = q.value(9).toString();
+		r.study       = q.value(10).toString();
+		r.study_date  = q.value(11).toString();
+		r.series      = q.value(12).toString();
+		r.series_date = q.value(13).toString();
+		h.insert(r.file, r);
+	}
+}
+
+void ScanIndex::store(const std::vector<ScanRecord> & l)
+{
+	if (connection.isEmpty() || l.empty()) return;
+	QSqlDatabase db = QSqlDatabase::database(connection, false);
+	if (!db.transaction()) return;
+	{
+		QSqlQuery q(db);
+		q.prepare(QString(
+			"insert or replace into files values (?,?,?,?,?,?,?,?,?,?,?,?,?,?)"));
+		for (size_t x = 0; x < l.size(); ++x)
+		{
+			const ScanRecord & r = l.at(x);
+			q.addBindValue(r.file);
+			q.addBindValue(r.size);
+			q.addBindValue(r.mtime);
+			q.addBindValue(r.ok ? 1 : 0);
+			q.addBindValue(r.is_image ? 1 : 0);
+			q.addBindValue(r.is_softcopy ? 1 : 0);
+			q.addBindValue(r.series_uid);
+			q.addBindValue(r.modality);
+			q.addBindValue(r.patient);
+			q.addBindValue(r.birthdate);
+			q.addBindValue(r.study);
+			q.addBindValue(r.study_date);
+			q.addBindValue(r.series);
+			q.addBindValue(r.series_date);
+			q.exec();
+		}
+	}
+	db.commit();
+}
+
+void ScanIndex::remove(const QStringList & l)
+{
+	if (connection.isEmpty() || l.empty()) return;
+	QSqlDatabase db = QSqlDatabase::database(connection, false);
+	if (!db.transaction()) return;
+	{
+		QSqlQuery q(db);
+		q.prepare(QString("delete from files where path = ?"));
+		for (int x = 0; x < l.size(); ++x)
+		{
+			q.addBindValue(l.at(x));
+			q.exec();
+		}
+	}
+	db.commit();
+}
+
+// Next to the settings file, call in the GUI thread.
+QString ScanIndex::default_file()
+{
+	const QSettings settings(
+		QSettings::IniFormat,
+		QSettings::UserScope,
+		QApplication::organizationName(),
+		QApplication::applicationName());
+	const QFileInfo fi(settings.fileName());
+	if (!QDir().mkpath(fi.absolutePath())) return QString();
+	return fi.absolutePath() + QString("/") + fi.completeBaseName() + QString("-scanindex.sqlite");
+}
+
@@ -0,0 +1,31 @@
+#ifndef A_SCANINDEX_H
+#define A_SCANINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <vector>
+#include "scandirectory_t.h"
+
+// SQLite index of scanned files, the values of the browser table per
+// file with its size and modification time, so a rescan reads only new
+// or changed files. An object must be used in one thread, the thread
+// which opened it.
+class ScanIndex
+{
+public:
+	ScanIndex() = default;
+	~ScanIndex();
+	bool open(const QString&);
+	void close();
+	void load(const QString&, QHash<QString, ScanRecord>&);
+	void store(const std::vector<ScanRecord>&);
+	void remove(const QStringList&);
+	static QString default_file();
+
+private:
+	QString connection;
+};
+
+#endif
+
@@ -0,0 +1,533 @@
+#include "seriestablemodel.h"
+#include <QDate>
+#include <algorithm>
+
+namespace
+{
+
+// New or changed series up to this number are inserted or moved at
+// the sorted position, for more all rows are sorted.
+constexpr size_t insert_max = 64;
+
+}
+
+SeriesTableModel::SeriesTableModel(QObject * p)
+	: QAbstractTableModel(p)
+{
+	intern(QString(""));
+}
+
+int SeriesTableModel::rowCount(const QModelIndex & p) const
+{
+	if (p.isValid()) return 0;
+	return static_cast<int>(rows.size());
+}
+
+int SeriesTableModel::columnCount(const QModelIndex & p) const
+{
+	if (p.isValid()) return 0;
+	return Columns + 3;
+}
+
+QVariant SeriesTableModel::data(const QModelIndex & i, int role) const
+{
+	if (!i.isValid()) return QVariant();
+	const int r = i.row();
+	const int c = i.column();
+	if (r < 0 || r >= static_cast<int>(rows.size())) return QVariant();
+	const int s = rows[r];
+	if (role == Qt::DisplayRole)
+	{
+		if (c == 0)
+		{
+			return QVariant(s);
+		}
+		else if (c > 1 && c < Columns + 2)
+		{
+			return QVariant(strings[values[c - 2][s]]);
+		}
+		else if (c == Columns + 2)
+		{
+			return QVariant(counts[s]);
+		}
+	}
+	else if (role == Qt::DecorationRole && c == 1)
+	{
+		if (icons[s] == 1)      return eye_icon;
+		else if (icons[s] == 2) return eye2_icon;
+	}
+	return QVariant();
+}
+
+QVariant SeriesTableModel::headerData(int section, Qt::Orientation o, int role) const
+{
+	if (role != Qt::DisplayRole) return QVariant();
+	if (o == Qt::Vertical) return QVariant(section + 1);
+	switch (section)
+	{
+	case 0:
+		return QVariant(QString("ID"));
+	case 2:
+		return QVariant(QString("Modality"));
+	case 3:
+		return QVariant(QString("Patient"));
+	case 4:
+		return QVariant(QString("Birthdate"));
+	case 5:
+		return QVariant(QString("Study"));
+	case 6:
+	case 8:
+		return QVariant(QString("Date"));
+	case 7:
+		return QVariant(QString("Series"));
+	case 9:
+		return QVariant(QString("Files"));
+	default:
+		break;
+	}
+	return QVariant();
+}
+
+void SeriesTableModel::sort(int column, Qt::SortOrder order)
+{
+	if (column < 0 || column >= Columns + 3) return;
+	sort_column = column;
+	sort_order = order;
+	sort_rows();
+}
+
+void SeriesTableModel::set_icons(const QIcon & i1, const QIcon & i2)
+{
+	eye_icon = i1;
+	eye2_icon = i2;
+}
+
+void SeriesTableModel::clear()
+{
+	beginResetModel();
+	strings.clear();
+	string_ids.clear();
+	string_match.clear();
+	string_days.clear();
+	for (int x = 0; x < Columns; ++x) values[x].clear();
+	icons.clear();
+	counts.clear();
+	first_range.clear();
+	last_range.clear();
+	ranges.clear();
+	dirs.clear();
+	dir_ids.clear();
+	names.clear();
+	file_dirs.clear();
+	file_names.clear();
+	file_sets.clear();
+	file_sets_made.clear();
+	rows.clear();
+	shown = 0;
+	changed.clear();
+	intern(QString(""));
+	endResetModel();
+}
+
+int SeriesTableModel::add_series(
+	const QString & modality,
+	const QString & patient,
+	const QString & birthdate,
+	const QString & study,
+	const QString & study_date,
+	const QString & series,
+	const QString & series_date,
+	int icon)
+{
+	values[0].push_back(intern(modality));
+	values[1].push_back(intern(patient));
+	values[2].push_back(intern(birthdate));
+	values[3].push_back(intern(study));
+	values[4].push_back(intern(study_date));
+	values[5].push_back(intern(series));
+	values[6].push_back(intern(series_date));
+	icons.push_back(static_cast<unsigned char>(icon));
+	counts.push_back(0);
+	first_range.push_back(-1);
+	last_range.push_back(-1);
+	file_sets.push_back(QSet<QPair<unsigned int, QString>>());
+	file_sets_made.push_back(0);
+	return static_cast<int>(icons.size()) - 1;
+}
+
+void SeriesTableModel::add_file(int s, const QString & f)
+{
+	if (s < 0 || s >= static_cast<int>(icons.size())) return;
+	const int sep = std::max(f.lastIndexOf(QChar('/')), f.lastIndexOf(QChar('\\')));
+	const QString dir = f.left(sep + 1);
+	unsigned int d;
+	QHash<QString, unsigned int>::const_iterator it = dir_ids.constFind(dir);
+	if (it != dir_ids.constEnd())
+	{
+		d = it.value();
+	}
+	else
+	{
+		d = static_cast<unsigned int>(dirs.size());
+		dirs.push_back(dir);
+		dir_ids.insert(dir, d);
+	}
+	const unsigned int i = static_cast<unsigned int>(file_dirs.size());
+	file_dirs.push_back(d);
+	file_names.push_back(static_cast<unsigned int>(names.size()));
+	const QString name = f.mid(sep + 1);
+	names.append(name);
+	if (file_sets_made[s]) file_sets[s].insert(qMakePair(d, name));
+	const int last = last_range[s];
+	if (last >= 0 && ranges[last].first + ranges[last].count == i)
+	{
+		++ranges[last].count;
+	}
+	else
+	{
+		const Range r{ i, 1, -1 };
+		ranges.push_back(r);
+		const int n = static_cast<int>(ranges.size()) - 1;
+		if (last >= 0) ranges[last].next = n;
+		else           first_range[s] = n;
+		last_range[s] = n;
+	}
+	++counts[s];
+	if (changed.empty() || changed.back() != s) changed.push_back(s);
+}
+
+int SeriesTableModel::get_icon(int s) const
+{
+	if (s < 0 || s >= static_cast<int>(icons.size())) return 0;
+	return icons[s];
+}
+
+void SeriesTableModel::set_icon(int s, int icon)
+{
+	if (s < 0 || s >= static_cast<int>(icons.size())) return;
+	icons[s] = static_cast<unsigned char>(icon);
+	if (changed.empty() || changed.back() != s) changed.push_back(s);
+}
+
+// Changed rows are repainted and, if sorted by the icon or the number
+// of files, moved to the sorted position. New series are shown (if
+// they match the filter) at the sorted position. For a large batch
+// (the scan) new rows are appended and all rows are sorted.
+void SeriesTableModel::update()
+{
+	const bool by_index = (sort_column == 0 && sort_order == Qt::AscendingOrder);
+	const bool by_value = (sort_column == 1 || sort_column == Columns + 2);
+	bool resort = false;
+	// Series shown before, new series are inserted below
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+	changed.erase(
+		std::lower_bound(changed.begin(), changed.end(), static_cast<int>(shown)),
+		changed.end());
+	if (!changed.empty() && !rows.empty())
+	{
+		// Moved one by one, the other rows must be sorted.
+		if (changed.size() > insert_max || (by_value && changed.size() > 1))
+		{
+			emit dataChanged(
+				index(0, 1),
+				index(static_cast<int>(rows.size()) - 1, Columns + 2));
+			if (by_value) sort_rows();
+		}
+		else
+		{
+			update_row(changed.at(0), by_value);
+			for (size_t x = 1; x < changed.size(); ++x) update_row(changed.at(x), false);
+		}
+	}
+	changed.clear();
+	if (shown < icons.size())
+	{
+		std::vector<int> l;
+		for (size_t x = shown; x < icons.size(); ++x)
+		{
+			if (row_matches(static_cast<int>(x))) l.push_back(static_cast<int>(x));
+		}
+		shown = icons.size();
+		if (l.size() <= insert_max)
+		{
+			for (size_t x = 0; x < l.size(); ++x) insert_row(l.at(x));
+		}
+		else
+		{
+			const int first = static_cast<int>(rows.size());
+			beginInsertRows(QModelIndex(), first, first + static_cast<int>(l.size()) - 1);
+			rows.insert(rows.end(), l.begin(), l.end());
+			endInsertRows();
+			resort = !by_index;
+		}
+	}
+	if (resort) sort_rows();
+}
+
+void SeriesTableModel::set_filter(const QString & f)
+{
+	const QString tmp0 = f.trimmed();
+	if (tmp0 == filter) return;
+	beginResetModel();
+	filter = tmp0;
+	string_match.clear();
+	filter_rows();
+	endResetModel();
+}
+
+// 's' is the series as for add_file(), not the row.
+bool SeriesTableModel::has_file(int s, const QString & f)
+{
+	if (s < 0 || s >= static_cast<int>(icons.size())) return false;
+	const int sep = std::max(f.lastIndexOf(QChar('/')), f.lastIndexOf(QChar('\\')));
+	QHash<QString, unsigned int>::const_iterator it = dir_ids.constFind(f.left(sep + 1));
+	if (it == dir_ids.constEnd()) return false;
+	QSet<QPair<unsigned int, QString>> & set = file_sets[s];
+	if (!file_sets_made[s])
+	{
+		set.reserve(static_cast<int>(counts[s]));
+		int n = first_range[s];
+		while (n >= 0)
+		{
+			const Range & range = ranges[n];
+			for (unsigned int i = range.first; i < range.first + range.count; ++i)
+			{
+				const unsigned int b = file_names[i];
+				const unsigned int e =
+					(i + 1 < file_names.size())
+					? file_names[i + 1]
+					: static_cast<unsigned int>(names.size());
+				set.insert(qMakePair(file_dirs[i], names.mid(b, e - b)));
+			}
+			n = range.next;
+		}
+		file_sets_made[s] = 1;
+	}
+	return set.contains(qMakePair(it.value(), f.mid(sep + 1)));
+}
+
+QStringList SeriesTableModel::get_files(int r) const
+{
+	QStringList l;
+	if (r < 0 || r >= static_cast<int>(rows.size())) return l;
+	const int s = rows[r];
+	int n = first_range[s];
+	while (n >= 0)
+	{
+		const Range & range = ranges[n];
+		for (unsigned int i = range.first; i < range.first + range.count; ++i)
+		{
+			const unsigned int b = file_names[i];
+			const unsigned int e =
+				(i + 1 < file_names.size())
+				? file_names[i + 1]
+				: static_cast<unsigned int>(names.size());
+			l.push_back(dirs[file_dirs[i]] + names.mid(b, e - b));
+		}
+		n = range.next;
+	}
+	return l;
+}
+
+int SeriesTableModel::get_files_count(int r) const
+{
+	if (r < 0 || r >= static_cast<int>(rows.size())) return 0;
+	return static_cast<int>(counts[rows[r]]);
+}
+
+unsigned int SeriesTableModel::intern(const QString & s)
+{
+	QHash<QString, unsigned int>::const_iterator it = string_ids.constFind(s);
+	if (it != string_ids.constEnd()) return it.value();
+	const unsigned int i = static_cast<unsigned int>(strings.size());
+	strings.push_back(s);
+	string_ids.insert(s, i);
+	return i;
+}
+
+// The filter is matched once per string, not per cell.
+bool SeriesTableModel::row_matches(int s)
+{
+	if (filter.isEmpty()) return true;
+	for (size_t x = string_match.size(); x < strings.size(); ++x)
+	{
+		string_match.push_back(strings[x].contains(filter, Qt::CaseInsensitive) ? 1 : 0);
+	}
+	for (int x = 0; x < Columns; ++x)
+	{
+		if (string_match[values[x][s]]) return true;
+	}
+	return false;
+}
+
+void SeriesTableModel::filter_rows()
+{
+	rows.clear();
+	for (size_t x = 0; x < shown; ++x)
+	{
+		if (row_matches(static_cast<int>(x))) rows.push_back(static_cast<int>(x));
+	}
+	if (!(sort_column == 0 && sort_order == Qt::AscendingOrder))
+	{
+		order_rows();
+	}
+}
+
+// After the rows equal to the series, as if appended and sorted.
+void SeriesTableModel::insert_row(int s)
+{
+	std::vector<int>::iterator it = find_position(s, rows.begin(), rows.end());
+	const int r = static_cast<int>(it - rows.begin());
+	beginInsertRows(QModelIndex(), r, r);
+	rows.insert(it, s);
+	endInsertRows();
+}
+
+// The row of the series is repainted, with 'move' it is moved first,
+// as if removed and inserted.
+void SeriesTableModel::update_row(int s, bool move)
+{
+	std::vector<int>::iterator it = std::find(rows.begin(), rows.end(), s);
+	if (it == rows.end()) return;
+	int r = static_cast<int>(it - rows.begin());
+	if (move)
+	{
+		// Position in the rows without the series, they stay sorted.
+		std::vector<int>::iterator it1 = find_position(s, rows.begin(), it);
+		int p = static_cast<int>(it1 - rows.begin());
+		if (it1 == it)
+		{
+			p = static_cast<int>(find_position(s, it + 1, rows.end()) - rows.begin()) - 1;
+		}
+		if (p != r)
+		{
+			beginMoveRows(QModelIndex(), r, r, QModelIndex(), (p > r) ? p + 1 : p);
+			rows.erase(it);
+			rows.insert(rows.begin() + p, s);
+			endMoveRows();
+			r = p;
+		}
+	}
+	emit dataChanged(index(r, 1), index(r, Columns + 2));
+}
+
+std::vector<int>::iterator SeriesTableModel::find_position(
+	int s, std::vector<int>::iterator first, std::vector<int>::iterator last)
+{
+	if (sort_order == Qt::AscendingOrder)
+	{
+		return std::upper_bound(first, last, s,
+			[this](int a, int b) { return less(a, b); });
+	}
+	return std::upper_bound(first, last, s,
+		[this](int a, int b) { return less(b, a); });
+}
+
+// Same order as order_rows()
+bool SeriesTableModel::less(int a, int b)
+{
+	if (sort_column == 1)           return icons[a] < icons[b];
+	if (sort_column == Columns + 2) return counts[a] < counts[b];
+	if (sort_column < 2 || sort_column > Columns + 1) return a < b;
+	const int c = sort_column - 2;
+	const unsigned int ia = values[c][a];
+	const unsigned int ib = values[c][b];
+	if (ia == ib) return false;
+	if (c == 2 || c == 4 || c == 6)
+	{
+		const qint64 da = get_day(ia);
+		const qint64 db = get_day(ib);
+		return (da == db) ? (ia < ib) : (da < db);
+	}
+	const int r = strings[ia].compare(strings[ib], Qt::CaseInsensitive);
+	return (r == 0) ? (ia < ib) : (r < 0);
+}
+
+// Julian day of the date string, -1 if empty or invalid
+qint64 SeriesTableModel::get_day(unsigned int i)
+{
+	for (size_t x = string_days.size(); x < strings.size(); ++x)
+	{
+		const QDate d = QDate::fromString(strings[x].trimmed(), QString("d MMM yyyy"));
+		string_days.push_back(d.isValid() ? d.toJulianDay() : -1);
+	}
+	return string_days[i];
+}
+
+void SeriesTableModel::sort_rows()
+{
+	if (rows.size() < 2) return;
+	const std::vector<int> old = rows;
+	emit layoutAboutToBeChanged();
+	order_rows();
+	const QModelIndexList from = persistentIndexList();
+	if (!from.empty())
+	{
+		std::vector<int> new_rows(icons.size(), -1);
+		for (size_t x = 0; x < rows.size(); ++x) new_rows[rows[x]] = static_cast<int>(x);
+		QModelIndexList to;
+		for (int x = 0; x < from.size(); ++x)
+		{
+			const QModelIndex & i = from.at(x);
+			to.append(index(new_rows[old[i.row()]], i.column()));
+		}
+		changePersistentIndexList(from, to);
+	}
+	emit layoutChanged();
+}
+
+void SeriesTableModel::order_rows()
+{
+	if (rows.size() < 2) return;
+	// Sort key per series, for text and dates the rank of the string
+	std::vector<unsigned int> keys(icons.size());
+	if (sort_column == 0)
+	{
+		for (size_t x = 0; x < keys.size(); ++x) keys[x] = static_cast<unsigned int>(x);
+	}
+	else if (sort_column == 1)
+	{
+		keys.assign(icons.begin(), icons.end());
+	}
+	else if (sort_column == Columns + 2)
+	{
+		keys = counts;
+	}
+	else
+	{
+		const int c = sort_column - 2;
+		const bool date = (c == 2 || c == 4 || c == 6);
+		std::vector<unsigned int> ids(strings.size());
+		for (size_t x = 0; x < ids.size(); ++x) ids[x] = static_cast<unsigned int>(x);
+		if (date)
+		{
+			get_day(0); // fills the cache
+			std::stable_sort(ids.begin(), ids.end(),
+				[this](unsigned int a, unsigned int b) { return string_days[a] < string_days[b]; });
+		}
+		else
+		{
+			std::sort(ids.begin(), ids.end(),
+				[this](unsigned int a, unsigned int b)
+				{
+					const int r = strings[a].compare(strings[b], Qt::CaseInsensitive);
+					return (r == 0) ? (a < b) : (r < 0);
+				});
+		}
+		std::vector<unsigned int> ranks(strings.size());
+		for (size_t x = 0; x < ids.size(); ++x) ranks[ids[x]] = static_cast<unsigned int>(x);
+		for (size_t x = 0; x < keys.size(); ++x) keys[x] = ranks[values[c][x]];
+	}
+	if (sort_order == Qt::AscendingOrder)
+	{
+		std::stable_sort(rows.begin(), rows.end(),
+			[&keys](int a, int b) { return keys[a] < keys[b]; });
+	}
+	else
+	{
+		std::stable_sort(rows.begin(), rows.end(),
+			[&keys](int a, int b) { return keys[b] < keys[a]; });
+	}
+}
+
@@ -0,0 +1,110 @@
+#ifndef A_SERIESTABLEMODEL_H
+#define A_SERIESTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QModelIndex>
+#include <QVariant>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QIcon>
+#include <vector>
+
+// Table of series of the browser, columns are ID (hidden), icon,
+// modality, patient, birthdate, study, date, series, date and number
+// of files.
+// The values are stored by column as IDs of interned strings. Files
+// of all series are in one arena (directory ID and name), a series
+// has a chain of index ranges into it, files of a series found one
+// after another are one range. A hash set of the files of a series is
+// made by the first has_file() for it and kept by add_file().
+// Sorting and filtering permute the series, there are no items per
+// cell. update() inserts new rows and moves changed rows to their
+// sorted position, a batch of files costs as much as the series it
+// changes, not as the table.
+class SeriesTableModel : public QAbstractTableModel
+{
+Q_OBJECT
+public:
+	SeriesTableModel(QObject * = nullptr);
+	~SeriesTableModel() = default;
+	int rowCount(const QModelIndex & = QModelIndex()) const override;
+	int columnCount(const QModelIndex & = QModelIndex()) const override;
+	QVariant data(const QModelIndex&, int = Qt::DisplayRole) const override;
+	QVariant headerData(int, Qt::Orientation, int = Qt::DisplayRole) const override;
+	void sort(int, Qt::SortOrder = Qt::AscendingOrder) override;
+	void set_icons(const QIcon&, const QIcon&);
+	void clear();
+	// Series are added to the store, update() shows them.
+	// Icon: 0 - none, 1 - eye, 2 - eye2
+	int add_series(
+		const QString&, const QString&, const QString&,
+		const QString&, const QString&, const QString&,
+		const QString&, int);
+	void add_file(int, const QString&);
+	bool has_file(int, const QString&);
+	int  get_icon(int) const;
+	void set_icon(int, int);
+	void update();
+	// Files of the series in the row
+	QStringList get_files(int) const;
+	int get_files_count(int) const;
+
+public slots:
+	void set_filter(const QString&);
+
+private:
+	struct Range
+	{
+		unsigned int first;
+		unsigned int count;
+		int next;
+	};
+	enum { Columns = 7 };
+	unsigned int intern(const QString&);
+	bool row_matches(int);
+	void filter_rows();
+	void sort_rows();
+	void order_rows();
+	void insert_row(int);
+	void update_row(int, bool);
+	std::vector<int>::iterator find_position(
+		int, std::vector<int>::iterator, std::vector<int>::iterator);
+	bool less(int, int);
+	qint64 get_day(unsigned int);
+	QIcon eye_icon;
+	QIcon eye2_icon;
+	// Strings
+	std::vector<QString> strings;
+	QHash<QString, unsigned int> string_ids;
+	std::vector<char> string_match;
+	std::vector<qint64> string_days;
+	// Series
+	std::vector<unsigned int> values[Columns];
+	std::vector<unsigned char> icons;
+	std::vector<unsigned int> counts;
+	std::vector<int> first_range;
+	std::vector<int> last_range;
+	std::vector<Range> ranges;
+	// Files
+	std::vector<QString> dirs;
+	QHash<QString, unsigned int> dir_ids;
+	QString names;
+	std::vector<unsigned int> file_dirs;
+	std::vector<unsigned int> file_names;
+	std::vector<QSet<QPair<unsigned int, QString>>> file_sets;
+	std::vector<char> file_sets_made;
+	// Rows
+	std::vector<int> rows;
+	size_t shown{};
+	// Series with a new file or icon since update()
+	std::vector<int> changed;
+	QString filter;
+	int sort_column{};
+	Qt::SortOrder sort_order{Qt::AscendingOrder};
+};
+
+#endif
+
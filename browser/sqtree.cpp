@@ -113,6 +113,7 @@ void get_series_files(
 	const mdcm::Dict & dict = dicts.GetPublicDict();
 	const mdcm::Tag t(0x0020,0x000e);
 	mdcm::Scanner s;
+	s.SetNumberOfThreads(0);
 	s.AddTag(t);
 	s.Scan(files, dict);
 	mdcm::Scanner::ValuesType v = s.GetValues();
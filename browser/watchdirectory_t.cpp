@@ -0,0 +1,261 @@
+#include "watchdirectory_t.h"
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace
+{
+
+const uint32_t watch_mask =
+	IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR;
+
+// Time to check if canceled, ms
+constexpr int poll_timeout = 250;
+
+// Wait for more events after the first, ms
+constexpr int settle_time = 50;
+
+}
+
+WatchDirectory_T::WatchDirectory_T(const QString & p)
+	: root(p)
+{
+}
+
+void WatchDirectory_T::run()
+{
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0)
+	{
+		watch_ready.store(true);
+		emit watching();
+		return;
+	}
+	// Files already there are not read, the scan started after
+	// watching() reads them.
+	{
+		QSet<int> visited;
+		add_watch(QDir(root).absolutePath(), false, visited);
+	}
+	watch_ready.store(true);
+	emit watching();
+	alignas(struct inotify_event) char buf[16384];
+	// Closed files are read after all pending events, a file written
+	// with a temporary name and renamed is read once with the new name.
+	QStringList closed;
+	bool overflow{};
+	while (!canceled.load())
+	{
+		struct pollfd pfd;
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, poll_timeout) <= 0) continue;
+		msleep(settle_time);
+		while (!canceled.load())
+		{
+			const ssize_t n = read(fd, buf, sizeof(buf));
+			if (n <= 0) break;
+			ssize_t i = 0;
+			while (i < n)
+			{
+				const struct inotify_event * e =
+					reinterpret_cast<const struct inotify_event *>(buf + i);
+				i += sizeof(struct inotify_event) + e->len;
+				// Events were lost, the tree is scanned again below.
+				if (e->wd == -1)
+				{
+					if (e->mask & IN_Q_OVERFLOW) overflow = true;
+					continue;
+				}
+				if (e->mask & IN_IGNORED)
+				{
+					watches.remove(e->wd);
+					continue;
+				}
+				if (e->len == 0) continue;
+				QHash<int, QString>::const_iterator it = watches.constFind(e->wd);
+				if (it == watches.constEnd()) continue;
+				const QString f = it.value() + QString("/") + QFile::decodeName(e->name);
+				if (e->mask & IN_ISDIR)
+				{
+					if (e->mask & (IN_CREATE | IN_MOVED_TO))
+					{
+						QSet<int> visited;
+						add_watch(f, true, visited);
+					}
+					else if (e->mask & (IN_MOVED_FROM | IN_DELETE))
+					{
+						const QString f1 = f + QString("/");
+						forget_files(f1);
+						QHash<int, QString>::iterator it1 = watches.begin();
+						while (it1 != watches.end())
+						{
+							if (it1.value() == f || it1.value().startsWith(f1))
+							{
+								inotify_rm_watch(fd, it1.key());
+								it1 = watches.erase(it1);
+							}
+							else
+							{
+								++it1;
+							}
+						}
+					}
+				}
+				else if (e->mask & IN_CREATE)
+				{
+					created.insert(f);
+				}
+				else if (e->mask & IN_CLOSE_WRITE)
+				{
+					if (created.remove(f)) closed.push_back(f);
+				}
+				else if (e->mask & IN_MOVED_TO)
+				{
+					created.remove(f);
+					read_file(f);
+				}
+				else if (e->mask & (IN_MOVED_FROM | IN_DELETE))
+				{
+					// Read again if it comes back
+					done.remove(f);
+					created.remove(f);
+					closed.removeAll(f);
+				}
+			}
+		}
+		if (overflow)
+		{
+			rescan();
+			overflow = false;
+		}
+		for (int x = 0; x < closed.size(); ++x)
+		{
+			read_file(closed.at(x));
+		}
+		closed.clear();
+		flush();
+	}
+	close(fd);
+	fd = -1;
+}
+
+// If 'read_files' is set, the directory is new and files already there
+// are read, they could be created before the watch was added, else
+// the files are read by the scan started after watching() and only
+// marked as done.
+// 'visited' stops loops of linked directories.
+void WatchDirectory_T::add_watch(const QString & p, bool read_files, QSet<int> & visited)
+{
+	if (canceled.load()) return;
+	const int wd = inotify_add_watch(fd, QFile::encodeName(p).constData(), watch_mask);
+	if (wd < 0 || visited.contains(wd)) return;
+	visited.insert(wd);
+	watches.insert(wd, p);
+	QDir dir(p);
+	const QStringList flist = dir.entryList(QDir::Files | QDir::Readable, QDir::Name);
+	for (int x = 0; x < flist.size(); ++x)
+	{
+		const QString f = p + QString("/") + flist.at(x);
+		if (read_files) read_file(f);
+		else            done.insert(f);
+	}
+	const QStringList dlist = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+	for (int x = 0; x < dlist.size(); ++x)
+	{
+		add_watch(p + QString("/") + dlist.at(x), read_files, visited);
+	}
+}
+
+// After an overflow of the event queue, events are lost. Files removed
+// meanwhile are forgotten, the tree is walked again, new directories
+// are watched and files not read yet are read.
+void WatchDirectory_T::rescan()
+{
+	QSet<QString>::iterator it = done.begin();
+	while (it != done.end())
+	{
+		if (QFile::exists(*it)) ++it;
+		else it = done.erase(it);
+	}
+	// Not readable files are inserted again by read_file().
+	created.clear();
+	QSet<int> visited;
+	add_watch(QDir(root).absolutePath(), true, visited);
+}
+
+// Files of a directory moved out of the tree or deleted,
+// 'p' ends with '/'.
+void WatchDirectory_T::forget_files(const QString & p)
+{
+	QSet<QString>::iterator it = done.begin();
+	while (it != done.end())
+	{
+		if ((*it).startsWith(p)) it = done.erase(it);
+		else ++it;
+	}
+	it = created.begin();
+	while (it != created.end())
+	{
+		if ((*it).startsWith(p)) it = created.erase(it);
+		else ++it;
+	}
+}
+
+void WatchDirectory_T::read_file(const QString & f)
+{
+	if (done.contains(f)) return;
+	ScanRecord r;
+	r.file = QDir::toNativeSeparators(f);
+	try
+	{
+		ScanDirectory_T::read_record(r.file, r);
+	}
+	catch (...)
+	{
+		r.ok = false;
+	}
+	// May be still written, is read again when closed.
+	if (!r.ok)
+	{
+		created.insert(f);
+		return;
+	}
+	done.insert(f);
+	std::lock_guard<std::mutex> lock(results_mutex);
+	ready.push_back(std::move(r));
+}
+
+void WatchDirectory_T::flush()
+{
+	{
+		std::lock_guard<std::mutex> lock(results_mutex);
+		if (ready.empty() || notified) return;
+		notified = true;
+	}
+	emit results_ready();
+}
+
+void WatchDirectory_T::take_results(std::vector<ScanRecord> & l)
+{
+	std::lock_guard<std::mutex> lock(results_mutex);
+	if (l.empty()) l.swap(ready);
+	else l.insert(l.end(), ready.begin(), ready.end());
+	ready.clear();
+	notified = false;
+}
+
+bool WatchDirectory_T::is_watching() const
+{
+	return watch_ready.load();
+}
+
+void WatchDirectory_T::cancel()
+{
+	canceled.store(true);
+}
+
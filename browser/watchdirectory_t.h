@@ -0,0 +1,61 @@
+#ifndef A_WATCHDIRECTORY_T_H
+#define A_WATCHDIRECTORY_T_H
+
+#include <QThread>
+#include <QString>
+#include <QHash>
+#include <QSet>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "scandirectory_t.h"
+
+// Watch of a directory tree with inotify (Linux). A file created in the
+// tree is read when it is closed after writing, a file moved into the
+// tree is read at once, files of a new sub-directory are read when the
+// directory appears. Existing files are not read again, removed files
+// are not reported, a removed file is read again if it comes back.
+// If the event queue overflows, the tree is scanned again. Records are
+// sent as by ScanDirectory_T, results_ready() is emitted for a new
+// batch, take_results() moves the batch out. watching() is emitted
+// when the tree is watched, a scan started after it sees every file
+// the watch takes as existing.
+class WatchDirectory_T : public QThread
+{
+Q_OBJECT
+public:
+	WatchDirectory_T(const QString&);
+	~WatchDirectory_T() = default;
+	void run() override;
+	void take_results(std::vector<ScanRecord>&);
+	bool is_watching() const;
+
+public slots:
+	void cancel();
+
+signals:
+	void watching();
+	void results_ready();
+
+private:
+	void add_watch(const QString&, bool, QSet<int>&);
+	void rescan();
+	void forget_files(const QString&);
+	void read_file(const QString&);
+	void flush();
+	const QString root;
+	int fd{-1};
+	QHash<int, QString> watches;
+	// Created and not closed yet, or not readable when closed
+	QSet<QString> created;
+	// Read, or there at start
+	QSet<QString> done;
+	std::atomic<bool> canceled{};
+	std::atomic<bool> watch_ready{};
+	std::mutex results_mutex;
+	std::vector<ScanRecord> ready;
+	bool notified{};
+};
+
+#endif
+
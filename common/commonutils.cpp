@@ -32,6 +32,7 @@
 #include <itkImageSliceIteratorWithIndex.h>
 #include <itkIdentityTransform.h>
 #include <itkResampleImageFilter.h>
+#include <itkImportImageContainer.h>
 #include <QSet>
 #include <QApplication>
 #include <QFileInfo>
@@ -48,6 +49,7 @@
 #include <chrono>
 #include <functional>
 #include <cfloat>
+#include <cstring>
 #include <atomic>
 #include "dicomutils.h"
 #include "colorspace/colorspace.h"
@@ -1393,30 +1395,71 @@ template<typename T> bool reload_rgba_image(
 	return true;
 }
 
-template<typename T> QString process_dicom_monochrome_image1(
-	bool * ok,
-	ImageVariant * ivariant,
+// Pixel container taking over a buffer allocated with new char[],
+// e.g. by DicomUtils::read_buffer().
+template<typename TElement> class CharBufferContainer
+	: public itk::ImportImageContainer<itk::SizeValueType, TElement>
+{
+public:
+	typedef CharBufferContainer Self;
+	typedef itk::ImportImageContainer<itk::SizeValueType, TElement> Superclass;
+	typedef itk::SmartPointer<Self> Pointer;
+	typedef itk::SmartPointer<const Self> ConstPointer;
+	itkNewMacro(Self);
+	void SetBuffer(char * b, const itk::SizeValueType s)
+	{
+		this->SetImportPointer(reinterpret_cast<TElement*>(b), s, false);
+		buffer = b;
+	}
+
+protected:
+	CharBufferContainer() = default;
+	~CharBufferContainer() override
+	{
+		delete [] buffer;
+	}
+
+private:
+	char * buffer{};
+};
+
+// One buffer with all slices or one buffer per slice.
+QString check_dicom_buffers(const std::vector<char*> & data, const size_t dimz)
+{
+	if (data.size() != 1 && data.size() != dimz)
+	{
+		return QString("data.size() != dimz");
+	}
+	for (size_t z = 0; z < data.size(); ++z)
+	{
+		if (!data.at(z))
+		{
+			return QString("!data.at(") +
+				QVariant(static_cast<unsigned long long>(z)).toString() +
+				QString(")");
+		}
+	}
+	return QString("");
+}
+
+// If 'take' is set, the only buffer in 'data' becomes the pixel
+// container of the image (no copy), otherwise the image is allocated.
+template<typename T> QString create_dicom_image(
 	typename T::Pointer & image,
-	char * buffer,
+	std::vector<char*> & data,
+	const bool take,
 	const itk::Matrix<itk::SpacePrecisionType, 3, 3> & direction,
 	const size_t dimx, const size_t dimy, const size_t dimz,
 	const double origin_x, const double origin_y, const double origin_z,
 	const double spacing_x, const double spacing_y, const double spacing_z,
-	const short image_type,
 	bool * bad_direction)
 {
-	if (!buffer)
-	{
-		*ok = false;
-		return QString("process_dicom_monochrome_image1: buffer is null");
-	}
+	typedef typename T::PixelType PixelType;
 	typename T::RegionType region;
 	typename T::SizeType size;
 	typename T::IndexType start;
 	typename T::PointType origin;
 	typename T::SpacingType spacing;
-	typedef itk::ImageSliceIteratorWithIndex<T> SliceIterator;
-	typename UpdateQtCommand::Pointer update_qt_command;
 	start.Fill(0);
 	size[0] = dimx;
 	size[1] = dimy;
@@ -1434,48 +1477,91 @@ template<typename T> QString process_dicom_monochrome_image1(
 	{
 		image = T::New();
 		image->SetRegions(region);
-		image->Allocate();
 		image->SetOrigin(origin);
 		image->SetSpacing(spacing);
 		if (*bad_direction == false) image->SetDirection(direction);
+		if (take)
+		{
+			typename CharBufferContainer<PixelType>::Pointer container =
+				CharBufferContainer<PixelType>::New();
+			container->SetBuffer(data[0], dimx * dimy * dimz);
+			data[0] = nullptr;
+			image->SetPixelContainer(container);
+		}
+		else
+		{
+			image->Allocate();
+		}
 	}
 	catch (const itk::ExceptionObject & ex)
 	{
-		*ok = false;
 		return QString(ex.GetDescription());
 	}
-	//
-	ivariant->image_type = image_type;
-	const void * vbuffer = static_cast<void*>(buffer);
-	const typename T::PixelType * p__ = static_cast<const typename T::PixelType*>(vbuffer);
-	//
-	try
+	catch (const std::bad_alloc&)
 	{
-		SliceIterator it(image, image->GetLargestPossibleRegion());
-		it.SetFirstDirection(0);
-		it.SetSecondDirection(1);
-		it.GoToBegin();
-		size_t j{};
-		while(!it.IsAtEnd())
+		return QString("std::bad_alloc exception");
+	}
+	return QString("");
+}
+
+// Buffers have the memory layout of the image's pixels.
+template<typename T> void copy_dicom_buffers(
+	typename T::Pointer & image,
+	std::vector<char*> & data,
+	const bool delete_data,
+	const size_t dimx, const size_t dimy, const size_t dimz)
+{
+	typedef typename T::PixelType PixelType;
+	PixelType * out = image->GetBufferPointer();
+	const size_t n = (data.size() == 1) ? dimx * dimy * dimz : dimx * dimy;
+	for (size_t z = 0; z < data.size(); ++z)
+	{
+		memcpy(static_cast<void*>(out + z * n), data[z], n * sizeof(PixelType));
+		if (delete_data)
 		{
-			while (!it.IsAtEndOfSlice())
-			{
-				while (!it.IsAtEndOfLine())
-				{
-					it.Set(p__[j]);
-					++j;
-					++it;
-				}
-				it.NextLine();
-			}
-			it.NextSlice();
+			delete [] data[z];
+			data[z] = nullptr;
 		}
 	}
-	catch (const itk::ExceptionObject & ex)
+}
+
+template<typename T> QString process_dicom_monochrome_image1(
+	bool * ok,
+	ImageVariant * ivariant,
+	typename T::Pointer & image,
+	std::vector<char*> & data,
+	const bool delete_data,
+	const itk::Matrix<itk::SpacePrecisionType, 3, 3> & direction,
+	const size_t dimx, const size_t dimy, const size_t dimz,
+	const double origin_x, const double origin_y, const double origin_z,
+	const double spacing_x, const double spacing_y, const double spacing_z,
+	const short image_type,
+	bool * bad_direction)
+{
+	QString error = check_dicom_buffers(data, dimz);
+	if (!error.isEmpty())
 	{
 		*ok = false;
-		return QString(ex.GetDescription());
+		return QString("process_dicom_monochrome_image1: ") + error;
+	}
+	const bool take = (data.size() == 1 && delete_data);
+	error = create_dicom_image<T>(
+		image, data, take,
+		direction,
+		dimx, dimy, dimz,
+		origin_x, origin_y, origin_z,
+		spacing_x, spacing_y, spacing_z,
+		bad_direction);
+	if (!error.isEmpty())
+	{
+		*ok = false;
+		return error;
+	}
+	if (!take)
+	{
+		copy_dicom_buffers<T>(image, data, delete_data, dimx, dimy, dimz);
 	}
+	ivariant->image_type = image_type;
 	return QString("");
 }
 
@@ -1529,7 +1615,8 @@ template<typename T> QString process_dicom_rgb_image1(
 	bool * ok,
 	ImageVariant * ivariant,
 	typename T::Pointer & image,
-	char * buffer,
+	std::vector<char*> & data,
+	const bool delete_data,
 	const itk::Matrix<itk::SpacePrecisionType, 3, 3> & direction,
 	const size_t dimx, const size_t dimy, const size_t dimz,
 	const double origin_x, const double origin_y, const double origin_z,
@@ -1540,129 +1627,96 @@ template<typename T> QString process_dicom_rgb_image1(
 	const int bitsstored,
 	bool * bad_direction)
 {
-	if (!buffer)
+	typedef typename T::PixelType PixelType;
+	typedef typename T::PixelType::ValueType ValueType;
+	QString error = check_dicom_buffers(data, dimz);
+	if (!error.isEmpty())
 	{
 		*ok = false;
-		return QString("process_dicom_rgb_image1: buffer is null");
+		return QString("process_dicom_rgb_image1: ") + error;
 	}
-	typename T::RegionType region;
-	typename T::SizeType size;
-	typename T::IndexType start;
-	typename T::PointType origin;
-	typename T::SpacingType spacing;
-	typedef itk::ImageSliceIteratorWithIndex<T> SliceIterator;
-	start.Fill(0);
-	size[0] = dimx;
-	size[1] = dimy;
-	size[2] = dimz;
-	region.SetIndex(start);
-	region.SetSize(size);
-	origin[0] = origin_x;
-	origin[1] = origin_y;
-	origin[2] = origin_z;
-	spacing[0] = spacing_x;
-	spacing[1] = spacing_y;
-	spacing[2] = spacing_z;
-	*bad_direction = check_direction_matrix(direction);
-	try
+	if (ybr < 0 || ybr > 2)
 	{
-		image = T::New();
-		image->SetRegions(region);
-		image->Allocate();
-		image->SetOrigin(origin);
-		image->SetSpacing(spacing);
-		if (*bad_direction == false) image->SetDirection(direction);
-	}
-	catch (const itk::ExceptionObject & ex)
+		*ok = false;
+		return QString("Internal error");
+	}
+	const bool convert = (ybr > 0 || hsv);
+	const bool take = (!convert && data.size() == 1 && delete_data);
+	error = create_dicom_image<T>(
+		image, data, take,
+		direction,
+		dimx, dimy, dimz,
+		origin_x, origin_y, origin_z,
+		spacing_x, spacing_y, spacing_z,
+		bad_direction);
+	if (!error.isEmpty())
 	{
 		*ok = false;
-		return QString(ex.GetDescription());
+		return error;
 	}
-	//
-	const void * vbuffer = static_cast<void*>(buffer);
-	const typename T::PixelType::ValueType * p__ =
-		static_cast<const typename T::PixelType::ValueType*>(vbuffer);
 	ivariant->image_type = image_type;
-	//
-	try
+	if (take) return QString("");
+	if (!convert)
+	{
+		copy_dicom_buffers<T>(image, data, delete_data, dimx, dimy, dimz);
+		return QString("");
+	}
+	PixelType * out = image->GetBufferPointer();
+	const size_t n = (data.size() == 1) ? dimx * dimy * dimz : dimx * dimy;
+	for (size_t z = 0; z < data.size(); ++z)
 	{
-		SliceIterator it(image, image->GetLargestPossibleRegion());
-		it.SetFirstDirection(0);
-		it.SetSecondDirection(1);
-		it.GoToBegin();
-		size_t j = 0;
-		while(!it.IsAtEnd())
+		const ValueType * p__ = reinterpret_cast<const ValueType*>(data[z]);
+		size_t j{};
+		for (size_t k = 0; k < n; ++k)
 		{
-			while (!it.IsAtEndOfSlice())
+			PixelType & p = out[z * n + k];
+			if (ybr > 0)
 			{
-				while (!it.IsAtEndOfLine())
+				// 8 bits
+				int R, G, B;
+				double Y  = p__[j];
+				const double Cb = p__[j + 1] - 128;
+				const double Cr = p__[j + 2] - 128;
+				if (ybr == 1)
 				{
-					typename T::PixelType p;
-					if (ybr > 0)
-					{
-						// 8 bits
-						int R, G, B;
-						double Y  = p__[j];
-						const double Cb = p__[j + 1] - 128;
-						const double Cr = p__[j + 2] - 128;
-						if (ybr == 1)
-						{
-							R = static_cast<int>(Y + (-0.000036820) * Cb +    1.401987577 * Cr);
-							G = static_cast<int>(Y + (-0.344113281) * Cb + (-0.714103821) * Cr);
-							B = static_cast<int>(Y +    1.771978117 * Cb + (-0.000134583) * Cr);
-						}
-						else if (ybr == 2)
-						{
-							// YBR_PARTIAL_422 is problematic
-							Y -= 16;
-							if (Y < 0) Y = 0; // invalid?
-							R = static_cast<int>(1.164415463 * Y + (-0.000095036) * Cb +    1.596001878 * Cr);
-							G = static_cast<int>(1.164415463 * Y + (-0.391724564) * Cb + (-0.813013368) * Cr);
-							B = static_cast<int>(1.164415463 * Y +    2.017290682 * Cb + (-0.000135273) * Cr);
-						}
-						else
-						{
-							R = G = B = 0;
-							*ok = false;
-							return QString("Internal error");
-						}
-						if (R > 255) R = 255;
-						if (G > 255) G = 255;
-						if (B > 255) B = 255;
-						p[0] = static_cast<typename T::PixelType::ValueType>(R < 0 ? 0 : R);
-						p[1] = static_cast<typename T::PixelType::ValueType>(G < 0 ? 0 : G);
-						p[2] = static_cast<typename T::PixelType::ValueType>(B < 0 ? 0 : B);
-					}
-					else if (hsv)
-					{
-						const double H = (p__[j] / 255.0) * 360.0;
-						const double S = p__[j + 1]/ 255.0;
-						const double V = p__[j + 2] / 255.0;
-						double R, G, B;
-						ColorSpace_::Hsv2Rgb(&R, &G, &B, H, S, V);
-						p[0] = static_cast<typename T::PixelType::ValueType>(R * 255.0);
-						p[1] = static_cast<typename T::PixelType::ValueType>(G * 255.0);
-						p[2] = static_cast<typename T::PixelType::ValueType>(B * 255.0);
-					}
-					else
-					{
-						p[0] = static_cast<typename T::PixelType::ValueType>(p__[j]);
-						p[1] = static_cast<typename T::PixelType::ValueType>(p__[j + 1]);
-						p[2] = static_cast<typename T::PixelType::ValueType>(p__[j + 2]);
-					}
-					it.Set(p);
-					j+=3;
-					++it;
+					R = static_cast<int>(Y + (-0.000036820) * Cb +    1.401987577 * Cr);
+					G = static_cast<int>(Y + (-0.344113281) * Cb + (-0.714103821) * Cr);
+					B = static_cast<int>(Y +    1.771978117 * Cb + (-0.000134583) * Cr);
+				}
+				else
+				{
+					// YBR_PARTIAL_422 is problematic
+					Y -= 16;
+					if (Y < 0) Y = 0; // invalid?
+					R = static_cast<int>(1.164415463 * Y + (-0.000095036) * Cb +    1.596001878 * Cr);
+					G = static_cast<int>(1.164415463 * Y + (-0.391724564) * Cb + (-0.813013368) * Cr);
+					B = static_cast<int>(1.164415463 * Y +    2.017290682 * Cb + (-0.000135273) * Cr);
 				}
-				it.NextLine();
+				if (R > 255) R = 255;
+				if (G > 255) G = 255;
+				if (B > 255) B = 255;
+				p[0] = static_cast<ValueType>(R < 0 ? 0 : R);
+				p[1] = static_cast<ValueType>(G < 0 ? 0 : G);
+				p[2] = static_cast<ValueType>(B < 0 ? 0 : B);
 			}
-			it.NextSlice();
+			else
+			{
+				const double H = (p__[j] / 255.0) * 360.0;
+				const double S = p__[j + 1]/ 255.0;
+				const double V = p__[j + 2] / 255.0;
+				double R, G, B;
+				ColorSpace_::Hsv2Rgb(&R, &G, &B, H, S, V);
+				p[0] = static_cast<ValueType>(R * 255.0);
+				p[1] = static_cast<ValueType>(G * 255.0);
+				p[2] = static_cast<ValueType>(B * 255.0);
+			}
+			j += 3;
+		}
+		if (delete_data)
+		{
+			delete [] data[z];
+			data[z] = nullptr;
 		}
-	}
-	catch(const itk::ExceptionObject & ex)
-	{
-		*ok = false;
-		return QString(ex.GetDescription());
 	}
 	return QString("");
 }
@@ -1719,7 +1773,8 @@ template<typename T> QString process_dicom_rgba_image1(
 	bool * ok,
 	ImageVariant * ivariant,
 	typename T::Pointer & image,
-	char * buffer,
+	std::vector<char*> & data,
+	const bool delete_data,
 	const itk::Matrix<itk::SpacePrecisionType, 3, 3> & direction,
 	const size_t dimx, const size_t dimy, const size_t dimz,
 	const double origin_x, const double origin_y, const double origin_z,
@@ -1729,145 +1784,111 @@ template<typename T> QString process_dicom_rgba_image1(
 	const bool argb,
 	bool * bad_direction)
 {
-	if (!buffer)
+	typedef typename T::PixelType PixelType;
+	typedef typename T::PixelType::ValueType ValueType;
+	QString error = check_dicom_buffers(data, dimz);
+	if (!error.isEmpty())
 	{
 		*ok = false;
-		return QString("process_dicom_rgba_image: buffer is null");
-	}
-	typename T::RegionType region;
-	typename T::SizeType size;
-	typename T::IndexType start;
-	typename T::PointType origin;
-	typename T::SpacingType spacing;
-	typedef itk::ImageSliceIteratorWithIndex<T> SliceIterator;
-	start.Fill(0);
-	size[0] = dimx;
-	size[1] = dimy;
-	size[2] = dimz;
-	region.SetIndex(start);
-	region.SetSize(size);
-	origin[0] = origin_x;
-	origin[1] = origin_y;
-	origin[2] = origin_z;
-	spacing[0] = spacing_x;
-	spacing[1] = spacing_y;
-	spacing[2] = spacing_z;
-	*bad_direction = check_direction_matrix(direction);
-	try
-	{
-		image = T::New();
-		image->SetRegions(region);
-		image->Allocate();
-		image->SetOrigin(origin);
-		image->SetSpacing(spacing);
-		if (*bad_direction == false) image->SetDirection(direction);
-	}
-	catch (const itk::ExceptionObject & ex)
+		return QString("process_dicom_rgba_image: ") + error;
+	}
+	const bool convert = (cmyk || argb);
+	const bool take = (!convert && data.size() == 1 && delete_data);
+	error = create_dicom_image<T>(
+		image, data, take,
+		direction,
+		dimx, dimy, dimz,
+		origin_x, origin_y, origin_z,
+		spacing_x, spacing_y, spacing_z,
+		bad_direction);
+	if (!error.isEmpty())
 	{
 		*ok = false;
-		return QString(ex.GetDescription());
+		return error;
 	}
-	//
-	const typename T::PixelType::ValueType * p__ =
-		reinterpret_cast<typename T::PixelType::ValueType*>(buffer);
 	ivariant->image_type = image_type;
-	//
-	try
+	if (take) return QString("");
+	if (!convert)
 	{
-		SliceIterator it(image, image->GetLargestPossibleRegion());
-		it.SetFirstDirection(0);
-		it.SetSecondDirection(1);
-		it.GoToBegin();
+		copy_dicom_buffers<T>(image, data, delete_data, dimx, dimy, dimz);
+		return QString("");
+	}
+	PixelType * out = image->GetBufferPointer();
+	const size_t n = (data.size() == 1) ? dimx * dimy * dimz : dimx * dimy;
+	for (size_t z = 0; z < data.size(); ++z)
+	{
+		const ValueType * p__ = reinterpret_cast<const ValueType*>(data[z]);
 		size_t j{};
-		while(!it.IsAtEnd())
+		for (size_t k = 0; k < n; ++k)
 		{
-			while (!it.IsAtEndOfSlice())
+			PixelType & p = out[z * n + k];
+			if (cmyk)
 			{
-				while (!it.IsAtEndOfLine())
-				{
-					typename T::PixelType p;
-					{
-						if (cmyk)
-						{
-							// CMYK (Retired)
-							// Pixel data represent a color image described by cyan, magenta,
-							// yellow, and black image  planes. The minimum sample value for
-							// each CMYK plane represents a minimum intensity of the color.
-							// This value may be used only when Samples per Pixel (0028,0002)
-							// has a value of 4.
-							const float C = static_cast<float>(p__[j]);
-							const float M = static_cast<float>(p__[j + 1]);
-							const float Y = static_cast<float>(p__[j + 2]);
-							const float K = static_cast<float>(p__[j + 3]);
+				// CMYK (Retired)
+				// Pixel data represent a color image described by cyan, magenta,
+				// yellow, and black image  planes. The minimum sample value for
+				// each CMYK plane represents a minimum intensity of the color.
+				// This value may be used only when Samples per Pixel (0028,0002)
+				// has a value of 4.
+				const float C = static_cast<float>(p__[j]);
+				const float M = static_cast<float>(p__[j + 1]);
+				const float Y = static_cast<float>(p__[j + 2]);
+				const float K = static_cast<float>(p__[j + 3]);
 #if 1
-							p[0] = static_cast<typename T::PixelType::ValueType>((C * K) / 255.0f);
-							p[1] = static_cast<typename T::PixelType::ValueType>((M * K) / 255.0f);
-							p[2] = static_cast<typename T::PixelType::ValueType>((Y * K) / 255.0f);
-							p[3] = 255;
+				p[0] = static_cast<ValueType>((C * K) / 255.0f);
+				p[1] = static_cast<ValueType>((M * K) / 255.0f);
+				p[2] = static_cast<ValueType>((Y * K) / 255.0f);
+				p[3] = 255;
 #else
-							if (p__[j+3] != 255)
-							{
-								p[0] = static_cast<typename T::PixelType::ValueType>(((255.0f - C) * (255.0f - K)) / 255.0f);
-								p[1] = static_cast<typename T::PixelType::ValueType>(((255.0f - M) * (255.0f - K)) / 255.0f);
-								p[2] = static_cast<typename T::PixelType::ValueType>(((255.0f - Y) * (255.0f - K)) / 255.0f);
-								p[3] = 255;
-							}
-							else
-							{
-								p[0] = static_cast<typename T::PixelType::ValueType>(255.0f - C);
-								p[1] = static_cast<typename T::PixelType::ValueType>(255.0f - M);
-								p[2] = static_cast<typename T::PixelType::ValueType>(255.0f - Y);
-								p[3] = 255;
-							}
-#endif
-						}
-						else if (argb)
-						{
-							// ARGB (Retired)
-							// Pixel data represent a color image
-							// described by red, green, blue, and alpha
-							// image planes. The minimum sample value for each
-							// RGB plane represents minimum intensity of the
-							// color. The alpha plane is passed through
-							// Palette Color Lookup Tables. If the alpha pixel
-							// value is greater than 0, the red, green, and blue
-							// lookup table values override the red, green, and
-							// blue, pixel plane colors.
-							//
-							// FIXME
-							const float tmp_max = 255.0f;
-							const float alpha = static_cast<float>(p__[j + 3]) / tmp_max;
-							const float one_minus_alpha = 1.0f - alpha;
-							const float tmp_oth = one_minus_alpha*0;
-							const float tmp_red = tmp_oth + alpha*static_cast<float>(p__[j]);
-							const float tmp_gre = tmp_oth + alpha*static_cast<float>(p__[j + 1]);
-							const float tmp_blu = tmp_oth + alpha*static_cast<float>(p__[j + 2]);
-							p[0] = static_cast<typename T::PixelType::ValueType>((tmp_red / tmp_max) * 255.0f);
-							p[1] = static_cast<typename T::PixelType::ValueType>((tmp_gre / tmp_max) * 255.0f);
-							p[2] = static_cast<typename T::PixelType::ValueType>((tmp_blu / tmp_max) * 255.0f);
-							p[3] = 255;
-						}
-						else
-						{
-							p[0] = static_cast<typename T::PixelType::ValueType>(p__[j]);
-							p[1] = static_cast<typename T::PixelType::ValueType>(p__[j + 1]);
-							p[2] = static_cast<typename T::PixelType::ValueType>(p__[j + 2]);
-							p[3] = static_cast<typename T::PixelType::ValueType>(p__[j + 3]);
-						}
-					}
-					it.Set(p);
-					j += 4;
-					++it;
+				if (p__[j+3] != 255)
+				{
+					p[0] = static_cast<ValueType>(((255.0f - C) * (255.0f - K)) / 255.0f);
+					p[1] = static_cast<ValueType>(((255.0f - M) * (255.0f - K)) / 255.0f);
+					p[2] = static_cast<ValueType>(((255.0f - Y) * (255.0f - K)) / 255.0f);
+					p[3] = 255;
+				}
+				else
+				{
+					p[0] = static_cast<ValueType>(255.0f - C);
+					p[1] = static_cast<ValueType>(255.0f - M);
+					p[2] = static_cast<ValueType>(255.0f - Y);
+					p[3] = 255;
 				}
-				it.NextLine();
+#endif
 			}
-			it.NextSlice();
+			else
+			{
+				// ARGB (Retired)
+				// Pixel data represent a color image
+				// described by red, green, blue, and alpha
+				// image planes. The minimum sample value for each
+				// RGB plane represents minimum intensity of the
+				// color. The alpha plane is passed through
+				// Palette Color Lookup Tables. If the alpha pixel
+				// value is greater than 0, the red, green, and blue
+				// lookup table values override the red, green, and
+				// blue, pixel plane colors.
+				//
+				// FIXME
+				const float tmp_max = 255.0f;
+				const float alpha = static_cast<float>(p__[j + 3]) / tmp_max;
+				const float one_minus_alpha = 1.0f - alpha;
+				const float tmp_oth = one_minus_alpha*0;
+				const float tmp_red = tmp_oth + alpha*static_cast<float>(p__[j]);
+				const float tmp_gre = tmp_oth + alpha*static_cast<float>(p__[j + 1]);
+				const float tmp_blu = tmp_oth + alpha*static_cast<float>(p__[j + 2]);
+				p[0] = static_cast<ValueType>((tmp_red / tmp_max) * 255.0f);
+				p[1] = static_cast<ValueType>((tmp_gre / tmp_max) * 255.0f);
+				p[2] = static_cast<ValueType>((tmp_blu / tmp_max) * 255.0f);
+				p[3] = 255;
+			}
+			j += 4;
+		}
+		if (delete_data)
+		{
+			delete [] data[z];
+			data[z] = nullptr;
 		}
-	}
-	catch(const itk::ExceptionObject & ex)
-	{
-		*ok = false;
-		return QString(ex.GetDescription());
 	}
 	return QString("");
 }
@@ -2023,15 +2044,13 @@ template<typename T> double get_value(
 int CommonUtils::get_next_id()
 {
 	static std::atomic<int> id___{};
-	++id___;
-	return id___;
+	return ++id___;
 }
 
 int CommonUtils::get_next_group_id()
 {
 	static std::atomic<int> group_id___{};
-	++group_id___;
-	return group_id___;
+	return ++group_id___;
 }
 
 double CommonUtils::random_range(
@@ -3563,76 +3582,18 @@ QString CommonUtils::gen_itk_image(bool * ok,
 		case mdcm::PixelFormat::INT12:
 		case mdcm::PixelFormat::INT16:
 			{
-				char * p__;
-				if (data_size > 1)
-				{
-					try
-					{
-						p__ = new char[dimx*dimy*dimz*2];
-					}
-					catch (const std::bad_alloc&)
-					{
-						return QString("const std::bad_alloc");
-					}
-					if (!p__) return QString("p__ is null");
-					size_t inc{};
-					for (size_t z_ = 0; z_ < dimz; ++z_)
-					{
-						if (!data.at(z_))
-						{
-							delete [] p__;
-							return QString("!data.at(") +
-								QVariant(static_cast<unsigned long long>(z_)).toString() +
-								QString(")");
-						}
-						size_t inc_xy{};
-						for (size_t y_ = 0; y_ < dimy; ++y_)
-						{
-							for (size_t x_ = 0; x_ < dimx; ++x_)
-							{
-								for (size_t ss_ = 0; ss_ < 2; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-						if (delete_data)
-						{
-							delete [] data[z_];
-							data[z_] = nullptr;
-						}
-					}
-				}
-				else
-				{
-					p__ = &data[0][0];
-				}
 				bool bad_direction{true};
 				error = process_dicom_monochrome_image1<ImageTypeSS>(
 					ok,
 					ivariant,
 					ivariant->pSS,
-					p__,
+					data, delete_data,
 					direction,
 					dimx, dimy, dimz,
 					origin_x, origin_y, origin_z,
 					spacing_x, spacing_y, spacing_z,
 					0,
 					&bad_direction);
-				if (data_size > 1)
-				{
-					delete [] p__;
-				}
-				else
-				{
-					if (delete_data)
-					{
-						delete [] data[0];
-						data[0] = nullptr;
-					}
-				}
 				if (!error.isEmpty()) return error;
 				process_dicom_monochrome_image2<ImageTypeSS>(
 					ivariant,
@@ -3644,76 +3605,18 @@ QString CommonUtils::gen_itk_image(bool * ok,
 		case mdcm::PixelFormat::UINT12:
 		case mdcm::PixelFormat::UINT16:
 			{
-				char * p__;
-				if (data_size > 1)
-				{
-					try
-					{
-						p__ = new char[dimx*dimy*dimz*2];
-					}
-					catch (const std::bad_alloc&)
-					{
-						return QString("const std::bad_alloc");
-					}
-					if (!p__) return QString("p__ is null");
-					size_t inc{};
-					for (size_t z_ = 0; z_ < dimz; ++z_)
-					{
-						if (!data.at(z_))
-						{
-							delete [] p__;
-							return QString("!data.at(") +
-								QVariant(static_cast<unsigned long long>(z_)).toString() +
-								QString(")");
-						}
-						size_t inc_xy{};
-						for (size_t y_ = 0; y_ < dimy; ++y_)
-						{
-							for (size_t x_ = 0; x_ < dimx; ++x_)
-							{
-								for (size_t ss_ = 0; ss_ < 2; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-						if (delete_data)
-						{
-							delete [] data[z_];
-							data[z_] = nullptr;
-						}
-					}
-				}
-				else
-				{
-					p__ = &data[0][0];
-				}
 				bool bad_direction{true};
 				error = process_dicom_monochrome_image1<ImageTypeUS>(
 					ok,
 					ivariant,
 					ivariant->pUS,
-					p__,
+					data, delete_data,
 					direction,
 					dimx, dimy, dimz,
 					origin_x, origin_y, origin_z,
 					spacing_x, spacing_y, spacing_z,
 					1,
 					&bad_direction);
-				if (data_size > 1)
-				{
-					delete [] p__;
-				}
-				else
-				{
-					if (delete_data)
-					{
-						delete [] data[0];
-						data[0] = nullptr;
-					}
-				}
 				if (!error.isEmpty()) return error;
 				process_dicom_monochrome_image2<ImageTypeUS>(
 					ivariant,
@@ -3724,76 +3627,18 @@ QString CommonUtils::gen_itk_image(bool * ok,
 			break;
 		case mdcm::PixelFormat::INT32:
 			{
-				char * p__;
-				if (data_size > 1)
-				{
-					try
-					{
-						p__ = new char[dimx*dimy*dimz*4];
-					}
-					catch (const std::bad_alloc&)
-					{
-						return QString("const std::bad_alloc");
-					}
-					if (!p__) return QString("p__ is null");
-					size_t inc{};
-					for (size_t z_ = 0; z_ < dimz; ++z_)
-					{
-						if (!data.at(z_))
-						{
-							delete [] p__;
-							return QString("!data.at(") +
-								QVariant(static_cast<unsigned long long>(z_)).toString() +
-								QString(")");
-						}
-						size_t inc_xy{};
-						for (size_t y_ = 0; y_ < dimy; ++y_)
-						{
-							for (size_t x_ = 0; x_ < dimx; ++x_)
-							{
-								for (size_t ss_ = 0; ss_ < 4; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-						if (delete_data)
-						{
-							delete [] data[z_];
-							data[z_] = nullptr;
-						}
-					}
-				}
-				else
-				{
-					p__ = &data[0][0];
-				}
 				bool bad_direction{true};
 				error = process_dicom_monochrome_image1<ImageTypeSI>(
 					ok,
 					ivariant,
 					ivariant->pSI,
-					p__,
+					data, delete_data,
 					direction,
 					dimx, dimy, dimz,
 					origin_x, origin_y, origin_z,
 					spacing_x, spacing_y, spacing_z,
 					2,
 					&bad_direction);
-				if (data_size > 1)
-				{
-					delete [] p__;
-				}
-				else
-				{
-					if (delete_data)
-					{
-						delete [] data[0];
-						data[0] = nullptr;
-					}
-				}
 				if (!error.isEmpty()) return error;
 				process_dicom_monochrome_image2<ImageTypeSI>(
 					ivariant,
@@ -3804,76 +3649,18 @@ QString CommonUtils::gen_itk_image(bool * ok,
 			break;
 		case mdcm::PixelFormat::UINT32:
 			{
-				char * p__;
-				if (data_size > 1)
-				{
-					try
-					{
-						p__ = new char[dimx*dimy*dimz*4];
-					}
-					catch (const std::bad_alloc&)
-					{
-						return QString("const std::bad_alloc");
-					}
-					if (!p__) return QString("p__ is null");
-					size_t inc{};
-					for (unsigned int z_ = 0; z_ < dimz; ++z_)
-					{
-						if (!data.at(z_))
-						{
-							delete [] p__;
-							return QString("!data.at(") +
-								QVariant(static_cast<unsigned long long>(z_)).toString() +
-								QString(")");
-						}
-						size_t inc_xy{};
-						for (size_t y_ = 0; y_ < dimy; ++y_)
-						{
-							for (size_t x_ = 0; x_ < dimx; ++x_)
-							{
-								for (size_t ss_ = 0; ss_ < 4; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-						if (delete_data)
-						{
-							delete [] data[z_];
-							data[z_] = nullptr;
-						}
-					}
-				}
-				else
-				{
-					p__ = &data[0][0];
-				}
 				bool bad_direction{true};
 				error = process_dicom_monochrome_image1<ImageTypeUI>(
 					ok,
 					ivariant,
 					ivariant->pUI,
-					p__,
+					data, delete_data,
 					direction,
 					dimx, dimy, dimz,
 					origin_x, origin_y, origin_z,
 					spacing_x, spacing_y, spacing_z,
 					3,
 					&bad_direction);
-				if (data_size > 1)
-				{
-					delete [] p__;
-				}
-				else
-				{
-					if (delete_data)
-					{
-						delete [] data[0];
-						data[0] = nullptr;
-					}
-				}
 				if (!error.isEmpty()) return error;
 				process_dicom_monochrome_image2<ImageTypeUI>(
 					ivariant,
@@ -3884,76 +3671,18 @@ QString CommonUtils::gen_itk_image(bool * ok,
 			break;
 		case mdcm::PixelFormat::INT64:
 			{
-				char * p__;
-				if (data_size > 1)
-				{
-					try
-					{
-						p__ = new char[dimx*dimy*dimz*8];
-					}
-					catch (const std::bad_alloc&)
-					{
-						return QString("const std::bad_alloc");
-					}
-					if (!p__) return QString("p__ is null");
-					size_t inc{};
-					for (size_t z_ = 0; z_ < dimz; ++z_)
-					{
-						if (!data.at(z_))
-						{
-							delete [] p__;
-							return QString("!data.at(") +
-								QVariant(static_cast<unsigned long long>(z_)).toString() +
-								QString(")");
-						}
-						size_t inc_xy{};
-						for (size_t y_ = 0; y_ < dimy; ++y_)
-						{
-							for (size_t x_ = 0; x_ < dimx; ++x_)
-							{
-								for (size_t ss_ = 0; ss_ < 8; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-						if (delete_data)
-						{
-							delete [] data[z_];
-							data[z_] = nullptr;
-						}
-					}
-				}
-				else
-				{
-					p__ = &data[0][0];
-				}
 				bool bad_direction{true};
 				error = process_dicom_monochrome_image1<ImageTypeSLL>(
 					ok,
 					ivariant,
 					ivariant->pSLL,
-					p__,
+					data, delete_data,
 					direction,
 					dimx, dimy, dimz,
 					origin_x, origin_y, origin_z,
 					spacing_x, spacing_y, spacing_z,
 					7,
 					&bad_direction);
-				if (data_size > 1)
-				{
-					delete [] p__;
-				}
-				else
-				{
-					if (delete_data)
-					{
-						delete [] data[0];
-						data[0] = nullptr;
-					}
-				}
 				if (!error.isEmpty()) return error;
 				process_dicom_monochrome_image2<ImageTypeSLL>(
 					ivariant,
@@ -3964,76 +3693,18 @@ QString CommonUtils::gen_itk_image(bool * ok,
 			break;
 		case mdcm::PixelFormat::UINT64:
 			{
-				char * p__;
-				if (data_size > 1)
-				{
-					try
-					{
-						p__ = new char[dimx*dimy*dimz*8];
-					}
-					catch (const std::bad_alloc&)
-					{
-						return QString("const std::bad_alloc");
-					}
-					if (!p__) return QString("p__ is null");
-					size_t inc{};
-					for (size_t z_ = 0; z_ < dimz; ++z_)
-					{
-						if (!data.at(z_))
-						{
-							delete [] p__;
-							return QString("!data.at(") +
-								QVariant(static_cast<unsigned long long>(z_)).toString() +
-								QString(")");
-						}
-						size_t inc_xy{};
-						for (size_t y_ = 0; y_ < dimy; ++y_)
-						{
-							for (size_t x_ = 0; x_ < dimx; ++x_)
-							{
-								for (size_t ss_ = 0; ss_ < 8; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-						if (delete_data)
-						{
-							delete [] data[z_];
-							data[z_] = nullptr;
-						}
-					}
-				}
-				else
-				{
-					p__ = &data[0][0];
-				}
 				bool bad_direction{true};
 				error = process_dicom_monochrome_image1<ImageTypeULL>(
 					ok,
 					ivariant,
 					ivariant->pULL,
-					p__,
+					data, delete_data,
 					direction,
 					dimx, dimy, dimz,
 					origin_x, origin_y, origin_z,
 					spacing_x, spacing_y, spacing_z,
 					8,
 					&bad_direction);
-				if (data_size > 1)
-				{
-					delete [] p__;
-				}
-				else
-				{
-					if (delete_data)
-					{
-						delete [] data[0];
-						data[0] = nullptr;
-					}
-				}
 				if (!error.isEmpty()) return error;
 				process_dicom_monochrome_image2<ImageTypeULL>(
 					ivariant,
@@ -4046,77 +3717,19 @@ QString CommonUtils::gen_itk_image(bool * ok,
 		case mdcm::PixelFormat::UINT8:
 		case mdcm::PixelFormat::SINGLEBIT:
 			{
-				char * p__;
-				if (data_size > 1)
-				{
-					try
-					{
-						p__ = new char[dimx*dimy*dimz];
-					}
-					catch (const std::bad_alloc&)
-					{
-						return QString("const std::bad_alloc");
-					}
-					if (!p__) return QString("p__ is null");
-					size_t inc{};
-					for (size_t z_ = 0; z_ < dimz; ++z_)
-					{
-						if (!data.at(z_))
-						{
-							delete [] p__;
-							return QString("!data.at(") +
-								QVariant(static_cast<unsigned long long>(z_)).toString() +
-								QString(")");
-						}
-						size_t inc_xy{};
-						for (size_t y_ = 0; y_ < dimy; ++y_)
-						{
-							for (size_t x_ = 0; x_ < dimx; ++x_)
-							{
-								for (size_t ss_ = 0; ss_ < 1; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-						if (delete_data)
-						{
-							delete [] data[z_];
-							data[z_] = nullptr;
-						}
-					}
-				}
-				else
-				{
-					p__ = &data[0][0];
-				}
 				ivariant->di->maxwindow = true;
 				bool bad_direction{true};
 				error = process_dicom_monochrome_image1<ImageTypeUC>(
 					ok,
 					ivariant,
 					ivariant->pUC,
-					p__,
+					data, delete_data,
 					direction,
 					dimx, dimy, dimz,
 					origin_x, origin_y, origin_z,
 					spacing_x, spacing_y, spacing_z,
 					4,
 					&bad_direction);
-				if (data_size > 1)
-				{
-					delete [] p__;
-				}
-				else
-				{
-					if (delete_data)
-					{
-						delete [] data[0];
-						data[0] = nullptr;
-					}
-				}
 				if (!error.isEmpty()) return error;
 				process_dicom_monochrome_image2<ImageTypeUC>(
 					ivariant,
@@ -4127,76 +3740,18 @@ QString CommonUtils::gen_itk_image(bool * ok,
 			break;
 		case mdcm::PixelFormat::FLOAT32:
 			{
-				char * p__;
-				if (data_size > 1)
-				{
-					try
-					{
-						p__ = new char[dimx*dimy*dimz*4];
-					}
-					catch (const std::bad_alloc&)
-					{
-						return QString("const std::bad_alloc");
-					}
-					if (!p__) return QString("p__ is null");
-					size_t inc{};
-					for (size_t z_ = 0; z_ < dimz; ++z_)
-					{
-						if (!data.at(z_))
-						{
-							delete [] p__;
-							return QString("!data.at(") +
-								QVariant(static_cast<unsigned long long>(z_)).toString() +
-								QString(")");
-						}
-						size_t inc_xy{};
-						for (size_t y_ = 0; y_ < dimy; ++y_)
-						{
-							for (size_t x_ = 0; x_ < dimx; ++x_)
-							{
-								for (size_t ss_ = 0; ss_ < 4; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-						if (delete_data)
-						{
-							delete [] data[z_];
-							data[z_] = nullptr;
-						}
-					}
-				}
-				else
-				{
-					p__ = &data[0][0];
-				}
 				bool bad_direction{true};
 				error = process_dicom_monochrome_image1<ImageTypeF>(
 					ok,
 					ivariant,
 					ivariant->pF,
-					p__,
+					data, delete_data,
 					direction,
 					dimx, dimy, dimz,
 					origin_x, origin_y, origin_z,
 					spacing_x, spacing_y, spacing_z,
 					5,
 					&bad_direction);
-				if (data_size > 1)
-				{
-					delete [] p__;
-				}
-				else
-				{
-					if (delete_data)
-					{
-						delete [] data[0];
-						data[0] = nullptr;
-					}
-				}
 				if (!error.isEmpty()) return error;
 				process_dicom_monochrome_image2<ImageTypeF>(
 					ivariant,
@@ -4207,76 +3762,18 @@ QString CommonUtils::gen_itk_image(bool * ok,
 			break;
 		case mdcm::PixelFormat::FLOAT64:
 			{
-				char * p__;
-				if (data_size > 1)
-				{
-					try
-					{
-						p__ = new char[dimx*dimy*dimz*8];
-					}
-					catch (const std::bad_alloc&)
-					{
-						return QString("const std::bad_alloc");
-					}
-					if (!p__) return QString("p__ is null");
-					size_t inc{};
-					for (size_t z_ = 0; z_ < dimz; ++z_)
-					{
-						if (!data.at(z_))
-						{
-							delete [] p__;
-							return QString("!data.at(") +
-								QVariant(static_cast<unsigned long long>(z_)).toString() +
-								QString(")");
-						}
-						size_t inc_xy{};
-						for (size_t y_ = 0; y_ < dimy; ++y_)
-						{
-							for (size_t x_ = 0; x_ < dimx; ++x_)
-							{
-								for (size_t ss_ = 0; ss_ < 8; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-						if (delete_data)
-						{
-							delete [] data[z_];
-							data[z_] = nullptr;
-						}
-					}
-				}
-				else
-				{
-					p__ = &data[0][0];
-				}
 				bool bad_direction{true};
 				error = process_dicom_monochrome_image1<ImageTypeD>(
 					ok,
 					ivariant,
 					ivariant->pD,
-					p__,
+					data, delete_data,
 					direction,
 					dimx, dimy, dimz,
 					origin_x, origin_y, origin_z,
 					spacing_x, spacing_y, spacing_z,
 					6,
 					&bad_direction);
-				if (data_size > 1)
-				{
-					delete [] p__;
-				}
-				else
-				{
-					if (delete_data)
-					{
-						delete [] data[0];
-						data[0] = nullptr;
-					}
-				}
 				if (!error.isEmpty()) return error;
 				process_dicom_monochrome_image2<ImageTypeD>(
 					ivariant,
@@ -4303,62 +3800,13 @@ QString CommonUtils::gen_itk_image(bool * ok,
 			pixelformat == mdcm::PixelFormat::UINT8 ||
 			pixelformat == mdcm::PixelFormat::INT8)
 		{
-			char * p__;
 			const int bitsstored = pixelformat.GetBitsStored();
-			if (data_size > 1)
-			{
-				try
-				{
-					p__ = new char[dimx*dimy*dimz*3];
-				}
-				catch (const std::bad_alloc&)
-				{
-					return QString("const std::bad_alloc");
-				}
-				if (!p__) return QString("p__ is null");
-				size_t inc{};
-				for (size_t z_ = 0; z_ < dimz; ++z_)
-				{
-					if (!data.at(z_))
-					{
-						delete [] p__;
-						return QString("!data.at(") +
-							QVariant(static_cast<unsigned long long>(z_)).toString() +
-							QString(")");
-					}
-					size_t inc_xy{};
-					for (size_t y_ = 0; y_ < dimy; ++y_)
-					{
-						for (size_t x_ = 0; x_ < dimx; ++x_)
-						{
-							for (size_t rgb__ = 0; rgb__ < 3; ++rgb__)
-							{
-								for (size_t ss_ = 0; ss_ < 1; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-					}
-					if (delete_data)
-					{
-						delete [] data[z_];
-						data[z_] = nullptr;
-					}
-				}
-			}
-			else
-			{
-				p__ = &data[0][0];
-			}
 			bool bad_direction{true};
 			error = process_dicom_rgb_image1<RGBImageTypeUC>(
 				ok,
 				ivariant,
 				ivariant->pUC_rgb,
-				p__,
+				data, delete_data,
 				direction,
 				dimx, dimy, dimz,
 				origin_x, origin_y, origin_z,
@@ -4368,18 +3816,6 @@ QString CommonUtils::gen_itk_image(bool * ok,
 				hsv,
 				bitsstored,
 				&bad_direction);
-			if (data_size > 1)
-			{
-				delete [] p__;
-			}
-			else
-			{
-				if (delete_data)
-				{
-					delete [] data[0];
-					data[0] = nullptr;
-				}
-			}
 			if (!error.isEmpty()) return error;
 			process_dicom_rgb_image2<RGBImageTypeUC>(
 				ivariant,
@@ -4391,62 +3827,13 @@ QString CommonUtils::gen_itk_image(bool * ok,
 			pixelformat == mdcm::PixelFormat::UINT16 ||
 			pixelformat == mdcm::PixelFormat::UINT12)
 		{
-			char * p__;
 			const int bitsstored = pixelformat.GetBitsStored();
-			if (data_size > 1)
-			{
-				try
-				{
-					p__ = new char[dimx*dimy*dimz*6];
-				}
-				catch (const std::bad_alloc&)
-				{
-					return QString("const std::bad_alloc");
-				}
-				if (!p__) return QString("p__ is null");
-				size_t inc{};
-				for (size_t z_ = 0; z_ < dimz; ++z_)
-				{
-					if (!data.at(z_))
-					{
-						delete [] p__;
-						return QString("!data.at(") +
-							QVariant(static_cast<unsigned long long>(z_)).toString() +
-							QString(")");
-					}
-					size_t inc_xy{};
-					for (size_t y_ = 0; y_ < dimy; ++y_)
-					{
-						for (size_t x_ = 0; x_ < dimx; ++x_)
-						{
-							for (size_t rgb__ = 0; rgb__ < 3; ++rgb__)
-							{
-								for (size_t ss_ = 0; ss_ < 2; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-					}
-					if (delete_data)
-					{
-						delete [] data[z_];
-						data[z_] = nullptr;
-					}
-				}
-			}
-			else
-			{
-				p__ = &data[0][0];
-			}
 			bool bad_direction{true};
 			error = process_dicom_rgb_image1<RGBImageTypeUS>(
 				ok,
 				ivariant,
 				ivariant->pUS_rgb,
-				p__,
+				data, delete_data,
 				direction,
 				dimx, dimy, dimz,
 				origin_x, origin_y, origin_z,
@@ -4456,18 +3843,6 @@ QString CommonUtils::gen_itk_image(bool * ok,
 				false,
 				bitsstored,
 				&bad_direction);
-			if (data_size > 1)
-			{
-				delete [] p__;
-			}
-			else
-			{
-				if (delete_data)
-				{
-					delete [] data[0];
-					data[0] = nullptr;
-				}
-			}
 			if (!error.isEmpty()) return error;
 			process_dicom_rgb_image2<RGBImageTypeUS>(
 				ivariant,
@@ -4479,61 +3854,12 @@ QString CommonUtils::gen_itk_image(bool * ok,
 			pixelformat == mdcm::PixelFormat::INT16 ||
 			pixelformat == mdcm::PixelFormat::INT12)
 		{
-			char * p__;
-			if (data_size > 1)
-			{
-				try
-				{
-					p__ = new char[dimx*dimy*dimz*6];
-				}
-				catch (const std::bad_alloc&)
-				{
-					return QString("const std::bad_alloc");
-				}
-				if (!p__) return QString("p__ is null");
-				size_t inc{};
-				for (size_t z_ = 0; z_ < dimz; ++z_)
-				{
-					if (!data.at(z_))
-					{
-						delete [] p__;
-						return QString("!data.at(") +
-							QVariant(static_cast<unsigned long long>(z_)).toString() +
-							QString(")");
-					}
-					size_t inc_xy{};
-					for (size_t y_ = 0; y_ < dimy; ++y_)
-					{
-						for (size_t x_ = 0; x_ < dimx; ++x_)
-						{
-							for (size_t rgb__ = 0; rgb__ < 3; ++rgb__)
-							{
-								for (size_t ss_ = 0; ss_ < 2; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-					}
-					if (delete_data)
-					{
-						delete [] data[z_];
-						data[z_] = nullptr;
-					}
-				}
-			}
-			else
-			{
-				p__ = &data[0][0];
-			}
 			bool bad_direction{true};
 			error = process_dicom_rgb_image1<RGBImageTypeSS>(
 				ok,
 				ivariant,
 				ivariant->pSS_rgb,
-				p__,
+				data, delete_data,
 				direction,
 				dimx, dimy, dimz,
 				origin_x, origin_y, origin_z,
@@ -4543,18 +3869,6 @@ QString CommonUtils::gen_itk_image(bool * ok,
 				false,
 				0,
 				&bad_direction);
-			if (data_size > 1)
-			{
-				delete [] p__;
-			}
-			else
-			{
-				if (delete_data)
-				{
-					delete [] data[0];
-					data[0] = nullptr;
-				}
-			}
 			if (!error.isEmpty()) return error;
 			process_dicom_rgb_image2<RGBImageTypeSS>(
 				ivariant,
@@ -4564,61 +3878,12 @@ QString CommonUtils::gen_itk_image(bool * ok,
 		}
 		else if (pixelformat == mdcm::PixelFormat::FLOAT32)
 		{
-			char * p__;
-			if (data_size > 1)
-			{
-				try
-				{
-					p__ = new char[dimx*dimy*dimz*12];
-				}
-				catch (const std::bad_alloc&)
-				{
-					return QString("const std::bad_alloc");
-				}
-				if (!p__) return QString("p__ is null");
-				size_t inc{};
-				for (size_t z_ = 0; z_ < dimz; ++z_)
-				{
-					if (!data.at(z_))
-					{
-						delete [] p__;
-						return QString("!data.at(") +
-							QVariant(static_cast<unsigned long long>(z_)).toString() +
-							QString(")");
-					}
-					size_t inc_xy{};
-					for (size_t y_ = 0; y_ < dimy; ++y_)
-					{
-						for (size_t x_ = 0; x_ < dimx; ++x_)
-						{
-							for (size_t rgb__ = 0; rgb__ < 3; ++rgb__)
-							{
-								for (size_t ss_ = 0; ss_ < 4; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-					}
-					if (delete_data)
-					{
-						delete [] data[z_];
-						data[z_] = nullptr;
-					}
-				}
-			}
-			else
-			{
-				p__ = &data[0][0];
-			}
 			bool bad_direction{true};
 			error = process_dicom_rgb_image1<RGBImageTypeF>(
 				ok,
 				ivariant,
 				ivariant->pF_rgb,
-				p__,
+				data, delete_data,
 				direction,
 				dimx, dimy, dimz,
 				origin_x, origin_y, origin_z,
@@ -4628,18 +3893,6 @@ QString CommonUtils::gen_itk_image(bool * ok,
 				false,
 				0,
 				&bad_direction);
-			if (data_size > 1)
-			{
-				delete [] p__;
-			}
-			else
-			{
-				if (delete_data)
-				{
-					delete [] data[0];
-					data[0] = nullptr;
-				}
-			}
 			if (!error.isEmpty()) return error;
 			process_dicom_rgb_image2<RGBImageTypeF>(
 				ivariant,
@@ -4671,61 +3924,12 @@ QString CommonUtils::gen_itk_image(bool * ok,
 		if (pixelformat == mdcm::PixelFormat::UINT8 ||
 			pixelformat == mdcm::PixelFormat::INT8)
 		{
-			char * p__;
-			if (data_size > 1)
-			{
-				try
-				{
-					p__ = new char[dimx*dimy*dimz*4];
-				}
-				catch (const std::bad_alloc&)
-				{
-					return QString("const std::bad_alloc");
-				}
-				if (!p__) return QString("p__ is null");
-				size_t inc{};
-				for (size_t z_ = 0; z_ < dimz; ++z_)
-				{
-					if (!data.at(z_))
-					{
-						delete [] p__;
-						return QString("!data.at(") +
-							QVariant(static_cast<unsigned long long>(z_)).toString() +
-							QString(")");
-					}
-					size_t inc_xy{};
-					for (size_t y_ = 0; y_ < dimy; ++y_)
-					{
-						for (size_t x_ = 0; x_ < dimx; ++x_)
-						{
-							for (size_t rgba__ = 0; rgba__ < 4; ++rgba__)
-							{
-								for (size_t ss_ = 0; ss_ < 1; ++ss_)
-								{
-									p__[inc] = data.at(z_)[inc_xy];
-									++inc;
-									++inc_xy;
-								}
-							}
-						}
-					}
-					if (delete_data)
-					{
-						delete [] data[z_];
-						data[z_] = nullptr;
-					}
-				}
-			}
-			else
-			{
-				p__ = &data[0][0];
-			}
 			bool bad_direction{true};
 			error = process_dicom_rgba_image1<RGBAImageTypeUC>(
 				ok,
 				ivariant,
 				ivariant->pUC_rgba,
-				p__,
+				data, delete_data,
 				direction,
 				dimx, dimy, dimz,
 				origin_x, origin_y, origin_z,
@@ -4734,18 +3938,6 @@ QString CommonUtils::gen_itk_image(bool * ok,
 				cmyk,
 				argb,
 				&bad_direction);
-			if (data_size > 1)
-			{
-				delete [] p__;
-			}
-			else
-			{
-				if (delete_data)
-				{
-					delete [] data[0];
-					data[0] = nullptr;
-				}
-			}
 			if (!error.isEmpty()) return error;
 			process_dicom_rgba_image2<RGBAImageTypeUC>(
 				ivariant,
@@ -27,7 +27,6 @@
 #include "colorspace/colorspace.h"
 #include <itkImageRegionIterator.h>
 #include <itkImageRegionConstIterator.h>
-#include <itkByteSwapper.h>
 #include <mdcmSystem.h>
 #include <mdcmReader.h>
 #include <mdcmFile.h>
@@ -63,6 +62,10 @@
 #ifndef ALIZA_LOAD_DCM_THREAD
 #include <QApplication>
 #endif
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
 #include "settingswidget.h"
 #include "updateqtcommand.h"
 #include <iostream>
@@ -72,6 +75,7 @@
 #include <random>
 #include <chrono>
 #include <atomic>
+#include <memory>
 #include "vectormath/scalar/vectormath.h"
 #ifdef ALIZA_USE_SYSTEM_LCMS2
 #include <lcms2.h>
@@ -219,92 +223,169 @@ bool sort_frames_ippiop(
 	return true;
 }
 
-struct files_less_than_ipp
+// Number of element headers checked by DicomUtils::is_dicom_stream()
+constexpr int sniff_elements = 4;
+
+bool is_sniff_vr(const unsigned char * v)
 {
-	inline bool operator() (const QString & f1, const QString & f2)
+	static const char vrs[] =
+		"AEASATCSDADSDTFDFLISLOLTOBODOFOLOVOWPNSHSLSQSSSTSVTMUCUIULUNURUSUTUV";
+	for (size_t x = 0; x + 1 < sizeof(vrs); x += 2)
 	{
-		const double t{0.001};
-		mdcm::Tag ipp(0x0020,0x0032);
-		mdcm::Tag iop(0x0020,0x0037);
-		std::set<mdcm::Tag> tags;
-		tags.insert(ipp);
-		tags.insert(iop);
-		mdcm::Reader reader1;
-		mdcm::Reader reader2;
-#ifdef _WIN32
-#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-		reader1.SetFileName(QDir::toNativeSeparators(f1).toUtf8().constData());
-		reader2.SetFileName(QDir::toNativeSeparators(f2).toUtf8().constData());
-#else
-		reader1.SetFileName(QDir::toNativeSeparators(f1).toLocal8Bit().constData());
-		reader2.SetFileName(QDir::toNativeSeparators(f2).toLocal8Bit().constData());
-#endif
-#else
-		reader1.SetFileName(f1.toLocal8Bit().constData());
-		reader2.SetFileName(f2.toLocal8Bit().constData());
-#endif
-		if (reader1.ReadSelectedTags(tags) && reader2.ReadSelectedTags(tags))
+		if (v[0] == vrs[x] && v[1] == vrs[x + 1]) return true;
+	}
+	return false;
+}
+
+// VRs with 2 reserved bytes and 32-bit length in explicit VR
+bool is_sniff_long_vr(const unsigned char * v)
+{
+	static const char vrs[] = "OBODOFOLOVOWSQSVUCUNURUTUV";
+	for (size_t x = 0; x + 1 < sizeof(vrs); x += 2)
+	{
+		if (v[0] == vrs[x] && v[1] == vrs[x + 1]) return true;
+	}
+	return false;
+}
+
+// Element headers of a data set without preamble and meta information,
+// little endian. Only headers are read, values are skipped. Tags must
+// increase. The file may be truncated, the first element must fit in
+// the file, an element after it may end after the end of the file.
+bool sniff_data_set(std::istream & is, std::streamoff size, bool explicit_vr)
+{
+	std::streamoff pos = 0;
+	unsigned int prev = 0;
+	for (int x = 0; x < sniff_elements; ++x)
+	{
+		if (pos == size) return (x > 0);
+		if (pos + 8 > size) return (x > 0);
+		unsigned char h[12];
+		is.clear();
+		is.seekg(pos, std::ios_base::beg);
+		if (!is.read(reinterpret_cast<char *>(h), 8)) return false;
+		const unsigned int group = h[0] | (h[1] << 8);
+		const unsigned int tag = (group << 16) | h[2] | (h[3] << 8);
+		if (x == 0)
 		{
-			const mdcm::DataSet & ds1 = reader1.GetFile().GetDataSet();
-			const mdcm::DataSet & ds2 = reader2.GetFile().GetDataSet();
-			if (!ds1.FindDataElement(ipp) || !ds2.FindDataElement(ipp))
-			{
-				return false;
-			}
-			if (!ds1.FindDataElement(iop) || !ds2.FindDataElement(iop))
-			{
-				return false;
-			}
-			mdcm::Attribute<0x0020,0x0032> ipp1;
-			ipp1.Set(ds1);
-			mdcm::Attribute<0x0020,0x0037> iop1;
-			iop1.Set(ds1);
-			mdcm::Attribute<0x0020,0x0032> ipp2;
-			ipp2.Set(ds2);
-			mdcm::Attribute<0x0020,0x0037> iop2;
-			iop2.Set(ds2);
-			if (ipp1.GetNumberOfValues() < 3 || ipp2.GetNumberOfValues() < 3)
+			// 0x0003 and 0x0005 are illegal, but files exist
+			if (!(group == 0x0002 || group == 0x0003 || group == 0x0005 || group == 0x0008))
 			{
 				return false;
 			}
-			if (iop1.GetNumberOfValues() < 6 || iop2.GetNumberOfValues() < 6)
+		}
+		else if (tag <= prev)
+		{
+			return false;
+		}
+		prev = tag;
+		unsigned long long length{};
+		std::streamoff header{8};
+		if (explicit_vr)
+		{
+			if (!is_sniff_vr(h + 4)) return false;
+			if (is_sniff_long_vr(h + 4))
 			{
-				return false;
+				if (pos + 12 > size) return (x > 0);
+				if (!is.read(reinterpret_cast<char *>(h + 8), 4)) return false;
+				length =
+					static_cast<unsigned long long>(h[8]) |
+					static_cast<unsigned long long>(h[9]) << 8 |
+					static_cast<unsigned long long>(h[10]) << 16 |
+					static_cast<unsigned long long>(h[11]) << 24;
+				header = 12;
 			}
-			if (!(
-				((iop1[0] + t) > iop2[0]) && ((iop1[0] - t) < iop2[0]) &&
-				((iop1[1] + t) > iop2[1]) && ((iop1[1] - t) < iop2[1]) &&
-				((iop1[2] + t) > iop2[2]) && ((iop1[2] - t) < iop2[2]) &&
-				((iop1[3] + t) > iop2[3]) && ((iop1[3] - t) < iop2[3]) &&
-				((iop1[4] + t) > iop2[4]) && ((iop1[4] - t) < iop2[4]) &&
-				((iop1[5] + t) > iop2[5]) && ((iop1[5] - t) < iop2[5])))
+			else
 			{
-				return false;
+				length = h[6] | (h[7] << 8);
 			}
-			double normal[3];
-			normal[0] = (iop1[1] * iop1[5]) - (iop1[2] * iop1[4]);
-			normal[1] = (iop1[2] * iop1[3]) - (iop1[0] * iop1[5]);
-			normal[2] = (iop1[0] * iop1[4]) - (iop1[1] * iop1[3]);
-			double dist1{};
-			double dist2{};
-			for (int i = 0; i < 3; ++i) dist1 += normal[i] * ipp1[i];
-			for (int i = 0; i < 3; ++i) dist2 += normal[i] * ipp2[i];
-			const bool r = (dist1 < dist2);
-			return r;
 		}
-		return false;
+		else
+		{
+			length =
+				static_cast<unsigned long long>(h[4]) |
+				static_cast<unsigned long long>(h[5]) << 8 |
+				static_cast<unsigned long long>(h[6]) << 16 |
+				static_cast<unsigned long long>(h[7]) << 24;
+		}
+		// Sequence or encapsulated data, items are not checked,
+		// at least one element before must be valid.
+		if (length == 0xffffffffULL) return (x > 0);
+		pos += header + static_cast<std::streamoff>(length);
+		if (pos > size) return (x > 0);
+	}
+	return true;
+}
+
+// IPP/IOP of image files, collected by read_dicom() when the files
+// are read first, files without valid values are not in the map.
+typedef std::map<QString, IPPIOP> FilesIPPIOP;
+
+void collect_ippiop(
+	const QString & f,
+	const mdcm::DataSet & ds,
+	FilesIPPIOP & m)
+{
+	const mdcm::Tag ipp(0x0020,0x0032);
+	const mdcm::Tag iop(0x0020,0x0037);
+	if (!ds.FindDataElement(ipp) || !ds.FindDataElement(iop))
+	{
+		return;
+	}
+	mdcm::Attribute<0x0020,0x0032> ipp1;
+	ipp1.Set(ds);
+	mdcm::Attribute<0x0020,0x0037> iop1;
+	iop1.Set(ds);
+	if (ipp1.GetNumberOfValues() < 3 || iop1.GetNumberOfValues() < 6)
+	{
+		return;
+	}
+	m.insert(std::make_pair(
+		f,
+		IPPIOP(
+			0,
+			ipp1[0], ipp1[1], ipp1[2],
+			iop1[0], iop1[1], iop1[2], iop1[3], iop1[4], iop1[5])));
+}
+
+// A file without values is not less and not greater than any other.
+struct files_less_than_ipp
+{
+	inline bool operator() (
+		const std::pair<bool, IPPIOP> & s1,
+		const std::pair<bool, IPPIOP> & s2)
+	{
+		if (!s1.first || !s2.first) return false;
+		return less_than_ipp()(s1.second, s2.second);
 	}
 };
 
 void sort_dicom_files_ippiop(
 	const std::vector<QString> & images,
+	const FilesIPPIOP & positions,
 	std::vector<QString> & images_ipp)
 {
+	std::vector<std::pair<bool, IPPIOP>> tmp0;
+	tmp0.reserve(images.size());
 	for (size_t x = 0; x < images.size(); ++x)
 	{
-		images_ipp.push_back(images.at(x));
+		FilesIPPIOP::const_iterator it = positions.find(images.at(x));
+		if (it != positions.cend())
+		{
+			IPPIOP tmp1 = it->second;
+			tmp1.idx = static_cast<unsigned int>(x);
+			tmp0.push_back(std::make_pair(true, tmp1));
+		}
+		else
+		{
+			tmp0.push_back(std::make_pair(false, IPPIOP(static_cast<unsigned int>(x), 0, 0, 0, 0, 0, 0, 0, 0, 0)));
+		}
+	}
+	std::stable_sort(tmp0.begin(), tmp0.end(), files_less_than_ipp());
+	for (size_t x = 0; x < tmp0.size(); ++x)
+	{
+		images_ipp.push_back(images.at(tmp0.at(x).second.idx));
 	}
-	std::stable_sort(images_ipp.begin(), images_ipp.end(), files_less_than_ipp());
 }
 
 bool acqtime_less_than(const QString & s1, const QString & s2)
@@ -2157,9 +2238,258 @@ unsigned int process_gsps(
 	return count;
 }
 
+// Reads and decodes one file of a series of single-frame images
+// in a worker thread into its slice of the volume buffer, the results
+// are taken in order by read_series().
+class ReadSeriesSlice_ : public QRunnable
+{
+public:
+	ReadSeriesSlice_(
+		const QString & f,
+		const int idx_,
+		const bool overlays_enabled_,
+		const bool rescale_,
+		const bool force_double_pf_,
+		const bool clean_unused_bits_,
+		const bool pred6_bug_,
+		const bool cornell_bug_,
+		const bool fix_jpeg_prec_,
+		const bool skip_too_large_,
+		const bool use_icc_,
+		char * target_,
+		const size_t target_size_,
+		const std::atomic<bool> * canceled_)
+		:
+		filename(f),
+		idx(idx_),
+		overlays_enabled(overlays_enabled_),
+		rescale(rescale_),
+		force_double_pf(force_double_pf_),
+		clean_unused_bits(clean_unused_bits_),
+		pred6_bug(pred6_bug_),
+		cornell_bug(cornell_bug_),
+		fix_jpeg_prec(fix_jpeg_prec_),
+		skip_too_large(skip_too_large_),
+		use_icc(use_icc_),
+		target(target_),
+		target_size(target_size_),
+		canceled(canceled_)
+	{
+		setAutoDelete(false);
+	}
+
+	~ReadSeriesSlice_()
+	{
+		for (size_t x = 0; x < data.size(); ++x)
+		{
+			delete [] data[x];
+		}
+	}
+
+	void run() override
+	{
+		if (canceled->load())
+		{
+			done.release();
+			return;
+		}
+		reader.SetMemoryMapping(DicomUtils::get_memory_mapping());
+#ifdef _WIN32
+#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
+		reader.SetFileName(QDir::toNativeSeparators(filename).toUtf8().constData());
+#else
+		reader.SetFileName(QDir::toNativeSeparators(filename).toLocal8Bit().constData());
+#endif
+#else
+		reader.SetFileName(filename.toLocal8Bit().constData());
+#endif
+		reader.SetApplySupplementalLUT(false);
+		reader.SetProcessOverlays(overlays_enabled);
+		DicomUtils::set_decode_options(
+			reader, clean_unused_bits, pred6_bug, cornell_bug, fix_jpeg_prec);
+		// slices are already in parallel, one thread per JPEG 2000 decoder
+		{
+			mdcm::DecodeOptions o = reader.GetDecodeOptions();
+			o.CodecThreads = 1;
+			reader.SetDecodeOptions(o);
+		}
+		read_ok = reader.Read();
+		if (read_ok)
+		{
+			buff_error = DicomUtils::read_buffer(
+				&ok,
+				data,
+				overlays,
+				overlays_enabled ? idx : -2,
+				anatomy,
+				idx,
+				filename,
+				rescale,
+				pixelformat, force_double_pf,
+				pi,
+				&dimx, &dimy, &dimz,
+				&origin_x, &origin_y, &origin_z,
+				&spacing_x, &spacing_y, &spacing_z,
+				dircos,
+				&shift_tmp, &scale_tmp,
+				clean_unused_bits,
+				false, false, false,
+				false,
+				pred6_bug,
+				cornell_bug,
+				fix_jpeg_prec,
+				skip_too_large,
+				nullptr,
+				&buffers_size,
+				use_icc, &icc_ok,
+				&reader,
+				target, target_size);
+		}
+		done.release();
+	}
+
+	mdcm::ImageReader reader;
+	QSemaphore done;
+	bool read_ok{};
+	bool ok{};
+	QString buff_error;
+	std::vector<char*> data;
+	ImageOverlays overlays;
+	AnatomyMap anatomy;
+	mdcm::PixelFormat pixelformat;
+	mdcm::PhotometricInterpretation pi;
+	unsigned int dimx{};
+	unsigned int dimy{};
+	unsigned int dimz{};
+	double origin_x{};
+	double origin_y{};
+	double origin_z{};
+	double spacing_x{};
+	double spacing_y{};
+	double spacing_z{};
+	double dircos[6]{};
+	double shift_tmp{};
+	double scale_tmp{1.0};
+	unsigned long long buffers_size{};
+	bool icc_ok{};
+
+private:
+	const QString filename;
+	const int idx;
+	const bool overlays_enabled;
+	const bool rescale;
+	const bool force_double_pf;
+	const bool clean_unused_bits;
+	const bool pred6_bug;
+	const bool cornell_bug;
+	const bool fix_jpeg_prec;
+	const bool skip_too_large;
+	const bool use_icc;
+	char * const target;
+	const size_t target_size;
+	const std::atomic<bool> * canceled;
+};
+
+// Size of a pixel in buffers of read_buffer(),
+// as expected by CommonUtils::gen_itk_image().
+size_t get_buffer_pixel_size(const mdcm::PixelFormat & p)
+{
+	size_t s{};
+	switch (p.GetScalarType())
+	{
+	case mdcm::PixelFormat::UINT8:
+	case mdcm::PixelFormat::INT8:
+	case mdcm::PixelFormat::SINGLEBIT:
+		s = 1;
+		break;
+	case mdcm::PixelFormat::UINT12:
+	case mdcm::PixelFormat::INT12:
+	case mdcm::PixelFormat::UINT16:
+	case mdcm::PixelFormat::INT16:
+		s = 2;
+		break;
+	case mdcm::PixelFormat::UINT32:
+	case mdcm::PixelFormat::INT32:
+	case mdcm::PixelFormat::FLOAT32:
+		s = 4;
+		break;
+	case mdcm::PixelFormat::UINT64:
+	case mdcm::PixelFormat::INT64:
+	case mdcm::PixelFormat::FLOAT64:
+		s = 8;
+		break;
+	default:
+		break;
+	}
+	return s * p.GetSamplesPerPixel();
+}
+
+// Jobs not started yet return immediately after read_series() returned,
+// jobs submitted and not taken are waited for, they write to the volume.
+class ReadSeriesCancel_
+{
+public:
+	ReadSeriesCancel_(
+		std::atomic<bool> & c,
+		std::vector<std::unique_ptr<ReadSeriesSlice_>> & j,
+		const int & t,
+		const int & s)
+		:
+		canceled(c), jobs(j), taken(t), submitted(s) {}
+	~ReadSeriesCancel_()
+	{
+		canceled.store(true);
+		for (int x = taken; x < submitted; ++x)
+		{
+			if (jobs[x]) jobs[x]->done.acquire();
+		}
+	}
+
+private:
+	std::atomic<bool> & canceled;
+	std::vector<std::unique_ptr<ReadSeriesSlice_>> & jobs;
+	const int & taken;
+	const int & submitted;
+};
+
+// Slices of all series being loaded are decoded here, the
+// number of threads doesn't grow with concurrent loads.
+QThreadPool * read_series_pool()
+{
+	static QThreadPool pool;
+	static const bool initialized = []()
+	{
+		pool.setMaxThreadCount(std::max(1, std::min(QThread::idealThreadCount(), 16)));
+		return true;
+	}();
+	(void)initialized;
+	return &pool;
+}
+
+// Reads of DICOM files by read_dicom() and read_series(),
+// see get_files_read().
+std::atomic<unsigned long long> files_read_count{};
+
+// Readers of pixel data map files, see set_memory_mapping().
+std::atomic<bool> memory_mapping{};
+
+// Series loaded at the same time, see begin_concurrent_loads().
+std::atomic<int> concurrent_loads{};
+std::atomic<unsigned long long> concurrent_buffers_size{};
+
+// Threads for frames of one multi-frame image, or for the codec,
+// divided between series loaded at the same time.
+unsigned int decode_threads()
+{
+	const int n = std::max(1, concurrent_loads.load());
+	const int t = QThread::idealThreadCount() / n;
+	return (t > 1) ? static_cast<unsigned int>(t) : 1;
 }
 
-static cmsUInt32Number cms_error = 0;
+}
+
+// Per thread, series may be loaded concurrently.
+static thread_local cmsUInt32Number cms_error = 0;
 extern "C"
 {
 	static void AlizaLCMS2LogErrorHandler(cmsContext id, cmsUInt32Number e, const char * t)
@@ -2820,7 +3150,7 @@ bool DicomUtils::is_multiframe(const mdcm::DataSet & ds)
 }
 
 void DicomUtils::read_image_info(
-	const QString & f,
+	const mdcm::DataSet & ds,
 	unsigned short * rows_,
 	unsigned short * columns_,
 	QString        & position,
@@ -2829,38 +3159,23 @@ void DicomUtils::read_image_info(
 	QString        & sop_instance_uid,
 	QString        & orientation_20_20)
 {
-	std::set<mdcm::Tag> tags;
-	mdcm::Tag tsopinstance(0x0008,0x0018); tags.insert(tsopinstance);
+	const mdcm::Tag tsopinstance(0x0008,0x0018);
 	// Imager Pixel Spacing
-	mdcm::Tag tspacing1(0x0018,0x1164);    tags.insert(tspacing1);
+	const mdcm::Tag tspacing1(0x0018,0x1164);
 	// Nominal Scanned Pixel Spacing
-	mdcm::Tag tspacing2(0x0018,0x2010);    tags.insert(tspacing2);
-	mdcm::Tag tpos_old(0x0020,0x0030);     tags.insert(tpos_old);
-	mdcm::Tag tpos(0x0020,0x0032);         tags.insert(tpos);
-	mdcm::Tag torie_old(0x0020,0x0035);    tags.insert(torie_old);
-	mdcm::Tag torie(0x0020,0x0037);        tags.insert(torie);
-	mdcm::Tag trows(0x0028,0x0010);        tags.insert(trows);
-	mdcm::Tag tcolumns(0x0028,0x0011);     tags.insert(tcolumns);
+	const mdcm::Tag tspacing2(0x0018,0x2010);
+	const mdcm::Tag tpos_old(0x0020,0x0030);
+	const mdcm::Tag tpos(0x0020,0x0032);
+	const mdcm::Tag torie_old(0x0020,0x0035);
+	const mdcm::Tag torie(0x0020,0x0037);
+	const mdcm::Tag trows(0x0028,0x0010);
+	const mdcm::Tag tcolumns(0x0028,0x0011);
 	// Pixel Spacing
-	mdcm::Tag tspacing0(0x0028,0x0030);    tags.insert(tspacing0);
+	const mdcm::Tag tspacing0(0x0028,0x0030);
 	// Pixel Aspect Ratio
-	mdcm::Tag tspacing3(0x0028,0x0034);    tags.insert(tspacing3);
+	const mdcm::Tag tspacing3(0x0028,0x0034);
 	// Patient Orientation
-	mdcm::Tag t2020(0x0020,0x0020);        tags.insert(t2020);
-	//
-	mdcm::Reader reader;
-#ifdef _WIN32
-#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-	reader.SetFileName(QDir::toNativeSeparators(f).toUtf8().constData());
-#else
-	reader.SetFileName(QDir::toNativeSeparators(f).toLocal8Bit().constData());
-#endif
-#else
-	reader.SetFileName(f.toLocal8Bit().constData());
-#endif
-	const bool f_ok = reader.ReadSelectedTags(tags);
-	if (!f_ok) return;
-	const mdcm::DataSet & ds = reader.GetFile().GetDataSet();
+	const mdcm::Tag t2020(0x0020,0x0020);
 	if (ds.IsEmpty()) return;
 	//
 	const bool b0 = get_us_value(ds, trows, rows_);
@@ -2938,7 +3253,8 @@ void DicomUtils::read_image_info(
 	}
 }
 
-void DicomUtils::read_image_info_rtdose(const QString & f,
+void DicomUtils::read_image_info_rtdose(
+	const mdcm::DataSet & ds,
 	unsigned short * num_frames_,
 	unsigned short * rows_,
 	unsigned short * columns_,
@@ -2947,27 +3263,13 @@ void DicomUtils::read_image_info_rtdose(const QString & f,
 	QString        & spacing,
 	std::vector<double> & z_offsets)
 {
-	std::set<mdcm::Tag> tags;
-	mdcm::Tag tframes(0x0028,0x0008);      tags.insert(tframes);
-	mdcm::Tag trows(0x0028,0x0010);        tags.insert(trows);
-	mdcm::Tag tcolumns(0x0028,0x0011);     tags.insert(tcolumns);
-	mdcm::Tag tpos(0x0020,0x0032);         tags.insert(tpos);
-	mdcm::Tag torie(0x0020,0x0037);        tags.insert(torie);
-	mdcm::Tag tspacing(0x0028,0x0030);     tags.insert(tspacing);
-	mdcm::Tag tframeoffset(0x3004,0x000c); tags.insert(tframeoffset);
-	mdcm::Reader reader;
-#ifdef _WIN32
-#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-	reader.SetFileName(QDir::toNativeSeparators(f).toUtf8().constData());
-#else
-	reader.SetFileName(QDir::toNativeSeparators(f).toLocal8Bit().constData());
-#endif
-#else
-	reader.SetFileName(f.toLocal8Bit().constData());
-#endif
-	const bool f_ok = reader.ReadSelectedTags(tags);
-	if (!f_ok) return;
-	const mdcm::DataSet & ds = reader.GetFile().GetDataSet();
+	const mdcm::Tag tframes(0x0028,0x0008);
+	const mdcm::Tag trows(0x0028,0x0010);
+	const mdcm::Tag tcolumns(0x0028,0x0011);
+	const mdcm::Tag tpos(0x0020,0x0032);
+	const mdcm::Tag torie(0x0020,0x0037);
+	const mdcm::Tag tspacing(0x0028,0x0030);
+	const mdcm::Tag tframeoffset(0x3004,0x000c);
 	if (ds.IsEmpty()) return;
 	//
 	const bool b0 = get_us_value(ds, trows, rows_);
@@ -3420,14 +3722,14 @@ void DicomUtils::read_us_regions(
 }
 
 bool DicomUtils::read_slices(
-	const QStringList & filenames_, ImageVariant * ivariant,
+	const std::vector<SliceImageInfo> & infos, ImageVariant * ivariant,
 	const bool ok3d, const bool skip_texture,
 	float tolerance)
 {
 	if (!ivariant) return false;
 	bool ok{};
 	bool failed{};
-	const int unsigned size_z = filenames_.size();
+	const int unsigned size_z = infos.size();
 	std::vector<double*> values;
 	unsigned short rows{};
 	unsigned short columns{};
@@ -3448,25 +3750,14 @@ bool DicomUtils::read_slices(
 	double dircos[9]{};
 	for (unsigned int i = 0; i < size_z; ++i)
 	{
-		QString
-			sop_instance_uid,
-			pat_pos_s,
-			pat_orient_s,
-			pix_spacing_s,
-			orientation_20_20;
-		unsigned short rows_{};
-		unsigned short columns_{};
-		read_image_info(
-			filenames_.at(i),
-			&rows_, &columns_,
-			pat_pos_s,
-			pat_orient_s,
-			pix_spacing_s,
-			sop_instance_uid,
-			orientation_20_20);
-		ivariant->image_instance_uids[i] = std::move(sop_instance_uid);
-		if (!orientation_20_20.isEmpty())
-			ivariant->orientations_20_20[i] = std::move(orientation_20_20);
+		const QString & pat_pos_s = infos.at(i).position;
+		const QString & pat_orient_s = infos.at(i).orientation;
+		const QString & pix_spacing_s = infos.at(i).spacing;
+		const unsigned short rows_ = infos.at(i).rows;
+		const unsigned short columns_ = infos.at(i).columns;
+		ivariant->image_instance_uids[i] = infos.at(i).sop_instance_uid;
+		if (!infos.at(i).orientation_20_20.isEmpty())
+			ivariant->orientations_20_20[i] = infos.at(i).orientation_20_20;
 		double pat_pos[3];
 		double pat_orient[6];
 		double pix_spacing[2];
@@ -3861,7 +4152,7 @@ bool DicomUtils::read_slices_uihgrid(
 }
 
 bool DicomUtils::read_slices_rtdose(
-	const QString & filename_, ImageVariant * ivariant,
+	const mdcm::DataSet & ds, ImageVariant * ivariant,
 	const bool ok3d,
 	float tolerance)
 {
@@ -3881,7 +4172,7 @@ bool DicomUtils::read_slices_rtdose(
 	float center_x, center_y, center_z;
 	double dircos[9]{};
 	QString pat_pos_s, pat_orient_s, pix_spacing_s;
-	read_image_info_rtdose(filename_,
+	read_image_info_rtdose(ds,
 		&numframes, &rows, &columns,
 		pat_pos_s, pat_orient_s, pix_spacing_s, z_offsets);
 	const bool ok_pos         = get_patient_position(pat_pos_s, pat_pos);
@@ -3967,14 +4258,6 @@ quit_:
 	return ok;
 }
 
-static std::atomic<short> force_suppllut(0);
-void DicomUtils::global_force_suppllut(short x)
-{
-	// 1 force apply
-	// 2 force not apply
-	force_suppllut.store(x);
-}
-
 void DicomUtils::read_dimension_index_sq(
 	const mdcm::DataSet & ds,
 	DimIndexSq & sq)
@@ -8340,6 +8623,7 @@ QString DicomUtils::read_series(
 {
 	*ok = false;
 	if (!ivariant) return QString("Image is null");
+	if (images_ipp.empty()) return QString("No files");
 	const SettingsWidget * wsettings =
 		static_cast<const SettingsWidget *>(settings);
 	unsigned int dimx{};
@@ -8372,26 +8656,124 @@ QString DicomUtils::read_series(
 	std::vector<short>  luts_;
 	QList<QString>      acqtimes;
 	//
+	// Geometry of slices is generated after all files were read
+	std::vector<SliceImageInfo> slices_info;
+	bool read_slices_later{};
+	double first_dircos[6]{};
+	double first_origin_x{};
+	double first_origin_y{};
+	double first_origin_z{};
+	double first_spacing_x{};
+	double first_spacing_y{};
+	double first_spacing_z{};
+	const unsigned long long files_read_0 = files_read_count.load();
+	size_t slice_size{};
+	//
 #ifdef WARN_RAM_SIZE
 	const double total_ram = CommonUtils::get_total_memory_saved();
 #endif
 	unsigned long long count_buffers_size = 0;
+	const bool rescale = (!apply_rescale) ? false : wsettings->get_rescale();
+	//
+	// Files 1..n-1 of a series of single-frame images are read and decoded
+	// in a pool, not more than 'window' files ahead of the file being
+	// assembled, so memory and error checks below stay in file order.
+	// The first file is read here, it provides the SOP class and the
+	// size of a slice in the volume buffer, other files are decoded
+	// into their slice. The volume is freed after the pool is done.
+	std::atomic<bool> canceled{};
+	std::unique_ptr<char[]> volume;
+	std::vector<std::unique_ptr<ReadSeriesSlice_>> jobs;
+	QThreadPool * pool = read_series_pool();
+	int window{};
+	int taken{1};
+	int submitted{1};
+	ReadSeriesCancel_ cancel_guard(canceled, jobs, taken, submitted);
+	//
 	for (int j = 0; j < images_ipp.size(); ++j)
 	{
-		//
+		const bool force_double_pf =
+			(ivariant->sop == QString("1.2.840.10008.5.1.4.1.1.128"));
+		if (j == 1 && images_ipp.size() > 2 && !elscint)
+		{
+			const int threads = pool->maxThreadCount();
+			if (threads > 1)
+			{
+				window = 2 * threads;
+				jobs.resize(images_ipp.size());
+			}
+		}
+		ReadSeriesSlice_ * job{};
+		if (window > 0)
+		{
+			const int last = std::min(j + window, static_cast<int>(images_ipp.size()));
+			for (; submitted < last; ++submitted)
+			{
+				jobs[submitted].reset(new ReadSeriesSlice_(
+					images_ipp.at(submitted),
+					submitted,
+					overlays_enabled,
+					rescale,
+					force_double_pf,
+					clean_unused_bits,
+					pred6_bug,
+					cornell_bug,
+					fix_jpeg_prec,
+					skip_too_large,
+					use_icc,
+					volume.get() + submitted * slice_size,
+					slice_size,
+					&canceled));
+				pool->start(jobs[submitted].get());
+			}
+			job = jobs[j].get();
+			job->done.acquire();
+			taken = j + 1;
+		}
+		// The file is parsed once, the dataset of the image reader is
+		// used for the info below, read_buffer() decodes its image.
+		// ELSCINT files are converted by read_buffer() and read again.
+		mdcm::ImageReader image_reader;
+		mdcm::Reader elscint_reader;
 		{
 			int number_of_frames{};
-			mdcm::Reader reader;
+			mdcm::Reader & reader = job
+				? static_cast<mdcm::Reader&>(job->reader)
+				: elscint
+					? elscint_reader
+					: static_cast<mdcm::Reader&>(image_reader);
+			if (job)
+			{
+				*ok = job->read_ok;
+			}
+			else
+			{
+				reader.SetMemoryMapping(get_memory_mapping());
 #ifdef _WIN32
 #if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-			reader.SetFileName(QDir::toNativeSeparators(images_ipp.at(j)).toUtf8().constData());
+				reader.SetFileName(QDir::toNativeSeparators(images_ipp.at(j)).toUtf8().constData());
 #else
-			reader.SetFileName(QDir::toNativeSeparators(images_ipp.at(j)).toLocal8Bit().constData());
+				reader.SetFileName(QDir::toNativeSeparators(images_ipp.at(j)).toLocal8Bit().constData());
 #endif
 #else
-			reader.SetFileName(images_ipp.at(j).toLocal8Bit().constData());
+				reader.SetFileName(images_ipp.at(j).toLocal8Bit().constData());
 #endif
-			*ok = reader.Read();
+				image_reader.SetApplySupplementalLUT(false);
+				image_reader.SetProcessOverlays(overlays_enabled);
+				set_decode_options(
+					image_reader, clean_unused_bits, pred6_bug, cornell_bug, fix_jpeg_prec);
+				// Frames of a single multi-frame file in parallel,
+				// files 1..n-1 of a series are decoded in the pool.
+				{
+					const unsigned int threads = decode_threads();
+					mdcm::DecodeOptions o = image_reader.GetDecodeOptions();
+					if (images_ipp.size() == 1 && threads > 1) o.FrameThreads = threads;
+					o.CodecThreads = threads;
+					image_reader.SetDecodeOptions(o);
+				}
+				*ok = reader.Read();
+			}
+			++files_read_count;
 			if (*ok == false)
 			{
 				for (unsigned int x = 0; x < data.size(); ++x)
@@ -8463,14 +8845,7 @@ QString DicomUtils::read_series(
 					{
 						if (!min_load)
 						{
-							slices_ok =	read_slices(
-								images_ipp,
-								ivariant,
-								ok3d,
-								ivariant->di->skip_texture,
-								tolerance);
-							if (slices_ok) ivariant->iod_supported = true;
-							else geometry_from_image = true;
+							read_slices_later = true;
 							ivariant->unit_str = QString(" mm");
 						}
 					}
@@ -8479,7 +8854,7 @@ QString DicomUtils::read_series(
 						if (!min_load)
 						{
 							slices_ok =	read_slices_rtdose(
-								images_ipp.at(j),
+								ds,
 								ivariant,
 								ok3d,
 								0.01f);
@@ -8498,19 +8873,7 @@ QString DicomUtils::read_series(
 					{
 						if (!min_load)
 						{
-							slices_ok =	read_slices(
-								images_ipp,
-								ivariant,
-								ok3d,
-								ivariant->di->skip_texture,
-								tolerance);
-							if (!slices_ok)
-							{
-								ivariant->di->skip_texture = true;
-#ifdef TMP_ALWAYS_GEOM_FROM_IMAGE
-								geometry_from_image = true;
-#endif
-							}
+							read_slices_later = true;
 						}
 					}
 				}
@@ -8551,6 +8914,20 @@ QString DicomUtils::read_series(
 				}
 			}
 			//
+			if (read_slices_later)
+			{
+				SliceImageInfo info;
+				read_image_info(
+					ds,
+					&info.rows, &info.columns,
+					info.position,
+					info.orientation,
+					info.spacing,
+					info.sop_instance_uid,
+					info.orientation_20_20);
+				slices_info.push_back(std::move(info));
+			}
+			//
 			if (!min_load)
 			{
 				{
@@ -8595,67 +8972,166 @@ QString DicomUtils::read_series(
 		double scale_tmp{1.0};
 		QString buff_error;
 		const int overlays_idx = overlays_enabled ? j : -2;
-		const bool rescale = (!apply_rescale) ? false : wsettings->get_rescale();
-		const bool force_double_pf =
-			(ivariant->sop == QString("1.2.840.10008.5.1.4.1.1.128"));
 		unsigned long long buffers_size{};
 		std::vector<char*> data_;
 		if (images_ipp.size() > 1)
 		{
-			buff_error = read_buffer(
-				ok,
-				data_,
-				ivariant->image_overlays,
-				overlays_idx,
-				ivariant->anatomy,
-				j,
-				images_ipp.at(j),
-				rescale,
-				pixelformat, force_double_pf,
-				pi,
-				&dimx_, &dimy_, &dimz_,
-				&origin_x_, &origin_y_, &origin_z_,
-				&spacing_x_, &spacing_y_, &spacing_z_,
-				dircos_,
-				&shift_tmp, &scale_tmp,
-				clean_unused_bits,
-				false, false, elscint,
-				false,
-				pred6_bug,
-				cornell_bug,
-				fix_jpeg_prec,
-				skip_too_large,
-				nullptr,
-				&buffers_size,
-				use_icc, &icc_ok);
-			if (dimz_ > 1)
-			{
-				*ok = false;
-			}
-			if (!(!data_.empty() && data_.at(0)))
-			{
-				*ok = false;
-			}
-			if (*ok == false)
-			{
-				for (unsigned int x = 0; x < data_.size(); ++x)
-				{
-					delete [] data_[x];
-				}
-				data_.clear();
-				for (unsigned int x = 0; x < data.size(); ++x)
+			if (job)
+			{
+				*ok = job->ok;
+				buff_error = job->buff_error;
+				data_.swap(job->data);
+				pixelformat = job->pixelformat;
+				pi = job->pi;
+				dimx_ = job->dimx;
+				dimy_ = job->dimy;
+				dimz_ = job->dimz;
+				buffers_size = job->buffers_size;
+				if (job->icc_ok) icc_ok = true;
+				{
+					const QList<int> keys = job->overlays.all_overlays.keys();
+					for (int x = 0; x < keys.size(); ++x)
+					{
+						const int idx = keys.at(x);
+						const SliceOverlays & l2 = job->overlays.all_overlays[idx];
+						if (!ivariant->image_overlays.all_overlays.contains(idx))
+						{
+							ivariant->image_overlays.all_overlays[idx] = l2;
+						}
+						else
+						{
+							for (int k = 0; k < l2.size(); ++k)
+							{
+								ivariant->image_overlays.all_overlays[idx].push_back(l2[k]);
+							}
+						}
+					}
+				}
 				{
-					delete [] data[x];
+					AnatomyMap::const_iterator it = job->anatomy.constBegin();
+					while (it != job->anatomy.constEnd())
+					{
+						ivariant->anatomy[it.key()] = it.value();
+						++it;
+					}
+				}
+				jobs[j].reset();
+			}
+			else
+			{
+				buff_error = read_buffer(
+					ok,
+					data_,
+					ivariant->image_overlays,
+					overlays_idx,
+					ivariant->anatomy,
+					j,
+					images_ipp.at(j),
+					rescale,
+					pixelformat, force_double_pf,
+					pi,
+					&dimx_, &dimy_, &dimz_,
+					&origin_x_, &origin_y_, &origin_z_,
+					&spacing_x_, &spacing_y_, &spacing_z_,
+					dircos_,
+					&shift_tmp, &scale_tmp,
+					clean_unused_bits,
+					false, false, elscint,
+					false,
+					pred6_bug,
+					cornell_bug,
+					fix_jpeg_prec,
+					skip_too_large,
+					nullptr,
+					&buffers_size,
+					use_icc, &icc_ok,
+					elscint ? nullptr : &image_reader,
+					(j > 0) ? volume.get() + j * slice_size : nullptr,
+					slice_size);
+			}
+			if (dimz_ > 1)
+			{
+				*ok = false;
+			}
+			if (j == 0 && !(!data_.empty() && data_.at(0)))
+			{
+				*ok = false;
+			}
+			if (*ok == false)
+			{
+				for (unsigned int x = 0; x < data_.size(); ++x)
+				{
+					delete [] data_[x];
+				}
+				data_.clear();
+				return buff_error.isEmpty()
+					? QString("Buffer read failed")
+					: buff_error;
+			}
+			// One buffer for the whole volume, gen_itk_image() takes
+			// over this buffer. Only the first slice is copied, its size
+			// is not known before it is decoded.
+			if (j == 0)
+			{
+				slice_size =
+					static_cast<size_t>(dimx_) * dimy_ * get_buffer_pixel_size(pixelformat);
+				if (slice_size > 0)
+				{
+					try
+					{
+						volume.reset(new char[slice_size * images_ipp.size()]);
+					}
+					catch (const std::bad_alloc&)
+					{
+						volume.reset();
+					}
+				}
+				if (!volume)
+				{
+					*ok = false;
+					delete [] data_[0];
+					data_.clear();
+					return QString("Buffer allocation error");
+				}
+				memcpy(volume.get(), data_[0], slice_size);
+				delete [] data_[0];
+				data_.clear();
+			}
+			else
+			{
+				QString slice_error;
+				if ((previous_pixelformat.GetBitsAllocated()
+						!= pixelformat.GetBitsAllocated()) ||
+					(previous_pixelformat.GetScalarType()
+						!= pixelformat.GetScalarType()) ||
+					(previous_pixelformat.GetSamplesPerPixel()
+						!= pixelformat.GetSamplesPerPixel()))
+				{
+					slice_error = QString(
+						"Files in series seem to have different "
+						"pixel format. Try to load separately.");
+				}
+				else if (dimx_ != dimx || dimy_ != dimy)
+				{
+					slice_error = QString(
+						"Files in series seem to have different "
+						"dimensions. Try to load separately.");
+				}
+				if (!slice_error.isEmpty())
+				{
+					*ok = false;
+					return slice_error;
 				}
-				data.clear();
-				return QString("Buffer read failed");
 			}
-			data.push_back(&data_[0][0]);
 			count_buffers_size += buffers_size;
 #ifdef WARN_RAM_SIZE
 			if (skip_too_large && total_ram > 0.0)
 			{
-				const double count_buffers_gb = count_buffers_size / 1073741824.0;
+				// With concurrent loads read_buffer() counts all buffers.
+				const double count_buffers_gb =
+					((concurrent_loads.load() > 1)
+						? concurrent_buffers_size.load()
+						: count_buffers_size) / 1073741824.0;
 				if ((count_buffers_gb * 3) >= total_ram)
 				{
 					*ok = false;
@@ -8698,8 +9174,11 @@ QString DicomUtils::read_series(
 				skip_too_large,
 				nullptr,
 				nullptr,
-				use_icc, &icc_ok);
+				use_icc, &icc_ok,
+				elscint ? nullptr : &image_reader);
 		}
+		// convert_elscint() reads the file, then the converted file is read
+		if (elscint) files_read_count += 2;
 		if (*ok == false)
 		{
 			for (unsigned int x = 0; x < data.size(); ++x)
@@ -8725,274 +9204,293 @@ QString DicomUtils::read_series(
 			dimy = dimy_;
 			if (images_ipp.size() == 1) dimz = dimz_;
 			else dimz = images_ipp.size();
-			if (slices_ok)
-			{
-				bool invalidate{};
-				if (ivariant->equi)
-				{
-					const float tmp0_spacing_x = static_cast<float>(spacing_x_);
-					const float tmp0_spacing_y = static_cast<float>(spacing_y_);
-					const float tmp1_spacing_x = static_cast<float>(ivariant->di->ix_spacing);
-					const float tmp1_spacing_y = static_cast<float>(ivariant->di->iy_spacing);
-					const float tmp1_spacing_z = static_cast<float>(ivariant->di->iz_spacing);
-					if (tmp1_spacing_x <= 0)
-					{
-#ifdef ALIZA_VERBOSE
-						std::cout << "ivariant->di->ix_spacing <= 0 " << std::endl;
-#endif
-						invalidate = true;
-						ivariant->di->ix_spacing = 1.0;
-					}
-					if (tmp1_spacing_y <= 0)
-					{
-#ifdef ALIZA_VERBOSE
-						std::cout << "ivariant->di->iy_spacing <= 0 " << std::endl;
+			first_origin_x = origin_x_;
+			first_origin_y = origin_y_;
+			first_origin_z = origin_z_;
+			first_spacing_x = spacing_x_;
+			first_spacing_y = spacing_y_;
+			first_spacing_z = spacing_z_;
+			for (int x = 0; x < 6; ++x) first_dircos[x] = dircos_[x];
+		}
+		previous_pixelformat = pixelformat;
+	}
+	if (volume) data.push_back(volume.release());
+	//
+	if (read_slices_later)
+	{
+		slices_ok = read_slices(
+			slices_info,
+			ivariant,
+			ok3d,
+			ivariant->di->skip_texture,
+			tolerance);
+		if (ivariant->sop == QString("1.2.840.10008.5.1.4.1.1.128") || // PET
+			ivariant->sop == QString("1.2.840.10008.5.1.4.1.1.2")   || // CT
+			ivariant->sop == QString("1.2.840.10008.5.1.4.1.1.4"))     // MR
+		{
+			if (slices_ok) ivariant->iod_supported = true;
+			else geometry_from_image = true;
+		}
+		else if (!slices_ok)
+		{
+			ivariant->di->skip_texture = true;
+#ifdef TMP_ALWAYS_GEOM_FROM_IMAGE
+			geometry_from_image = true;
 #endif
-						invalidate = true;
-						ivariant->di->iy_spacing = 1.0;
-					}
-					if (tmp1_spacing_z <= 0)
-					{
+		}
+	}
+	if (slices_ok)
+	{
+		bool invalidate{};
+		if (ivariant->equi)
+		{
+			const float tmp0_spacing_x = static_cast<float>(first_spacing_x);
+			const float tmp0_spacing_y = static_cast<float>(first_spacing_y);
+			const float tmp1_spacing_x = static_cast<float>(ivariant->di->ix_spacing);
+			const float tmp1_spacing_y = static_cast<float>(ivariant->di->iy_spacing);
+			const float tmp1_spacing_z = static_cast<float>(ivariant->di->iz_spacing);
+			if (tmp1_spacing_x <= 0)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "ivariant->di->iz_spacing <= 0 " << std::endl;
+				std::cout << "ivariant->di->ix_spacing <= 0 " << std::endl;
 #endif
-						invalidate = true;
-						ivariant->di->iz_spacing = 0.00001;
-					}
-					if ((tmp0_spacing_x + 0.001f) < tmp1_spacing_x ||
-						(tmp0_spacing_x - 0.001f) > tmp1_spacing_x)
-					{
+				invalidate = true;
+				ivariant->di->ix_spacing = 1.0;
+			}
+			if (tmp1_spacing_y <= 0)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_spacing_x != tmp1_spacing_x "
-							<< tmp0_spacing_x << " "
-							<< tmp1_spacing_x << std::endl;
+				std::cout << "ivariant->di->iy_spacing <= 0 " << std::endl;
 #endif
-						invalidate = true;
-					}
-					if ((tmp0_spacing_y + 0.001f) < tmp1_spacing_y ||
-						(tmp0_spacing_y - 0.001f) > tmp1_spacing_y)
-					{
+				invalidate = true;
+				ivariant->di->iy_spacing = 1.0;
+			}
+			if (tmp1_spacing_z <= 0)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_spacing_y != tmp1_spacing_y "
-							<< tmp0_spacing_y << " "
-							<< tmp1_spacing_y << std::endl;
+				std::cout << "ivariant->di->iz_spacing <= 0 " << std::endl;
 #endif
-						invalidate = true;
-					}
-					const float tmp0_origin_x = static_cast<float>(origin_x_);
-					const float tmp0_origin_y = static_cast<float>(origin_y_);
-					const float tmp0_origin_z = static_cast<float>(origin_z_);
-					const float tmp1_origin_x = ivariant->di->ix_origin;
-					const float tmp1_origin_y = ivariant->di->iy_origin;
-					const float tmp1_origin_z = ivariant->di->iz_origin;
-					if ((tmp0_origin_x + 0.001f) < tmp1_origin_x ||
-						(tmp0_origin_x - 0.001f) > tmp1_origin_x)
-					{
+				invalidate = true;
+				ivariant->di->iz_spacing = 0.00001;
+			}
+			if ((tmp0_spacing_x + 0.001f) < tmp1_spacing_x ||
+				(tmp0_spacing_x - 0.001f) > tmp1_spacing_x)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_origin_x != tmp1_origin_x "
-							<< tmp0_origin_x << " "
-							<< tmp1_origin_x << std::endl;
+				std::cout << "tmp0_spacing_x != tmp1_spacing_x "
+					<< tmp0_spacing_x << " "
+					<< tmp1_spacing_x << std::endl;
 #endif
-						invalidate = true;
-					}
-					if ((tmp0_origin_y + 0.001f) < tmp1_origin_y ||
-						(tmp0_origin_y - 0.001f) > tmp1_origin_y)
-					{
+				invalidate = true;
+			}
+			if ((tmp0_spacing_y + 0.001f) < tmp1_spacing_y ||
+				(tmp0_spacing_y - 0.001f) > tmp1_spacing_y)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_origin_y != tmp1_origin_y "
-							<< tmp0_origin_y << " "
-							<< tmp1_origin_y << std::endl;
+				std::cout << "tmp0_spacing_y != tmp1_spacing_y "
+					<< tmp0_spacing_y << " "
+					<< tmp1_spacing_y << std::endl;
 #endif
-						invalidate = true;
-					}
-					if ((tmp0_origin_z + 0.001f) < tmp1_origin_z ||
-						(tmp0_origin_z - 0.001f) > tmp1_origin_z)
-					{
-#ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_origin_z != tmp1_origin_z "
-							<< tmp0_origin_z << " "
-							<< tmp1_origin_z << std::endl;
-#endif
-						invalidate = true;
-					}
-					const float tmp0_dircos_0 = static_cast<float>(dircos_[0]);
-					const float tmp0_dircos_1 = static_cast<float>(dircos_[1]);
-					const float tmp0_dircos_2 = static_cast<float>(dircos_[2]);
-					const float tmp0_dircos_3 = static_cast<float>(dircos_[3]);
-					const float tmp0_dircos_4 = static_cast<float>(dircos_[4]);
-					const float tmp0_dircos_5 = static_cast<float>(dircos_[5]);
-					const float tmp1_dircos_0 = ivariant->di->dircos[0];
-					const float tmp1_dircos_1 = ivariant->di->dircos[1];
-					const float tmp1_dircos_2 = ivariant->di->dircos[2];
-					const float tmp1_dircos_3 = ivariant->di->dircos[3];
-					const float tmp1_dircos_4 = ivariant->di->dircos[4];
-					const float tmp1_dircos_5 = ivariant->di->dircos[5];
-					if ((tmp0_dircos_0 + 0.001f) < tmp1_dircos_0 ||
-						(tmp0_dircos_0 - 0.001f) > tmp1_dircos_0)
-					{
+				invalidate = true;
+			}
+			const float tmp0_origin_x = static_cast<float>(first_origin_x);
+			const float tmp0_origin_y = static_cast<float>(first_origin_y);
+			const float tmp0_origin_z = static_cast<float>(first_origin_z);
+			const float tmp1_origin_x = ivariant->di->ix_origin;
+			const float tmp1_origin_y = ivariant->di->iy_origin;
+			const float tmp1_origin_z = ivariant->di->iz_origin;
+			if ((tmp0_origin_x + 0.001f) < tmp1_origin_x ||
+				(tmp0_origin_x - 0.001f) > tmp1_origin_x)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_dircos_0 != tmp1_dircos_0 "
-							<< tmp0_dircos_0 << " "
-							<< tmp1_dircos_0 << std::endl;
+				std::cout << "tmp0_origin_x != tmp1_origin_x "
+					<< tmp0_origin_x << " "
+					<< tmp1_origin_x << std::endl;
 #endif
-						invalidate = true;
-					}
-					if ((tmp0_dircos_1 + 0.001f) < tmp1_dircos_1 ||
-						(tmp0_dircos_1 - 0.001f) > tmp1_dircos_1)
-					{
+				invalidate = true;
+			}
+			if ((tmp0_origin_y + 0.001f) < tmp1_origin_y ||
+				(tmp0_origin_y - 0.001f) > tmp1_origin_y)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_dircos_1 != tmp1_dircos_1 "
-							<< tmp0_dircos_1 << " "
-							<< tmp1_dircos_1 << std::endl;
+				std::cout << "tmp0_origin_y != tmp1_origin_y "
+					<< tmp0_origin_y << " "
+					<< tmp1_origin_y << std::endl;
 #endif
-						invalidate = true;
-					}
-					if ((tmp0_dircos_2 + 0.001f) < tmp1_dircos_2 ||
-						(tmp0_dircos_2 - 0.001f) > tmp1_dircos_2)
-					{
+				invalidate = true;
+			}
+			if ((tmp0_origin_z + 0.001f) < tmp1_origin_z ||
+				(tmp0_origin_z - 0.001f) > tmp1_origin_z)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_dircos_2 != tmp1_dircos_2 "
-							<< tmp0_dircos_2 << " "
-							<< tmp1_dircos_2 << std::endl;
+				std::cout << "tmp0_origin_z != tmp1_origin_z "
+					<< tmp0_origin_z << " "
+					<< tmp1_origin_z << std::endl;
 #endif
-						invalidate = true;
-					}
-					if ((tmp0_dircos_3 + 0.001f) < tmp1_dircos_3 ||
-						(tmp0_dircos_3 - 0.001f) > tmp1_dircos_3)
-					{
+				invalidate = true;
+			}
+			const float tmp0_dircos_0 = static_cast<float>(first_dircos[0]);
+			const float tmp0_dircos_1 = static_cast<float>(first_dircos[1]);
+			const float tmp0_dircos_2 = static_cast<float>(first_dircos[2]);
+			const float tmp0_dircos_3 = static_cast<float>(first_dircos[3]);
+			const float tmp0_dircos_4 = static_cast<float>(first_dircos[4]);
+			const float tmp0_dircos_5 = static_cast<float>(first_dircos[5]);
+			const float tmp1_dircos_0 = ivariant->di->dircos[0];
+			const float tmp1_dircos_1 = ivariant->di->dircos[1];
+			const float tmp1_dircos_2 = ivariant->di->dircos[2];
+			const float tmp1_dircos_3 = ivariant->di->dircos[3];
+			const float tmp1_dircos_4 = ivariant->di->dircos[4];
+			const float tmp1_dircos_5 = ivariant->di->dircos[5];
+			if ((tmp0_dircos_0 + 0.001f) < tmp1_dircos_0 ||
+				(tmp0_dircos_0 - 0.001f) > tmp1_dircos_0)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_dircos_3 != tmp1_dircos_3 "
-							<< tmp0_dircos_3 << " "
-							<< tmp1_dircos_3 << std::endl;
+				std::cout << "tmp0_dircos_0 != tmp1_dircos_0 "
+					<< tmp0_dircos_0 << " "
+					<< tmp1_dircos_0 << std::endl;
 #endif
-						invalidate = true;
-					}
-					if ((tmp0_dircos_4 + 0.001f) < tmp1_dircos_4 ||
-						(tmp0_dircos_4 - 0.001f) > tmp1_dircos_4)
-					{
+				invalidate = true;
+			}
+			if ((tmp0_dircos_1 + 0.001f) < tmp1_dircos_1 ||
+				(tmp0_dircos_1 - 0.001f) > tmp1_dircos_1)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_dircos_4 != tmp1_dircos_4 "
-							<< tmp0_dircos_4 << " "
-							<< tmp1_dircos_4 << std::endl;
+				std::cout << "tmp0_dircos_1 != tmp1_dircos_1 "
+					<< tmp0_dircos_1 << " "
+					<< tmp1_dircos_1 << std::endl;
 #endif
-						invalidate = true;
-					}
-					if ((tmp0_dircos_5 + 0.001f) < tmp1_dircos_5 ||
-						(tmp0_dircos_5 - 0.001f) > tmp1_dircos_5)
-					{
+				invalidate = true;
+			}
+			if ((tmp0_dircos_2 + 0.001f) < tmp1_dircos_2 ||
+				(tmp0_dircos_2 - 0.001f) > tmp1_dircos_2)
+			{
 #ifdef ALIZA_VERBOSE
-						std::cout << "tmp0_dircos_5 != tmp1_dircos_5 "
-							<< tmp0_dircos_5 << " "
-							<< tmp1_dircos_5 << std::endl;
+				std::cout << "tmp0_dircos_2 != tmp1_dircos_2 "
+					<< tmp0_dircos_2 << " "
+					<< tmp1_dircos_2 << std::endl;
 #endif
-						invalidate = true;
-					}
-				}
-				if (invalidate)
-				{
-					ivariant->equi = false;
-					ivariant->orientation = 0;
-					ivariant->orientation_string = QString("");
+				invalidate = true;
+			}
+			if ((tmp0_dircos_3 + 0.001f) < tmp1_dircos_3 ||
+				(tmp0_dircos_3 - 0.001f) > tmp1_dircos_3)
+			{
 #ifdef ALIZA_VERBOSE
-					std::cout << "warning: could not validate image, using as non-uniform"
-						<< std::endl;
+				std::cout << "tmp0_dircos_3 != tmp1_dircos_3 "
+					<< tmp0_dircos_3 << " "
+					<< tmp1_dircos_3 << std::endl;
 #endif
-				}
-				spacing_x = ivariant->di->ix_spacing > 0 ?
-					ivariant->di->ix_spacing : 1;
-				spacing_y = ivariant->di->iy_spacing > 0 ?
-					ivariant->di->iy_spacing : 1;
-				spacing_z = ivariant->di->iz_spacing > 0.00001 ?
-					ivariant->di->iz_spacing : 0.00001;
-				origin_x = ivariant->di->ix_origin;
-				origin_y = ivariant->di->iy_origin;
-				origin_z = ivariant->di->iz_origin;
-				const float row_dircos_x = ivariant->di->dircos[0];
-				const float row_dircos_y = ivariant->di->dircos[1];
-				const float row_dircos_z = ivariant->di->dircos[2];
-				const float col_dircos_x = ivariant->di->dircos[3];
-				const float col_dircos_y = ivariant->di->dircos[4];
-				const float col_dircos_z = ivariant->di->dircos[5];
-				const float nrm_dircos_x =
-					row_dircos_y * col_dircos_z - row_dircos_z * col_dircos_y;
-				const float nrm_dircos_y =
-					row_dircos_z * col_dircos_x - row_dircos_x * col_dircos_z;
-				const float nrm_dircos_z =
-					row_dircos_x * col_dircos_y - row_dircos_y * col_dircos_x;
-				direction[0][0] = row_dircos_x;
-				direction[1][0] = row_dircos_y;
-				direction[2][0] = row_dircos_z;
-				direction[0][1] = col_dircos_x;
-				direction[1][1] = col_dircos_y;
-				direction[2][1] = col_dircos_z;
-				direction[0][2] = nrm_dircos_x;
-				direction[1][2] = nrm_dircos_y;
-				direction[2][2] = nrm_dircos_z;
+				invalidate = true;
 			}
-			else
+			if ((tmp0_dircos_4 + 0.001f) < tmp1_dircos_4 ||
+				(tmp0_dircos_4 - 0.001f) > tmp1_dircos_4)
 			{
-				spacing_x = spacing_x_ > 0 ? spacing_x_ : 1;
-				spacing_y = spacing_y_ > 0 ? spacing_y_ : 1;
-				spacing_z = spacing_z_ > 0.00001 ? spacing_z_ : 0.00001;
-				origin_x = origin_x_;
-				origin_y = origin_y_;
-				origin_z = origin_z_;
-				const float row_dircos_x = dircos_[0];
-				const float row_dircos_y = dircos_[1];
-				const float row_dircos_z = dircos_[2];
-				const float col_dircos_x = dircos_[3];
-				const float col_dircos_y = dircos_[4];
-				const float col_dircos_z = dircos_[5];
-				const float nrm_dircos_x =
-					row_dircos_y * col_dircos_z - row_dircos_z * col_dircos_y;
-				const float nrm_dircos_y =
-					row_dircos_z * col_dircos_x - row_dircos_x * col_dircos_z;
-				const float nrm_dircos_z =
-					row_dircos_x * col_dircos_y - row_dircos_y * col_dircos_x;
-				direction[0][0] = row_dircos_x;
-				direction[1][0] = row_dircos_y;
-				direction[2][0] = row_dircos_z;
-				direction[0][1] = col_dircos_x;
-				direction[1][1] = col_dircos_y;
-				direction[2][1] = col_dircos_z;
-				direction[0][2] = nrm_dircos_x;
-				direction[1][2] = nrm_dircos_y;
-				direction[2][2] = nrm_dircos_z;
+#ifdef ALIZA_VERBOSE
+				std::cout << "tmp0_dircos_4 != tmp1_dircos_4 "
+					<< tmp0_dircos_4 << " "
+					<< tmp1_dircos_4 << std::endl;
+#endif
+				invalidate = true;
 			}
-			if (ivariant->di->iz_spacing <= 0.00001 &&
-				ivariant->one_direction)
+			if ((tmp0_dircos_5 + 0.001f) < tmp1_dircos_5 ||
+				(tmp0_dircos_5 - 0.001f) > tmp1_dircos_5)
 			{
-				ivariant->di->iz_spacing = 0.00001;
-				ivariant->equi = false;
-#if 0
-				ivariant->di->skip_texture = true;
+#ifdef ALIZA_VERBOSE
+				std::cout << "tmp0_dircos_5 != tmp1_dircos_5 "
+					<< tmp0_dircos_5 << " "
+					<< tmp1_dircos_5 << std::endl;
 #endif
+				invalidate = true;
 			}
 		}
-		else if (j > 0)
+		if (invalidate)
 		{
-			if ((previous_pixelformat.GetBitsAllocated()
-					!= pixelformat.GetBitsAllocated()) ||
-				(previous_pixelformat.GetScalarType()
-					!= pixelformat.GetScalarType()) ||
-				(previous_pixelformat.GetSamplesPerPixel()
-					!= pixelformat.GetSamplesPerPixel()))
-			{
-				*ok = false;
-				for (unsigned int x = 0; x < data.size(); ++x)
-				{
-					delete [] data[x];
-				}
-				data.clear();
-				return QString(
-					"Files in series seem to have different "
-					"pixel format. Try to load separately.");
-			}
+			ivariant->equi = false;
+			ivariant->orientation = 0;
+			ivariant->orientation_string = QString("");
+#ifdef ALIZA_VERBOSE
+			std::cout << "warning: could not validate image, using as non-uniform"
+				<< std::endl;
+#endif
 		}
-		previous_pixelformat = pixelformat;
+		spacing_x = ivariant->di->ix_spacing > 0 ?
+			ivariant->di->ix_spacing : 1;
+		spacing_y = ivariant->di->iy_spacing > 0 ?
+			ivariant->di->iy_spacing : 1;
+		spacing_z = ivariant->di->iz_spacing > 0.00001 ?
+			ivariant->di->iz_spacing : 0.00001;
+		origin_x = ivariant->di->ix_origin;
+		origin_y = ivariant->di->iy_origin;
+		origin_z = ivariant->di->iz_origin;
+		const float row_dircos_x = ivariant->di->dircos[0];
+		const float row_dircos_y = ivariant->di->dircos[1];
+		const float row_dircos_z = ivariant->di->dircos[2];
+		const float col_dircos_x = ivariant->di->dircos[3];
+		const float col_dircos_y = ivariant->di->dircos[4];
+		const float col_dircos_z = ivariant->di->dircos[5];
+		const float nrm_dircos_x =
+			row_dircos_y * col_dircos_z - row_dircos_z * col_dircos_y;
+		const float nrm_dircos_y =
+			row_dircos_z * col_dircos_x - row_dircos_x * col_dircos_z;
+		const float nrm_dircos_z =
+			row_dircos_x * col_dircos_y - row_dircos_y * col_dircos_x;
+		direction[0][0] = row_dircos_x;
+		direction[1][0] = row_dircos_y;
+		direction[2][0] = row_dircos_z;
+		direction[0][1] = col_dircos_x;
+		direction[1][1] = col_dircos_y;
+		direction[2][1] = col_dircos_z;
+		direction[0][2] = nrm_dircos_x;
+		direction[1][2] = nrm_dircos_y;
+		direction[2][2] = nrm_dircos_z;
 	}
+	else
+	{
+		spacing_x = first_spacing_x > 0 ? first_spacing_x : 1;
+		spacing_y = first_spacing_y > 0 ? first_spacing_y : 1;
+		spacing_z = first_spacing_z > 0.00001 ? first_spacing_z : 0.00001;
+		origin_x = first_origin_x;
+		origin_y = first_origin_y;
+		origin_z = first_origin_z;
+		const float row_dircos_x = first_dircos[0];
+		const float row_dircos_y = first_dircos[1];
+		const float row_dircos_z = first_dircos[2];
+		const float col_dircos_x = first_dircos[3];
+		const float col_dircos_y = first_dircos[4];
+		const float col_dircos_z = first_dircos[5];
+		const float nrm_dircos_x =
+			row_dircos_y * col_dircos_z - row_dircos_z * col_dircos_y;
+		const float nrm_dircos_y =
+			row_dircos_z * col_dircos_x - row_dircos_x * col_dircos_z;
+		const float nrm_dircos_z =
+			row_dircos_x * col_dircos_y - row_dircos_y * col_dircos_x;
+		direction[0][0] = row_dircos_x;
+		direction[1][0] = row_dircos_y;
+		direction[2][0] = row_dircos_z;
+		direction[0][1] = col_dircos_x;
+		direction[1][1] = col_dircos_y;
+		direction[2][1] = col_dircos_z;
+		direction[0][2] = nrm_dircos_x;
+		direction[1][2] = nrm_dircos_y;
+		direction[2][2] = nrm_dircos_z;
+	}
+	if (ivariant->di->iz_spacing <= 0.00001 &&
+		ivariant->one_direction)
+	{
+		ivariant->di->iz_spacing = 0.00001;
+		ivariant->equi = false;
+#if 0
+		ivariant->di->skip_texture = true;
+#endif
+	}
+#ifdef ALIZA_VERBOSE
+	std::cout << "read_series(): " << images_ipp.size()
+		<< " file(s), " << (files_read_count.load() - files_read_0)
+		<< " read(s)" << std::endl;
+#else
+	(void)files_read_0;
+#endif
 	//
-	if ((images_ipp.size() > 1) && (data.size() != dimz))
+	if ((images_ipp.size() > 1) && (data.size() != 1 && data.size() != dimz))
 	{
 		*ok = false;
 		for (unsigned int x = 0; x < data.size(); ++x)
@@ -9467,6 +9965,59 @@ bool DicomUtils::convert_elscint(const QString f, const QString outf)
 	return true;
 }
 
+// 'n' series are loaded at the same time, until end_concurrent_loads().
+// Decode threads are divided between them, the RAM check counts the
+// buffers of all of them.
+void DicomUtils::begin_concurrent_loads(const int n)
+{
+	concurrent_buffers_size.store(0);
+	concurrent_loads.store(n);
+}
+
+void DicomUtils::end_concurrent_loads()
+{
+	concurrent_loads.store(0);
+	concurrent_buffers_size.store(0);
+}
+
+// Total of all threads, including the reads to sort files.
+unsigned long long DicomUtils::get_files_read()
+{
+	return files_read_count.load();
+}
+
+// Off by default, a mapped file truncated while it is read, e.g.
+// on a network share, raises SIGBUS.
+void DicomUtils::set_memory_mapping(bool t)
+{
+	memory_mapping.store(t);
+}
+
+bool DicomUtils::get_memory_mapping()
+{
+	return memory_mapping.load();
+}
+
+// Options are per reader, readers in different threads
+// may use different settings.
+void DicomUtils::set_decode_options(
+	mdcm::ImageReader & reader,
+	const bool clean_unused_bits,
+	const bool pred6_bug,
+	const bool cornell_bug,
+	const bool fix_jpeg_prec)
+{
+	mdcm::DecodeOptions o = reader.GetDecodeOptions();
+	o.ForceRescaleInterceptSlope = true;
+	o.WorkaroundPredictorBug = pred6_bug;
+	o.WorkaroundCornellBug = cornell_bug;
+	o.CleanUnusedBits = clean_unused_bits;
+	o.FixJpegBits = fix_jpeg_prec;
+	reader.SetDecodeOptions(o);
+}
+
+// If 'reader' is set, it has already read the file (with the same
+// options as below, see read_series()), 'f' and 'elscint' are not used.
 QString DicomUtils::read_buffer(
 	bool * ok, std::vector<char*> & data,
 	ImageOverlays & image_overlays,
@@ -9492,17 +10043,17 @@ QString DicomUtils::read_buffer(
 	const bool skip_too_large,
 	int * red_subscript,
 	unsigned long long * buffers_size,
-	const bool use_icc, bool * has_icc)
+	const bool use_icc, bool * has_icc,
+	mdcm::ImageReader * reader,
+	char * target, const size_t target_size)
 {
 #ifdef ALIZA_LINUX_DEBUG_MEM
 	CommonUtils::linux_print_memusage("read_buffer() begin");
 #endif
 	*ok = false;
-	mdcm::ImageHelper::SetForceRescaleInterceptSlope(true);
-	mdcm::ImageHelper::SetWorkaroundPredictorBug(pred6_bug);
-	mdcm::ImageHelper::SetWorkaroundCornellBug(cornell_bug);
-	mdcm::ImageHelper::SetCleanUnusedBits(clean_unused_bits);
-	mdcm::ImageHelper::SetFixJpegBits(fix_jpeg_prec);
+	// With a reader given the caller has set the options before reading.
+	// With a target given the image must be one frame of 'target_size'
+	// bytes, it is written there and nothing is added to 'data'.
 	//
 	bool rescale_{};
 	unsigned long long rescaled_buffer_size{};
@@ -9533,58 +10084,86 @@ QString DicomUtils::read_buffer(
 	bool mapped_implicit{};
 	bool mapped_signed{};
 	bool modality_lut_ok{};
+	// The image may be decoded into the target, it is not deleted here.
+	const auto delete_not_rescaled = [&not_rescaled_buffer, target]()
+	{
+		if (not_rescaled_buffer != target) delete [] not_rescaled_buffer;
+	};
 	//
 	{
-		mdcm::ImageReader image_reader;
-		if (elscint)
-		{
-			QFileInfo fi(f);
-			elscf =
-				QDir::tempPath() +
-				QString("/") +
-				fi.fileName() + QString("ELSCINT.dcm");
-			const bool elsc_ok = convert_elscint(f, elscf);
-			if (elsc_ok)
-			{
+		mdcm::ImageReader local_reader;
+		mdcm::ImageReader & image_reader = reader ? *reader : local_reader;
+		if (!reader)
+		{
+			set_decode_options(
+				image_reader, clean_unused_bits, pred6_bug, cornell_bug, fix_jpeg_prec);
+			// Single multi-frame file, frames in parallel,
+			// series read slices in parallel, see read_series().
+			{
+				mdcm::DecodeOptions o = image_reader.GetDecodeOptions();
+				const unsigned int threads = decode_threads();
+				o.FrameThreads = (threads > 1) ? threads : 0;
+				o.CodecThreads = threads;
+				image_reader.SetDecodeOptions(o);
+			}
+			image_reader.SetMemoryMapping(get_memory_mapping());
+			// Pixel Data stays in the file, frames are read when
+			// decoded, not all compressed frames in memory at once.
+			// Mosaic and grid filters replace the image.
+			image_reader.SetDeferPixelData(!mosaic && !uihgrid);
+			if (elscint)
+			{
+				QFileInfo fi(f);
+				elscf =
+					QDir::tempPath() +
+					QString("/") +
+					fi.fileName() +
+					QString("_") +
+					QString::number(qHash(fi.absoluteFilePath())) +
+					QString("ELSCINT.dcm");
+				const bool elsc_ok = convert_elscint(f, elscf);
+				if (elsc_ok)
+				{
 #ifdef _WIN32
 #if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-				image_reader.SetFileName(QDir::toNativeSeparators(elscf).toUtf8().constData());
+					image_reader.SetFileName(QDir::toNativeSeparators(elscf).toUtf8().constData());
 #else
-				image_reader.SetFileName(QDir::toNativeSeparators(elscf).toLocal8Bit().constData());
+					image_reader.SetFileName(QDir::toNativeSeparators(elscf).toLocal8Bit().constData());
 #endif
 #else
-				image_reader.SetFileName(elscf.toLocal8Bit().constData());
+					image_reader.SetFileName(elscf.toLocal8Bit().constData());
 #endif
+				}
+				else
+				{
+					QFile::remove(elscf);
+					return QString("Can not convert ELSCINT file");
+				}
 			}
 			else
 			{
-				QFile::remove(elscf);
-				return QString("Can not convert ELSCINT file");
-			}
-		}
-		else
-		{
 #ifdef _WIN32
 #if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
-			image_reader.SetFileName(QDir::toNativeSeparators(f).toUtf8().constData());
+				image_reader.SetFileName(QDir::toNativeSeparators(f).toUtf8().constData());
 #else
-			image_reader.SetFileName(QDir::toNativeSeparators(f).toLocal8Bit().constData());
+				image_reader.SetFileName(QDir::toNativeSeparators(f).toLocal8Bit().constData());
 #endif
 #else
-			image_reader.SetFileName(f.toLocal8Bit().constData());
+				image_reader.SetFileName(f.toLocal8Bit().constData());
 #endif
-			image_reader.SetApplySupplementalLUT(supp_palette_color);
-		}
-		if (overlay_idx == -2) image_reader.SetProcessOverlays(false);
-		const bool i_ok = image_reader.Read();
-		if (!i_ok)
-		{
-			if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
-			return QString("!image_reader.Read()");
-		}
+				image_reader.SetApplySupplementalLUT(supp_palette_color);
+			}
+			if (overlay_idx == -2) image_reader.SetProcessOverlays(false);
+			const bool i_ok = image_reader.Read();
+			if (!i_ok)
+			{
+				if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
+				return QString("!image_reader.Read()");
+			}
 #ifndef ALIZA_LOAD_DCM_THREAD
-		QApplication::processEvents();
+			QApplication::processEvents();
 #endif
+		}
 		mdcm::Image & image = image_reader.GetImage();
 		{
 			const unsigned long long buffer_size_tmp = image.GetBufferLength();
@@ -9592,7 +10171,10 @@ QString DicomUtils::read_buffer(
 			const double total_ram = CommonUtils::get_total_memory_saved();
 			if (skip_too_large && total_ram > 0.0)
 			{
-				const double buffer_gb = buffer_size_tmp / 1073741824.0;
+				const double buffer_gb =
+					((concurrent_loads.load() > 1)
+						? concurrent_buffers_size.fetch_add(buffer_size_tmp) + buffer_size_tmp
+						: buffer_size_tmp) / 1073741824.0;
 				if ((buffer_gb * 3) >= total_ram)
 				{
 					return QString(
@@ -9936,13 +10518,20 @@ QString DicomUtils::read_buffer(
 		//
 		//
 		//
-		try
+		if (target && image_buffer_length == target_size)
 		{
-			not_rescaled_buffer = new char[image_buffer_length];
+			not_rescaled_buffer = target;
 		}
-		catch (const std::bad_alloc&)
+		else
 		{
-			not_rescaled_buffer = nullptr;
+			try
+			{
+				not_rescaled_buffer = new char[image_buffer_length];
+			}
+			catch (const std::bad_alloc&)
+			{
+				not_rescaled_buffer = nullptr;
+			}
 		}
 		if (!not_rescaled_buffer)
 		{
@@ -9952,7 +10541,7 @@ QString DicomUtils::read_buffer(
 		}
 		if (!image.GetBuffer(not_rescaled_buffer))
 		{
-			delete [] not_rescaled_buffer;
+			delete_not_rescaled();
 			delete [] icc_profile;
 			if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
 			return QString("Buffer is null");
@@ -9976,7 +10565,7 @@ QString DicomUtils::read_buffer(
 			{
 				if (pixelformat.GetBitsAllocated() < 8)
 				{
-					delete [] not_rescaled_buffer;
+					delete_not_rescaled();
 					delete [] icc_profile;
 					if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
 					return QString(
@@ -9985,7 +10574,7 @@ QString DicomUtils::read_buffer(
 				}
 				if (supp_palette_color)
 				{
-					delete [] not_rescaled_buffer;
+					delete_not_rescaled();
 					delete [] icc_profile;
 					if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
 					return QString("Re-scale and Suppl. LUT?");
@@ -10026,7 +10615,7 @@ QString DicomUtils::read_buffer(
 						}
 						else
 						{
-							delete [] not_rescaled_buffer;
+							delete_not_rescaled();
 							delete [] icc_profile;
 							if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
 							return QString("Internal error (re-scale)");
@@ -10048,7 +10637,7 @@ QString DicomUtils::read_buffer(
 					}
 					if (!rescaled_buffer)
 					{
-						delete [] not_rescaled_buffer;
+						delete_not_rescaled();
 						delete [] icc_profile;
 						if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
 						return QString("Buffer is null");
@@ -10057,7 +10646,7 @@ QString DicomUtils::read_buffer(
 					if (ok_rescale)
 					{
 						rescale_ = true;
-						delete [] not_rescaled_buffer;
+						delete_not_rescaled();
 						not_rescaled_buffer = nullptr;
 					}
 					else
@@ -10142,7 +10731,7 @@ QString DicomUtils::read_buffer(
 						}
 						if (!rescaled_buffer)
 						{
-							delete [] not_rescaled_buffer;
+							delete_not_rescaled();
 							delete [] icc_profile;
 							if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
 							return QString("Buffer is null");
@@ -10317,7 +10906,7 @@ QString DicomUtils::read_buffer(
 				QString(", samples per pixel = ") +
 				QVariant(static_cast<int>(samples_per_pix)).toString() +
 				QString(", not supported.");
-			delete [] not_rescaled_buffer;
+			delete_not_rescaled();
 			delete [] icc_profile;
 			if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
 			return tmp_s0;
@@ -10333,7 +10922,7 @@ QString DicomUtils::read_buffer(
 				QString("Bits allocated = ") +
 				QVariant(static_cast<int>(pixelformat.GetBitsAllocated())).toString() +
 				QString(", not supported.");
-			delete [] not_rescaled_buffer;
+			delete_not_rescaled();
 			delete [] icc_profile;
 			if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
 			return tmp_s0;
@@ -10358,7 +10947,7 @@ QString DicomUtils::read_buffer(
 		}
 		if (!singlebit_buffer)
 		{
-			delete [] not_rescaled_buffer;
+			delete_not_rescaled();
 			delete [] icc_profile;
 			if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
 			return QString("Buffer allocation error");
@@ -10403,7 +10992,7 @@ QString DicomUtils::read_buffer(
 					QVariant(image_buffer_length).toString() +
 					QString(" but must be ") +
 					QVariant(dimx * dimy * dimz * type_size * samples_per_pix).toString();
-				delete [] not_rescaled_buffer;
+				delete_not_rescaled();
 				delete [] rescaled_buffer;
 				delete [] icc_profile;
 				if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
@@ -10423,7 +11012,7 @@ QString DicomUtils::read_buffer(
 				}
 				catch (const std::bad_alloc &)
 				{
-					delete [] not_rescaled_buffer;
+					delete_not_rescaled();
 					delete [] rescaled_buffer;
 					delete [] icc_profile;
 					if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
@@ -10437,7 +11026,7 @@ QString DicomUtils::read_buffer(
 					}
 					catch (const std::bad_alloc &)
 					{
-						delete [] not_rescaled_buffer;
+						delete_not_rescaled();
 						delete [] rescaled_buffer;
 						delete [] icc_buffer;
 						delete [] icc_profile;
@@ -10476,7 +11065,9 @@ QString DicomUtils::read_buffer(
 					}
 				}
 				cms_error = 0;
-				cmsSetLogErrorHandler(AlizaLCMS2LogErrorHandler);
+				static const bool cms_handler_set =
+					(cmsSetLogErrorHandler(AlizaLCMS2LogErrorHandler), true);
+				(void)cms_handler_set;
 				cmsHPROFILE hInProfile = cmsOpenProfileFromMem(icc_profile, icc_size);
 				if (cms_error == 0)
 				{
@@ -10503,7 +11094,7 @@ QString DicomUtils::read_buffer(
 								if (cms_error == 0)
 								{
 									buffer = icc_buffer;
-									delete [] not_rescaled_buffer;
+									delete_not_rescaled();
 									not_rescaled_buffer = nullptr;
 									*has_icc = true;
 								}
@@ -10557,35 +11148,53 @@ QString DicomUtils::read_buffer(
 		}
 	}
 	//
-	const size_t xy = buffer_size / dimz;
-	for (unsigned long long j = 0; j < dimz; ++j)
+	if (target)
 	{
-		char * p__;
-		bool badalloc{};
-		try
+		if (dimz != 1 || buffer_size != target_size)
 		{
-			p__ = new char[xy];
-		}
-		catch(const std::bad_alloc&)
-		{
-			badalloc = true;
-		}
-		if (p__ && !badalloc)
-		{
-			memcpy(p__, &(buffer[j*xy]), xy);
-			data.push_back(p__);
-		}
-		else
-		{
-			delete [] not_rescaled_buffer;
+			delete_not_rescaled();
 			delete [] rescaled_buffer;
 			delete [] singlebit_buffer;
 			delete [] icc_profile;
 			if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
-			return QString("Memory allocation error");
+			return QString(
+				"Files in series seem to have different "
+				"pixel format or dimensions. Try to load separately.");
+		}
+		if (buffer != target) memcpy(target, buffer, buffer_size);
+	}
+	else
+	{
+		const size_t xy = buffer_size / dimz;
+		for (unsigned long long j = 0; j < dimz; ++j)
+		{
+			char * p__;
+			bool badalloc{};
+			try
+			{
+				p__ = new char[xy];
+			}
+			catch(const std::bad_alloc&)
+			{
+				badalloc = true;
+			}
+			if (p__ && !badalloc)
+			{
+				memcpy(p__, &(buffer[j*xy]), xy);
+				data.push_back(p__);
+			}
+			else
+			{
+				delete_not_rescaled();
+				delete [] rescaled_buffer;
+				delete [] singlebit_buffer;
+				delete [] icc_profile;
+				if (elscint && !elscf.isEmpty()) QFile::remove(elscf);
+				return QString("Memory allocation error");
+			}
 		}
 	}
-	delete [] not_rescaled_buffer;
+	delete_not_rescaled();
 	delete [] rescaled_buffer;
 	delete [] singlebit_buffer;
 	delete [] icc_profile;
@@ -12166,7 +12775,6 @@ void DicomUtils::write_mpeg(
 bool DicomUtils::is_dicom_file(const QString & f)
 {
 	bool dicom{};
-	char b[4]{};
 	std::ifstream fs;
 #ifdef _WIN32
 #if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
@@ -12179,41 +12787,39 @@ bool DicomUtils::is_dicom_file(const QString & f)
 #else
 	fs.open(f.toLocal8Bit().constData(), std::ios::in | std::ios::binary);
 #endif
-	for (std::streamoff off = 128; off >= 0; off -= 128)
-	{
-		fs.seekg(off, std::ios_base::beg);
-		if (!fs.fail() && !fs.eof())
-		{
-			fs.read(b, 4);
-			if (!fs.fail())
-			{
-				if (b[0] == 'D' && b[1] == 'I' && b[2] == 'C' && b[3] == 'M')
-				{
-					dicom = true;
-					break;
-				}
-			}
-		}
-	}
-	if (!dicom)
+	if (fs.is_open())
 	{
-		unsigned short group_no{};
-		fs.seekg(0, std::ios_base::beg);
-		if (!fs.fail() && !fs.eof())
-		{
-			fs.read(reinterpret_cast<char *>(&group_no), sizeof(unsigned short));
-			itk::ByteSwapper<unsigned short>::SwapFromSystemToLittleEndian(&group_no);
-			// 0x0003 and 0x0005 are illegal, but files exist
-			if (group_no == 0x0002 || group_no == 0x0003 || group_no == 0x0005 || group_no == 0x0008)
-			{
-				dicom = true;
-			}
-		}
+		dicom = is_dicom_stream(fs);
 	}
 	fs.close();
 	return dicom;
 }
 
+// Reads not more than the first 132 bytes and a few element headers.
+// A file with the Part 10 prefix is accepted, else the stream may be
+// a data set without preamble in explicit or implicit VR little endian.
+bool DicomUtils::is_dicom_stream(std::istream & is)
+{
+	is.clear();
+	is.seekg(0, std::ios_base::end);
+	const std::streamoff size = is.tellg();
+	if (size < 8) return false;
+	char b[132]{};
+	const std::streamsize n = (size < 132) ? static_cast<std::streamsize>(size) : 132;
+	is.seekg(0, std::ios_base::beg);
+	if (!is.read(b, n)) return false;
+	if (n == 132 && b[128] == 'D' && b[129] == 'I' && b[130] == 'C' && b[131] == 'M')
+	{
+		return true;
+	}
+	// Prefix without preamble, the reader may still read the file
+	if (b[0] == 'D' && b[1] == 'I' && b[2] == 'C' && b[3] == 'M')
+	{
+		return true;
+	}
+	return (sniff_data_set(is, size, true) || sniff_data_set(is, size, false));
+}
+
 void DicomUtils::scan_dir_for_rtstruct_image(
 	const QString & p, QList<QStringList> & ref_files)
 {
@@ -13397,17 +14003,20 @@ QString DicomUtils::read_dicom(
 	bool ok3d,
 	const QWidget * settings,
 	short load_type,
-	short enh_loading_type)
+	short enh_loading_type,
+	short force_suppllut)
 {
 #ifdef ALIZA_LINUX_DEBUG_MEM
 	CommonUtils::linux_print_memusage("read_dicom() begin");
 #endif
+	const unsigned long long files_read_0 = files_read_count.load();
 	bool ok{};
 	QString message_;
 	const mdcm::Tag tSOPClassUID(0x0008,0x0016);
 	const mdcm::Tag tSlicePosition(0x0020,0x1041);
 	const mdcm::Tag tPhotometricInterpretation(0x0028,0x0004);
 	QStringList images;
+	FilesIPPIOP images_positions;
 	QStringList rtstruct_ref_search;
 	QString     rtstruct_ref_search_path;
 	QStringList grey_softcopy_pr_files;
@@ -13478,6 +14087,7 @@ QString DicomUtils::read_dicom(
 #else
 		reader.SetFileName(filenames.at(x).toLocal8Bit().constData());
 #endif
+		++files_read_count;
 		if (!reader.Read()) continue;
 #ifndef ALIZA_LOAD_DCM_THREAD
 		QApplication::processEvents();
@@ -13836,6 +14446,7 @@ QString DicomUtils::read_dicom(
 				}
 			}
 			images.push_back(filenames.at(x));
+			collect_ippiop(filenames.at(x), ds, images_positions);
 			++count_images;
 			sop_tmp1 = sop_tmp0;
 			rows_tmp1 = rows_tmp0;
@@ -14176,7 +14787,7 @@ QString DicomUtils::read_dicom(
 			}
 			if (images__.size() > 1)
 			{
-				sort_dicom_files_ippiop(images__, images_ipp);
+				sort_dicom_files_ippiop(images__, images_positions, images_ipp);
 			}
 			else if (images__.size() == 1)
 			{
@@ -14577,6 +15188,7 @@ QString DicomUtils::read_dicom(
 #else
 			reader.SetFileName(images.at(x).toLocal8Bit().constData());
 #endif
+			++files_read_count;
 			if (!reader.ReadUpToTag(mdcm::Tag(0x0028,0x2000))) continue;
 #ifndef ALIZA_LOAD_DCM_THREAD
 			QApplication::processEvents();
@@ -14678,7 +15290,7 @@ QString DicomUtils::read_dicom(
 			}
 			if (images__.size() > 1)
 			{
-				sort_dicom_files_ippiop(images__, images_ipp);
+				sort_dicom_files_ippiop(images__, images_positions, images_ipp);
 			}
 			else if (images__.size() == 1)
 			{
@@ -14765,7 +15377,7 @@ QString DicomUtils::read_dicom(
 			}
 			if (images__.size() > 1)
 			{
-				sort_dicom_files_ippiop(images__, images_ipp);
+				sort_dicom_files_ippiop(images__, images_positions, images_ipp);
 			}
 			else if (images__.size() == 1)
 			{
@@ -15076,6 +15688,13 @@ QString DicomUtils::read_dicom(
 		CommonUtils::get_reference_count(ivariants.at(x));
 	}
 #endif
+#ifdef ALIZA_VERBOSE
+	std::cout << "read_dicom(): " << filenames_size
+		<< " file(s), " << (files_read_count.load() - files_read_0)
+		<< " read(s)" << std::endl;
+#else
+	(void)files_read_0;
+#endif
 #ifdef ALIZA_LINUX_DEBUG_MEM
 	CommonUtils::linux_print_memusage("read_dicom() end");
 #endif
@@ -16,6 +16,12 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <istream>
+
+namespace mdcm
+{
+class ImageReader;
+}
 
 enum class EnhancedIODLoadingType : short
 {
@@ -91,6 +97,17 @@ public:
 
 typedef std::vector<FrameGroup> FrameGroupValues;
 
+struct SliceImageInfo
+{
+	unsigned short rows{};
+	unsigned short columns{};
+	QString position;
+	QString orientation;
+	QString spacing;
+	QString sop_instance_uid;
+	QString orientation_20_20;
+};
+
 struct GEMSParam
 {
 	unsigned int type;
@@ -209,7 +226,7 @@ public:
 	static bool check_encapsulated(const mdcm::DataSet&);
 	static bool is_multiframe(const mdcm::DataSet&);
 	static void read_image_info(
-		const QString&,
+		const mdcm::DataSet&,
 		unsigned short*,
 		unsigned short*,
 		QString&,
@@ -218,7 +235,7 @@ public:
 		QString&,
 		QString&);
 	static void read_image_info_rtdose(
-		const QString&,
+		const mdcm::DataSet&,
 		unsigned short*,
 		unsigned short*,
 		unsigned short*,
@@ -236,7 +253,7 @@ public:
 		const mdcm::DataSet&,
 		ImageVariant*);
 	static bool read_slices(
-		const QStringList&, ImageVariant*,
+		const std::vector<SliceImageInfo>&, ImageVariant*,
 		const bool, const bool,
 		float);
 	static bool read_slices_uihgrid(
@@ -244,7 +261,7 @@ public:
 		const bool,
 		float);
 	static bool read_slices_rtdose(
-		const QString&, ImageVariant*,
+		const mdcm::DataSet&, ImageVariant*,
 		const bool,
 		float);
 	static void read_dimension_index_sq(
@@ -375,7 +392,20 @@ public:
 		const bool,
 		int*,
 		unsigned long long*,
-		const bool, bool *);
+		const bool, bool *,
+		mdcm::ImageReader * = nullptr,
+		char * = nullptr, const size_t = 0);
+	static void begin_concurrent_loads(const int);
+	static void end_concurrent_loads();
+	static unsigned long long get_files_read();
+	static void set_memory_mapping(bool);
+	static bool get_memory_mapping();
+	static void set_decode_options(
+		mdcm::ImageReader&,
+		const bool,
+		const bool,
+		const bool,
+		const bool);
 	static QString read_enhanced_common(
 		bool*,
 		std::vector<ImageVariant*> &,
@@ -453,6 +483,7 @@ public:
 	static QString suffix_mpeg(const QString&);
 	static void write_mpeg(const QString&, const QString&);
 	static bool is_dicom_file(const QString&);
+	static bool is_dicom_stream(std::istream&);
 	static void scan_dir_for_rtstruct_image(
 		const QString&, QList<QStringList> &);
 	static void scan_files_for_rtstruct_image(
@@ -479,8 +510,6 @@ public:
 		bool);
 	static QString read_enhct_info(
 		const mdcm::DataSet&);
-	static void global_force_suppllut(
-		short);
 	static mdcm::VR get_vr(
 		const mdcm::DataSet &,
 		const mdcm::Tag&,
@@ -518,7 +547,8 @@ public:
 		bool,
 		const QWidget*,
 		short, // type of object processing
-		short);
+		short,
+		short = 0); // supplemental LUT: 1 force apply, 2 force not apply
 };
 
 #endif
@@ -39,5 +39,6 @@ void LoadDicom_T::run()
 		(void)ex;
 #endif
 	}
+	loaded.store(true);
 }
 
@@ -5,6 +5,7 @@
 #include <QWidget>
 #include <QString>
 #include <QStringList>
+#include <atomic>
 #include <vector>
 
 class ImageVariant;
@@ -37,6 +38,8 @@ public:
 	QStringList video_files;
 	QStringList spectroscopy_files;
 	QStringList sr_files;
+	// Set at the end of run(), before finished() is emitted
+	std::atomic<bool> loaded{};
 
 private:
 	const QString root;
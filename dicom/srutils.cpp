@@ -30,8 +30,6 @@
 #include "findrefdialog.h"
 #include <itkExtractImageFilter.h>
 #include "mmath.h"
-#include <chrono>
-#include <thread>
 
 namespace
 {
@@ -109,101 +107,16 @@ template<typename T> SRImage li3(
 		return SRImage();
 	}
 	//
-	std::vector<QThread*> threadsLUT_;
-	const int num_threads = QThread::idealThreadCount();
-	const int tmp99 = size[1] % num_threads;
 	const double center = ivariant->di->us_window_center;
 	const double width = ivariant->di->us_window_width;
 	const short lut_function = ivariant->di->lut_function;
-	if (tmp99 == 0)
-	{
-		unsigned int j{};
-		for (int i = 0; i < num_threads; ++i)
-		{
-			const int size_0 = size[0];
-			const int size_1 = size[1] / num_threads;
-			const int index_0{};
-			const int index_1 = i * size_1;
-			ProcessImageThreadLUT_<T> * t__ = new ProcessImageThreadLUT_<T>(
-						image,
-						p,
-						size_0, size_1,
-						index_0, index_1, j,
-						center, width,
-						lut, false, lut_function);
-			j += 3 * size_0 * size_1;
-			threadsLUT_.push_back(static_cast<QThread*>(t__));
-			t__->start();
-		}
-	}
-	else
-	{
-		unsigned int j{};
-		unsigned int block{64};
-		if (static_cast<float>(size[1]) / static_cast<float>(block) > 16.0f)
-		{
-			block = 128;
-		}
-		const int tmp100 = size[1] % block;
-		const int incr = static_cast<int>(floor(size[1] / static_cast<double>(block)));
-		if (size[1] > block)
-		{
-			for (int i = 0; i < incr; ++i)
-			{
-				const int size_0 = size[0];
-				const int index_0{};
-				const int index_1 = i * block;
-				ProcessImageThreadLUT_<T> * t__ = new ProcessImageThreadLUT_<T>(
-							image,
-							p,
-							size_0, block,
-							index_0, index_1, j,
-							center, width,
-							lut, false, lut_function);
-				j += 3 * size_0 * block;
-				threadsLUT_.push_back(static_cast<QThread*>(t__));
-				t__->start();
-			}
-			ProcessImageThreadLUT_<T> * lt__ = new ProcessImageThreadLUT_<T>(
-						image,
-						p,
-						size[0], tmp100,
-						0, incr * block, j,
-						ivariant->di->us_window_center, ivariant->di->us_window_width,
-						lut, false, lut_function);
-			threadsLUT_.push_back(static_cast<QThread*>(lt__));
-			lt__->start();
-		}
-		else
-		{
-			ProcessImageThreadLUT_<T> * lt__ = new ProcessImageThreadLUT_<T>(
-						image,
-						p,
-						size[0], size[1],
-						0, 0, 0,
-						center, width,
-						lut, false, lut_function);
-			threadsLUT_.push_back(static_cast<QThread*>(lt__));
-			lt__->start();
-		}
-	}
-	//
-	const size_t threadsLUT_size = threadsLUT_.size();
-	while (true)
-	{
-		std::this_thread::sleep_for(std::chrono::milliseconds(2));
-		size_t b__{};
-		for (size_t i = 0; i < threadsLUT_size; ++i)
-		{
-			if (threadsLUT_.at(i)->isFinished()) ++b__;
-		}
-		if (b__ == threadsLUT_size) break;
-	}
-	for (size_t i = 0; i < threadsLUT_size; ++i)
-	{
-		delete threadsLUT_[i];
-	}
-	threadsLUT_.clear();
+	process_image_LUT<T>(
+		image,
+		p,
+		size[0], size[1],
+		center, width,
+		lut, false, lut_function,
+		ivariant->di->rmin, ivariant->di->rmax);
 	//
 	SRImage sr;
 	sr.sx = spacing[0];
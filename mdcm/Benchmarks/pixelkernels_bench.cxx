@@ -0,0 +1,192 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+// Throughput of PixelKernels with each instruction set supported by
+// the CPU, GB/s of input values. The output of SSE2 and AVX2 must be
+// the same as of the scalar code, bit by bit, else the exit code is 1.
+// Built with MDCM_BUILD_BENCHMARKS.
+
+#include "mdcmPixelKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+
+// Not a multiple of any vector width, the scalar tail is checked too
+const size_t values = (size_t{ 1 } << 23) + 7;
+const int    repeats = 10;
+
+const char * const instruction_sets[] = { "scalar", "SSE2", "AVX2" };
+
+template <typename T>
+std::vector<T>
+random_values(T lo, T hi, unsigned int seed)
+{
+  std::mt19937_64                  g(seed);
+  std::uniform_int_distribution<T> d(lo, hi);
+  std::vector<T>                   v(values);
+  for (size_t i = 0; i < v.size(); ++i)
+    v[i] = d(g);
+  return v;
+}
+
+// Best time of 'repeats' runs, the input is restored before each run
+double
+best_seconds(const std::function<void()> & restore, const std::function<void()> & run)
+{
+  double best = 1e30;
+  for (int r = 0; r < repeats; ++r)
+  {
+    restore();
+    const auto   t0 = std::chrono::steady_clock::now();
+    run();
+    const auto   t1 = std::chrono::steady_clock::now();
+    const double s = std::chrono::duration<double>(t1 - t0).count();
+    best = std::min(best, s);
+  }
+  return best;
+}
+
+bool failed = false;
+
+// 'run' is called with the instruction set limited, 'result' is the
+// output as bytes after a single run from the original input.
+void
+bench(const std::string &                                 name,
+      const size_t                                        input_bytes,
+      const std::function<void()> &                       restore,
+      const std::function<void()> &                       run,
+      const std::function<std::vector<unsigned char>()> & result)
+{
+  std::printf("%-44s", name.c_str());
+  std::vector<unsigned char> reference;
+  for (const char * is : instruction_sets)
+  {
+    if (!mdcm::PixelKernels::SetInstructionSet(is))
+    {
+      std::printf("%12s", "-");
+      continue;
+    }
+    const double s = best_seconds(restore, run);
+    std::printf("%12.2f", (input_bytes / s) / 1e9);
+    restore();
+    run();
+    const std::vector<unsigned char> out = result();
+    if (reference.empty())
+    {
+      reference = out;
+    }
+    else if (out != reference)
+    {
+      std::printf(" (%s differs)", is);
+      failed = true;
+    }
+  }
+  mdcm::PixelKernels::SetInstructionSet(nullptr);
+  std::printf("\n");
+}
+
+template <typename T>
+std::vector<unsigned char>
+as_bytes(const std::vector<T> & v)
+{
+  const unsigned char * p = reinterpret_cast<const unsigned char *>(v.data());
+  return std::vector<unsigned char>(p, p + v.size() * sizeof(T));
+}
+
+template <typename T>
+void
+bench_swap(const std::string & name, void (*f)(void *, size_t), unsigned int seed)
+{
+  const std::vector<T> in = random_values<T>(0, static_cast<T>(-1), seed);
+  std::vector<T>       v(in.size());
+  bench(
+    name,
+    in.size() * sizeof(T),
+    [&]() { std::memcpy(v.data(), in.data(), in.size() * sizeof(T)); },
+    [&]() { f(v.data(), v.size()); },
+    [&]() { return as_bytes(v); });
+}
+
+template <typename T>
+void
+bench_cleanup(const std::string & name,
+              void (*f)(T *, size_t, unsigned int, unsigned int, bool),
+              unsigned int shift,
+              unsigned int bits,
+              bool         sign,
+              unsigned int seed)
+{
+  const std::vector<T> in = random_values<T>(0, static_cast<T>(-1), seed);
+  std::vector<T>       v(in.size());
+  bench(
+    name + " shift " + std::to_string(shift) + " bits " + std::to_string(bits) + (sign ? " signed" : ""),
+    in.size() * sizeof(T),
+    [&]() { std::memcpy(v.data(), in.data(), in.size() * sizeof(T)); },
+    [&]() { f(v.data(), v.size(), shift, bits, sign); },
+    [&]() { return as_bytes(v); });
+}
+
+// Input values are 12 bits, slope and intercept keep results in
+// the range of the output type.
+template <typename TOut, typename TIn>
+void
+bench_rescale(const std::string & name, double slope, double intercept, unsigned int seed)
+{
+  const std::vector<TIn> in = std::is_signed<TIn>::value ? random_values<TIn>(-2048, 2047, seed)
+                                                         : random_values<TIn>(0, 4095, seed);
+  std::vector<TOut>      out(in.size());
+  bench(
+    name,
+    in.size() * sizeof(TIn),
+    [&]() { std::fill(out.begin(), out.end(), TOut(0)); },
+    [&]() { mdcm::PixelKernels::Rescale(out.data(), in.data(), in.size(), slope, intercept); },
+    [&]() { return as_bytes(out); });
+}
+
+} // namespace
+
+int
+main()
+{
+  std::printf("PixelKernels, detected %s, %zu values, GB/s of input, best of %d\n\n",
+              mdcm::PixelKernels::GetInstructionSet(),
+              values,
+              repeats);
+  std::printf("%-44s%12s%12s%12s\n", "", "scalar", "SSE2", "AVX2");
+  bench_swap<uint16_t>("SwapArray16", mdcm::PixelKernels::SwapArray16, 1);
+  bench_swap<uint32_t>("SwapArray32", mdcm::PixelKernels::SwapArray32, 2);
+  bench_swap<uint64_t>("SwapArray64", mdcm::PixelKernels::SwapArray64, 3);
+  bench_cleanup<uint16_t>("CleanupUnusedBits16", mdcm::PixelKernels::CleanupUnusedBits16, 0, 12, false, 4);
+  bench_cleanup<uint16_t>("CleanupUnusedBits16", mdcm::PixelKernels::CleanupUnusedBits16, 4, 12, true, 5);
+  bench_cleanup<uint32_t>("CleanupUnusedBits32", mdcm::PixelKernels::CleanupUnusedBits32, 0, 24, false, 6);
+  bench_cleanup<uint32_t>("CleanupUnusedBits32", mdcm::PixelKernels::CleanupUnusedBits32, 8, 20, true, 7);
+  bench_rescale<int16_t, int16_t>("Rescale int16 <- int16", 1.5, -1024.0, 8);
+  bench_rescale<int16_t, uint16_t>("Rescale int16 <- uint16", 1.5, -1024.0, 9);
+  bench_rescale<uint16_t, int16_t>("Rescale uint16 <- int16", 2.0, 4096.0, 10);
+  bench_rescale<uint16_t, uint16_t>("Rescale uint16 <- uint16", 2.0, 4096.0, 11);
+  bench_rescale<int32_t, int16_t>("Rescale int32 <- int16", 1.5, -1024.0, 12);
+  bench_rescale<int32_t, uint16_t>("Rescale int32 <- uint16", 1.5, -1024.0, 13);
+  bench_rescale<float, int16_t>("Rescale float <- int16", 0.3, -1024.5, 14);
+  bench_rescale<float, uint16_t>("Rescale float <- uint16", 0.3, -1024.5, 15);
+  if (failed)
+  {
+    std::printf("\nSIMD output is not the same as scalar output\n");
+    return 1;
+  }
+  std::printf("\nSIMD output is the same as scalar output\n");
+  return 0;
+}
@@ -0,0 +1,162 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#include "mdcmMappedFile.h"
+#include "mdcmSystem.h"
+#include "mdcmTrace.h"
+#include <limits>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+namespace mdcm
+{
+
+// Smaller values are copied
+static const size_t min_view_size = 4096;
+
+MappedFile::~MappedFile()
+{
+  Close();
+}
+
+bool
+MappedFile::Open(const char * filename)
+{
+  Close();
+  if (!filename || !*filename)
+    return false;
+#ifdef _WIN32
+#  if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
+  const std::wstring unc = System::ConvertToUtf16(filename);
+  HANDLE             f = CreateFileW(
+    unc.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#  else
+  HANDLE f = CreateFileA(
+    filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#  endif
+  if (f == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER s;
+  if (!GetFileSizeEx(f, &s) || s.QuadPart <= 0 ||
+      static_cast<unsigned long long>(s.QuadPart) > std::numeric_limits<size_t>::max())
+  {
+    CloseHandle(f);
+    return false;
+  }
+  HANDLE m = CreateFileMappingA(f, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+  CloseHandle(f);
+  if (!m)
+    return false;
+  void * p = MapViewOfFile(m, FILE_MAP_COPY, 0, 0, 0);
+  if (!p)
+  {
+    CloseHandle(m);
+    return false;
+  }
+  Mapping = m;
+  Data = static_cast<char *>(p);
+  Size = static_cast<size_t>(s.QuadPart);
+#else
+  const int f = open(filename, O_RDONLY);
+  if (f < 0)
+    return false;
+  struct stat s;
+  if (fstat(f, &s) != 0 || s.st_size <= 0 ||
+      static_cast<unsigned long long>(s.st_size) > std::numeric_limits<size_t>::max())
+  {
+    close(f);
+    return false;
+  }
+  void * p = mmap(nullptr, static_cast<size_t>(s.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, f, 0);
+  close(f);
+  if (p == MAP_FAILED)
+  {
+    mdcmDebugMacro("mmap failed " << filename);
+    return false;
+  }
+  Data = static_cast<char *>(p);
+  Size = static_cast<size_t>(s.st_size);
+#endif
+  return true;
+}
+
+void
+MappedFile::Close()
+{
+  if (!Data)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(Data);
+  CloseHandle(static_cast<HANDLE>(Mapping));
+  Mapping = nullptr;
+#else
+  munmap(Data, Size);
+#endif
+  Data = nullptr;
+  Size = 0;
+}
+
+char *
+MappedFile::GetData() const
+{
+  return Data;
+}
+
+size_t
+MappedFile::GetSize() const
+{
+  return Size;
+}
+
+MappedStreamBuf::MappedStreamBuf(MappedFile * f)
+  : MemoryStreamBuf(f ? f->GetData() : nullptr, (f && f->GetData()) ? f->GetSize() : 0)
+  , File(f)
+{}
+
+MappedFile *
+MappedStreamBuf::GetFile() const
+{
+  return File;
+}
+
+// True if a value of the length can be a view,
+// the stream must be good.
+bool
+MappedStreamBuf::CanView(std::istream & is, size_t length)
+{
+  if (length < min_view_size || !is.good())
+    return false;
+  const MappedStreamBuf * b = dynamic_cast<const MappedStreamBuf *>(is.rdbuf());
+  if (!b)
+    return false;
+  return (static_cast<size_t>(b->egptr() - b->gptr()) >= length);
+}
+
+// Returns the current position and skips 'length' bytes,
+// 'owner' keeps the memory mapped.
+const char *
+MappedStreamBuf::View(std::istream & is, size_t length, SmartPointer<Object> & owner)
+{
+  if (!CanView(is, length))
+    return nullptr;
+  MappedStreamBuf * b = static_cast<MappedStreamBuf *>(is.rdbuf());
+  char * p = b->gptr();
+  b->setg(b->eback(), p + length, b->egptr());
+  owner = b->File.GetPointer();
+  return p;
+}
+
+} // end namespace mdcm
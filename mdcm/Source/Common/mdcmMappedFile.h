@@ -0,0 +1,78 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#ifndef MDCMMAPPEDFILE_H
+#define MDCMMAPPEDFILE_H
+
+#include "mdcmObject.h"
+#include "mdcmSmartPointer.h"
+#include "mdcmMemoryStreamBuf.h"
+#include <istream>
+#include <cstddef>
+
+namespace mdcm
+{
+
+/**
+ * MappedFile
+ *
+ * Read-only file mapped into memory, copy-on-write, i.e. writing
+ * to the memory is allowed, but never changes the file. ByteValues
+ * pointing into the memory keep a reference.
+ *
+ */
+class MDCM_EXPORT MappedFile : public Object
+{
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &
+  operator=(const MappedFile &) = delete;
+  bool
+  Open(const char *);
+  void
+  Close();
+  char *
+  GetData() const;
+  size_t
+  GetSize() const;
+
+private:
+  char * Data{};
+  size_t Size{};
+#ifdef _WIN32
+  void * Mapping{};
+#endif
+};
+
+/**
+ * MappedStreamBuf
+ *
+ * Stream buffer over a MappedFile, large values read from an istream
+ * using this buffer are views into the memory, see ByteValue.
+ *
+ */
+class MDCM_EXPORT MappedStreamBuf : public MemoryStreamBuf
+{
+public:
+  explicit MappedStreamBuf(MappedFile *);
+  MappedFile *
+  GetFile() const;
+  static bool
+  CanView(std::istream &, size_t);
+  static const char *
+  View(std::istream &, size_t, SmartPointer<Object> &);
+
+private:
+  SmartPointer<MappedFile> File;
+};
+
+} // end namespace mdcm
+
+#endif // MDCMMAPPEDFILE_H
@@ -0,0 +1,106 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#include "mdcmMemoryStreamBuf.h"
+#include <climits>
+#include <cstring>
+
+namespace mdcm
+{
+
+MemoryStreamBuf::MemoryStreamBuf(const char * p, size_t s)
+{
+  // Never written, get area only
+  char * b = const_cast<char *>(p);
+  setg(b, b, b ? b + s : b);
+}
+
+MemoryStreamBuf::pos_type
+MemoryStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  if (!(which & std::ios_base::in))
+    return pos_type(off_type(-1));
+  const off_type size = egptr() - eback();
+  off_type       pos;
+  if (dir == std::ios_base::beg)
+    pos = off;
+  else if (dir == std::ios_base::cur)
+    pos = (gptr() - eback()) + off;
+  else
+    pos = size + off;
+  if (pos < 0 || pos > size)
+    return pos_type(off_type(-1));
+  setg(eback(), eback() + pos, egptr());
+  return pos_type(pos);
+}
+
+MemoryStreamBuf::pos_type
+MemoryStreamBuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+  return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+std::streamsize
+MemoryStreamBuf::showmanyc()
+{
+  const std::streamsize n = egptr() - gptr();
+  return (n > 0) ? n : -1;
+}
+
+MemoryOutputStreamBuf::MemoryOutputStreamBuf(char * p, size_t s)
+{
+  setp(p, p ? p + s : p);
+}
+
+// Bytes written, including discarded
+unsigned long long
+MemoryOutputStreamBuf::GetLength() const
+{
+  return static_cast<unsigned long long>(pptr() - pbase()) + Discarded;
+}
+
+MemoryOutputStreamBuf::int_type
+MemoryOutputStreamBuf::overflow(int_type c)
+{
+  if (!traits_type::eq_int_type(c, traits_type::eof()))
+    ++Discarded;
+  return traits_type::not_eof(c);
+}
+
+std::streamsize
+MemoryOutputStreamBuf::xsputn(const char * s, std::streamsize n)
+{
+  if (n <= 0)
+    return 0;
+  const std::streamsize a = epptr() - pptr();
+  const std::streamsize k = (n < a) ? n : a;
+  if (k > 0)
+  {
+    memcpy(pptr(), s, static_cast<size_t>(k));
+    std::streamsize r = k;
+    while (r > 0)
+    {
+      const int x = (r > INT_MAX) ? INT_MAX : static_cast<int>(r);
+      pbump(x);
+      r -= x;
+    }
+  }
+  Discarded += static_cast<unsigned long long>(n - k);
+  return n;
+}
+
+MemoryOutputStreamBuf::pos_type
+MemoryOutputStreamBuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+  // tellp() only
+  if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::out))
+    return pos_type(off_type(-1));
+  return pos_type(static_cast<off_type>(GetLength()));
+}
+
+} // end namespace mdcm
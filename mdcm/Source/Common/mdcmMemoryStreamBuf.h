@@ -0,0 +1,68 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#ifndef MDCMMEMORYSTREAMBUF_H
+#define MDCMMEMORYSTREAMBUF_H
+
+#include "mdcmTypes.h"
+#include <streambuf>
+#include <cstddef>
+
+namespace mdcm
+{
+
+/**
+ * MemoryStreamBuf
+ *
+ * Seekable read-only stream buffer over memory owned by the caller,
+ * to pass data to stream based decoders without copies.
+ *
+ */
+class MDCM_EXPORT MemoryStreamBuf : public std::streambuf
+{
+public:
+  MemoryStreamBuf(const char *, size_t);
+
+protected:
+  pos_type
+  seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode) override;
+  pos_type
+  seekpos(pos_type, std::ios_base::openmode) override;
+  std::streamsize
+  showmanyc() override;
+};
+
+/**
+ * MemoryOutputStreamBuf
+ *
+ * Stream buffer writing into memory of fixed size owned by the caller,
+ * bytes beyond the end are counted, but discarded.
+ *
+ */
+class MDCM_EXPORT MemoryOutputStreamBuf : public std::streambuf
+{
+public:
+  MemoryOutputStreamBuf(char *, size_t);
+  unsigned long long
+  GetLength() const;
+
+protected:
+  int_type
+  overflow(int_type) override;
+  std::streamsize
+  xsputn(const char *, std::streamsize) override;
+  pos_type
+  seekoff(off_type, std::ios_base::seekdir, std::ios_base::openmode) override;
+
+private:
+  unsigned long long Discarded{};
+};
+
+} // end namespace mdcm
+
+#endif // MDCMMEMORYSTREAMBUF_H
@@ -0,0 +1,677 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#include "mdcmPixelKernels.h"
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// Only x86-64, on 32-bit x86 the scalar code may use x87
+// and the results would not be the same.
+#if !defined(DISABLE_SIMDMATH) && (defined(__x86_64__) || defined(_M_X64))
+#  define MDCM_KERNELS_SSE2
+#  include <emmintrin.h>
+#  if defined(__GNUC__) || defined(__clang__)
+#    define MDCM_KERNELS_AVX2
+#    define MDCM_KERNELS_TARGET_AVX2 __attribute__((target("avx2")))
+#    include <immintrin.h>
+#  elif defined(_MSC_VER)
+#    define MDCM_KERNELS_AVX2
+#    define MDCM_KERNELS_TARGET_AVX2
+#    include <immintrin.h>
+#    include <intrin.h>
+#  endif
+#endif
+
+namespace mdcm
+{
+
+namespace
+{
+
+int
+detect_level()
+{
+#ifdef MDCM_KERNELS_AVX2
+#  if defined(__GNUC__) || defined(__clang__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return 2;
+#  else
+  int r[4];
+  __cpuid(r, 0);
+  if (r[0] >= 7)
+  {
+    __cpuid(r, 1);
+    const bool osxsave = (r[2] & (1 << 27)) != 0;
+    const bool avx = (r[2] & (1 << 28)) != 0;
+    __cpuidex(r, 7, 0);
+    const bool avx2 = (r[1] & (1 << 5)) != 0;
+    if (osxsave && avx && avx2 && ((_xgetbv(0) & 6) == 6))
+      return 2;
+  }
+#  endif
+#endif
+#ifdef MDCM_KERNELS_SSE2
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+int
+detected_level()
+{
+  static const int level = detect_level();
+  return level;
+}
+
+// Set with PixelKernels::SetInstructionSet()
+std::atomic<int> max_level{ 2 };
+
+int
+get_level()
+{
+  const int l = max_level.load(std::memory_order_relaxed);
+  const int d = detected_level();
+  return (d < l) ? d : l;
+}
+
+// Scalar code, also for the remaining values of the vectorized loops
+
+void
+swap16_scalar(uint16_t * p, size_t n)
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    p[i] = static_cast<uint16_t>((p[i] << 8) | (p[i] >> 8));
+  }
+}
+
+void
+swap32_scalar(uint32_t * p, size_t n)
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    const uint32_t a = p[i];
+    p[i] = (a << 24) | ((a << 8) & 0x00ff0000U) | ((a >> 8) & 0x0000ff00U) | (a >> 24);
+  }
+}
+
+void
+swap64_scalar(uint64_t * p, size_t n)
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    uint64_t a = p[i];
+    a = ((a << 8) & 0xff00ff00ff00ff00ULL) | ((a >> 8) & 0x00ff00ff00ff00ffULL);
+    a = ((a << 16) & 0xffff0000ffff0000ULL) | ((a >> 16) & 0x0000ffff0000ffffULL);
+    p[i] = (a << 32) | (a >> 32);
+  }
+}
+
+void
+cleanup16_scalar(uint16_t * p, size_t n, unsigned int shift, unsigned int bits, bool sign)
+{
+  const uint16_t pmask = static_cast<uint16_t>(0xffffU >> (16 - bits));
+  if (sign)
+  {
+    const uint16_t smask = static_cast<uint16_t>(1U << (16 - (16 - bits + 1)));
+    const int16_t  nmask = static_cast<int16_t>(0xffff8000U >> (16 - bits - 1));
+    for (size_t i = 0; i < n; ++i)
+    {
+      uint16_t c = static_cast<uint16_t>(p[i] >> shift);
+      if (c & smask)
+      {
+        c = static_cast<uint16_t>(c | nmask);
+      }
+      else
+      {
+        c = c & pmask;
+      }
+      p[i] = c;
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      p[i] = static_cast<uint16_t>((p[i] >> shift) & pmask);
+    }
+  }
+}
+
+void
+cleanup32_scalar(uint32_t * p, size_t n, unsigned int shift, unsigned int bits, bool sign)
+{
+  const uint32_t pmask = static_cast<uint32_t>(0xffffffffU >> (32 - bits));
+  if (sign)
+  {
+    const uint32_t smask = static_cast<uint32_t>(1U << (32 - (32 - bits + 1)));
+    const int32_t  nmask = static_cast<int32_t>(0xffffffff80000000ULL >> (32 - bits - 1));
+    for (size_t i = 0; i < n; ++i)
+    {
+      uint32_t c = p[i] >> shift;
+      if (c & smask)
+      {
+        c = static_cast<uint32_t>(c | nmask);
+      }
+      else
+      {
+        c = c & pmask;
+      }
+      p[i] = c;
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      p[i] = (p[i] >> shift) & pmask;
+    }
+  }
+}
+
+template <typename TOut, typename TIn>
+void
+rescale_scalar(TOut * out, const TIn * in, size_t n, double slope, double intercept)
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    out[i] = static_cast<TOut>(slope * in[i] + intercept);
+  }
+}
+
+#ifdef MDCM_KERNELS_SSE2
+
+size_t
+swap16_sse2(uint16_t * p, size_t n)
+{
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m128i * q = reinterpret_cast<__m128i *>(p + i);
+    const __m128i v = _mm_loadu_si128(q);
+    _mm_storeu_si128(q, _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+  }
+  return i;
+}
+
+inline __m128i
+swap32_sse2(const __m128i v)
+{
+  const __m128i w = _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+  return _mm_or_si128(_mm_slli_epi16(w, 8), _mm_srli_epi16(w, 8));
+}
+
+size_t
+swap32_sse2(uint32_t * p, size_t n)
+{
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128i * q = reinterpret_cast<__m128i *>(p + i);
+    _mm_storeu_si128(q, swap32_sse2(_mm_loadu_si128(q)));
+  }
+  return i;
+}
+
+size_t
+swap64_sse2(uint64_t * p, size_t n)
+{
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2)
+  {
+    __m128i * q = reinterpret_cast<__m128i *>(p + i);
+    _mm_storeu_si128(q, swap32_sse2(_mm_shuffle_epi32(_mm_loadu_si128(q), 0xb1)));
+  }
+  return i;
+}
+
+// Sign extension from 'bits' is the same as the masks of the scalar code
+size_t
+cleanup16_sse2(uint16_t * p, size_t n, unsigned int shift, unsigned int bits, bool sign)
+{
+  const __m128i s = _mm_cvtsi32_si128(static_cast<int>(shift));
+  const __m128i e = _mm_cvtsi32_si128(static_cast<int>(16 - bits));
+  const __m128i pmask = _mm_set1_epi16(static_cast<short>(0xffffU >> (16 - bits)));
+  size_t        i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m128i * q = reinterpret_cast<__m128i *>(p + i);
+    __m128i   v = _mm_srl_epi16(_mm_loadu_si128(q), s);
+    v = sign ? _mm_sra_epi16(_mm_sll_epi16(v, e), e) : _mm_and_si128(v, pmask);
+    _mm_storeu_si128(q, v);
+  }
+  return i;
+}
+
+size_t
+cleanup32_sse2(uint32_t * p, size_t n, unsigned int shift, unsigned int bits, bool sign)
+{
+  const __m128i s = _mm_cvtsi32_si128(static_cast<int>(shift));
+  const __m128i e = _mm_cvtsi32_si128(static_cast<int>(32 - bits));
+  const __m128i pmask = _mm_set1_epi32(static_cast<int>(0xffffffffU >> (32 - bits)));
+  size_t        i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    __m128i * q = reinterpret_cast<__m128i *>(p + i);
+    __m128i   v = _mm_srl_epi32(_mm_loadu_si128(q), s);
+    v = sign ? _mm_sra_epi32(_mm_sll_epi32(v, e), e) : _mm_and_si128(v, pmask);
+    _mm_storeu_si128(q, v);
+  }
+  return i;
+}
+
+// Conversion to 16 bits keeps the low bits as the scalar cast does
+inline __m128i
+pack16_sse2(const __m128i a, const __m128i b)
+{
+  return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+}
+
+inline void
+store8_sse2(float * out, const __m128d * y)
+{
+  _mm_storeu_ps(out, _mm_movelh_ps(_mm_cvtpd_ps(y[0]), _mm_cvtpd_ps(y[1])));
+  _mm_storeu_ps(out + 4, _mm_movelh_ps(_mm_cvtpd_ps(y[2]), _mm_cvtpd_ps(y[3])));
+}
+
+inline void
+store8_sse2(int32_t * out, const __m128d * y)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                   _mm_unpacklo_epi64(_mm_cvttpd_epi32(y[0]), _mm_cvttpd_epi32(y[1])));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4),
+                   _mm_unpacklo_epi64(_mm_cvttpd_epi32(y[2]), _mm_cvttpd_epi32(y[3])));
+}
+
+inline void
+store8_sse2(int16_t * out, const __m128d * y)
+{
+  const __m128i a = _mm_unpacklo_epi64(_mm_cvttpd_epi32(y[0]), _mm_cvttpd_epi32(y[1]));
+  const __m128i b = _mm_unpacklo_epi64(_mm_cvttpd_epi32(y[2]), _mm_cvttpd_epi32(y[3]));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out), pack16_sse2(a, b));
+}
+
+inline void
+store8_sse2(uint16_t * out, const __m128d * y)
+{
+  store8_sse2(reinterpret_cast<int16_t *>(out), y);
+}
+
+template <typename TOut, typename TIn>
+size_t
+rescale_sse2(TOut * out, const TIn * in, size_t n, double slope, double intercept)
+{
+  const __m128d s = _mm_set1_pd(slope);
+  const __m128d c = _mm_set1_pd(intercept);
+  const __m128i z = _mm_setzero_si128();
+  size_t        i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    __m128i       lo, hi;
+    if (std::is_signed<TIn>::value)
+    {
+      lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+      hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    }
+    else
+    {
+      lo = _mm_unpacklo_epi16(v, z);
+      hi = _mm_unpackhi_epi16(v, z);
+    }
+    __m128d y[4];
+    y[0] = _mm_add_pd(_mm_mul_pd(s, _mm_cvtepi32_pd(lo)), c);
+    y[1] = _mm_add_pd(_mm_mul_pd(s, _mm_cvtepi32_pd(_mm_shuffle_epi32(lo, 0xee))), c);
+    y[2] = _mm_add_pd(_mm_mul_pd(s, _mm_cvtepi32_pd(hi)), c);
+    y[3] = _mm_add_pd(_mm_mul_pd(s, _mm_cvtepi32_pd(_mm_shuffle_epi32(hi, 0xee))), c);
+    store8_sse2(out + i, y);
+  }
+  return i;
+}
+
+#endif
+
+#ifdef MDCM_KERNELS_AVX2
+
+MDCM_KERNELS_TARGET_AVX2
+size_t
+swap_avx2(char * p, size_t bytes, const __m256i mask)
+{
+  size_t i = 0;
+  for (; i + 32 <= bytes; i += 32)
+  {
+    __m256i * q = reinterpret_cast<__m256i *>(p + i);
+    _mm256_storeu_si256(q, _mm256_shuffle_epi8(_mm256_loadu_si256(q), mask));
+  }
+  return i;
+}
+
+MDCM_KERNELS_TARGET_AVX2
+size_t
+swap16_avx2(uint16_t * p, size_t n)
+{
+  const __m256i mask = _mm256_setr_epi8(
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  return swap_avx2(reinterpret_cast<char *>(p), n * 2, mask) / 2;
+}
+
+MDCM_KERNELS_TARGET_AVX2
+size_t
+swap32_avx2(uint32_t * p, size_t n)
+{
+  const __m256i mask = _mm256_setr_epi8(
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  return swap_avx2(reinterpret_cast<char *>(p), n * 4, mask) / 4;
+}
+
+MDCM_KERNELS_TARGET_AVX2
+size_t
+swap64_avx2(uint64_t * p, size_t n)
+{
+  const __m256i mask = _mm256_setr_epi8(
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+  return swap_avx2(reinterpret_cast<char *>(p), n * 8, mask) / 8;
+}
+
+MDCM_KERNELS_TARGET_AVX2
+size_t
+cleanup16_avx2(uint16_t * p, size_t n, unsigned int shift, unsigned int bits, bool sign)
+{
+  const __m128i s = _mm_cvtsi32_si128(static_cast<int>(shift));
+  const __m128i e = _mm_cvtsi32_si128(static_cast<int>(16 - bits));
+  const __m256i pmask = _mm256_set1_epi16(static_cast<short>(0xffffU >> (16 - bits)));
+  size_t        i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m256i * q = reinterpret_cast<__m256i *>(p + i);
+    __m256i   v = _mm256_srl_epi16(_mm256_loadu_si256(q), s);
+    v = sign ? _mm256_sra_epi16(_mm256_sll_epi16(v, e), e) : _mm256_and_si256(v, pmask);
+    _mm256_storeu_si256(q, v);
+  }
+  return i;
+}
+
+MDCM_KERNELS_TARGET_AVX2
+size_t
+cleanup32_avx2(uint32_t * p, size_t n, unsigned int shift, unsigned int bits, bool sign)
+{
+  const __m128i s = _mm_cvtsi32_si128(static_cast<int>(shift));
+  const __m128i e = _mm_cvtsi32_si128(static_cast<int>(32 - bits));
+  const __m256i pmask = _mm256_set1_epi32(static_cast<int>(0xffffffffU >> (32 - bits)));
+  size_t        i = 0;
+  for (; i + 8 <= n; i += 8)
+  {
+    __m256i * q = reinterpret_cast<__m256i *>(p + i);
+    __m256i   v = _mm256_srl_epi32(_mm256_loadu_si256(q), s);
+    v = sign ? _mm256_sra_epi32(_mm256_sll_epi32(v, e), e) : _mm256_and_si256(v, pmask);
+    _mm256_storeu_si256(q, v);
+  }
+  return i;
+}
+
+MDCM_KERNELS_TARGET_AVX2
+inline void
+store16_avx2(float * out, const __m256d * y)
+{
+  _mm_storeu_ps(out, _mm256_cvtpd_ps(y[0]));
+  _mm_storeu_ps(out + 4, _mm256_cvtpd_ps(y[1]));
+  _mm_storeu_ps(out + 8, _mm256_cvtpd_ps(y[2]));
+  _mm_storeu_ps(out + 12, _mm256_cvtpd_ps(y[3]));
+}
+
+MDCM_KERNELS_TARGET_AVX2
+inline void
+store16_avx2(int32_t * out, const __m256d * y)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_cvttpd_epi32(y[0]));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4), _mm256_cvttpd_epi32(y[1]));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm256_cvttpd_epi32(y[2]));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 12), _mm256_cvttpd_epi32(y[3]));
+}
+
+MDCM_KERNELS_TARGET_AVX2
+inline void
+store16_avx2(int16_t * out, const __m256d * y)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                   pack16_sse2(_mm256_cvttpd_epi32(y[0]), _mm256_cvttpd_epi32(y[1])));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8),
+                   pack16_sse2(_mm256_cvttpd_epi32(y[2]), _mm256_cvttpd_epi32(y[3])));
+}
+
+MDCM_KERNELS_TARGET_AVX2
+inline void
+store16_avx2(uint16_t * out, const __m256d * y)
+{
+  store16_avx2(reinterpret_cast<int16_t *>(out), y);
+}
+
+template <typename TOut, typename TIn>
+MDCM_KERNELS_TARGET_AVX2 size_t
+rescale_avx2(TOut * out, const TIn * in, size_t n, double slope, double intercept)
+{
+  const __m256d s = _mm256_set1_pd(slope);
+  const __m256d c = _mm256_set1_pd(intercept);
+  size_t        i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 8));
+    __m256i       a, b;
+    if (std::is_signed<TIn>::value)
+    {
+      a = _mm256_cvtepi16_epi32(v0);
+      b = _mm256_cvtepi16_epi32(v1);
+    }
+    else
+    {
+      a = _mm256_cvtepu16_epi32(v0);
+      b = _mm256_cvtepu16_epi32(v1);
+    }
+    __m256d y[4];
+    y[0] = _mm256_add_pd(_mm256_mul_pd(s, _mm256_cvtepi32_pd(_mm256_castsi256_si128(a))), c);
+    y[1] = _mm256_add_pd(_mm256_mul_pd(s, _mm256_cvtepi32_pd(_mm256_extracti128_si256(a, 1))), c);
+    y[2] = _mm256_add_pd(_mm256_mul_pd(s, _mm256_cvtepi32_pd(_mm256_castsi256_si128(b))), c);
+    y[3] = _mm256_add_pd(_mm256_mul_pd(s, _mm256_cvtepi32_pd(_mm256_extracti128_si256(b, 1))), c);
+    store16_avx2(out + i, y);
+  }
+  return i;
+}
+
+#endif
+
+template <typename TOut, typename TIn>
+bool
+rescale(TOut * out, const TIn * in, size_t n, double slope, double intercept)
+{
+  size_t i = 0;
+#ifdef MDCM_KERNELS_AVX2
+  if (get_level() == 2)
+    i = rescale_avx2(out, in, n, slope, intercept);
+#endif
+#ifdef MDCM_KERNELS_SSE2
+  if (get_level() == 1)
+    i = rescale_sse2(out, in, n, slope, intercept);
+#endif
+  rescale_scalar(out + i, in + i, n - i, slope, intercept);
+  return true;
+}
+
+} // namespace
+
+void
+PixelKernels::SwapArray16(void * p, size_t n)
+{
+  uint16_t * q = static_cast<uint16_t *>(p);
+  size_t     i = 0;
+#ifdef MDCM_KERNELS_AVX2
+  if (get_level() == 2)
+    i = swap16_avx2(q, n);
+#endif
+#ifdef MDCM_KERNELS_SSE2
+  if (get_level() == 1)
+    i = swap16_sse2(q, n);
+#endif
+  swap16_scalar(q + i, n - i);
+}
+
+void
+PixelKernels::SwapArray32(void * p, size_t n)
+{
+  uint32_t * q = static_cast<uint32_t *>(p);
+  size_t     i = 0;
+#ifdef MDCM_KERNELS_AVX2
+  if (get_level() == 2)
+    i = swap32_avx2(q, n);
+#endif
+#ifdef MDCM_KERNELS_SSE2
+  if (get_level() == 1)
+    i = swap32_sse2(q, n);
+#endif
+  swap32_scalar(q + i, n - i);
+}
+
+void
+PixelKernels::SwapArray64(void * p, size_t n)
+{
+  uint64_t * q = static_cast<uint64_t *>(p);
+  size_t     i = 0;
+#ifdef MDCM_KERNELS_AVX2
+  if (get_level() == 2)
+    i = swap64_avx2(q, n);
+#endif
+#ifdef MDCM_KERNELS_SSE2
+  if (get_level() == 1)
+    i = swap64_sse2(q, n);
+#endif
+  swap64_scalar(q + i, n - i);
+}
+
+// Nothing is done with invalid parameters
+void
+PixelKernels::CleanupUnusedBits16(uint16_t * p, size_t n, unsigned int shift, unsigned int bits, bool sign)
+{
+  if (bits < 1 || bits > 15 || shift > 15)
+    return;
+  size_t i = 0;
+#ifdef MDCM_KERNELS_AVX2
+  if (get_level() == 2)
+    i = cleanup16_avx2(p, n, shift, bits, sign);
+#endif
+#ifdef MDCM_KERNELS_SSE2
+  if (get_level() == 1)
+    i = cleanup16_sse2(p, n, shift, bits, sign);
+#endif
+  cleanup16_scalar(p + i, n - i, shift, bits, sign);
+}
+
+void
+PixelKernels::CleanupUnusedBits32(uint32_t * p, size_t n, unsigned int shift, unsigned int bits, bool sign)
+{
+  if (bits < 1 || bits > 31 || shift > 31)
+    return;
+  size_t i = 0;
+#ifdef MDCM_KERNELS_AVX2
+  if (get_level() == 2)
+    i = cleanup32_avx2(p, n, shift, bits, sign);
+#endif
+#ifdef MDCM_KERNELS_SSE2
+  if (get_level() == 1)
+    i = cleanup32_sse2(p, n, shift, bits, sign);
+#endif
+  cleanup32_scalar(p + i, n - i, shift, bits, sign);
+}
+
+bool
+PixelKernels::Rescale(int16_t * out, const int16_t * in, size_t n, double slope, double intercept)
+{
+  return rescale(out, in, n, slope, intercept);
+}
+
+bool
+PixelKernels::Rescale(int16_t * out, const uint16_t * in, size_t n, double slope, double intercept)
+{
+  return rescale(out, in, n, slope, intercept);
+}
+
+bool
+PixelKernels::Rescale(uint16_t * out, const int16_t * in, size_t n, double slope, double intercept)
+{
+  return rescale(out, in, n, slope, intercept);
+}
+
+bool
+PixelKernels::Rescale(uint16_t * out, const uint16_t * in, size_t n, double slope, double intercept)
+{
+  return rescale(out, in, n, slope, intercept);
+}
+
+bool
+PixelKernels::Rescale(int32_t * out, const int16_t * in, size_t n, double slope, double intercept)
+{
+  return rescale(out, in, n, slope, intercept);
+}
+
+bool
+PixelKernels::Rescale(int32_t * out, const uint16_t * in, size_t n, double slope, double intercept)
+{
+  return rescale(out, in, n, slope, intercept);
+}
+
+bool
+PixelKernels::Rescale(float * out, const int16_t * in, size_t n, double slope, double intercept)
+{
+  return rescale(out, in, n, slope, intercept);
+}
+
+bool
+PixelKernels::Rescale(float * out, const uint16_t * in, size_t n, double slope, double intercept)
+{
+  return rescale(out, in, n, slope, intercept);
+}
+
+bool
+PixelKernels::SetInstructionSet(const char * s)
+{
+  int l = 2;
+  if (s)
+  {
+    if (strcmp(s, "AVX2") == 0)
+      l = 2;
+    else if (strcmp(s, "SSE2") == 0)
+      l = 1;
+    else if (strcmp(s, "scalar") == 0)
+      l = 0;
+    else
+      return false;
+    if (l > detected_level())
+      return false;
+  }
+  max_level.store(l);
+  return true;
+}
+
+const char *
+PixelKernels::GetInstructionSet()
+{
+  switch (get_level())
+  {
+    case 2:
+      return "AVX2";
+    case 1:
+      return "SSE2";
+    default:
+      break;
+  }
+  return "scalar";
+}
+
+} // end namespace mdcm
@@ -0,0 +1,81 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#ifndef MDCMPIXELKERNELS_H
+#define MDCMPIXELKERNELS_H
+
+#include "mdcmTypes.h"
+#include <cstddef>
+
+namespace mdcm
+{
+
+/**
+ * PixelKernels
+ *
+ * Per-pixel loops of byte swapping, rescaling and cleanup of unused
+ * bits. On x86-64 SSE2 or AVX2 code is selected at runtime, elsewhere
+ * (or with DISABLE_SIMDMATH) the scalar code is used. The results are
+ * the same as of the scalar code. Pointers don't have to be aligned,
+ * the counts are numbers of values, not bytes.
+ *
+ */
+class MDCM_EXPORT PixelKernels
+{
+public:
+  static void
+  SwapArray16(void *, size_t);
+  static void
+  SwapArray32(void *, size_t);
+  static void
+  SwapArray64(void *, size_t);
+  // Values are shifted right by 'shift', then the 'bits' low bits are
+  // kept, with sign extension if 'sign', as ImageCodec::CleanupUnusedBits
+  static void
+  CleanupUnusedBits16(uint16_t *, size_t, unsigned int shift, unsigned int bits, bool sign);
+  static void
+  CleanupUnusedBits32(uint32_t *, size_t, unsigned int shift, unsigned int bits, bool sign);
+  // out[i] = static_cast<TOut>(slope * in[i] + intercept), returns
+  // false if the types are not handled, the caller does the loop then.
+  // Not for double output, it is limited by the stores, the compiler
+  // vectorizes the loop as well.
+  template <typename TOut, typename TIn>
+  static bool
+  Rescale(TOut *, const TIn *, size_t, double, double)
+  {
+    return false;
+  }
+  static bool
+  Rescale(int16_t *, const int16_t *, size_t, double, double);
+  static bool
+  Rescale(int16_t *, const uint16_t *, size_t, double, double);
+  static bool
+  Rescale(uint16_t *, const int16_t *, size_t, double, double);
+  static bool
+  Rescale(uint16_t *, const uint16_t *, size_t, double, double);
+  static bool
+  Rescale(int32_t *, const int16_t *, size_t, double, double);
+  static bool
+  Rescale(int32_t *, const uint16_t *, size_t, double, double);
+  static bool
+  Rescale(float *, const int16_t *, size_t, double, double);
+  static bool
+  Rescale(float *, const uint16_t *, size_t, double, double);
+  // "AVX2", "SSE2" or "scalar"
+  static const char *
+  GetInstructionSet();
+  // Limits the code used to "SSE2" or "scalar", nullptr is the detected
+  // instruction set again, for benchmarks and tests. Returns false if
+  // not supported by the CPU.
+  static bool
+  SetInstructionSet(const char *);
+};
+
+} // end namespace mdcm
+
+#endif // MDCMPIXELKERNELS_H
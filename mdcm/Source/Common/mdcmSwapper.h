@@ -23,6 +23,7 @@
 #define MDCMSWAPPER_H
 
 #include "mdcmSwapCode.h"
+#include "mdcmPixelKernels.h"
 
 namespace mdcm
 {
@@ -126,6 +127,37 @@ public:
       array[i] = Swap<T>(array[i]);
     }
   }
+  // Large arrays, e.g. pixel data, vectorized
+  static void
+  SwapArray(uint16_t * array, size_t n)
+  {
+    PixelKernels::SwapArray16(array, n);
+  }
+  static void
+  SwapArray(int16_t * array, size_t n)
+  {
+    PixelKernels::SwapArray16(array, n);
+  }
+  static void
+  SwapArray(uint32_t * array, size_t n)
+  {
+    PixelKernels::SwapArray32(array, n);
+  }
+  static void
+  SwapArray(int32_t * array, size_t n)
+  {
+    PixelKernels::SwapArray32(array, n);
+  }
+  static void
+  SwapArray(uint64_t * array, size_t n)
+  {
+    PixelKernels::SwapArray64(array, n);
+  }
+  static void
+  SwapArray(int64_t * array, size_t n)
+  {
+    PixelKernels::SwapArray64(array, n);
+  }
 };
 
 #endif
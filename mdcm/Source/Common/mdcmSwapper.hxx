@@ -164,14 +164,14 @@ template <>
 inline void
 SwapperNoOp::SwapArray(float * array, size_t n)
 {
-  SwapperNoOp::SwapArray<float>(array, n);
+  PixelKernels::SwapArray32(array, n);
 }
 
 template <>
 inline void
 SwapperNoOp::SwapArray(double * array, size_t n)
 {
-  SwapperNoOp::SwapArray<double>(array, n);
+  PixelKernels::SwapArray64(array, n);
 }
 
 #else
@@ -258,14 +258,14 @@ template <>
 inline void
 SwapperDoOp::SwapArray(float * array, size_t n)
 {
-  SwapperDoOp::SwapArray<float>(array, n);
+  PixelKernels::SwapArray32(array, n);
 }
 
 template <>
 inline void
 SwapperDoOp::SwapArray(double * array, size_t n)
 {
-  SwapperDoOp::SwapArray<double>(array, n);
+  PixelKernels::SwapArray64(array, n);
 }
 
 #endif
@@ -0,0 +1,74 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#include "mdcmValueArena.h"
+
+namespace mdcm
+{
+
+// Chunks grow from min to max size, small reads do not
+// keep much more memory than used.
+static const size_t min_chunk_size = 8192;
+static const size_t max_chunk_size = 65536;
+// Larger values have own memory, see ByteValue
+static const size_t max_value_size = 4096;
+
+static int
+stream_index()
+{
+  static const int i = std::ios_base::xalloc();
+  return i;
+}
+
+// Returns nullptr for a value larger than max_value_size,
+// the memory is 8 bytes aligned.
+char *
+ValueArena::Allocate(size_t n)
+{
+  if (n == 0 || n > max_value_size)
+    return nullptr;
+  const size_t s = (n + 7) & ~static_cast<size_t>(7);
+  if (Chunks.empty() || Used + s > Size)
+  {
+    const size_t size = Chunks.empty() ? min_chunk_size : ((Size < max_chunk_size) ? Size * 2 : max_chunk_size);
+    try
+    {
+      Chunks.emplace_back(new char[size]);
+    }
+    catch (const std::bad_alloc &)
+    {
+      return nullptr;
+    }
+    Size = size;
+    Used = 0;
+  }
+  char * p = Chunks.back().get() + Used;
+  Used += s;
+  return p;
+}
+
+// nullptr detaches, the stream does not keep a reference
+void
+ValueArena::Attach(std::istream & is, ValueArena * a)
+{
+  is.pword(stream_index()) = a;
+}
+
+ValueArena *
+ValueArena::Get(std::istream & is)
+{
+  return static_cast<ValueArena *>(is.pword(stream_index()));
+}
+
+bool
+ValueArena::CanAllocate(std::istream & is, size_t n)
+{
+  return (n > 0 && n <= max_value_size && Get(is));
+}
+
+} // end namespace mdcm
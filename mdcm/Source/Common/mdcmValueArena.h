@@ -0,0 +1,54 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#ifndef MDCMVALUEARENA_H
+#define MDCMVALUEARENA_H
+
+#include "mdcmObject.h"
+#include <istream>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace mdcm
+{
+
+/**
+ * ValueArena
+ *
+ * Memory for small values of a read, allocated in large chunks
+ * instead of a vector per value. Attached to the stream by Reader,
+ * ByteValues pointing into the arena keep a reference, the memory
+ * is released with the last one.
+ *
+ */
+class MDCM_EXPORT ValueArena : public Object
+{
+public:
+  ValueArena() = default;
+  ValueArena(const ValueArena &) = delete;
+  ValueArena &
+  operator=(const ValueArena &) = delete;
+  char *
+  Allocate(size_t);
+  static void
+  Attach(std::istream &, ValueArena *);
+  static ValueArena *
+  Get(std::istream &);
+  static bool
+  CanAllocate(std::istream &, size_t);
+
+private:
+  std::vector<std::unique_ptr<char[]>> Chunks{};
+  size_t                               Size{};
+  size_t                               Used{};
+};
+
+} // end namespace mdcm
+
+#endif // MDCMVALUEARENA_H
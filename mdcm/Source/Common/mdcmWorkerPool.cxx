@@ -0,0 +1,129 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#include "mdcmWorkerPool.h"
+#include <memory>
+#include <system_error>
+
+namespace mdcm
+{
+
+namespace
+{
+
+// State of one Run(), shared with its queued tasks, a task
+// dequeued after Run() has returned finds it closed.
+struct RunState
+{
+  std::mutex              Mutex;
+  std::condition_variable Condition;
+  unsigned int            Active{};
+  bool                    Closed{};
+};
+
+} // namespace
+
+WorkerPool &
+WorkerPool::GetInstance()
+{
+  static WorkerPool pool;
+  return pool;
+}
+
+WorkerPool::WorkerPool()
+{
+  unsigned int n = std::thread::hardware_concurrency();
+  if (n > 16)
+    n = 16;
+  try
+  {
+    for (unsigned int x = 0; x < n; ++x)
+    {
+      Threads.emplace_back(&WorkerPool::Loop, this);
+    }
+  }
+  catch (const std::system_error &)
+  {
+    // continue with the threads started
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(Mutex);
+    Stop = true;
+  }
+  Condition.notify_all();
+  for (size_t x = 0; x < Threads.size(); ++x)
+  {
+    Threads[x].join();
+  }
+}
+
+unsigned int
+WorkerPool::GetNumberOfThreads() const
+{
+  return static_cast<unsigned int>(Threads.size());
+}
+
+void
+WorkerPool::Loop()
+{
+  for (;;)
+  {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(Mutex);
+      Condition.wait(lock, [this]() { return Stop || !Tasks.empty(); });
+      if (Tasks.empty())
+        return;
+      task = std::move(Tasks.front());
+      Tasks.pop_front();
+    }
+    task();
+  }
+}
+
+void
+WorkerPool::Run(unsigned int n, const std::function<void()> & work)
+{
+  const unsigned int        threads = GetNumberOfThreads();
+  const unsigned int        queued = (n > threads + 1) ? threads : ((n > 1) ? n - 1 : 0);
+  std::shared_ptr<RunState> state = std::make_shared<RunState>();
+  if (queued > 0)
+  {
+    {
+      std::lock_guard<std::mutex> lock(Mutex);
+      for (unsigned int x = 0; x < queued; ++x)
+      {
+        Tasks.emplace_back([state, &work]() {
+          {
+            std::lock_guard<std::mutex> lock(state->Mutex);
+            if (state->Closed)
+              return;
+            ++state->Active;
+          }
+          work();
+          {
+            std::lock_guard<std::mutex> lock(state->Mutex);
+            --state->Active;
+          }
+          state->Condition.notify_one();
+        });
+      }
+    }
+    Condition.notify_all();
+  }
+  work();
+  std::unique_lock<std::mutex> lock(state->Mutex);
+  state->Closed = true;
+  state->Condition.wait(lock, [&state]() { return state->Active == 0; });
+}
+
+} // end namespace mdcm
@@ -0,0 +1,63 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#ifndef MDCMWORKERPOOL_H
+#define MDCMWORKERPOOL_H
+
+#include "mdcmTypes.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mdcm
+{
+
+/**
+ * WorkerPool
+ *
+ * Threads shared by all decodes of the process, the number of threads
+ * doesn't grow with concurrent reads. Started on the first use, up to
+ * the number of processors, not more than 16.
+ *
+ */
+class MDCM_EXPORT WorkerPool
+{
+public:
+  static WorkerPool &
+  GetInstance();
+  unsigned int
+  GetNumberOfThreads() const;
+  // Runs 'work' in the calling thread and in up to 'n' - 1 threads
+  // of the pool, returns when all copies started have returned. Copies
+  // not started by then are skipped, so 'work' must take its items from
+  // a shared counter and the calling thread alone may do all of them.
+  void
+  Run(unsigned int n, const std::function<void()> & work);
+
+private:
+  WorkerPool();
+  ~WorkerPool();
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &
+  operator=(const WorkerPool &) = delete;
+  void
+  Loop();
+
+  std::vector<std::thread>          Threads;
+  std::deque<std::function<void()>> Tasks;
+  std::mutex                        Mutex;
+  std::condition_variable           Condition;
+  bool                              Stop{};
+};
+
+} // end namespace mdcm
+
+#endif // MDCMWORKERPOOL_H
@@ -31,6 +31,8 @@
 #include <iostream>
 #include <iomanip>
 #include <map>
+#include <mutex>
+#include <algorithm>
 
 namespace mdcm
 {
@@ -40,71 +42,81 @@ namespace mdcm
 
 static const DictEntry tagNotFound("", "", VR::INVALID, VM::VM0, true);
 
+/**
+ * Entry of the static public dictionary, sorted by Key,
+ * i.e. (group << 16) | element
+ */
+struct DictTableEntry
+{
+  constexpr DictTableEntry(uint16_t     group,
+                           uint16_t     element,
+                           VR::VRType   vr,
+                           VM::VMType   vm,
+                           const char * name,
+                           const char * keyword,
+                           bool         ret)
+    : Key((static_cast<uint32_t>(group) << 16) | element)
+    , Entry(name, keyword, vr, vm, ret)
+  {}
+  Tag
+  GetTag() const
+  {
+    return Tag(Key);
+  }
+  uint32_t  Key;
+  DictEntry Entry;
+};
+
+/**
+ * Public dictionary, a view of a sorted, constant-initialized table,
+ * lookup by tag is a binary search.
+ */
 class MDCM_EXPORT Dict
 {
 public:
-  typedef std::map<Tag, DictEntry>     MapDictEntry;
-  typedef MapDictEntry::iterator       Iterator;
-  typedef MapDictEntry::const_iterator ConstIterator;
+  typedef const DictTableEntry * ConstIterator;
 
   MDCM_DISALLOW_COPY_AND_MOVE(Dict);
 
-  Dict() : DictInternal()
-  {
-    assert(DictInternal.empty());
-  }
+  Dict() = default;
   friend std::ostream &
   operator<<(std::ostream &, const Dict &);
   ConstIterator
   Begin() const
   {
-    return DictInternal.cbegin();
+    return Entries;
   }
   ConstIterator
   End() const
   {
-    return DictInternal.cend();
+    return Entries + Size;
   }
   bool
   IsEmpty() const
   {
-    return DictInternal.empty();
-  }
-
-  void
-  AddDictEntry(const Tag & tag, const DictEntry & de)
-  {
-#ifndef NDEBUG
-    MapDictEntry::size_type s = DictInternal.size();
-#endif
-    DictInternal.insert(MapDictEntry::value_type(tag, de));
-#ifndef NDEBUG
-    assert(s < DictInternal.size());
-#endif
+    return Size == 0;
   }
 
   const DictEntry &
   GetDictEntry(const Tag & tag) const
   {
-    MapDictEntry::const_iterator it = DictInternal.find(tag);
-    if (it == DictInternal.cend())
+    ConstIterator it = Find(tag);
+    if (it == End())
     {
       return tagNotFound;
     }
-    assert(DictInternal.count(tag) == 1);
-    return it->second;
+    return it->Entry;
   }
 
   const char *
   GetKeywordFromTag(const Tag & tag) const
   {
-    MapDictEntry::const_iterator it = DictInternal.find(tag);
-    if (it == DictInternal.cend())
+    ConstIterator it = Find(tag);
+    if (it == End())
     {
       return nullptr;
     }
-    assert(DictInternal.count(tag) == 1);
-    return it->second.GetKeyword();
+    return it->Entry.GetKeyword();
   }
 
   // Lookup DictEntry by keyword. Even if DICOM standard defines keyword
@@ -114,16 +126,14 @@ public:
   const DictEntry &
   GetDictEntryByKeyword(const char * keyword, Tag & tag) const
   {
-    MapDictEntry::const_iterator it = DictInternal.cbegin();
     if (keyword)
     {
-      for (; it != DictInternal.cend(); ++it)
+      for (ConstIterator it = Begin(); it != End(); ++it)
       {
-        if (strcmp(keyword, it->second.GetKeyword()) == 0)
+        if (strcmp(keyword, it->Entry.GetKeyword()) == 0)
         {
-          tag = it->first;
-          assert(DictInternal.count(tag) == 1);
-          return it->second;
+          tag = it->GetTag();
+          return it->Entry;
         }
       }
     }
@@ -137,18 +147,29 @@ protected:
   LoadDefault();
 
 private:
-  MapDictEntry DictInternal;
+  ConstIterator
+  Find(const Tag & tag) const
+  {
+    const uint32_t key = tag.GetElementTag();
+    ConstIterator  it = std::lower_bound(
+      Begin(), End(), key, [](const DictTableEntry & e, uint32_t k) { return e.Key < k; });
+    if (it != End() && it->Key == key)
+    {
+      return it;
+    }
+    return End();
+  }
+
+  ConstIterator Entries{};
+  size_t        Size{};
 };
 
 inline std::ostream &
 operator<<(std::ostream & os, const Dict & val)
 {
-  Dict::MapDictEntry::const_iterator it = val.DictInternal.cbegin();
-  for (; it != val.DictInternal.cend(); ++it)
+  for (Dict::ConstIterator it = val.Begin(); it != val.End(); ++it)
   {
-    const Tag &       t = it->first;
-    const DictEntry & de = it->second;
-    os << t << " " << de << '\n';
+    os << it->GetTag() << " " << it->Entry << '\n';
   }
 
   return os;
@@ -156,6 +177,8 @@ operator<<(std::ostream & os, const Dict & val)
 
 /**
  * Private Dict
+ *
+ * The default entries are indexed on first use, not at startup.
  */
 class MDCM_EXPORT PrivateDict
 {
@@ -171,6 +194,7 @@ public:
   void
   AddDictEntry(const PrivateTag & tag, const DictEntry & de)
   {
+    EnsureLoaded();
 #ifndef NDEBUG
     MapDictEntry::size_type s = DictInternal.size();
 #endif
@@ -183,6 +207,7 @@ public:
   bool
   RemoveDictEntry(const PrivateTag & tag)
   {
+    EnsureLoaded();
     MapDictEntry::size_type s = DictInternal.erase(tag);
     assert(s == 1 || s == 0);
     return s == 1;
@@ -191,6 +216,7 @@ public:
   bool
   FindDictEntry(const PrivateTag & tag) const
   {
+    EnsureLoaded();
     MapDictEntry::const_iterator it = DictInternal.find(tag);
     if (it == DictInternal.cend())
     {
@@ -202,6 +228,7 @@ public:
   const DictEntry &
   GetDictEntry(const PrivateTag & tag) const
   {
+    EnsureLoaded();
     MapDictEntry::const_iterator it = DictInternal.find(tag);
     if (it == DictInternal.cend())
     {
@@ -214,6 +241,7 @@ public:
   void
   PrintXML() const
   {
+    EnsureLoaded();
     MapDictEntry::const_iterator it = DictInternal.cbegin();
     std::cout << "<dict edition=\"2008\">\n";
     for (; it != DictInternal.cend(); ++it)
@@ -239,6 +267,7 @@ public:
   bool
   IsEmpty() const
   {
+    EnsureLoaded();
     return DictInternal.empty();
   }
 
@@ -248,12 +277,26 @@ protected:
   LoadDefault();
 
 private:
-  MapDictEntry DictInternal;
+  void
+  EnsureLoaded() const
+  {
+    if (DefaultPending)
+    {
+      std::call_once(DefaultOnce, &PrivateDict::LoadDefaultEntries, this);
+    }
+  }
+  void
+  LoadDefaultEntries() const;
+
+  mutable MapDictEntry   DictInternal;
+  mutable std::once_flag DefaultOnce;
+  bool                   DefaultPending{};
 };
 
 inline std::ostream &
 operator<<(std::ostream & os, const PrivateDict & val)
 {
+  val.EnsureLoaded();
   PrivateDict::MapDictEntry::const_iterator it = val.DictInternal.cbegin();
   for (; it != val.DictInternal.cend(); ++it)
   {
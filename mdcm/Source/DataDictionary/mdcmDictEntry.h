@@ -32,11 +32,15 @@ namespace mdcm
 {
 /**
  * Class to represent an Entry in the Dict
+ *
+ * Name and keyword are not copied, they must have static storage
+ * duration (string literals of the default dictionaries), so that
+ * the tables of entries are constant-initialized.
  */
 class MDCM_EXPORT DictEntry
 {
 public:
-  DictEntry(const char * name = "",
+  constexpr DictEntry(const char * name = "",
             const char * keyword = "",
             const VR &   vr = VR::INVALID,
             const VM &   vm = VM::VM0,
@@ -74,7 +78,7 @@ public:
   const char *
   GetName() const
   {
-    return Name.c_str();
+    return Name;
   }
   void
   SetName(const char * name)
@@ -84,7 +88,7 @@ public:
   const char *
   GetKeyword() const
   {
-    return Keyword.c_str();
+    return Keyword;
   }
   void
   SetKeyword(const char * keyword)
@@ -121,19 +125,19 @@ private:
   friend class Dict;
 
 private:
-  std::string Name;
-  std::string Keyword;
-  VR          ValueRepresentation;
-  VM          ValueMultiplicity;
-  bool        Retired : 1;
-  bool        GroupXX : 1;
-  bool        ElementXX : 1;
+  const char * Name;
+  const char * Keyword;
+  VR           ValueRepresentation;
+  VM           ValueMultiplicity;
+  bool         Retired : 1;
+  bool         GroupXX : 1;
+  bool         ElementXX : 1;
 };
 
 inline std::ostream &
 operator<<(std::ostream & os, const DictEntry & val)
 {
-  if (val.Name.empty())
+  if (!val.Name || !*val.Name)
   {
     os << "[No name]";
   }
@@ -141,7 +145,7 @@ operator<<(std::ostream & os, const DictEntry & val)
   {
     os << val.Name;
   }
-  if (val.Keyword.empty())
+  if (!val.Keyword || !*val.Keyword)
   {
     os << "[No keyword]";
   }
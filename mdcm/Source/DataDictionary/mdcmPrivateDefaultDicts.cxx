@@ -11227,6 +11227,12 @@ const PRIV_DICT_ENTRY DICOMV3DataDict[] = {
 
 void
 PrivateDict::LoadDefault()
+{
+  DefaultPending = true;
+}
+
+void
+PrivateDict::LoadDefaultEntries() const
 {
   unsigned int    i = 0;
   PRIV_DICT_ENTRY n = DICOMV3DataDict[i];
@@ -11237,7 +11243,7 @@ PrivateDict::LoadDefault()
     assert(n.element <= 0xff || n.element == 0xffff);
     PrivateTag t(n.group, n.element, n.owner);
     DictEntry  e(n.name, "", n.vr, n.vm, n.ret);
-    AddDictEntry(t, e);
+    DictInternal.insert(MapDictEntry::value_type(t, e));
     n = DICOMV3DataDict[++i];
   }
 }
@@ -56,15 +56,15 @@ ByteValue::PrintASCII(std::ostream & os, VL maxlength) const
 {
   VL length = std::min(maxlength, Length);
   // Special case for VR::UI, do not print the trailing \0
+  const char * p = GetPointer();
   if (length && length == Length)
   {
-    if (Internal[length - 1] == 0)
+    if (p[length - 1] == 0)
     {
       length = length - 1;
     }
   }
-  std::vector<char>::const_iterator it = Internal.cbegin();
-  for (; it != Internal.cbegin() + length; ++it)
+  for (const char * it = p; it != p + length; ++it)
   {
     const char & c = *it;
     if (!(isprint(static_cast<unsigned char>(c)) || isspace(static_cast<unsigned char>(c))))
@@ -79,13 +79,13 @@ ByteValue::PrintHex(std::ostream & os, VL maxlength) const
 {
   std::ios oldState(nullptr);
   oldState.copyfmt(os);
-  VL                                length = std::min(maxlength, Length);
-  std::vector<char>::const_iterator it = Internal.begin();
+  VL           length = std::min(maxlength, Length);
+  const char * p = GetPointer();
   os << std::hex;
-  for (; it != Internal.begin() + length; ++it)
+  for (const char * it = p; it != p + length; ++it)
   {
     uint8_t v = *it;
-    if (it != Internal.begin())
+    if (it != p)
       os << "\\";
     os << std::setw(2) << std::setfill('0') << static_cast<uint16_t>(v);
   }
@@ -136,6 +136,7 @@ ByteValue::SetLength(VL vl)
 #else
   assert(!l.IsUndefined() && !l.IsOdd());
 #endif
+  Materialize();
   // Can not use reserve for now, need to implement:
   // STL - vector<> and istream
   // http://groups.google.com/group/comp.lang.c++/msg/37ec052ed8283e74
@@ -150,10 +151,33 @@ ByteValue::SetLength(VL vl)
   Length = vl;
 }
 
+// The memory is not allocated if the value can be a view
+// into the memory mapped file read by the stream or allocated
+// in the stream's arena, see Read().
+void
+ByteValue::SetLength(VL vl, std::istream & is)
+{
+  if (!vl.IsUndefined() && !vl.IsOdd() &&
+      (MappedStreamBuf::CanView(is, vl) || ValueArena::CanAllocate(is, vl)))
+  {
+    Clear();
+    Length = vl;
+    return;
+  }
+  SetLength(vl);
+}
+
+bool
+ByteValue::IsView() const
+{
+  return (View != nullptr);
+}
+
 void
 ByteValue::Append(const ByteValue & bv)
 {
-  Internal.insert(Internal.end(), bv.Internal.begin(), bv.Internal.end());
+  Materialize();
+  Internal.insert(Internal.end(), bv.GetPointer(), bv.GetPointer() + bv.GetSize());
   Length += bv.Length;
   assert(Internal.size() % 2 == 0 && Internal.size() == Length);
 }
@@ -162,11 +186,15 @@ void
 ByteValue::Clear()
 {
   Internal.clear();
+  View = nullptr;
+  ViewOwner = nullptr;
 }
 
 const char *
 ByteValue::GetPointer() const
 {
+  if (View)
+    return View;
   if (!Internal.empty())
     return Internal.data();
   return nullptr;
@@ -175,6 +203,8 @@ ByteValue::GetPointer() const
 const void *
 ByteValue::GetVoidPointer() const
 {
+  if (View)
+    return static_cast<const void *>(View);
   if (!Internal.empty())
     return static_cast<const void *>(Internal.data());
   return nullptr;
@@ -183,6 +213,7 @@ ByteValue::GetVoidPointer() const
 void *
 ByteValue::GetVoidPointer()
 {
+  Materialize();
   if (!Internal.empty())
     return static_cast<void *>(Internal.data());
   return nullptr;
@@ -191,6 +222,12 @@ ByteValue::GetVoidPointer()
 void
 ByteValue::Fill(char c)
 {
+  if (View)
+  {
+    View = nullptr;
+    ViewOwner = nullptr;
+    Internal.resize(Length);
+  }
   std::vector<char>::iterator it = Internal.begin();
   for (; it != Internal.end(); ++it)
     *it = c;
@@ -199,10 +236,10 @@ ByteValue::Fill(char c)
 bool
 ByteValue::GetBuffer(char * buffer, unsigned long long length) const
 {
-  if (length <= Internal.size())
+  if (length <= GetSize())
   {
-    if (!Internal.empty())
-      memcpy(buffer, Internal.data(), length);
+    if (GetSize() > 0)
+      memcpy(buffer, GetPointer(), length);
     return true;
   }
   mdcmAlwaysWarnMacro("Could not handle length = " << length);
@@ -214,8 +251,8 @@ ByteValue::WriteBuffer(std::ostream & os) const
 {
   if (Length)
   {
-    assert(!(Internal.size() % 2));
-    os.write(Internal.data(), Internal.size());
+    assert(!(GetSize() % 2));
+    os.write(GetPointer(), GetSize());
   }
   return true;
 }
@@ -226,4 +263,50 @@ ByteValue::SetLengthOnly(VL vl)
   Length = vl;
 }
 
+bool
+ByteValue::ReadView(std::istream & is)
+{
+  const char * p = MappedStreamBuf::View(is, Length, ViewOwner);
+  if (!p)
+    return false;
+  Internal.clear();
+  View = p;
+  return true;
+}
+
+bool
+ByteValue::ReadArena(std::istream & is)
+{
+  ValueArena * a = ValueArena::Get(is);
+  if (!a)
+    return false;
+  char * p = a->Allocate(Length);
+  if (!p)
+    return false;
+  is.read(p, Length);
+  Internal.clear();
+  View = p;
+  ViewOwner = a;
+  return true;
+}
+
+// Copy of the view, e.g. before the value is changed
+void
+ByteValue::Materialize()
+{
+  if (!View)
+    return;
+  Internal.assign(View, View + Length);
+  View = nullptr;
+  ViewOwner = nullptr;
+}
+
+size_t
+ByteValue::GetSize() const
+{
+  if (View)
+    return Length;
+  return Internal.size();
+}
+
 } // end namespace mdcm
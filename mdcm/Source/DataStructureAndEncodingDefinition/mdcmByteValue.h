@@ -25,14 +25,25 @@
 #include "mdcmValue.h"
 #include "mdcmTrace.h"
 #include "mdcmVL.h"
+#include "mdcmSwapper.h"
+#include "mdcmMappedFile.h"
+#include "mdcmValueArena.h"
 #include <vector>
 #include <iostream>
+#include <cstring>
+#include <type_traits>
 
 namespace mdcm
 {
 
 /**
  * Class to represent binary value (array of bytes)
+ *
+ * A large value read from a memory mapped file (see
+ * Reader::SetMemoryMapping) is a view into the file, a small value
+ * read by Reader is in the ValueArena of the read. Both are copied
+ * only if a non-const pointer or the vector is requested or the value
+ * is changed, const access never changes the object.
  */
 
 class MDCM_EXPORT ByteValue : public Value
@@ -44,13 +55,20 @@ public:
   ByteValue(ByteValue && val) noexcept;
   ~ByteValue() = default;
 
-  operator const std::vector<char> &() const { return Internal; }
+  // Non-const, a view is copied into the vector
+  operator const std::vector<char> &()
+  {
+    Materialize();
+    return Internal;
+  }
 
   ByteValue &
   operator=(const ByteValue & other)
   {
     Internal = other.Internal;
     Length = other.Length;
+    View = other.View;
+    ViewOwner = other.ViewOwner;
     return *this;
   }
 
@@ -61,7 +79,11 @@ public:
     {
       Internal = std::move(other.Internal);
       Length = other.Length;
+      View = other.View;
+      ViewOwner = other.ViewOwner;
       other.Length = 0;
+      other.View = nullptr;
+      other.ViewOwner = nullptr;
     }
     return *this;
   }
@@ -71,6 +93,8 @@ public:
   {
     if (Length != val.Length)
       return false;
+    if (View || val.View)
+      return (GetSize() == val.GetSize() && (GetSize() == 0 || memcmp(GetPointer(), val.GetPointer(), GetSize()) == 0));
     if (Internal == val.Internal)
       return true;
     return false;
@@ -80,7 +104,7 @@ public:
   operator==(const Value & val) const override
   {
     const ByteValue & bv = dynamic_cast<const ByteValue &>(val);
-    return Length == bv.Length && Internal == bv.Internal;
+    return *this == bv;
   }
 
   template <typename TSwap, typename TType>
@@ -95,6 +119,20 @@ public:
     {
       if (readvalues)
       {
+        if (Internal.size() < Length)
+        {
+          // SetLength(VL, std::istream &), a view if not swapped
+          if ((sizeof(TType) == 1 || std::is_same<TSwap, SwapperNoOp>::value) && ReadView(is))
+          {
+            return is;
+          }
+          if (ReadArena(is))
+          {
+            TSwap::SwapArray(static_cast<TType *>(static_cast<void *>(const_cast<char *>(View))), Length / sizeof(TType));
+            return is;
+          }
+          SetLength(Length);
+        }
         is.read(Internal.data(), Length);
         assert(Internal.size() == Length || Internal.size() == Length + 1);
         TSwap::SwapArray(static_cast<TType *>(GetVoidPointer()), Internal.size() / sizeof(TType));
@@ -118,11 +156,11 @@ public:
   const std::ostream &
   Write(std::ostream & os) const
   {
-    assert(!(Internal.size() % 2));
-    if (!Internal.empty())
+    assert(!(GetSize() % 2));
+    if (GetSize() > 0)
     {
-      std::vector<char> copy = Internal;
-      TSwap::SwapArray(static_cast<TType *>(static_cast<void *>(copy.data())), Internal.size() / sizeof(TType));
+      std::vector<char> copy(GetPointer(), GetPointer() + GetSize());
+      TSwap::SwapArray(static_cast<TType *>(static_cast<void *>(copy.data())), copy.size() / sizeof(TType));
       os.write(copy.data(), copy.size());
     }
     return os;
@@ -149,6 +187,10 @@ public:
   ComputeLength() const;
   void SetLength(VL) override;
   void
+  SetLength(VL, std::istream &);
+  bool
+  IsView() const;
+  void
   Append(const ByteValue &);
   void
   Clear() override;
@@ -169,9 +211,19 @@ protected:
   void SetLengthOnly(VL) override;
 
 private:
+  bool
+  ReadView(std::istream &);
+  bool
+  ReadArena(std::istream &);
+  void
+  Materialize();
+  size_t
+  GetSize() const;
   std::vector<char> Internal{};
   // WARNING Length is not Internal.size()
   VL Length{};
+  const char *         View{};
+  SmartPointer<Object> ViewOwner{};
 };
 
 } // end namespace mdcm
@@ -285,10 +285,16 @@ DataElement::IsUndefinedLength() const
 }
 
 void
-DataElement::SetValueFieldLength(VL vl, bool readvalues)
+DataElement::SetValueFieldLength(VL vl, bool readvalues, std::istream & is)
 {
   if (readvalues)
-    ValueField->SetLength(vl); // perform realloc
+  {
+    ByteValue * bv = dynamic_cast<ByteValue *>(ValueField.GetPointer());
+    if (bv)
+      bv->SetLength(vl, is); // no realloc for a view into a mapped file
+    else
+      ValueField->SetLength(vl); // perform realloc
+  }
   else
     ValueField->SetLengthOnly(vl); // do not perform realloc
 }
@@ -78,6 +78,8 @@ public:
     }
   }
 
+  DataElement(DataElement &&) noexcept = default;
+
   const Tag &
   GetTag() const;
 
@@ -173,6 +175,9 @@ public:
     return *this;
   }
 
+  DataElement &
+  operator=(DataElement &&) noexcept = default;
+
   bool
   operator==(const DataElement & de) const
   {
@@ -261,7 +266,7 @@ public:
 
 protected:
   void
-  SetValueFieldLength(VL vl, bool readvalues);
+  SetValueFieldLength(VL vl, bool readvalues, std::istream &);
 
   Tag TagField{};
   // This is the value read from the file, might be different from the length of ValueField
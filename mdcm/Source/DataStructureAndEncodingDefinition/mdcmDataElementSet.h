@@ -0,0 +1,178 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#ifndef MDCMDATAELEMENTSET_H
+#define MDCMDATAELEMENTSET_H
+
+#include "mdcmDataElement.h"
+#include "mdcmTag.h"
+#include <algorithm>
+#include <vector>
+
+namespace mdcm
+{
+
+/**
+ * DataElementSet
+ *
+ * Data Elements of a DataSet, sorted by tag in one contiguous vector,
+ * elements with equal tags are kept in the order of insertion (as
+ * std::multiset). Elements are read in ascending order, so insertion
+ * is mostly an append.
+ *
+ * Note: unlike a std::set, inserting or erasing invalidates iterators
+ * and references, replacing an element (see DataSet::Replace) does not.
+ *
+ */
+class DataElementSet
+{
+public:
+  typedef std::vector<DataElement>::const_iterator const_iterator;
+  typedef std::vector<DataElement>::iterator       iterator;
+  typedef std::vector<DataElement>::size_type      size_type;
+  typedef DataElement                              value_type;
+
+  const_iterator
+  begin() const
+  {
+    return Elements.cbegin();
+  }
+  iterator
+  begin()
+  {
+    return Elements.begin();
+  }
+  const_iterator
+  end() const
+  {
+    return Elements.cend();
+  }
+  iterator
+  end()
+  {
+    return Elements.end();
+  }
+  const_iterator
+  cbegin() const
+  {
+    return Elements.cbegin();
+  }
+  const_iterator
+  cend() const
+  {
+    return Elements.cend();
+  }
+  size_type
+  size() const
+  {
+    return Elements.size();
+  }
+  bool
+  empty() const
+  {
+    return Elements.empty();
+  }
+  void
+  clear()
+  {
+    Elements.clear();
+  }
+  void
+  reserve(size_type n)
+  {
+    Elements.reserve(n);
+  }
+
+  const_iterator
+  lower_bound(const Tag & t) const
+  {
+    return std::lower_bound(Elements.cbegin(), Elements.cend(), t, TagLess());
+  }
+  iterator
+  lower_bound(const Tag & t)
+  {
+    return std::lower_bound(Elements.begin(), Elements.end(), t, TagLess());
+  }
+  const_iterator
+  upper_bound(const Tag & t) const
+  {
+    return std::upper_bound(Elements.cbegin(), Elements.cend(), t, TagLess());
+  }
+  iterator
+  upper_bound(const Tag & t)
+  {
+    return std::upper_bound(Elements.begin(), Elements.end(), t, TagLess());
+  }
+  const_iterator
+  find(const Tag & t) const
+  {
+    const_iterator it = lower_bound(t);
+    return (it != Elements.cend() && it->GetTag() == t) ? it : Elements.cend();
+  }
+  iterator
+  find(const Tag & t)
+  {
+    iterator it = lower_bound(t);
+    return (it != Elements.end() && it->GetTag() == t) ? it : Elements.end();
+  }
+
+  // After the elements with equal tag
+  iterator
+  insert(const DataElement & de)
+  {
+    if (Elements.empty() || !(de.GetTag() < Elements.back().GetTag()))
+    {
+      Elements.push_back(de);
+      return Elements.end() - 1;
+    }
+    return Elements.insert(upper_bound(de.GetTag()), de);
+  }
+  iterator
+  erase(const_iterator it)
+  {
+    return Elements.erase(it);
+  }
+  // All elements with the tag
+  size_type
+  erase(const Tag & t)
+  {
+    const iterator first = lower_bound(t);
+    iterator       last = first;
+    while (last != Elements.end() && last->GetTag() == t)
+      ++last;
+    const size_type n = static_cast<size_type>(last - first);
+    Elements.erase(first, last);
+    return n;
+  }
+
+  bool
+  operator==(const DataElementSet & other) const
+  {
+    return (Elements == other.Elements);
+  }
+
+private:
+  struct TagLess
+  {
+    bool
+    operator()(const DataElement & de, const Tag & t) const
+    {
+      return de.GetTag() < t;
+    }
+    bool
+    operator()(const Tag & t, const DataElement & de) const
+    {
+      return t < de.GetTag();
+    }
+  };
+  std::vector<DataElement> Elements;
+};
+
+} // end namespace mdcm
+
+#endif // MDCMDATAELEMENTSET_H
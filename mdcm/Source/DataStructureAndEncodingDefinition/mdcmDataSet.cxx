@@ -96,19 +96,23 @@ DataSet::Insert(const DataElement & de)
   }
 }
 
+// An existing element is replaced in place,
+// iterators and references stay valid.
 void
 DataSet::Replace(const DataElement & de)
 {
-  ConstIterator it = DES.find(de);
-  if (it != DES.cend())
+  Iterator it = DES.find(de.GetTag());
+  if (it != DES.end())
   {
     // detect loop
     if (!(&*it != &de)) // FIXME
     {
       mdcmAlwaysWarnMacro("DataSet::Replace: loop?");
       assert(0);
+      return;
     }
-    DES.erase(it);
+    *it = de;
+    return;
   }
   DES.insert(de);
 }
@@ -116,16 +120,18 @@ DataSet::Replace(const DataElement & de)
 void
 DataSet::ReplaceEmpty(const DataElement & de)
 {
-  ConstIterator it = DES.find(de);
-  if (it != DES.cend() && it->IsEmpty())
+  Iterator it = DES.find(de.GetTag());
+  if (it != DES.end() && it->IsEmpty())
   {
     // detect loop
     if (!(&*it != &de)) // FIXME
     {
       mdcmAlwaysWarnMacro("DataSet::ReplaceEmpty: loop?");
       assert(0);
+      return;
     }
-    DES.erase(it);
+    *it = de;
+    return;
   }
   DES.insert(de);
 }
@@ -133,8 +139,7 @@ DataSet::ReplaceEmpty(const DataElement & de)
 const DataElement &
 DataSet::GetDataElement(const Tag & t) const
 {
-  const DataElement r(t);
-  ConstIterator     it = DES.find(r);
+  ConstIterator it = DES.find(t);
   if (it != DES.cend())
     return *it;
   return GetDEEnd();
@@ -154,8 +159,7 @@ DataSet::GetPrivateCreator(const Tag & t) const
     Tag pc = t.GetPrivateCreator();
     if (pc.GetElement())
     {
-      const DataElement r(pc);
-      ConstIterator     it = DES.find(r);
+      ConstIterator it = DES.find(pc);
       if (it == DES.cend())
         return "";
       const DataElement & de = *it;
@@ -179,8 +183,7 @@ DataSet::GetPrivateCreator(const Tag & t) const
 bool
 DataSet::FindDataElement(const Tag & t) const
 {
-  const DataElement r(t);
-  if (DES.find(r) != DES.cend())
+  if (DES.find(t) != DES.cend())
     return true;
   return false;
 }
@@ -194,8 +197,7 @@ DataSet::FindDataElement(const PrivateTag & t) const
 const DataElement &
 DataSet::FindNextDataElement(const Tag & t) const
 {
-  const DataElement r(t);
-  ConstIterator     it = DES.lower_bound(r);
+  ConstIterator it = DES.lower_bound(t);
   if (it != DES.cend())
     return *it;
   return GetDEEnd();
@@ -281,10 +283,9 @@ DataSet::ComputeDataElement(const PrivateTag & t) const
   mdcmDebugMacro("ComputeDataElement, tag " << t);
 #endif
   // First private creator (0x0 -> 0x9 are reserved...)
-  const Tag         start(t.GetGroup(), 0x0010);
-  const DataElement r(start);
-  ConstIterator     it = DES.lower_bound(r);
-  const char *      refowner = t.GetOwner();
+  const Tag     start(t.GetGroup(), 0x0010);
+  ConstIterator it = DES.lower_bound(start);
+  const char *  refowner = t.GetOwner();
   assert(refowner);
   bool found = false;
   while (it != DES.cend() && it->GetTag().GetGroup() == t.GetGroup() && it->GetTag().GetElement() < 0x100)
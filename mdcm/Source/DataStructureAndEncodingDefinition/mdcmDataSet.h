@@ -23,6 +23,7 @@
 #define MDCMDATASET_H
 
 #include "mdcmDataElement.h"
+#include "mdcmDataElementSet.h"
 #include "mdcmTag.h"
 #include "mdcmVR.h"
 #include "mdcmElement.h"
@@ -58,6 +59,13 @@ class PrivateTag;
  * length.
  *
  * a DataSet does not have a Transfer Syntax type, only a File does.
+ *
+ * Elements are stored in a sorted vector (see DataElementSet). Insert
+ * or Replace of a new tag and Remove of an existing tag invalidate all
+ * iterators, pointers and references into the DataSet. Replace of an
+ * existing tag assigns in place and does not. While iterating, erase
+ * with GetDES().erase(), it returns the next iterator, and collect new
+ * elements to insert them after the loop.
  */
 class MDCM_EXPORT DataSet
 {
@@ -65,11 +73,7 @@ class MDCM_EXPORT DataSet
   friend std::ostream & operator<<(std::ostream &, const DataSet &);
 
 public:
-#if 0
-  typedef std::set<DataElement> DataElementSet;
-#else
-  typedef std::multiset<DataElement> DataElementSet;
-#endif
+  typedef mdcm::DataElementSet          DataElementSet;
   typedef DataElementSet::const_iterator ConstIterator;
   typedef DataElementSet::iterator       Iterator;
   typedef DataElementSet::size_type      SizeType;
@@ -118,9 +122,8 @@ public:
   ComputeGroupLength(const Tag & tag) const
   {
     assert(tag.GetElement() == 0x0);
-    const DataElement r(tag);
-    ConstIterator     it = DES.find(r);
-    unsigned int      res = 0;
+    ConstIterator it = DES.find(tag);
+    unsigned int  res = 0;
     for (++it; it != DES.cend() && it->GetTag().GetGroup() == tag.GetGroup(); ++it)
     {
       assert(it->GetTag().GetElement() != 0x0);
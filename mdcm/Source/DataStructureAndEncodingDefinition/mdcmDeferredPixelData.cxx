@@ -0,0 +1,196 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#include "mdcmDeferredPixelData.h"
+#include "mdcmByteValue.h"
+#include "mdcmSequenceOfFragments.h"
+#include "mdcmSystem.h"
+#include "mdcmTrace.h"
+#include <fstream>
+#include <new>
+
+namespace mdcm
+{
+
+void
+DeferredPixelData::SetFileName(const char * p)
+{
+  FileName = p ? p : "";
+}
+
+const std::string &
+DeferredPixelData::GetFileName() const
+{
+  return FileName;
+}
+
+void
+DeferredPixelData::SetEncapsulated(bool b)
+{
+  Encapsulated = b;
+}
+
+bool
+DeferredPixelData::IsEncapsulated() const
+{
+  return Encapsulated;
+}
+
+void
+DeferredPixelData::SetVR(const VR & vr)
+{
+  PixelDataVR = vr;
+}
+
+const VR &
+DeferredPixelData::GetVR() const
+{
+  return PixelDataVR;
+}
+
+void
+DeferredPixelData::SetTable(std::vector<char> & v)
+{
+  Table.swap(v);
+}
+
+const std::vector<char> &
+DeferredPixelData::GetTable() const
+{
+  return Table;
+}
+
+// 'head' has min(length, HeadSize) bytes
+void
+DeferredPixelData::AddFragment(unsigned long long offset, uint32_t length, const char * head)
+{
+  Offsets.push_back(offset);
+  Lengths.push_back(length);
+  const size_t k = Heads.size();
+  Heads.resize(k + HeadSize, 0);
+  if (head)
+  {
+    const unsigned int n = (length < HeadSize) ? length : HeadSize;
+    for (unsigned int x = 0; x < n; ++x)
+    {
+      Heads[k + x] = static_cast<unsigned char>(head[x]);
+    }
+  }
+}
+
+size_t
+DeferredPixelData::GetNumberOfFragments() const
+{
+  return Offsets.size();
+}
+
+unsigned long long
+DeferredPixelData::GetOffset(size_t k) const
+{
+  return Offsets[k];
+}
+
+uint32_t
+DeferredPixelData::GetLength(size_t k) const
+{
+  return Lengths[k];
+}
+
+const unsigned char *
+DeferredPixelData::GetHead(size_t k, unsigned int n) const
+{
+  if (k >= Lengths.size() || n > HeadSize || Lengths[k] < n)
+    return nullptr;
+  return Heads.data() + k * HeadSize;
+}
+
+bool
+DeferredPixelData::Read(unsigned long long offset, unsigned long long length, char * buffer) const
+{
+  if (length == 0)
+    return true;
+  if (!buffer || FileName.empty())
+    return false;
+  std::ifstream is;
+#if (defined(_MSC_VER) && defined(MDCM_WIN32_UNC))
+  const std::wstring uncpath = System::ConvertToUtf16(FileName.c_str());
+  is.open(uncpath.c_str(), std::ios_base::in | std::ios::binary);
+#else
+  is.open(FileName.c_str(), std::ios::binary);
+#endif
+  if (!is.is_open())
+  {
+    mdcmAlwaysWarnMacro("DeferredPixelData: can not open " << FileName);
+    return false;
+  }
+  is.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+  is.read(buffer, static_cast<std::streamsize>(length));
+  if (!is || static_cast<unsigned long long>(is.gcount()) != length)
+  {
+    mdcmAlwaysWarnMacro("DeferredPixelData: can not read " << length << " bytes at " << offset << " from "
+                                                           << FileName);
+    return false;
+  }
+  return true;
+}
+
+// Native Pixel Data, 'length' bytes at 'offset' of the value
+bool
+DeferredPixelData::GetBytes(unsigned long long offset, uint32_t length, DataElement & de) const
+{
+  if (Encapsulated || Offsets.size() != 1 || offset + length > Lengths[0])
+    return false;
+  try
+  {
+    SmartPointer<ByteValue> bv = new ByteValue;
+    bv->SetLength(length);
+    if (!Read(Offsets[0] + offset, length, static_cast<char *>(bv->GetVoidPointer())))
+      return false;
+    de.SetValue(*bv);
+  }
+  catch (const std::bad_alloc &)
+  {
+    return false;
+  }
+  return true;
+}
+
+// Encapsulated Pixel Data, 'count' fragments from 'first',
+// with the Basic Offset Table if 'table' is set
+bool
+DeferredPixelData::GetFragments(size_t first, size_t count, bool table, DataElement & de) const
+{
+  if (!Encapsulated || count == 0 || first + count > Offsets.size())
+    return false;
+  try
+  {
+    SmartPointer<SequenceOfFragments> sq = new SequenceOfFragments;
+    if (table && !Table.empty())
+    {
+      sq->GetTable().SetByteValue(Table.data(), static_cast<uint32_t>(Table.size()));
+    }
+    for (size_t x = first; x < first + count; ++x)
+    {
+      SmartPointer<ByteValue> bv = new ByteValue;
+      bv->SetLength(Lengths[x]);
+      if (!Read(Offsets[x], Lengths[x], static_cast<char *>(bv->GetVoidPointer())))
+        return false;
+      Fragment frag;
+      frag.SetValue(*bv);
+      sq->AddFragment(frag);
+    }
+    de.SetValue(*sq);
+  }
+  catch (const std::bad_alloc &)
+  {
+    return false;
+  }
+  return true;
+}
+
+} // end namespace mdcm
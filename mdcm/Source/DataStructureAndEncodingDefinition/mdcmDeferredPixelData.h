@@ -0,0 +1,83 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#ifndef MDCMDEFERREDPIXELDATA_H
+#define MDCMDEFERREDPIXELDATA_H
+
+#include "mdcmObject.h"
+#include "mdcmDataElement.h"
+#include <string>
+#include <vector>
+
+namespace mdcm
+{
+
+/**
+ * DeferredPixelData
+ *
+ * Pixel Data (7FE0,0010) not read into memory, the file offset and
+ * length of the value or, if encapsulated, of each fragment after the
+ * Basic Offset Table. The table and the first bytes of each fragment
+ * are kept, to find the frames, see Bitmap::GetFrameBuffer.
+ * Set by PixmapReader::SetDeferPixelData, the values are read from
+ * the file when a frame is decoded, each read opens the file, so
+ * reads may run in parallel. The file must not change until then.
+ *
+ */
+class MDCM_EXPORT DeferredPixelData : public Object
+{
+public:
+  static const unsigned int HeadSize = 8;
+  DeferredPixelData() = default;
+  void
+  SetFileName(const char *);
+  const std::string &
+  GetFileName() const;
+  void
+  SetEncapsulated(bool);
+  bool
+  IsEncapsulated() const;
+  void
+  SetVR(const VR &);
+  const VR &
+  GetVR() const;
+  void
+  SetTable(std::vector<char> &);
+  const std::vector<char> &
+  GetTable() const;
+  void
+  AddFragment(unsigned long long, uint32_t, const char *);
+  size_t
+  GetNumberOfFragments() const;
+  unsigned long long
+  GetOffset(size_t) const;
+  uint32_t
+  GetLength(size_t) const;
+  // First bytes of the fragment, nullptr if it is shorter than 'n'
+  const unsigned char *
+  GetHead(size_t, unsigned int n) const;
+  bool
+  Read(unsigned long long, unsigned long long, char *) const;
+  bool
+  GetBytes(unsigned long long, uint32_t, DataElement &) const;
+  bool
+  GetFragments(size_t, size_t, bool, DataElement &) const;
+
+private:
+  std::string                     FileName;
+  std::vector<unsigned long long> Offsets;
+  std::vector<uint32_t>           Lengths;
+  std::vector<unsigned char>      Heads;
+  std::vector<char>               Table;
+  VR                              PixelDataVR{};
+  bool                            Encapsulated{};
+};
+
+} // end namespace mdcm
+
+#endif // MDCMDEFERREDPIXELDATA_H
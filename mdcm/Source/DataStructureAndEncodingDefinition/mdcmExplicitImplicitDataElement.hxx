@@ -377,7 +377,7 @@ ExplicitImplicitDataElement::ReadValue(std::istream & is, bool readvalues)
     ValueField = new ByteValue;
   }
   // We have the length we should be able to read the value
-  this->SetValueFieldLength(ValueLengthField, readvalues);
+  this->SetValueFieldLength(ValueLengthField, readvalues, is);
 #if defined(MDCM_SUPPORT_BROKEN_IMPLEMENTATION) && 0
   // PHILIPS_Intera-16-MONO2-Uncompress.dcm
   if (TagField == Tag(0x2001, 0xe05f) || TagField == Tag(0x2001, 0xe100) || TagField == Tag(0x2005, 0xe080) ||
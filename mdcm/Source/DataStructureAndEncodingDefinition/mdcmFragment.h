@@ -86,7 +86,7 @@ public:
   ReadValue(std::istream & is)
   {
     SmartPointer<ByteValue> bv = new ByteValue;
-    bv->SetLength(ValueLengthField);
+    bv->SetLength(ValueLengthField, is);
     if (!bv->Read<TSwap>(is))
     {
       // Fragment is incomplete, but is a itemStart, let's try to push it anyway
@@ -135,7 +135,7 @@ public:
       return is;
     }
     SmartPointer<ByteValue> bv = new ByteValue;
-    bv->SetLength(ValueLengthField);
+    bv->SetLength(ValueLengthField, is);
     if (!bv->Read<TSwap>(is))
     {
       // Fragment is incomplete, but is a itemStart, let's try to push it anyway
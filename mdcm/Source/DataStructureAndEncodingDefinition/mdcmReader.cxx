@@ -26,6 +26,9 @@
 #include "mdcmSwapper.h"
 #include "mdcmDeflateStream.h"
 #include "mdcmSystem.h"
+#include "mdcmMappedFile.h"
+#include "mdcmValueArena.h"
+#include "mdcmDeferredPixelData.h"
 #include "mdcmExplicitDataElement.h"
 #include "mdcmImplicitDataElement.h"
 #ifdef MDCM_SUPPORT_BROKEN_IMPLEMENTATION
@@ -45,6 +48,12 @@ Reader::Reader() : F(new File)
 }
 
 Reader::~Reader()
+{
+  CloseFile();
+}
+
+void
+Reader::CloseFile()
 {
   if (Ifstream)
   {
@@ -53,6 +62,15 @@ Reader::~Reader()
     Ifstream = nullptr;
     Stream = nullptr;
   }
+  if (Mstream)
+  {
+    delete Mstream;
+    Mstream = nullptr;
+    Stream = nullptr;
+  }
+  // Values may still point into the file, they keep it mapped
+  delete Mbuf;
+  Mbuf = nullptr;
 }
 
 bool
@@ -197,6 +215,30 @@ Reader::GuessTransferSyntax()
 namespace details
 {
 
+// Small values of a read share one arena, see ByteValue,
+// the stream is detached at the end.
+class ArenaScope
+{
+public:
+  explicit ArenaScope(std::istream & is)
+    : m_stream(is)
+    , m_arena(new ValueArena)
+  {
+    ValueArena::Attach(m_stream, m_arena);
+  }
+  ~ArenaScope()
+  {
+    ValueArena::Attach(m_stream, nullptr);
+  }
+  ArenaScope(const ArenaScope &) = delete;
+  ArenaScope &
+  operator=(const ArenaScope &) = delete;
+
+private:
+  std::istream &           m_stream;
+  SmartPointer<ValueArena> m_arena;
+};
+
 class DefaultCaller
 {
 private:
@@ -362,6 +404,145 @@ Reader::ReadSelectedPrivateTags(const std::set<PrivateTag> & selectedPTags, bool
   return InternalReadCommon(caller);
 }
 
+// Reads the data set up to Pixel Data (7FE0,0010), the value is not
+// read, its offset and length or the offsets and lengths of the
+// fragments are set to 'pd'. Little endian only, not deflated. If
+// false, the file is empty, the stream is at the beginning and 'pd'
+// is not valid, use Read(). Elements after Pixel Data are not read.
+bool
+Reader::ReadUpToPixelData(DeferredPixelData & pd)
+{
+  if (!Stream || !*Stream || FileName.empty())
+    return false;
+  const Tag     tpixeldata(0x7fe0, 0x0010);
+  std::set<Tag> skiptags;
+  skiptags.insert(tpixeldata);
+  bool ok = ReadUpToTag(tpixeldata, skiptags);
+  if (ok)
+  {
+    const TransferSyntax & ts = F->GetHeader().GetDataSetTransferSyntax();
+    ok = ts.IsValid() && ts.GetSwapCode() == SwapCode::LittleEndian &&
+         ts != TransferSyntax::DeflatedExplicitVRLittleEndian &&
+         ts != TransferSyntax::ImplicitVRBigEndianPrivateGE;
+    std::istream & is = *Stream;
+    // The header of the element is read again to make sure
+    // the stream is at the value of Pixel Data.
+    const std::streamoff pos = ok ? static_cast<std::streamoff>(is.tellg()) : -1;
+    const bool           explicitvr = (ts.GetNegociatedType() == TransferSyntax::Explicit);
+    const std::streamoff hl = explicitvr ? 12 : 8;
+    unsigned char        h[12]{};
+    ok = ok && pos >= hl && is.seekg(pos - hl, std::ios::beg) && is.read(reinterpret_cast<char *>(h), hl) &&
+         h[0] == 0xe0 && h[1] == 0x7f && h[2] == 0x10 && h[3] == 0x00;
+    if (ok && explicitvr)
+    {
+      ok = ((h[4] == 'O' && (h[5] == 'B' || h[5] == 'W')) || (h[4] == 'U' && h[5] == 'N')) && h[6] == 0 && h[7] == 0;
+    }
+    std::streamoff end{};
+    if (ok)
+    {
+      is.seekg(0, std::ios::end);
+      end = static_cast<std::streamoff>(is.tellg());
+      is.seekg(pos, std::ios::beg);
+      ok = end >= pos && is.good();
+    }
+    const auto read32 = [](const unsigned char * p) -> uint32_t {
+      return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+             (static_cast<uint32_t>(p[3]) << 24);
+    };
+    if (ok)
+    {
+      const uint32_t vl = read32(h + hl - 4);
+      pd.SetFileName(FileName.c_str());
+      if (explicitvr)
+        pd.SetVR(h[4] == 'U' ? VR::UN : ((h[5] == 'B') ? VR::OB : VR::OW));
+      if (vl != 0xffffffff)
+      {
+        // Native
+        ok = static_cast<unsigned long long>(pos) + vl <= static_cast<unsigned long long>(end);
+        pd.SetEncapsulated(false);
+        pd.AddFragment(pos, vl, nullptr);
+      }
+      else
+      {
+        // Encapsulated, Basic Offset Table and fragments
+        pd.SetEncapsulated(true);
+        bool           table = true;
+        std::streamoff o = pos;
+        for (;;)
+        {
+          unsigned char item[8];
+          if (o + 8 > end || !is.read(reinterpret_cast<char *>(item), 8))
+          {
+            // tolerate a missing Sequence Delimitation Item
+            ok = (o == end && !table);
+            break;
+          }
+          const uint32_t l = read32(item + 4);
+          o += 8;
+          if (item[0] == 0xfe && item[1] == 0xff && item[2] == 0xdd && item[3] == 0xe0)
+          {
+            break;
+          }
+          if (!(item[0] == 0xfe && item[1] == 0xff && item[2] == 0x00 && item[3] == 0xe0) || l == 0xffffffff ||
+              o + l > end)
+          {
+            ok = false;
+            break;
+          }
+          if (table)
+          {
+            std::vector<char> v(l);
+            if (l > 0 && !is.read(v.data(), l))
+            {
+              ok = false;
+              break;
+            }
+            pd.SetTable(v);
+            table = false;
+          }
+          else
+          {
+            char           head[DeferredPixelData::HeadSize]{};
+            const uint32_t n = (l < DeferredPixelData::HeadSize) ? l : DeferredPixelData::HeadSize;
+            if (n > 0 && !is.read(head, n))
+            {
+              ok = false;
+              break;
+            }
+            pd.AddFragment(o, l, head);
+          }
+          o += l;
+          if (!is.seekg(o, std::ios::beg))
+          {
+            ok = false;
+            break;
+          }
+        }
+        ok = ok && pd.GetNumberOfFragments() > 0;
+      }
+    }
+  }
+  if (!ok)
+  {
+    mdcmDebugMacro("Pixel Data can not be deferred");
+    ResetFile();
+  }
+  return ok;
+}
+
+// Empty file, stream at the beginning, to read again
+void
+Reader::ResetFile()
+{
+  F->SetHeader(FileMetaInformation());
+  F->SetDataSet(DataSet());
+  if (Stream)
+  {
+    Stream->clear();
+    Stream->seekg(0, std::ios::beg);
+  }
+}
+
 template <typename T_Caller>
 bool
 Reader::InternalReadCommon(const T_Caller & caller)
@@ -371,7 +552,8 @@ Reader::InternalReadCommon(const T_Caller & caller)
     mdcmErrorMacro("No File");
     return false;
   }
-  bool success = true;
+  bool                      success = true;
+  const details::ArenaScope arena(*Stream);
   try
   {
     std::istream & is = *Stream;
@@ -449,6 +631,7 @@ Reader::InternalReadCommon(const T_Caller & caller)
     if (ts == TransferSyntax::DeflatedExplicitVRLittleEndian)
     {
       zlib_stream::zip_istream gzis(is);
+      ValueArena::Attach(gzis, ValueArena::Get(is));
       assert(ts.GetNegociatedType() == TransferSyntax::Explicit);
       caller.template ReadCommon<ExplicitDataElement, SwapperNoOp>(gzis);
       return is.good();
@@ -790,10 +973,37 @@ Reader::CanRead() const
   return false;
 }
 
+// Must be set before SetFileName
+void
+Reader::SetMemoryMapping(bool b)
+{
+  MemoryMapping = b;
+}
+
+bool
+Reader::GetMemoryMapping() const
+{
+  return MemoryMapping;
+}
+
 void
 Reader::SetFileName(const char * p)
 {
-  delete Ifstream;
+  CloseFile();
+  FileName = p ? p : "";
+  if (MemoryMapping && p && *p)
+  {
+    SmartPointer<MappedFile> mf = new MappedFile;
+    if (mf->Open(p))
+    {
+      Mbuf = new MappedStreamBuf(mf);
+      Mstream = new std::istream(Mbuf);
+      Stream = Mstream;
+      return;
+    }
+    // e.g. empty file or address space exhausted
+    mdcmDebugMacro("Memory mapping failed, using ifstream");
+  }
   Ifstream = new std::ifstream();
   if (p && *p)
   {
@@ -24,9 +24,14 @@
 
 #include "mdcmFile.h"
 #include <fstream>
+#include <string>
 
 namespace mdcm
 {
+
+class MappedStreamBuf;
+class DeferredPixelData;
+
 /**
  * Reader
  *
@@ -40,6 +45,9 @@ namespace mdcm
  * to any IOD at all.
  * MDCM will not produce warning for non-alphabetical order.
  *
+ * With memory mapping enabled, large values are not copied, they
+ * point into the mapped file (see ByteValue).
+ *
  */
 class MDCM_EXPORT Reader
 {
@@ -51,9 +59,14 @@ public:
   void
   SetFileName(const char *);
   void
+  SetMemoryMapping(bool);
+  bool
+  GetMemoryMapping() const;
+  void
   SetStream(std::istream & input_stream)
   {
     Stream = &input_stream;
+    FileName.clear();
   }
   const File &
   GetFile() const
@@ -91,6 +104,10 @@ protected:
   ReadMetaInformation();
   bool
   ReadDataSet();
+  bool
+  ReadUpToPixelData(DeferredPixelData &);
+  void
+  ResetFile();
   SmartPointer<File> F;
 
 private:
@@ -99,8 +116,14 @@ private:
   InternalReadCommon(const T_Caller &);
   TransferSyntax
   GuessTransferSyntax();
-  std::istream *  Stream{};
-  std::ifstream * Ifstream{};
+  void
+  CloseFile();
+  std::istream *    Stream{};
+  std::ifstream *   Ifstream{};
+  std::istream *    Mstream{};
+  MappedStreamBuf * Mbuf{};
+  std::string       FileName;
+  bool              MemoryMapping{};
 };
 
 } // end namespace mdcm
@@ -127,6 +127,37 @@ SequenceOfFragments::GetBuffer(char * buffer, unsigned long long length) const
   return true;
 }
 
+// Data of all fragments, the single fragment's data without copy
+// or concatenated into 'tmp', nullptr on error.
+const char *
+SequenceOfFragments::GetContiguousBuffer(std::vector<char> & tmp, unsigned long long & length) const
+{
+  length = 0;
+  if (Fragments.size() == 1)
+  {
+    const ByteValue * bv = Fragments[0].GetByteValue();
+    if (!bv)
+      return nullptr;
+    length = bv->GetLength();
+    return bv->GetPointer();
+  }
+  const unsigned long long total = ComputeByteLength();
+  if (total == 0)
+    return nullptr;
+  try
+  {
+    tmp.resize(total);
+  }
+  catch (const std::bad_alloc &)
+  {
+    return nullptr;
+  }
+  if (!GetBuffer(tmp.data(), total))
+    return nullptr;
+  length = total;
+  return tmp.data();
+}
+
 bool
 SequenceOfFragments::WriteBuffer(std::ostream & os) const
 {
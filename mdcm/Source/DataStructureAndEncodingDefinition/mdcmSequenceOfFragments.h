@@ -100,6 +100,9 @@ public:
   bool
   GetFragBuffer(unsigned int, char *, unsigned long long &) const;
 
+  const char *
+  GetContiguousBuffer(std::vector<char> &, unsigned long long &) const;
+
   SizeType
   GetNumberOfFragments() const;
 
@@ -89,7 +89,7 @@ public:
 
   VM() = default;
 
-  VM(VMType type) : VMField(type) {}
+  constexpr VM(VMType type) : VMField(type) {}
 
   static std::string GetVMString(VMType);
 
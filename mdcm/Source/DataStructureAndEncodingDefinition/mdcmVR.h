@@ -115,7 +115,7 @@ public:
 
   VR() = default;
 
-  VR(VRType vr)
+  constexpr VR(VRType vr)
     : VRField(vr)
   {}
 
@@ -29,14 +29,238 @@
 #include "mdcmJPEG2000Codec.h"
 #include "mdcmRLECodec.h"
 #include "mdcmImageHelper.h"
+#include "mdcmWorkerPool.h"
+#include <atomic>
 #include <cstring>
+#include <limits>
+#include <vector>
 
 #define MDCM_DATA_MORE_THAN_4GB
-#define MDCM_TRYJPEG_USE_RDBUF
 
 namespace mdcm
 {
 
+namespace
+{
+
+// Single frame of a multi-frame bitmap, the Pixel Data
+// may share fragments with the source.
+class FrameBitmap : public Bitmap
+{
+public:
+  FrameBitmap(const Bitmap & b, const DataElement & pd, bool overlays, bool unused)
+    : Bitmap(b)
+    , Overlays(overlays)
+    , Unused(unused)
+  {
+    PixelData = pd;
+    Deferred = nullptr;
+    NumberOfDimensions = 2;
+    Dimensions[2] = 1;
+  }
+  bool
+  AreOverlaysInPixelData() const override
+  {
+    return Overlays;
+  }
+  bool
+  UnusedBitsPresentInPixelData() const override
+  {
+    return Unused;
+  }
+
+private:
+  bool Overlays;
+  bool Unused;
+};
+
+// Lengths and first bytes of the fragments and the Basic Offset Table,
+// of a SequenceOfFragments or of deferred Pixel Data
+class FragmentList
+{
+public:
+  explicit FragmentList(const SequenceOfFragments & sf)
+    : SF(&sf)
+  {}
+  explicit FragmentList(const DeferredPixelData & d)
+    : Deferred(&d)
+  {}
+  size_t
+  Size() const
+  {
+    return SF ? SF->GetNumberOfFragments() : Deferred->GetNumberOfFragments();
+  }
+  unsigned long long
+  Length(size_t k) const
+  {
+    return SF ? static_cast<unsigned long long>((SF->Begin() + k)->GetVL()) : Deferred->GetLength(k);
+  }
+  // First 'n' bytes (up to 8), nullptr if the fragment is shorter
+  const unsigned char *
+  Head(size_t k, unsigned int n) const
+  {
+    if (!SF)
+      return Deferred->GetHead(k, n);
+    const ByteValue * bv = (SF->Begin() + k)->GetByteValue();
+    if (!bv || bv->GetLength() < n)
+      return nullptr;
+    return reinterpret_cast<const unsigned char *>(bv->GetPointer());
+  }
+  const unsigned char *
+  Table(unsigned long long & length) const
+  {
+    if (!SF)
+    {
+      length = Deferred->GetTable().size();
+      return reinterpret_cast<const unsigned char *>(Deferred->GetTable().data());
+    }
+    const ByteValue * table = SF->GetTable().GetByteValue();
+    length = table ? static_cast<unsigned long long>(table->GetLength()) : 0ull;
+    return table ? reinterpret_cast<const unsigned char *>(table->GetPointer()) : nullptr;
+  }
+
+private:
+  const SequenceOfFragments * SF{};
+  const DeferredPixelData *   Deferred{};
+};
+
+// First fragment of each frame from the offsets of the frames, relative to
+// the first fragment's Item tag, 'index' gets one more value for the end.
+bool
+OffsetsToFrameIndex(const FragmentList &                    fl,
+                    const std::vector<unsigned long long> & offsets,
+                    std::vector<size_t> &                   index)
+{
+  const size_t frames = offsets.size();
+  const size_t n = fl.Size();
+  if (frames == 0 || n < frames || offsets[0] != 0)
+  {
+    return false;
+  }
+  for (size_t x = 1; x < frames; ++x)
+  {
+    if (offsets[x] <= offsets[x - 1])
+    {
+      return false;
+    }
+  }
+  index.assign(frames + 1, n);
+  size_t             f = 0;
+  unsigned long long pos = 0;
+  for (size_t k = 0; k < n && f < frames; ++k)
+  {
+    if (pos == offsets[f])
+    {
+      index[f] = k;
+      ++f;
+    }
+    else if (pos > offsets[f])
+    {
+      return false;
+    }
+    pos += 8ull + fl.Length(k);
+  }
+  return (f == frames);
+}
+
+bool
+ReadBasicOffsetTable(const FragmentList & fl, unsigned int frames, std::vector<unsigned long long> & offsets)
+{
+  unsigned long long    length{};
+  const unsigned char * p = fl.Table(length);
+  if (!p || length < 4ull * frames)
+  {
+    return false;
+  }
+  offsets.resize(frames);
+  for (unsigned int x = 0; x < frames; ++x)
+  {
+    const unsigned char * o = p + 4 * x;
+    offsets[x] = static_cast<unsigned long long>(o[0]) | (static_cast<unsigned long long>(o[1]) << 8) |
+                 (static_cast<unsigned long long>(o[2]) << 16) | (static_cast<unsigned long long>(o[3]) << 24);
+  }
+  return true;
+}
+
+// Without offset tables, a frame starts with the fragment starting
+// with a JPEG or JPEG-LS SOI, a JPEG 2000 SOC and SIZ or a JP2 signature.
+// Only the first bytes of each fragment are read.
+bool
+ScanFrameIndex(const FragmentList & fl, unsigned int frames, std::vector<size_t> & index)
+{
+  const size_t n = fl.Size();
+  if (frames == 0 || n < frames)
+  {
+    return false;
+  }
+  index.assign(frames + 1, n);
+  size_t f = 0;
+  for (size_t k = 0; k < n; ++k)
+  {
+    const unsigned char * p = fl.Head(k, 4);
+    if (!p)
+    {
+      continue;
+    }
+    const unsigned char * p8 = fl.Head(k, 8);
+    const bool            start =
+      (p[0] == 0xff && p[1] == 0xd8) || (p[0] == 0xff && p[1] == 0x4f && p[2] == 0xff && p[3] == 0x51) ||
+      (p8 && p[0] == 0x00 && p[1] == 0x00 && p[2] == 0x00 && p[3] == 0x0c && p[4] == 0x6a && p[5] == 0x50 &&
+       p[6] == 0x20 && p[7] == 0x20);
+    if (!start)
+    {
+      continue;
+    }
+    if (f == frames || (f == 0 && k != 0))
+    {
+      return false;
+    }
+    index[f] = k;
+    ++f;
+  }
+  return (f == frames);
+}
+
+// Fragments of a frame, from the index, one per frame
+// or from the Basic Offset Table
+bool
+GetFrameFragments(const FragmentList &        fl,
+                  const std::vector<size_t> & index,
+                  unsigned int                frames,
+                  unsigned int                frame,
+                  size_t &                    first,
+                  size_t &                    count)
+{
+  const size_t n = fl.Size();
+  std::vector<size_t> tmp;
+  const std::vector<size_t> * x = &index;
+  if (index.size() != frames + 1ull || index[frames] != n)
+  {
+    if (n == frames)
+    {
+      first = frame;
+      count = 1;
+      return true;
+    }
+    std::vector<unsigned long long> offsets;
+    if (!ReadBasicOffsetTable(fl, frames, offsets) || !OffsetsToFrameIndex(fl, offsets, tmp))
+    {
+      return false;
+    }
+    x = &tmp;
+  }
+  first = (*x)[frame];
+  count = (*x)[frame + 1] - first;
+  return (first < n && count > 0);
+}
+
+} // end anonymous namespace
+
+Bitmap::Bitmap()
+  : Options(ImageHelper::GetDecodeOptions())
+{
+}
+
 unsigned int
 Bitmap::GetNumberOfDimensions() const
 {
@@ -280,6 +504,267 @@ Bitmap::GetBuffer(char * buffer) const
   return GetBufferInternal(buffer, dummy);
 }
 
+// Length of one decoded frame, 0 if frames are not byte aligned
+unsigned long long
+Bitmap::GetFrameBufferLength() const
+{
+  const unsigned int       frames = (NumberOfDimensions > 2) ? Dimensions[2] : 1;
+  const unsigned long long len = GetBufferLength();
+  if (frames == 0 || len % frames != 0)
+    return 0ull;
+  if (PF == PixelFormat::SINGLEBIT && frames > 1 &&
+      ((static_cast<unsigned long long>(Dimensions[0]) * Dimensions[1]) % 8) != 0)
+    return 0ull;
+  return len / frames;
+}
+
+// Decodes only the frame, native Pixel Data or encapsulated with
+// one fragment per frame, the frame index (see ComputeFrameIndex)
+// or a Basic Offset Table. Other data are decoded completely and
+// the frame is copied.
+// With a memory mapped reader (Reader::SetMemoryMapping) the file
+// is paged in only for the frames decoded.
+bool
+Bitmap::GetFrameBuffer(unsigned int frame, char * buffer) const
+{
+  const unsigned int frames = (NumberOfDimensions > 2) ? Dimensions[2] : 1;
+  if (!buffer || frame >= frames)
+    return false;
+  if (frames == 1)
+    return GetBuffer(buffer);
+  const unsigned long long frame_length = GetFrameBufferLength();
+  if (frame_length == 0)
+    return false;
+  DataElement pd;
+  if (GetFrameDataElement(frame, frame_length, pd))
+  {
+    const FrameBitmap b(*this, pd, AreOverlaysInPixelData(), UnusedBitsPresentInPixelData());
+    return b.GetBuffer(buffer);
+  }
+  std::vector<char> tmp;
+  try
+  {
+    tmp.resize(GetBufferLength());
+  }
+  catch (const std::bad_alloc &)
+  {
+    return false;
+  }
+  if (!GetBuffer(tmp.data()))
+    return false;
+  memcpy(buffer, tmp.data() + frame * frame_length, frame_length);
+  return true;
+}
+
+// Decodes the frame at reduced resolution, each level halves the size,
+// e.g. for thumbnails. JPEG 2000 discards the resolution levels while
+// decoding, fewer if the codestream has not enough, other data are
+// decoded at full resolution. The buffer must have GetFrameBufferLength()
+// bytes, 'dims' (2 values) are the decoded dimensions.
+bool
+Bitmap::GetReducedFrameBuffer(unsigned int frame, unsigned int level, char * buffer, unsigned int * dims) const
+{
+  const unsigned int frames = (NumberOfDimensions > 2) ? Dimensions[2] : 1;
+  if (!buffer || !dims || frame >= frames)
+    return false;
+  JPEG2000Codec codec;
+  if (level > 0 && codec.CanDecode(TS))
+  {
+    const unsigned long long frame_length = GetFrameBufferLength();
+    DataElement              pd;
+    const bool               whole = (frames == 1 && !Deferred);
+    if (frame_length > 0 && frame_length <= std::numeric_limits<size_t>::max() &&
+        (whole || GetFrameDataElement(frame, frame_length, pd)))
+    {
+      const SequenceOfFragments * sf = whole ? PixelData.GetSequenceOfFragments() : pd.GetSequenceOfFragments();
+      std::vector<char>  tmp;
+      unsigned long long in_len{};
+      const char *       in = sf ? sf->GetContiguousBuffer(tmp, in_len) : nullptr;
+      if (in && in_len <= std::numeric_limits<size_t>::max())
+      {
+        const unsigned int d[3] = { Dimensions[0], Dimensions[1], 1 };
+        codec.SetDecodeOptions(Options);
+        codec.SetPixelFormat(PF);
+        codec.SetNumberOfDimensions(2);
+        codec.SetPlanarConfiguration(PlanarConfiguration);
+        codec.SetPhotometricInterpretation(PI);
+        codec.SetNeedOverlayCleanup(AreOverlaysInPixelData() ||
+                                    (Options.CleanUnusedBits && UnusedBitsPresentInPixelData()));
+        codec.SetDimensions(d);
+        codec.SetReduction(level);
+        size_t len{};
+        if (codec.DecodeToBuffer(in, static_cast<size_t>(in_len), buffer, static_cast<size_t>(frame_length), len) &&
+            codec.GetPixelFormat().GetBitsAllocated() == PF.GetBitsAllocated() &&
+            codec.GetPixelFormat().GetSamplesPerPixel() == PF.GetSamplesPerPixel())
+        {
+          const unsigned int r = codec.GetReduction();
+          dims[0] = (Dimensions[0] + (1u << r) - 1) >> r;
+          dims[1] = (Dimensions[1] + (1u << r) - 1) >> r;
+          const unsigned long long expected =
+            static_cast<unsigned long long>(dims[0]) * dims[1] * PF.GetPixelSize();
+          if (len >= expected)
+            return true;
+        }
+      }
+    }
+  }
+  dims[0] = Dimensions[0];
+  dims[1] = Dimensions[1];
+  return GetFrameBuffer(frame, buffer);
+}
+
+// Pixel Data of a single frame, a slice of native data or the fragments
+// of the frame, shared with the source or, if deferred, read from the file.
+bool
+Bitmap::GetFrameDataElement(unsigned int frame, unsigned long long frame_length, DataElement & pd) const
+{
+  const unsigned int frames = (NumberOfDimensions > 2) ? Dimensions[2] : 1;
+  pd = DataElement(PixelData.GetTag());
+  pd.SetVR(PixelData.GetVR());
+  const bool native_frames = !TS.IsEncapsulated() && PF.GetBitsAllocated() % 8 == 0 && PF != PixelFormat::SINGLEBIT &&
+                             frame_length < 0xffffffffull;
+  if (Deferred)
+  {
+    if (!Deferred->IsEncapsulated())
+    {
+      return native_frames && frame_length * frames <= Deferred->GetLength(0) &&
+             Deferred->GetBytes(frame * frame_length, static_cast<uint32_t>(frame_length), pd);
+    }
+    size_t first{};
+    size_t count{};
+    if (frames == 1)
+    {
+      return Deferred->GetFragments(0, Deferred->GetNumberOfFragments(), true, pd);
+    }
+    return GetFrameFragments(FragmentList(*Deferred), FrameIndex, frames, frame, first, count) &&
+           Deferred->GetFragments(first, count, false, pd);
+  }
+  const ByteValue *           bv = PixelData.GetByteValue();
+  const SequenceOfFragments * sf = PixelData.GetSequenceOfFragments();
+  if (bv && native_frames && frame_length * frames <= bv->GetLength())
+  {
+    pd.SetByteValue(bv->GetPointer() + frame * frame_length, static_cast<uint32_t>(frame_length));
+    return true;
+  }
+  if (sf)
+  {
+    size_t first{};
+    size_t count{};
+    if (GetFrameFragments(FragmentList(*sf), FrameIndex, frames, frame, first, count))
+    {
+      SmartPointer<SequenceOfFragments> sq = new SequenceOfFragments;
+      SequenceOfFragments::ConstIterator it = sf->Begin() + first;
+      for (size_t x = 0; x < count; ++x, ++it)
+      {
+        sq->AddFragment(*it);
+      }
+      pd.SetValue(*sq);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Encapsulated frames decoded by up to DecodeOptions::FrameThreads threads,
+// the calling thread and threads of the shared WorkerPool, each frame with
+// own codec into its place in the buffer. Deferred frames are read by
+// the thread decoding them. Returns false to decode serially, also if
+// a codec had to adjust the pixel format or dimensions, so the result
+// and the bitmap are the same as serial.
+bool
+Bitmap::GetBufferParallel(char * buffer, bool & lossyflag) const
+{
+  const unsigned int frames = (NumberOfDimensions > 2) ? Dimensions[2] : 1;
+  if (!buffer || Options.FrameThreads < 2 || frames < 2 || !TS.IsEncapsulated() ||
+      (Deferred ? !Deferred->IsEncapsulated() : !PixelData.GetSequenceOfFragments()))
+    return false;
+  const unsigned long long frame_length = GetFrameBufferLength();
+  if (frame_length == 0)
+    return false;
+  std::vector<DataElement> pds;
+  if (!Deferred)
+  {
+    pds.resize(frames);
+    for (unsigned int k = 0; k < frames; ++k)
+    {
+      if (!GetFrameDataElement(k, frame_length, pds[k]))
+        return false;
+    }
+  }
+  const bool                overlays = AreOverlaysInPixelData();
+  const bool                unused = UnusedBitsPresentInPixelData();
+  std::atomic<unsigned int> next{};
+  std::atomic<bool>         ok{true};
+  std::atomic<bool>         lossy{};
+  auto                      work = [&]() {
+    for (unsigned int k = next++; k < frames && ok; k = next++)
+    {
+      try
+      {
+        DataElement pd;
+        if (Deferred && !GetFrameDataElement(k, frame_length, pd))
+        {
+          ok = false;
+          break;
+        }
+        FrameBitmap b(*this, Deferred ? pd : pds[k], overlays, unused);
+        // the frames are already in parallel
+        b.Options.CodecThreads = 1;
+        bool l{};
+        if (!static_cast<const Bitmap &>(b).GetBufferInternal(buffer + k * frame_length, l) || b.PF != PF ||
+            b.PlanarConfiguration != PlanarConfiguration || b.Dimensions[0] != Dimensions[0] ||
+            b.Dimensions[1] != Dimensions[1])
+        {
+          ok = false;
+        }
+        else if (l)
+        {
+          lossy = true;
+        }
+      }
+      catch (...)
+      {
+        ok = false;
+      }
+    }
+  };
+  const unsigned int n = (Options.FrameThreads < frames) ? Options.FrameThreads : frames;
+  WorkerPool::GetInstance().Run(n, work);
+  if (!ok)
+  {
+    mdcmDebugMacro("Parallel decoding failed, decoding serially");
+    return false;
+  }
+  lossyflag = lossy;
+  return true;
+}
+
+// Index of the first fragment of each frame, from the Extended Offset Table
+// (7FE0,0001), if valid, the Basic Offset Table or the fragments' markers.
+// Not required with one fragment per frame.
+bool
+Bitmap::ComputeFrameIndex(const std::vector<unsigned long long> & extended_offsets)
+{
+  FrameIndex.clear();
+  const unsigned int          frames = (NumberOfDimensions > 2) ? Dimensions[2] : 1;
+  const SequenceOfFragments * sf = PixelData.GetSequenceOfFragments();
+  if (frames < 2 || (Deferred ? !Deferred->IsEncapsulated() : !sf))
+    return false;
+  const FragmentList fl = Deferred ? FragmentList(*Deferred) : FragmentList(*sf);
+  if (fl.Size() == frames)
+    return false;
+  if (extended_offsets.size() == frames && OffsetsToFrameIndex(fl, extended_offsets, FrameIndex))
+    return true;
+  std::vector<unsigned long long> offsets;
+  if (ReadBasicOffsetTable(fl, frames, offsets) && OffsetsToFrameIndex(fl, offsets, FrameIndex))
+    return true;
+  if (TS != TransferSyntax::RLELossless && TS != TransferSyntax::EncapsulatedUncompressedExplicitVRLittleEndian &&
+      ScanFrameIndex(fl, frames, FrameIndex))
+    return true;
+  FrameIndex.clear();
+  return false;
+}
+
 bool
 Bitmap::AreOverlaysInPixelData() const
 {
@@ -337,17 +822,48 @@ void
 Bitmap::SetDataElement(const DataElement & de)
 {
   PixelData = de;
+  Deferred = nullptr;
+  FrameIndex.clear();
 }
 
+// Pixel Data in the file, see PixmapReader::SetDeferPixelData, the
+// data element is then a placeholder with tag and VR, until read by
+// GetDataElement. Set after SetDataElement, which clears it.
+void
+Bitmap::SetDeferredPixelData(DeferredPixelData * d)
+{
+  Deferred = d;
+  FrameIndex.clear();
+}
+
+const DeferredPixelData *
+Bitmap::GetDeferredPixelData() const
+{
+  return Deferred;
+}
+
+// Deferred Pixel Data is read into memory first, for filters and writers
+// using the data element, the bitmap is changed, not thread-safe then.
 const DataElement &
 Bitmap::GetDataElement() const
 {
+  if (Deferred)
+  {
+    DataElement pd;
+    if (GetDeferredDataElement(pd))
+    {
+      Bitmap * i = const_cast<Bitmap *>(this);
+      i->PixelData = pd;
+      i->Deferred = nullptr;
+    }
+  }
   return PixelData;
 }
 
 DataElement &
 Bitmap::GetDataElement()
 {
+  static_cast<const Bitmap *>(this)->GetDataElement();
   return PixelData;
 }
 
@@ -412,6 +928,18 @@ Bitmap::SetPixelFormat(const PixelFormat & pf)
   PF.Validate();
 }
 
+void
+Bitmap::SetDecodeOptions(const DecodeOptions & o)
+{
+  Options = o;
+}
+
+const DecodeOptions &
+Bitmap::GetDecodeOptions() const
+{
+  return Options;
+}
+
 void
 Bitmap::Print(std::ostream & os) const
 {
@@ -443,6 +971,7 @@ Bitmap::TryRAWCodec(char * buffer, bool & lossyflag) const
 {
   RAWCodec               codec;
   const TransferSyntax & ts = GetTransferSyntax();
+  codec.SetDecodeOptions(Options);
   if (!buffer)
   {
     if (codec.CanDecode(ts))
@@ -467,7 +996,7 @@ Bitmap::TryRAWCodec(char * buffer, bool & lossyflag) const
     codec.SetPixelFormat(GetPixelFormat());
     codec.SetNeedByteSwap(GetNeedByteSwap());
     codec.SetNeedOverlayCleanup(AreOverlaysInPixelData() ||
-                                (ImageHelper::GetCleanUnusedBits() && UnusedBitsPresentInPixelData()));
+                                (Options.CleanUnusedBits && UnusedBitsPresentInPixelData()));
     DataElement out;
     const bool  r = codec.DecodeBytes(bv->GetPointer(), bv->GetLength(), buffer, len);
     if (!r)
@@ -493,6 +1022,7 @@ Bitmap::TryEncapsulatedRAWCodec(char * buffer, bool & lossyflag) const
 {
   EncapsulatedRAWCodec   codec;
   const TransferSyntax & ts = GetTransferSyntax();
+  codec.SetDecodeOptions(Options);
   if (!buffer)
   {
     if (codec.CanDecode(ts))
@@ -518,7 +1048,7 @@ Bitmap::TryEncapsulatedRAWCodec(char * buffer, bool & lossyflag) const
     codec.SetPixelFormat(GetPixelFormat());
     codec.SetNeedByteSwap(GetNeedByteSwap());
     codec.SetNeedOverlayCleanup(AreOverlaysInPixelData() ||
-                                (ImageHelper::GetCleanUnusedBits() && UnusedBitsPresentInPixelData()));
+                                (Options.CleanUnusedBits && UnusedBitsPresentInPixelData()));
     DataElement out;
     const bool  r = codec.Decode2(PixelData, buffer, len);
     if (!r)
@@ -539,6 +1069,7 @@ Bitmap::TryJPEGCodec(char * buffer, bool & lossyflag) const
 {
   JPEGCodec              codec;
   const TransferSyntax & ts = GetTransferSyntax();
+  codec.SetDecodeOptions(Options);
   if (!buffer)
   {
     if (codec.CanDecode(ts))
@@ -581,7 +1112,7 @@ Bitmap::TryJPEGCodec(char * buffer, bool & lossyflag) const
               mdcmAlwaysWarnMacro(
                 "TryJPEGCodec:: encapsulated stream precision " << cpf.GetBitsStored() <<
                 " bits, but DICOM bits stored " << pf.GetBitsStored());
-              if (ImageHelper::GetFixJpegBits())
+              if (Options.FixJpegBits)
               {
                 mdcmAlwaysWarnMacro("... fixed, assumed JPEG header is correct");
                 Bitmap * i = const_cast<Bitmap *>(this);
@@ -612,12 +1143,11 @@ Bitmap::TryJPEGCodec(char * buffer, bool & lossyflag) const
     codec.SetPhotometricInterpretation(GetPhotometricInterpretation());
     codec.SetPixelFormat(GetPixelFormat());
     codec.SetNeedOverlayCleanup(AreOverlaysInPixelData() ||
-                                (ImageHelper::GetCleanUnusedBits() && UnusedBitsPresentInPixelData()));
-    std::stringstream os;
-    if (!codec.Decode2(PixelData, os))
+                                (Options.CleanUnusedBits && UnusedBitsPresentInPixelData()));
+    if (!codec.Decode2(PixelData, buffer, len))
     {
       // PHILIPS_Gyroscan-12-MONO2-Jpeg_Lossless.dcm
-      mdcmAlwaysWarnMacro("TryJPEGCodec: !codec.Decode2(PixelData, os)");
+      mdcmAlwaysWarnMacro("TryJPEGCodec: !codec.Decode2(PixelData, buffer, len)");
       return false;
     }
     if (GetPlanarConfiguration() != codec.GetPlanarConfiguration())
@@ -640,32 +1170,6 @@ Bitmap::TryJPEGCodec(char * buffer, bool & lossyflag) const
         }
       }
     }
-    const size_t len2 = os.tellp();
-    if (len != len2)
-    {
-      mdcmAlwaysWarnMacro("TryJPEGCodec: len=" << len << " len2=" << len2);
-      if (len > len2)
-      {
-        memset(buffer, 0, len);
-      }
-    }
-#ifdef MDCM_TRYJPEG_USE_RDBUF
-    std::stringbuf * pbuf = os.rdbuf();
-    const long long sgetn_s = pbuf->sgetn(buffer, ((len < len2) ? len : len2));
-#if 0
-    std::cout << "TryJPEGCodec: sizes should be the equal: " << len << " " << len2 << " " << sgetn_s << std::endl;
-#endif
-    if (sgetn_s <= 0)
-    {
-      mdcmAlwaysWarnMacro("TryJPEGCodec: pbuf->sgetn returned " << sgetn_s);
-    }
-#else
-    const std::string & tmp0 = os.str();
-    memcpy(
-      buffer,
-      tmp0.data(),
-      ((len < len2) ? len : len2));
-#endif
     lossyflag = codec.IsLossy();
     return true;
   }
@@ -675,6 +1179,7 @@ Bitmap::TryJPEGCodec(char * buffer, bool & lossyflag) const
 {
   JPEGCodec              codec;
   const TransferSyntax & ts = GetTransferSyntax();
+  codec.SetDecodeOptions(Options);
   if (!buffer)
   {
     if (codec.CanDecode(ts))
@@ -717,7 +1222,7 @@ Bitmap::TryJPEGCodec(char * buffer, bool & lossyflag) const
               mdcmAlwaysWarnMacro(
                 "Encapsulated stream reports precision " << cpf.GetBitsStored() <<
                 " bits, but DICOM bits stored " << pf.GetBitsStored());
-              if (ImageHelper::GetFixJpegBits())
+              if (Options.FixJpegBits)
               {
                 mdcmAlwaysWarnMacro("... fixed, assumed JPEG header is correct");
                 Bitmap * i = const_cast<Bitmap *>(this);
@@ -752,7 +1257,7 @@ Bitmap::TryJPEGCodec(char * buffer, bool & lossyflag) const
     codec.SetPhotometricInterpretation(GetPhotometricInterpretation());
     codec.SetPixelFormat(GetPixelFormat());
     codec.SetNeedOverlayCleanup(AreOverlaysInPixelData() ||
-                                (ImageHelper::GetCleanUnusedBits() && UnusedBitsPresentInPixelData()));
+                                (Options.CleanUnusedBits && UnusedBitsPresentInPixelData()));
     DataElement out;
     if (!codec.Decode(PixelData, out))
     {
@@ -796,7 +1301,7 @@ Bitmap::TryJPEGCodec(char * buffer, bool & lossyflag) const
             mdcmAlwaysWarnMacro(
               "Encapsulated stream reports precision " << cpf.GetBitsStored() <<
               " bits, but DICOM bits stored " << pf.GetBitsStored());
-            if (ImageHelper::GetFixJpegBits())
+            if (Options.FixJpegBits)
             {
               mdcmAlwaysWarnMacro("... fixed, assumed JPEG header is correct");
               Bitmap * i = const_cast<Bitmap *>(this);
@@ -834,6 +1339,7 @@ Bitmap::TryJPEGLSCodec(char * buffer, bool & lossyflag) const
 {
   JPEGLSCodec            codec;
   const TransferSyntax & ts = GetTransferSyntax();
+  codec.SetDecodeOptions(Options);
   if (!buffer)
   {
     if (codec.CanDecode(ts))
@@ -862,7 +1368,7 @@ Bitmap::TryJPEGLSCodec(char * buffer, bool & lossyflag) const
     codec.SetPlanarConfiguration(GetPlanarConfiguration());
     codec.SetPhotometricInterpretation(GetPhotometricInterpretation());
     codec.SetNeedOverlayCleanup(AreOverlaysInPixelData() ||
-                                (ImageHelper::GetCleanUnusedBits() && UnusedBitsPresentInPixelData()));
+                                (Options.CleanUnusedBits && UnusedBitsPresentInPixelData()));
     codec.SetDimensions(GetDimensions());
     const bool r = codec.Decode2(PixelData, buffer, len);
     if (!r)
@@ -880,6 +1386,7 @@ Bitmap::TryJPEGLSCodec(char * buffer, bool & lossyflag) const
 {
   JPEGLSCodec            codec;
   const TransferSyntax & ts = GetTransferSyntax();
+  codec.SetDecodeOptions(Options);
   if (!buffer)
   {
     if (codec.CanDecode(ts))
@@ -913,7 +1420,7 @@ Bitmap::TryJPEGLSCodec(char * buffer, bool & lossyflag) const
     codec.SetPlanarConfiguration(GetPlanarConfiguration());
     codec.SetPhotometricInterpretation(GetPhotometricInterpretation());
     codec.SetNeedOverlayCleanup(AreOverlaysInPixelData() ||
-                                (ImageHelper::GetCleanUnusedBits() && UnusedBitsPresentInPixelData()));
+                                (Options.CleanUnusedBits && UnusedBitsPresentInPixelData()));
     codec.SetDimensions(GetDimensions());
     DataElement out;
     const bool  r = codec.Decode(PixelData, out);
@@ -942,6 +1449,7 @@ Bitmap::TryJPEG2000Codec(char * buffer, bool & lossyflag) const
 {
   JPEG2000Codec          codec;
   const TransferSyntax & ts = GetTransferSyntax();
+  codec.SetDecodeOptions(Options);
   if (!buffer)
   {
     if (codec.CanDecode(ts))
@@ -990,7 +1498,7 @@ Bitmap::TryJPEG2000Codec(char * buffer, bool & lossyflag) const
     codec.SetPlanarConfiguration(GetPlanarConfiguration());
     codec.SetPhotometricInterpretation(GetPhotometricInterpretation());
     codec.SetNeedOverlayCleanup(AreOverlaysInPixelData() ||
-                                (ImageHelper::GetCleanUnusedBits() && UnusedBitsPresentInPixelData()));
+                                (Options.CleanUnusedBits && UnusedBitsPresentInPixelData()));
     codec.SetDimensions(GetDimensions());
     const bool r = codec.Decode2(PixelData, buffer, len);
     if (!r)
@@ -1027,6 +1535,7 @@ Bitmap::TryJPEG2000Codec(char * buffer, bool & lossyflag) const
 {
   JPEG2000Codec          codec;
   const TransferSyntax & ts = GetTransferSyntax();
+  codec.SetDecodeOptions(Options);
   if (!buffer)
   {
     if (codec.CanDecode(ts))
@@ -1080,7 +1589,7 @@ Bitmap::TryJPEG2000Codec(char * buffer, bool & lossyflag) const
     codec.SetPlanarConfiguration(GetPlanarConfiguration());
     codec.SetPhotometricInterpretation(GetPhotometricInterpretation());
     codec.SetNeedOverlayCleanup(AreOverlaysInPixelData() ||
-                                (ImageHelper::GetCleanUnusedBits() && UnusedBitsPresentInPixelData()));
+                                (Options.CleanUnusedBits && UnusedBitsPresentInPixelData()));
     codec.SetDimensions(GetDimensions());
     DataElement out;
     bool        r = codec.Decode(PixelData, out);
@@ -1133,6 +1642,7 @@ Bitmap::TryRLECodec(char * buffer, bool & lossyflag) const
   }
   const TransferSyntax & ts = GetTransferSyntax();
   RLECodec               codec;
+  codec.SetDecodeOptions(Options);
   if (codec.CanDecode(ts))
   {
     codec.SetDimensions(GetDimensions());
@@ -1142,7 +1652,7 @@ Bitmap::TryRLECodec(char * buffer, bool & lossyflag) const
     codec.SetPixelFormat(GetPixelFormat());
     codec.SetLUT(GetLUT());
     codec.SetNeedOverlayCleanup(AreOverlaysInPixelData() ||
-                                (ImageHelper::GetCleanUnusedBits() && UnusedBitsPresentInPixelData()));
+                                (Options.CleanUnusedBits && UnusedBitsPresentInPixelData()));
     codec.SetBufferLength(len);
     DataElement out;
     const bool  r = codec.Decode(PixelData, out);
@@ -1157,9 +1667,97 @@ Bitmap::TryRLECodec(char * buffer, bool & lossyflag) const
   return false;
 }
 
+// Deferred Pixel Data is read and decoded frame by frame (in parallel
+// if possible), so only the frames being decoded are in memory. Other
+// data, e.g. frames not byte aligned, are read completely. Without a
+// buffer, the lossy flag is computed from the first frame.
+bool
+Bitmap::GetBufferDeferred(char * buffer, bool & lossyflag) const
+{
+  const unsigned int       frames = (NumberOfDimensions > 2) ? Dimensions[2] : 1;
+  const unsigned long long frame_length = GetFrameBufferLength();
+  const bool               overlays = AreOverlaysInPixelData();
+  const bool               unused = UnusedBitsPresentInPixelData();
+  if (!buffer)
+  {
+    DataElement pd;
+    if (frame_length > 0 && GetFrameDataElement(0, frame_length, pd))
+    {
+      const FrameBitmap b(*this, pd, overlays, unused);
+      return static_cast<const Bitmap &>(b).GetBufferInternal(nullptr, lossyflag);
+    }
+  }
+  else if (GetBufferParallel(buffer, lossyflag))
+  {
+    return true;
+  }
+  else if (frame_length > 0)
+  {
+    bool lossy{};
+    bool ok{true};
+    for (unsigned int k = 0; k < frames && ok; ++k)
+    {
+      DataElement pd;
+      if (!GetFrameDataElement(k, frame_length, pd))
+      {
+        ok = false;
+        break;
+      }
+      FrameBitmap b(*this, pd, overlays, unused);
+      bool        l{};
+      if (!static_cast<const Bitmap &>(b).GetBufferInternal(buffer + k * frame_length, l) || b.PF != PF ||
+          b.PlanarConfiguration != PlanarConfiguration || b.Dimensions[0] != Dimensions[0] ||
+          b.Dimensions[1] != Dimensions[1])
+      {
+        ok = false;
+      }
+      else if (l)
+      {
+        lossy = true;
+      }
+    }
+    if (ok)
+    {
+      lossyflag = lossy;
+      return true;
+    }
+    mdcmDebugMacro("Decoding deferred frames failed, reading all Pixel Data");
+  }
+  DataElement pd;
+  if (!GetDeferredDataElement(pd))
+    return false;
+  FrameBitmap b(*this, pd, overlays, unused);
+  b.NumberOfDimensions = NumberOfDimensions;
+  b.Dimensions = Dimensions;
+  b.FrameIndex = FrameIndex;
+  if (!static_cast<const Bitmap &>(b).GetBufferInternal(buffer, lossyflag))
+    return false;
+  // as if decoded by this bitmap, a codec may have adjusted it
+  Bitmap * i = const_cast<Bitmap *>(this);
+  i->PF = b.PF;
+  i->PI = b.PI;
+  i->PlanarConfiguration = b.PlanarConfiguration;
+  i->Dimensions = b.Dimensions;
+  return true;
+}
+
+// All deferred Pixel Data
+bool
+Bitmap::GetDeferredDataElement(DataElement & pd) const
+{
+  pd = DataElement(PixelData.GetTag());
+  pd.SetVR(PixelData.GetVR());
+  return Deferred->IsEncapsulated() ? Deferred->GetFragments(0, Deferred->GetNumberOfFragments(), true, pd)
+                                    : Deferred->GetBytes(0, Deferred->GetLength(0), pd);
+}
+
 bool
 Bitmap::GetBufferInternal(char * buffer, bool & lossyflag) const
 {
+  if (Deferred)
+    return GetBufferDeferred(buffer, lossyflag);
+  if (GetBufferParallel(buffer, lossyflag))
+    return true;
   bool success = TryRAWCodec(buffer, lossyflag);
   if (!success)
     success = TryJPEGCodec(buffer, lossyflag);
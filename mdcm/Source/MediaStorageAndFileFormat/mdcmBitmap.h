@@ -25,6 +25,8 @@
 #include "mdcmObject.h"
 #include "mdcmCurve.h"
 #include "mdcmDataElement.h"
+#include "mdcmDecodeOptions.h"
+#include "mdcmDeferredPixelData.h"
 #include "mdcmLookupTable.h"
 #include "mdcmOverlay.h"
 #include "mdcmPhotometricInterpretation.h"
@@ -48,7 +50,7 @@ class MDCM_EXPORT Bitmap : public Object
   friend class ImageChangeTransferSyntax;
 
 public:
-  Bitmap() = default;
+  Bitmap();
   virtual ~Bitmap() = default;
   unsigned int
   GetNumberOfDimensions() const;
@@ -82,6 +84,14 @@ public:
   GetBufferLength() const;
   bool
   GetBuffer(char *) const;
+  unsigned long long
+  GetFrameBufferLength() const;
+  bool
+  GetFrameBuffer(unsigned int, char *) const;
+  bool
+  GetReducedFrameBuffer(unsigned int, unsigned int, char *, unsigned int *) const;
+  bool
+  ComputeFrameIndex(const std::vector<unsigned long long> &);
   virtual bool
   AreOverlaysInPixelData() const;
   virtual bool
@@ -103,6 +113,10 @@ public:
   DataElement &
   GetDataElement();
   void
+  SetDeferredPixelData(DeferredPixelData *);
+  const DeferredPixelData *
+  GetDeferredPixelData() const;
+  void
   SetLUT(const LookupTable &);
   const LookupTable &
   GetLUT() const;
@@ -123,6 +137,10 @@ public:
   void
   SetPixelFormat(const PixelFormat &);
   void
+  SetDecodeOptions(const DecodeOptions &);
+  const DecodeOptions &
+  GetDecodeOptions() const;
+  void
   Print(std::ostream &) const;
 
 protected:
@@ -140,20 +158,31 @@ protected:
   TryJPEG2000Codec(char *, bool &) const;
   bool
   TryRLECodec(char *, bool &) const;
-  unsigned int              PlanarConfiguration{};
-  unsigned int              NumberOfDimensions{2};
-  TransferSyntax            TS{};
-  PixelFormat               PF{};
-  PhotometricInterpretation PI{};
-  std::vector<unsigned int> Dimensions{0, 0, 1};
-  DataElement               PixelData{};
-  LookupTable               LUT{};
-  bool                      NeedByteSwap{};
-  bool                      LossyFlag{};
+  unsigned int                    PlanarConfiguration{};
+  unsigned int                    NumberOfDimensions{2};
+  TransferSyntax                  TS{};
+  PixelFormat                     PF{};
+  PhotometricInterpretation       PI{};
+  std::vector<unsigned int>       Dimensions{0, 0, 1};
+  DataElement                     PixelData{};
+  LookupTable                     LUT{};
+  bool                            NeedByteSwap{};
+  bool                            LossyFlag{};
+  DecodeOptions                   Options{};
+  std::vector<size_t>             FrameIndex{};
+  SmartPointer<DeferredPixelData> Deferred{};
 
 private:
   bool
   GetBufferInternal(char *, bool &) const;
+  bool
+  GetBufferParallel(char *, bool &) const;
+  bool
+  GetBufferDeferred(char *, bool &) const;
+  bool
+  GetDeferredDataElement(DataElement &) const;
+  bool
+  GetFrameDataElement(unsigned int, unsigned long long, DataElement &) const;
 
 };
 
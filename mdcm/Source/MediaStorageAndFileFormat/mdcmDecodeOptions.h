@@ -0,0 +1,41 @@
+/*********************************************************
+ *
+ * MDCM
+ *
+ * github.com/issakomi
+ *
+ *********************************************************/
+
+#ifndef MDCMDECODEOPTIONS_H
+#define MDCMDECODEOPTIONS_H
+
+namespace mdcm
+{
+
+/**
+ * DecodeOptions
+ *
+ * Decoding options of a single read, carried by PixmapReader, Bitmap
+ * and ImageCodec. They start with the global values of ImageHelper,
+ * set them per reader to read files in parallel with different options.
+ *
+ */
+struct DecodeOptions
+{
+  bool ForceRescaleInterceptSlope{};
+  bool CleanUnusedBits{};
+  bool WorkaroundCornellBug{};
+  bool WorkaroundPredictorBug{};
+  bool JpegPreserveYBRfull{true};
+  bool FixJpegBits{};
+  // Encapsulated multi-frame images, frames are decoded
+  // in parallel with more than one thread
+  unsigned int FrameThreads{};
+  // Threads of a codec decoding one frame (JPEG 2000),
+  // 0 all processors, 1 the calling thread only
+  unsigned int CodecThreads{};
+};
+
+} // end namespace mdcm
+
+#endif // MDCMDECODEOPTIONS_H
@@ -22,7 +22,9 @@
 
 #include "mdcmImageCodec.h"
 #include "mdcmJPEGCodec.h"
+#include "mdcmImageHelper.h"
 #include "mdcmByteSwap.h"
+#include "mdcmPixelKernels.h"
 #include "mdcmTrace.h"
 #include <iostream>
 #include <iomanip>
@@ -33,6 +35,11 @@
 namespace mdcm
 {
 
+ImageCodec::ImageCodec()
+  : Options(ImageHelper::GetDecodeOptions())
+{
+}
+
 bool
 ImageCodec::CanDecode(const TransferSyntax &) const
 {
@@ -195,79 +202,19 @@ ImageCodec::CleanupUnusedBits(char * data8, size_t datalen)
   if (!NeedOverlayCleanup) return true;
   void * data = static_cast<void*>(data8);
   assert(PF.GetBitsAllocated() > 8);
+  // Shifted by (BitsStored - HighBit - 1), then BitsStored bits are
+  // kept, with sign extension for signed pixels (the 'unused bits'
+  // may contain overlays)
+  const unsigned int shift = static_cast<unsigned int>(PF.GetBitsStored() - PF.GetHighBit() - 1);
+  const unsigned int bits = PF.GetBitsStored();
+  const bool         sign = (PF.GetPixelRepresentation() != 0);
   if (PF.GetBitsAllocated() == 16)
   {
-    // pmask: to mask the 'unused bits' (may contain overlays)
-    const uint16_t pmask = static_cast<uint16_t>(0xffffU >> (PF.GetBitsAllocated() - PF.GetBitsStored()));
-    if (PF.GetPixelRepresentation())
-    {
-      // smask: to check the 'sign' when BitsStored != BitsAllocated
-      const uint16_t smask = static_cast<uint16_t>(1U << (16 - (PF.GetBitsAllocated() - PF.GetBitsStored() + 1)));
-      // nmask: to propagate sign bit on negative values
-      const int16_t nmask = static_cast<int16_t>(0xffff8000U >> (PF.GetBitsAllocated() - PF.GetBitsStored() - 1));
-      uint16_t * start = static_cast<uint16_t*>(data);
-      for (uint16_t * p = start ; p != start + datalen / 2; ++p )
-      {
-        uint16_t c = *p;
-        c = c >> static_cast<uint16_t>(PF.GetBitsStored() - PF.GetHighBit() - 1);
-        if (c & smask)
-        {
-          c = static_cast<uint16_t>(c | nmask);
-        }
-        else
-        {
-          c = c & pmask;
-        }
-        *p = c;
-      }
-    }
-    else
-    {
-      uint16_t * start = static_cast<uint16_t*>(data);
-      for (uint16_t * p = start ; p != start + datalen / 2; ++p)
-      {
-        uint16_t c = *p;
-        c = (c >> (PF.GetBitsStored() - PF.GetHighBit() - 1)) & pmask;
-        *p = c;
-      }
-    }
+    PixelKernels::CleanupUnusedBits16(static_cast<uint16_t*>(data), datalen / 2, shift, bits, sign);
   }
   else if (PF.GetBitsAllocated() == 32)
   {
-    // pmask: to mask the 'unused bits' (may contain overlays)
-    const uint32_t pmask = static_cast<uint32_t>(0xffffffffU >> (PF.GetBitsAllocated() - PF.GetBitsStored()));
-    if (PF.GetPixelRepresentation())
-    {
-      // smask: to check the 'sign' when BitsStored != BitsAllocated
-      const uint32_t smask = static_cast<uint32_t>(1U << (32 - (PF.GetBitsAllocated() - PF.GetBitsStored() + 1)));
-      // nmask: to propagate sign bit on negative values
-      const int32_t nmask = static_cast<int32_t>(0xffffffff80000000ULL >> (PF.GetBitsAllocated() - PF.GetBitsStored() - 1));
-      uint32_t * start = static_cast<uint32_t*>(data);
-      for (uint32_t * p = start ; p != start + datalen / 4; ++p )
-      {
-        uint32_t c = *p;
-        c = c >> static_cast<uint32_t>(PF.GetBitsStored() - PF.GetHighBit() - 1);
-        if (c & smask)
-        {
-          c = static_cast<uint32_t>(c | nmask);
-        }
-        else
-        {
-          c = c & pmask;
-        }
-        *p = c;
-      }
-    }
-    else
-    {
-      uint32_t * start = static_cast<uint32_t*>(data);
-      for (uint32_t * p = start ; p != start + datalen / 4; ++p)
-      {
-        uint32_t c = *p;
-        c = (c >> (PF.GetBitsStored() - PF.GetHighBit() - 1)) & pmask;
-        *p = c;
-      }
-    }
+    PixelKernels::CleanupUnusedBits32(static_cast<uint32_t*>(data), datalen / 4, shift, bits, sign);
   }
   else
   {
@@ -276,6 +223,18 @@ ImageCodec::CleanupUnusedBits(char * data8, size_t datalen)
   return true;
 }
 
+void
+ImageCodec::SetDecodeOptions(const DecodeOptions & o)
+{
+  Options = o;
+}
+
+const DecodeOptions &
+ImageCodec::GetDecodeOptions() const
+{
+  return Options;
+}
+
 bool
 ImageCodec::IsValid(const PhotometricInterpretation &)
 {
@@ -477,10 +436,7 @@ ImageCodec::DoByteSwap(std::istream & is, std::ostream & os)
       delete[] buffer;
       return false;
     }
-    void * vbuffer = static_cast<void*>(buffer);
-    ByteSwap<uint16_t>::SwapRangeFromSwapCodeIntoSystem(static_cast<uint16_t *>(vbuffer),
-                                                        SwapCode::BigEndian,
-                                                        buf_size / 2);
+    PixelKernels::SwapArray16(buffer, buf_size / 2);
   }
   else if (PF.GetBitsAllocated() == 32)
   {
@@ -489,10 +445,7 @@ ImageCodec::DoByteSwap(std::istream & is, std::ostream & os)
       delete[] buffer;
       return false;
     }
-    void * vbuffer = static_cast<void*>(buffer);
-    ByteSwap<uint32_t>::SwapRangeFromSwapCodeIntoSystem(static_cast<uint32_t *>(vbuffer),
-                                                        SwapCode::BigEndian,
-                                                        buf_size / 4);
+    PixelKernels::SwapArray32(buffer, buf_size / 4);
   }
 #endif
   os.write(buffer, buf_size);
@@ -27,6 +27,7 @@
 #include "mdcmPhotometricInterpretation.h"
 #include "mdcmLookupTable.h"
 #include "mdcmPixelFormat.h"
+#include "mdcmDecodeOptions.h"
 
 namespace mdcm
 {
@@ -37,7 +38,7 @@ namespace mdcm
 class MDCM_EXPORT ImageCodec
 {
 public:
-  ImageCodec() = default;
+  ImageCodec();
   virtual ~ImageCodec() = default;
   virtual bool
   CanDecode(const TransferSyntax &) const;
@@ -91,6 +92,10 @@ public:
   GetNumberOfDimensions() const;
   bool
   CleanupUnusedBits(char *, size_t);
+  virtual void
+  SetDecodeOptions(const DecodeOptions &);
+  const DecodeOptions &
+  GetDecodeOptions() const;
 
 protected:
   virtual bool
@@ -134,6 +139,7 @@ protected:
   unsigned int              Dimensions[3]{};
   unsigned int              NumberOfDimensions{};
   bool                      LossyFlag{};
+  DecodeOptions             Options{};
 };
 
 } // end namespace mdcm
@@ -628,6 +628,19 @@ ImageHelper::GetFixJpegBits()
   return FixJpegBits;
 }
 
+DecodeOptions
+ImageHelper::GetDecodeOptions()
+{
+  DecodeOptions o;
+  o.ForceRescaleInterceptSlope = ForceRescaleInterceptSlope;
+  o.CleanUnusedBits = CleanUnusedBits;
+  o.WorkaroundCornellBug = WorkaroundCornellBug;
+  o.WorkaroundPredictorBug = WorkaroundPredictorBug;
+  o.JpegPreserveYBRfull = JpegPreserveYBRfull;
+  o.FixJpegBits = FixJpegBits;
+  return o;
+}
+
 bool
 GetRescaleInterceptSlopeValueFromDataSet(const DataSet & ds, std::vector<double> & interceptslope)
 {
@@ -834,6 +847,12 @@ ImageHelper::SetDimensionsValue(File & f, const Pixmap & img)
 
 std::vector<double>
 ImageHelper::GetRescaleInterceptSlopeValue(const File & f)
+{
+  return GetRescaleInterceptSlopeValue(f, ForceRescaleInterceptSlope);
+}
+
+std::vector<double>
+ImageHelper::GetRescaleInterceptSlopeValue(const File & f, bool force)
 {
   std::vector<double> interceptslope;
   MediaStorage        ms;
@@ -865,7 +884,7 @@ ImageHelper::GetRescaleInterceptSlopeValue(const File & f)
       ms == MediaStorage::PETImageStorage || ms == MediaStorage::SecondaryCaptureImageStorage ||
       ms == MediaStorage::MultiframeGrayscaleWordSecondaryCaptureImageStorage ||
       ms == MediaStorage::MultiframeGrayscaleByteSecondaryCaptureImageStorage ||
-      ForceRescaleInterceptSlope)
+      force)
   {
     bool b = GetRescaleInterceptSlopeValueFromDataSet(ds, interceptslope);
     if (!b)
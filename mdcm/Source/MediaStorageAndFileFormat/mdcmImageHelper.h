@@ -31,6 +31,7 @@
 #include "mdcmPhotometricInterpretation.h"
 #include "mdcmSmartPointer.h"
 #include "mdcmLookupTable.h"
+#include "mdcmDecodeOptions.h"
 
 // TODO completely replace and remove the mess
 
@@ -87,6 +88,8 @@ public:
   SetFixJpegBits(bool);
   static bool
   GetFixJpegBits();
+  static DecodeOptions
+  GetDecodeOptions();
   static std::vector<unsigned int>
   GetDimensionsValue(const File &);
   static void
@@ -95,6 +98,8 @@ public:
   GetPixelFormatValue(const File &);
   static std::vector<double>
   GetRescaleInterceptSlopeValue(const File &);
+  static std::vector<double>
+  GetRescaleInterceptSlopeValue(const File &, bool);
   static void
   SetRescaleInterceptSlopeValue(File &, const Image &);
   static void
@@ -90,7 +90,7 @@ ImageReader::ReadImage(const MediaStorage & ms)
   {
     pixeldata.SetDirectionCosines(dircos.data());
   }
-  std::vector<double> is = ImageHelper::GetRescaleInterceptSlopeValue(*F);
+  std::vector<double> is = ImageHelper::GetRescaleInterceptSlopeValue(*F, m_DecodeOptions.ForceRescaleInterceptSlope);
   pixeldata.SetIntercept(is[0]);
   pixeldata.SetSlope(is[1]);
   return true;
@@ -136,7 +136,7 @@ ImageReader::ReadACRNEMAImage()
     at.SetFromDataElement(de);
     pixeldata.SetDirectionCosines(at.GetValues());
   }
-  std::vector<double> is = ImageHelper::GetRescaleInterceptSlopeValue(*F);
+  std::vector<double> is = ImageHelper::GetRescaleInterceptSlopeValue(*F, m_DecodeOptions.ForceRescaleInterceptSlope);
   pixeldata.SetIntercept(is[0]);
   pixeldata.SetSlope(is[1]);
   return true;
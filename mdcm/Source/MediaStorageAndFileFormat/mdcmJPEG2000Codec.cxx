@@ -30,9 +30,9 @@
 #include <cstring>
 #include <cstdio>
 #include <numeric>
+#include <vector>
 #include "mdcm_openjpeg.h"
 
-#define MDCM_JPEG2000_USE_RDBUF
 //#define MDCM_JPEG2000_VERBOSE
 
 namespace mdcm
@@ -404,14 +404,28 @@ class JPEG2000Internals
 public:
   JPEG2000Internals()
     : nNumberOfThreadsForDecompression(0)
+    , nReduction(0)
+    , nAppliedReduction(0)
   {
     memset(&coder_param, 0, sizeof(coder_param));
     opj_set_default_encoder_parameters(&coder_param);
   }
   opj_cparameters coder_param;
   int             nNumberOfThreadsForDecompression;
+  unsigned int    nReduction;
+  unsigned int    nAppliedReduction;
 };
 
+// Threads of the decoder, DecodeOptions::CodecThreads 0 is
+// the default (all processors), 1 is the calling thread only.
+static int
+get_decompression_threads(const DecodeOptions & o, int d)
+{
+  if (o.CodecThreads == 0)
+    return d;
+  return (o.CodecThreads == 1) ? 0 : static_cast<int>(o.CodecThreads);
+}
+
 template <typename T>
 void
 rawtoimage_fill2(const T *     inputbuffer,
@@ -817,34 +831,24 @@ JPEG2000Codec::Decode(const DataElement & in, DataElement & out)
     }
     if (!sf)
       return false;
-    std::stringstream        is;
-    const unsigned long long totalLen = sf->ComputeByteLength();
-    char *                   buffer;
-    try
-    {
-      buffer = new char[totalLen];
-    }
-    catch (const std::bad_alloc &)
-    {
+    std::vector<char>        tmp;
+    unsigned long long       totalLen{};
+    const char *             buffer = sf->GetContiguousBuffer(tmp, totalLen);
+    if (!buffer)
       return false;
-    }
-    sf->GetBuffer(buffer, totalLen);
-    is.write(buffer, totalLen);
-    delete[] buffer;
-    std::stringstream os;
-    const bool        r = DecodeByStreams(is, os);
-    if (!r)
+    const std::pair<char *, size_t> raw_len = DecodeByStreamsCommon(buffer, totalLen);
+    if (!raw_len.first || !raw_len.second)
       return false;
-    out = in;
-    std::string str = os.str();
-    const unsigned long long str_size = str.size();
-    if (str_size >= 0xffffffff)
+    if (raw_len.second >= 0xffffffff)
     {
       mdcmAlwaysWarnMacro("JPEG2000Codec: value too big for ByteValue");
+      delete[] raw_len.first;
       return false;
     }
-    out.SetByteValue(str.data(), static_cast<uint32_t>(str_size));
-    return r;
+    out = in;
+    out.SetByteValue(raw_len.first, static_cast<uint32_t>(raw_len.second));
+    delete[] raw_len.first;
+    return true;
   }
   else if (NumberOfDimensions == 3)
   {
@@ -857,40 +861,35 @@ JPEG2000Codec::Decode(const DataElement & in, DataElement & out)
     const SequenceOfFragments * sf = in.GetSequenceOfFragments();
     if (!sf)
       return false;
-    std::stringstream os;
     if (sf->GetNumberOfFragments() != Dimensions[2])
     {
       mdcmAlwaysWarnMacro(
         "JPEG2000Codec: number of frames does not match 3rd dimension, not supported");
       return false;
     }
+    std::vector<char> str;
     for (unsigned int i = 0; i < sf->GetNumberOfFragments(); ++i)
     {
-      std::stringstream is;
-      const Fragment &  frag = sf->GetFragment(i);
+      const Fragment & frag = sf->GetFragment(i);
       if (frag.IsEmpty())
         return false;
       const ByteValue * bv = frag.GetByteValue();
       if (!bv)
         return false;
-      const size_t bv_len = bv->GetLength();
-      char *       mybuffer;
+      const std::pair<char *, size_t> raw_len = DecodeByStreamsCommon(bv->GetPointer(), bv->GetLength());
+      if (!raw_len.first || !raw_len.second)
+        return false;
       try
       {
-        mybuffer = new char[bv_len];
+        str.insert(str.end(), raw_len.first, raw_len.first + raw_len.second);
       }
       catch (const std::bad_alloc &)
       {
+        delete[] raw_len.first;
         return false;
       }
-      bv->GetBuffer(mybuffer, bv->GetLength());
-      is.write(mybuffer, bv->GetLength());
-      delete[] mybuffer;
-      const bool r = DecodeByStreams(is, os);
-      if (!r)
-        return false;
+      delete[] raw_len.first;
     }
-    std::string str = os.str();
     assert(!str.empty());
     const unsigned long long str_size = str.size();
     if (str_size >= 0xffffffff)
@@ -947,53 +946,23 @@ JPEG2000Codec::Decode2(const DataElement & in, char * out_buffer, size_t len)
     }
     if (!sf)
       return false;
-    std::stringstream        is;
-    const unsigned long long totalLen = sf->ComputeByteLength();
-    char *                   buffer;
-    try
-    {
-      buffer = new char[totalLen];
-    }
-    catch (const std::bad_alloc &)
-    {
+    std::vector<char>        tmp;
+    unsigned long long       totalLen{};
+    const char *             buffer = sf->GetContiguousBuffer(tmp, totalLen);
+    if (!buffer)
       return false;
-    }
-    sf->GetBuffer(buffer, totalLen);
-    is.write(buffer, totalLen);
-    delete[] buffer;
-    std::stringstream os;
-    const bool        r = DecodeByStreams(is, os);
-    if (!r)
+    size_t len2{};
+    if (!DecodeToBuffer(buffer, totalLen, out_buffer, len, len2))
       return false;
-    os.seekg(0, std::ios::end);
-    const size_t len2 = os.tellg();
     if (len != len2)
     {
       mdcmAlwaysWarnMacro("JPEG2000Codec: sizes mismatch " << len << ", " << len2);
       if (len > len2)
       {
-        memset(out_buffer, 0, len);
+        memset(out_buffer + len2, 0, len - len2);
       }
     }
-    os.seekg(0, std::ios::beg);
-#ifdef MDCM_JPEG2000_USE_RDBUF
-    std::stringbuf * pbuf = os.rdbuf();
-    const long long sgetn_s = pbuf->sgetn(out_buffer, ((len < len2) ? len : len2));
-#if 0
-    std::cout << "JPEG2000Codec: sizes should be the equal: " << len << " " << len2 << " " << sgetn_s << std::endl;
-#endif
-    if (sgetn_s <= 0)
-    {
-      mdcmAlwaysWarnMacro("JPEG2000Codec: pbuf->sgetn returned " << sgetn_s);
-    }
-#else
-    const std::string & tmp0 = os.str();
-    memcpy(
-      out_buffer,
-      tmp0.data(),
-      ((len < len2) ? len : len2));
-#endif
-    return r;
+    return true;
   }
   else if (NumberOfDimensions == 3)
   {
@@ -1006,67 +975,35 @@ JPEG2000Codec::Decode2(const DataElement & in, char * out_buffer, size_t len)
     const SequenceOfFragments * sf = in.GetSequenceOfFragments();
     if (!sf)
       return false;
-    std::stringstream os;
     if (sf->GetNumberOfFragments() != Dimensions[2])
     {
       mdcmAlwaysWarnMacro(
         "JPEG2000Codec: number of frames does not match 3rd dimension, not supported");
       return false;
     }
+    size_t len2{};
     for (unsigned int i = 0; i < sf->GetNumberOfFragments(); ++i)
     {
-      std::stringstream is;
-      const Fragment &  frag = sf->GetFragment(i);
+      const Fragment & frag = sf->GetFragment(i);
       if (frag.IsEmpty())
         return false;
       const ByteValue * bv = frag.GetByteValue();
       if (!bv)
         return false;
-      const size_t bv_len = bv->GetLength();
-      char *       mybuffer;
-      try
-      {
-        mybuffer = new char[bv_len];
-      }
-      catch (const std::bad_alloc &)
-      {
-        return false;
-      }
-      bv->GetBuffer(mybuffer, bv->GetLength());
-      is.write(mybuffer, bv->GetLength());
-      delete[] mybuffer;
-      const bool r = DecodeByStreams(is, os);
-      if (!r)
+      size_t       frame_len{};
+      const size_t offset = (len2 < len) ? len2 : len;
+      if (!DecodeToBuffer(bv->GetPointer(), bv->GetLength(), out_buffer + offset, len - offset, frame_len))
         return false;
+      len2 += frame_len;
     }
-    os.seekg(0, std::ios::end);
-    const size_t len2 = os.tellg();
     if (len != len2)
     {
       mdcmAlwaysWarnMacro("JPEG2000Codec: sizes mismatch " << len << ", " << len2);
       if (len > len2)
       {
-        memset(out_buffer, 0, len);
+        memset(out_buffer + len2, 0, len - len2);
       }
     }
-    os.seekg(0, std::ios::beg);
-#ifdef MDCM_JPEG2000_USE_RDBUF
-    std::stringbuf * pbuf = os.rdbuf();
-    const long long sgetn_s = pbuf->sgetn(out_buffer, ((len < len2) ? len : len2));
-#if 0
-    std::cout << "JPEG2000Codec: sizes should be the equal: " << len << " " << len2 << " " << sgetn_s << std::endl;
-#endif
-    if (sgetn_s <= 0)
-    {
-      mdcmAlwaysWarnMacro("JPEG2000Codec: pbuf->sgetn returned " << sgetn_s);
-    }
-#else
-    const std::string & tmp0 = os.str();
-    memcpy(
-      out_buffer,
-      tmp0.data(),
-      ((len < len2) ? len : len2));
-#endif
     return true;
   }
   return false;
@@ -1259,7 +1196,7 @@ JPEG2000Codec::DecodeByStreams(std::istream & is, std::ostream & os)
   }
   is.seekg(0, std::ios::beg);
   is.read(buf, buf_size);
-  std::pair<char *, size_t> raw_len = this->DecodeByStreamsCommon(buf, buf_size);
+  const std::pair<char *, size_t> raw_len = this->DecodeByStreamsCommon(buf, buf_size);
   delete[] buf;
   buf = nullptr;
   if (!raw_len.first || !raw_len.second)
@@ -1269,6 +1206,39 @@ JPEG2000Codec::DecodeByStreams(std::istream & is, std::ostream & os)
   return true;
 }
 
+// Decodes a frame into 'out', only the first 'out_len' bytes if
+// the frame is larger, 'len' is the decoded length.
+bool
+JPEG2000Codec::DecodeToBuffer(const char * in, size_t in_len, char * out, size_t out_len, size_t & len)
+{
+  const std::pair<char *, size_t> raw_len = DecodeByStreamsCommon(in, in_len, out, out_len);
+  if (!raw_len.first || !raw_len.second)
+    return false;
+  len = raw_len.second;
+  if (raw_len.first != out)
+  {
+    memcpy(out, raw_len.first, (out_len < len) ? out_len : len);
+    delete[] raw_len.first;
+  }
+  return true;
+}
+
+// Number of the highest resolution levels discarded while decoding,
+// the decoded size is ceil(dimension / 2^n). Fewer levels are discarded
+// if the codestream has not enough.
+void
+JPEG2000Codec::SetReduction(unsigned int n)
+{
+  Internals->nReduction = n;
+}
+
+// Levels discarded by the last decode
+unsigned int
+JPEG2000Codec::GetReduction() const
+{
+  return Internals->nAppliedReduction;
+}
+
 bool
 JPEG2000Codec::StartEncode(std::ostream &)
 {
@@ -1317,8 +1287,10 @@ JPEG2000Codec::StopEncode(std::ostream &)
   return true;
 }
 
+// Decodes a frame into 'out' if it has enough space, otherwise into a new buffer.
+// Returns the buffer and the decoded length.
 std::pair<char *, size_t>
-JPEG2000Codec::DecodeByStreamsCommon(char * dummy_buffer, size_t buf_size)
+JPEG2000Codec::DecodeByStreamsCommon(const char * dummy_buffer, size_t buf_size, char * out, size_t out_len)
 {
   if (!dummy_buffer)
     return std::make_pair<char *, size_t>(nullptr, 0);
@@ -1326,7 +1298,7 @@ JPEG2000Codec::DecodeByStreamsCommon(char * dummy_buffer, size_t buf_size)
   opj_codec_t *     dinfo = nullptr; // handle to a decompressor
   opj_stream_t *    cio = nullptr;
   opj_image_t *     image = nullptr;
-  unsigned char *   src = reinterpret_cast<unsigned char *>(dummy_buffer);
+  const unsigned char * src = reinterpret_cast<const unsigned char *>(dummy_buffer);
   size_t file_length = buf_size;
   // OpenJPEG is very picky when there is a trailing 00 at the end of the JPC,
   // so we need to make sure to remove it.
@@ -1390,12 +1362,13 @@ JPEG2000Codec::DecodeByStreamsCommon(char * dummy_buffer, size_t buf_size)
 #if ((OPJ_VERSION_MAJOR == 2 && OPJ_VERSION_MINOR >= 3) || OPJ_VERSION_MAJOR > 2)
   if (opj_has_thread_support())
   {
-    opj_codec_set_threads(dinfo, Internals->nNumberOfThreadsForDecompression);
+    opj_codec_set_threads(dinfo, get_decompression_threads(Options, Internals->nNumberOfThreadsForDecompression));
   }
 #endif
   myfile   mysrc;
   myfile * fsrc = &mysrc;
-  fsrc->mem = fsrc->cur = reinterpret_cast<char *>(src);
+  // Read only
+  fsrc->mem = fsrc->cur = const_cast<char *>(dummy_buffer);
   fsrc->len = file_length;
   OPJ_UINT32 * s[2];
   // The following hack is used for the file: DX_J2K_0Padding.dcm,
@@ -1426,6 +1399,35 @@ JPEG2000Codec::DecodeByStreamsCommon(char * dummy_buffer, size_t buf_size)
     mdcmErrorMacro("opj_setup_decoder failure");
     return std::make_pair<char *, size_t>(nullptr, 0);
   }
+  // Discard the highest resolution levels, not more than available
+  unsigned int reduction = 0;
+#if ((OPJ_VERSION_MAJOR == 2 && OPJ_VERSION_MINOR >= 1) || OPJ_VERSION_MAJOR > 2)
+  if (Internals->nReduction > 0)
+  {
+    opj_codestream_info_v2_t * cstr_info = opj_get_cstr_info(dinfo);
+    if (cstr_info && cstr_info->m_default_tile_info.tccp_info)
+    {
+      reduction = Internals->nReduction;
+      for (OPJ_UINT32 c = 0; c < cstr_info->nbcomps; ++c)
+      {
+        const OPJ_UINT32 n = cstr_info->m_default_tile_info.tccp_info[c].numresolutions;
+        if (n == 0)
+          reduction = 0;
+        else if (reduction > n - 1)
+          reduction = n - 1;
+      }
+    }
+    opj_destroy_cstr_info(&cstr_info);
+    if (reduction > 0 && !opj_set_decoded_resolution_factor(dinfo, reduction))
+    {
+      reduction = 0;
+      opj_set_decoded_resolution_factor(dinfo, 0);
+    }
+  }
+#endif
+  Internals->nAppliedReduction = reduction;
+  const unsigned int dimx = static_cast<unsigned int>(int_ceildivpow2(static_cast<int>(Dimensions[0]), reduction));
+  const unsigned int dimy = static_cast<unsigned int>(int_ceildivpow2(static_cast<int>(Dimensions[1]), reduction));
 #if 0
   // Optional if you want decode the entire image
   opj_set_decode_area(dinfo,
@@ -1500,34 +1502,38 @@ JPEG2000Codec::DecodeByStreamsCommon(char * dummy_buffer, size_t buf_size)
 #endif
   // Close the byte stream
   opj_stream_destroy(cio);
-  const size_t len =
-    static_cast<size_t>(Dimensions[0]) * Dimensions[1] * (PF.GetBitsAllocated() / 8) * image->numcomps;
-  char * raw;
-  try
+  const size_t len = static_cast<size_t>(dimx) * dimy * (PF.GetBitsAllocated() / 8) * image->numcomps;
+  char * raw = (out && out_len >= len) ? out : nullptr;
+  if (!raw)
   {
-    raw = new char[len];
-  }
-  catch (const std::bad_alloc &)
-  {
-    opj_destroy_codec(dinfo);
-    opj_image_destroy(image);
-    return std::make_pair<char *, size_t>(nullptr, 0);
+    try
+    {
+      raw = new char[len];
+    }
+    catch (const std::bad_alloc &)
+    {
+      opj_destroy_codec(dinfo);
+      opj_image_destroy(image);
+      return std::make_pair<char *, size_t>(nullptr, 0);
+    }
   }
   for (unsigned int compno = 0; compno < image->numcomps; ++compno)
   {
     opj_image_comp_t * comp = &image->comps[compno];
     const int          w = image->comps[compno].w;
-    const int          wr = int_ceildivpow2(image->comps[compno].w, image->comps[compno].factor);
-    const int          hr = int_ceildivpow2(image->comps[compno].h, image->comps[compno].factor);
+    // OpenJPEG 2 sets the size already reduced by the factor
+    const int          wr = static_cast<int>(image->comps[compno].w);
+    const int          hr = static_cast<int>(image->comps[compno].h);
     if (wr < 0 || hr < 0 ||
-        static_cast<unsigned int>(wr) != Dimensions[0] ||
-        static_cast<unsigned int>(hr) != Dimensions[1])
+        static_cast<unsigned int>(wr) != dimx ||
+        static_cast<unsigned int>(hr) != dimy)
     {
       mdcmAlwaysWarnMacro("JPEG2000Codec: dimension is invalid\n  "
-                          << wr << ' ' << Dimensions[0] << "\n  " << hr << ' ' << Dimensions[1]);
+                          << wr << ' ' << dimx << "\n  " << hr << ' ' << dimy);
       opj_destroy_codec(dinfo);
       opj_image_destroy(image);
-      delete[] raw;
+      if (raw != out)
+        delete[] raw;
       return std::make_pair<char*, size_t>(nullptr, 0);
     }
     // ELSCINT1_JP2vsJ2K.dcm
@@ -1557,7 +1563,8 @@ JPEG2000Codec::DecodeByStreamsCommon(char * dummy_buffer, size_t buf_size)
       mdcmAlwaysWarnMacro("JPEG2000Codec: comp->prec = " << comp->prec << " is not supported");
       opj_destroy_codec(dinfo);
       opj_image_destroy(image);
-      delete[] raw;
+      if (raw != out)
+        delete[] raw;
       return std::make_pair<char *, size_t>(nullptr, 0);
     }
     void * vraw = static_cast<void*>(raw);
@@ -1830,7 +1837,7 @@ JPEG2000Codec::GetHeaderInfo(const char * dummy_buffer, size_t buf_size)
 #if ((OPJ_VERSION_MAJOR == 2 && OPJ_VERSION_MINOR >= 3) || OPJ_VERSION_MAJOR > 2)
   if (opj_has_thread_support())
   {
-    opj_codec_set_threads(dinfo, Internals->nNumberOfThreadsForDecompression);
+    opj_codec_set_threads(dinfo, get_decompression_threads(Options, Internals->nNumberOfThreadsForDecompression));
   }
 #endif
   myfile   mysrc;
@@ -53,6 +53,10 @@ public:
   bool
   GetHeaderInfo(std::istream &) override;
   void
+  SetReduction(unsigned int);
+  unsigned int
+  GetReduction() const;
+  void
   SetRate(unsigned int, double);
   double
   GetRate(unsigned int = 0) const;
@@ -91,7 +95,9 @@ protected:
 
 private:
   std::pair<char *, size_t>
-  DecodeByStreamsCommon(char *, size_t);
+  DecodeByStreamsCommon(const char *, size_t, char * = nullptr, size_t = 0);
+  bool
+  DecodeToBuffer(const char *, size_t, char *, size_t, size_t &);
   bool
   CodeFrameIntoBuffer(char *, size_t, size_t &, const char *, size_t);
   bool
@@ -24,7 +24,6 @@
 
 #include "mdcmTrace.h"
 #include "mdcmTransferSyntax.h"
-#include "mdcmImageHelper.h"
 #include <csetjmp>
 
 /*
@@ -492,9 +491,9 @@ JPEGBITSCodec::GetHeaderInfoAndTS(std::istream & is, TransferSyntax & ts)
     // Initialize the JPEG decompression object.
     jpeg_create_decompress(&cinfo);
     int workaround = 0;
-    if (ImageHelper::GetWorkaroundPredictorBug())
+    if (Options.WorkaroundPredictorBug)
       workaround |= WORKAROUND_PREDICTOR6OVERFLOW;
-    if (ImageHelper::GetWorkaroundCornellBug())
+    if (Options.WorkaroundCornellBug)
       workaround |= WORKAROUND_BUGGY_CORNELL_16BIT_JPEG_ENCODER;
     if (workaround != 0)
       cinfo.workaround_options = workaround;
@@ -754,9 +753,9 @@ JPEGBITSCodec::DecodeByStreams(std::istream & is, std::ostream & os)
     // Initialize the JPEG decompression object.
     jpeg_create_decompress(&cinfo);
     volatile int workaround = 0;
-    if (ImageHelper::GetWorkaroundPredictorBug())
+    if (Options.WorkaroundPredictorBug)
       workaround = workaround | WORKAROUND_PREDICTOR6OVERFLOW;
-    if (ImageHelper::GetWorkaroundCornellBug())
+    if (Options.WorkaroundCornellBug)
       workaround = workaround | WORKAROUND_BUGGY_CORNELL_16BIT_JPEG_ENCODER;
     if (workaround != 0)
       cinfo.workaround_options = workaround;
@@ -867,7 +866,7 @@ JPEGBITSCodec::DecodeByStreams(std::istream & is, std::ostream & os)
         }
         break;
       case JCS_YCbCr:
-        if (ImageHelper::GetJpegPreserveYBRfull() &&
+        if (Options.JpegPreserveYBRfull &&
             (
              (GetPhotometricInterpretation() == PhotometricInterpretation::YBR_FULL_422) ||
              (GetPhotometricInterpretation() == PhotometricInterpretation::YBR_FULL) ||
@@ -28,6 +28,7 @@
 #include "mdcmJPEG8Codec.h"
 #include "mdcmJPEG12Codec.h"
 #include "mdcmJPEG16Codec.h"
+#include "mdcmMemoryStreamBuf.h"
 #include <numeric>
 #include <cstring>
 
@@ -67,151 +68,10 @@ JPEGCodec::CanCode(const TransferSyntax & ts) const
 bool
 JPEGCodec::Decode(const DataElement & in, DataElement & out)
 {
-  assert(Internal);
   out = in;
-  const SequenceOfFragments * sf0 = in.GetSequenceOfFragments();
-  const ByteValue *           jpegbv = in.GetByteValue();
-  if (!sf0 && !jpegbv)
-  {
-    mdcmAlwaysWarnMacro("JPEGCodec: !sf0 && !jpegbv");
-    return false;
-  }
   std::stringstream os;
-  if (sf0)
-  {
-    for (unsigned int i = 0; i < sf0->GetNumberOfFragments(); ++i)
-    {
-      std::stringstream is;
-      const Fragment &  frag = sf0->GetFragment(i);
-      if (frag.IsEmpty())
-      {
-        mdcmAlwaysWarnMacro("JPEGCodec: frag.IsEmpty()");
-        return false;
-      }
-      const ByteValue & bv = dynamic_cast<const ByteValue &>(frag.GetValue());
-      const size_t      bv_len = bv.GetLength();
-      char *            mybuffer;
-      try
-      {
-        mybuffer = new char[bv_len];
-      }
-      catch (const std::bad_alloc &)
-      {
-        return false;
-      }
-      const bool b = bv.GetBuffer(mybuffer, bv_len);
-      if (!b)
-      {
-        delete[] mybuffer;
-        return false;
-      }
-      is.write(mybuffer, bv_len);
-      delete[] mybuffer;
-      const bool r = DecodeByStreams(is, os);
-      // PHILIPS_Gyroscan-12-MONO2-Jpeg_Lossless.dcm
-      if (!r)
-      {
-        mdcmDebugMacro("JPEGCodec: failed to decompress Frag #" << i);
-        const bool   suspended = Internal->IsStateSuspension();
-        const size_t nfrags = sf0->GetNumberOfFragments();
-        // In case of chunked-jpeg, this is always an error
-        if (suspended)
-        {
-          mdcmAlwaysWarnMacro("JPEGCodec: suspended");
-          return false;
-        }
-        // Ok so we are decoding a multiple frame jpeg DICOM file:
-        // if we are lucky, we might be trying to decode some sort of broken multi-frame
-        // DICOM file. In this case check that we have read all Fragment properly:
-        if (i >= this->GetDimensions()[2])
-        {
-          // JPEGInvalidSecondFrag.dcm
-          assert(nfrags == this->GetNumberOfDimensions());
-          (void)nfrags;
-          mdcmAlwaysWarnMacro("JPEGCodec: invalid fragment found at #" << i + 1 << ", skipped");
-        }
-        else
-        {
-          return false;
-        }
-      }
-    }
-  }
-  else if (jpegbv)
-  {
-    // GEIIS Icon
-    std::stringstream is0;
-    const size_t      jpegbv_len = jpegbv->GetLength();
-    char *            mybuffer0;
-    try
-    {
-      mybuffer0 = new char[jpegbv_len];
-    }
-    catch (const std::bad_alloc &)
-    {
-      return false;
-    }
-    const bool b0 = jpegbv->GetBuffer(mybuffer0, jpegbv_len);
-    if (!b0)
-    {
-      delete[] mybuffer0;
-      return false;
-    }
-    is0.write(mybuffer0, jpegbv_len);
-    delete[] mybuffer0;
-    const bool r = DecodeByStreams(is0, os);
-    if (!r)
-    {
-      // Let's try another time: JPEGDefinedLengthSequenceOfFragments.dcm
-      is0.seekg(0);
-      SequenceOfFragments sf_bug;
-      try
-      {
-        sf_bug.Read<SwapperNoOp>(is0, true);
-      }
-      catch (...)
-      {
-        mdcmAlwaysWarnMacro("JPEGCodec: unknown exception");
-        return false;
-      }
-      const SequenceOfFragments * sf = &sf_bug;
-      for (unsigned int i = 0; i < sf->GetNumberOfFragments(); ++i)
-      {
-        std::stringstream is;
-        const Fragment &  frag = sf->GetFragment(i);
-        if (frag.IsEmpty())
-        {
-          mdcmAlwaysWarnMacro("JPEGCodec: frag.IsEmpty() (2)");
-          return false;
-        }
-        const ByteValue & bv = dynamic_cast<const ByteValue &>(frag.GetValue());
-        const size_t      bv_len = bv.GetLength();
-        char *            mybuffer;
-        try
-        {
-          mybuffer = new char[bv_len];
-        }
-        catch (const std::bad_alloc &)
-        {
-          return false;
-        }
-        const bool b = bv.GetBuffer(mybuffer, bv_len);
-        if (!b)
-        {
-          delete[] mybuffer;
-          return false;
-        }
-        is.write(mybuffer, bv_len);
-        delete[] mybuffer;
-        const bool r2 = DecodeByStreams(is, os);
-        if (!r2)
-        {
-          mdcmAlwaysWarnMacro("JPEGCodec: !r2");
-          return false;
-        }
-      }
-    }
-  }
+  if (!DecodeFragments(in, os))
+    return false;
   const unsigned long long sizeOfOs = os.tellp();
   if (sizeOfOs >= 0xffffffff)
   {
@@ -226,8 +86,29 @@ JPEGCodec::Decode(const DataElement & in, DataElement & out)
   return true;
 }
 
+// Decodes into 'out_buffer', only the first 'len' bytes if the data
+// are larger, the rest is zeroed if they are smaller.
 bool
-JPEGCodec::Decode2(const DataElement & in, std::stringstream & os)
+JPEGCodec::Decode2(const DataElement & in, char * out_buffer, size_t len)
+{
+  MemoryOutputStreamBuf sb(out_buffer, len);
+  std::ostream          os(&sb);
+  if (!DecodeFragments(in, os))
+    return false;
+  const unsigned long long len2 = sb.GetLength();
+  if (len != len2)
+  {
+    mdcmAlwaysWarnMacro("JPEGCodec::Decode2: len=" << len << " len2=" << len2);
+    if (len > len2)
+    {
+      memset(out_buffer + len2, 0, len - len2);
+    }
+  }
+  return true;
+}
+
+bool
+JPEGCodec::DecodeFragments(const DataElement & in, std::ostream & os)
 {
   assert(Internal);
   const SequenceOfFragments * sf0 = in.GetSequenceOfFragments();
@@ -241,8 +122,7 @@ JPEGCodec::Decode2(const DataElement & in, std::stringstream & os)
   {
     for (unsigned int i = 0; i < sf0->GetNumberOfFragments(); ++i)
     {
-      std::stringstream is;
-      const Fragment &  frag = sf0->GetFragment(i);
+      const Fragment & frag = sf0->GetFragment(i);
       if (frag.IsEmpty())
       {
         mdcmAlwaysWarnMacro("JPEGCodec: frag.IsEmpty()");
@@ -250,24 +130,9 @@ JPEGCodec::Decode2(const DataElement & in, std::stringstream & os)
       }
       const ByteValue & bv = dynamic_cast<const ByteValue &>(frag.GetValue());
       const size_t      bv_len = bv.GetLength();
-      char *            mybuffer;
-      try
-      {
-        mybuffer = new char[bv_len];
-      }
-      catch (const std::bad_alloc &)
-      {
-        return false;
-      }
-      const bool b = bv.GetBuffer(mybuffer, bv_len);
-      if (!b)
-      {
-        delete[] mybuffer;
-        return false;
-      }
-      is.write(mybuffer, bv_len);
-      delete[] mybuffer;
-      const bool r = DecodeByStreams(is, os);
+      MemoryStreamBuf   sb(bv.GetPointer(), bv_len);
+      std::istream      is(&sb);
+      const bool        r = DecodeByStreams(is, os);
       // PHILIPS_Gyroscan-12-MONO2-Jpeg_Lossless.dcm
       if (!r)
       {
@@ -300,26 +165,10 @@ JPEGCodec::Decode2(const DataElement & in, std::stringstream & os)
   else if (jpegbv)
   {
     // GEIIS Icon
-    std::stringstream is0;
     const size_t      jpegbv_len = jpegbv->GetLength();
-    char *            mybuffer0;
-    try
-    {
-      mybuffer0 = new char[jpegbv_len];
-    }
-    catch (const std::bad_alloc &)
-    {
-      return false;
-    }
-    const bool b0 = jpegbv->GetBuffer(mybuffer0, jpegbv_len);
-    if (!b0)
-    {
-      delete[] mybuffer0;
-      return false;
-    }
-    is0.write(mybuffer0, jpegbv_len);
-    delete[] mybuffer0;
-    const bool r = DecodeByStreams(is0, os);
+    MemoryStreamBuf   sb0(jpegbv->GetPointer(), jpegbv_len);
+    std::istream      is0(&sb0);
+    const bool        r = DecodeByStreams(is0, os);
     if (!r)
     {
       // Let's try another time: JPEGDefinedLengthSequenceOfFragments.dcm
@@ -337,8 +186,7 @@ JPEGCodec::Decode2(const DataElement & in, std::stringstream & os)
       const SequenceOfFragments * sf = &sf_bug;
       for (unsigned int i = 0; i < sf->GetNumberOfFragments(); ++i)
       {
-        std::stringstream is;
-        const Fragment &  frag = sf->GetFragment(i);
+        const Fragment & frag = sf->GetFragment(i);
         if (frag.IsEmpty())
         {
           mdcmAlwaysWarnMacro("JPEGCodec: frag.IsEmpty() (2)");
@@ -346,24 +194,9 @@ JPEGCodec::Decode2(const DataElement & in, std::stringstream & os)
         }
         const ByteValue & bv = dynamic_cast<const ByteValue &>(frag.GetValue());
         const size_t      bv_len = bv.GetLength();
-        char *            mybuffer;
-        try
-        {
-          mybuffer = new char[bv_len];
-        }
-        catch (const std::bad_alloc &)
-        {
-          return false;
-        }
-        const bool b = bv.GetBuffer(mybuffer, bv_len);
-        if (!b)
-        {
-          delete[] mybuffer;
-          return false;
-        }
-        is.write(mybuffer, bv_len);
-        delete[] mybuffer;
-        const bool r2 = DecodeByStreams(is, os);
+        MemoryStreamBuf   sb(bv.GetPointer(), bv_len);
+        std::istream      is(&sb);
+        const bool        r2 = DecodeByStreams(is, os);
         if (!r2)
         {
           mdcmAlwaysWarnMacro("JPEGCodec: !r2");
@@ -640,6 +473,14 @@ JPEGCodec::IsStateSuspension() const
   return false;
 }
 
+void
+JPEGCodec::SetDecodeOptions(const DecodeOptions & o)
+{
+  ImageCodec::SetDecodeOptions(o);
+  if (Internal)
+    Internal->SetDecodeOptions(o);
+}
+
 void
 JPEGCodec::SetupJPEGBitCodec(int b)
 {
@@ -665,6 +506,8 @@ JPEGCodec::SetupJPEGBitCodec(int b)
   {
     mdcmAlwaysWarnMacro("JPEGCodec: SetupJPEGBitCodec(" << b << ") failed");
   }
+  if (Internal)
+    Internal->SetDecodeOptions(Options);
 }
 
 } // end namespace mdcm
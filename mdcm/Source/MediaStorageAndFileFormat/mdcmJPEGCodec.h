@@ -49,7 +49,7 @@ public:
   bool
   Decode(const DataElement &, DataElement &) override;
   bool
-  Decode2(const DataElement &, std::stringstream &);
+  Decode2(const DataElement &, char *, size_t);
   bool
   Code(const DataElement &, DataElement &) override;
   void
@@ -70,6 +70,8 @@ public:
   GetLossless() const;
   virtual bool
   EncodeBuffer(std::ostream &, const char *, size_t);
+  void
+  SetDecodeOptions(const DecodeOptions &) override;
 
 protected:
   bool
@@ -100,6 +102,8 @@ protected:
   int Quality;
 
 private:
+  bool
+  DecodeFragments(const DataElement &, std::ostream &);
   void
   SetupJPEGBitCodec(int);
   JPEGCodec * Internal;
@@ -26,9 +26,9 @@
 #include "mdcmSwapper.h"
 #include <numeric>
 #include <cstring>
+#include <vector>
 #include "mdcm_charls.h"
 
-#define MDCM_JPEGLS_USE_RDBUF
 //#define MDCM_PRINT_JPEGLS_PARAMS
 
 namespace mdcm
@@ -49,28 +49,20 @@ JPEGLSCodec::CanCode(const TransferSyntax & ts) const
 bool
 JPEGLSCodec::Decode(const DataElement & in, DataElement & out)
 {
-  using namespace charls;
   if (NumberOfDimensions == 2)
   {
     const SequenceOfFragments * sf = in.GetSequenceOfFragments();
     if (!sf)
       return false;
-    const size_t totalLen = sf->ComputeByteLength();
-    char *       buffer;
-    try
-    {
-      buffer = new char[totalLen];
-    }
-    catch (const std::bad_alloc &)
-    {
+    std::vector<char>  tmp;
+    unsigned long long totalLen{};
+    const char *       buffer = sf->GetContiguousBuffer(tmp, totalLen);
+    if (!buffer)
       return false;
-    }
-    sf->GetBuffer(buffer, totalLen);
     std::vector<unsigned char> rgbyteOut;
     const bool                 b = DecodeByStreamsCommon(buffer, totalLen, rgbyteOut);
     if (!b)
       return false;
-    delete[] buffer;
     out = in;
     out.SetByteValue(reinterpret_cast<char *>(rgbyteOut.data()), static_cast<uint32_t>(rgbyteOut.size()));
     return true;
@@ -82,7 +74,7 @@ JPEGLSCodec::Decode(const DataElement & in, DataElement & out)
       return false;
     if (sf->GetNumberOfFragments() != Dimensions[2])
       return false;
-    std::stringstream os;
+    std::vector<char> str;
     for (unsigned int i = 0; i < sf->GetNumberOfFragments(); ++i)
     {
       const Fragment & frag = sf->GetFragment(i);
@@ -91,59 +83,23 @@ JPEGLSCodec::Decode(const DataElement & in, DataElement & out)
       const ByteValue * bv = frag.GetByteValue();
       if (!bv)
         return false;
-      size_t totalLen = bv->GetLength();
-      char * mybuffer;
+      const size_t totalLen = GetCodestreamLength(bv->GetPointer(), bv->GetLength());
+      const size_t frame_len = GetFrameLength(bv->GetPointer(), totalLen);
+      if (frame_len == 0)
+        return false;
+      const size_t offset = str.size();
       try
       {
-        mybuffer = new char[totalLen];
+        str.resize(offset + frame_len);
       }
       catch (const std::bad_alloc &)
       {
         return false;
       }
-      bv->GetBuffer(mybuffer, bv->GetLength());
-      const unsigned char * pbyteCompressed = reinterpret_cast<const unsigned char *>(mybuffer);
-      while (totalLen > 0 && pbyteCompressed[totalLen - 1] != 0xd9)
-      {
-        --totalLen;
-      }
-      assert(totalLen > 0 && pbyteCompressed[totalLen - 1] == 0xd9);
-      size_t        cbyteCompressed = totalLen;
-      JlsParameters params = {};
-      if (JpegLsReadHeader(pbyteCompressed, cbyteCompressed, &params, nullptr) != ApiResult::OK)
-      {
-        mdcmAlwaysWarnMacro("Could not parse JPEG-LS header");
-        return false;
-      }
-#ifdef MDCM_PRINT_JPEGLS_PARAMS
-      {
-        std::cout
-          << "\nwidth = " << params.width
-          << "\nheight = " << params.height
-          << "\nbitsPerSample = " << params.bitsPerSample
-          << "\nstride = " << params.stride
-          << "\ncomponents = " << params.components
-          << "\nallowedLossyError = " << params.allowedLossyError << std::endl;
-      }
-#endif
-      // allowedlossyerror == 0 => Lossless
-      LossyFlag = params.allowedLossyError != 0;
-      std::vector<unsigned char> rgbyteOut;
-      rgbyteOut.resize(
-        static_cast<size_t>(params.height) * params.width * ((params.bitsPerSample + 7) / 8) * params.components);
-      char charls_error[256]{};
-      ApiResult result =
-        JpegLsDecode(rgbyteOut.data(), rgbyteOut.size(), pbyteCompressed, cbyteCompressed, &params, charls_error);
-      delete[] mybuffer;
-      if (result != ApiResult::OK)
-      {
-        mdcmAlwaysWarnMacro("Could not decode JPEG-LS stream: " << static_cast<int>(result)
-                            << '\n' << charls_error);
+      size_t len2{};
+      if (!DecodeByStreamsCommon2(bv->GetPointer(), totalLen, str.data() + offset, frame_len, len2))
         return false;
-      }
-      os.write(reinterpret_cast<const char *>(rgbyteOut.data()), rgbyteOut.size());
     }
-    std::string str = os.str();
     assert(!str.empty());
     const unsigned long long str_size = str.size();
     if (str_size >= 0xffffffff)
@@ -160,27 +116,27 @@ JPEGLSCodec::Decode(const DataElement & in, DataElement & out)
 bool
 JPEGLSCodec::Decode2(const DataElement & in, char * out_buffer, size_t len)
 {
-  using namespace charls;
   if (NumberOfDimensions == 2)
   {
     const SequenceOfFragments * sf = in.GetSequenceOfFragments();
     if (!sf)
       return false;
-    const size_t totalLen = sf->ComputeByteLength();
-    char *       buffer;
-    try
-    {
-      buffer = new char[totalLen];
-    }
-    catch (const std::bad_alloc &)
-    {
+    std::vector<char>  tmp;
+    unsigned long long totalLen{};
+    const char *       buffer = sf->GetContiguousBuffer(tmp, totalLen);
+    if (!buffer)
       return false;
-    }
-    sf->GetBuffer(buffer, totalLen);
-    const bool b = DecodeByStreamsCommon2(buffer, totalLen, out_buffer, len);
-    if (!b)
+    size_t len2{};
+    if (!DecodeByStreamsCommon2(buffer, totalLen, out_buffer, len, len2))
       return false;
-    delete[] buffer;
+    if (len2 != len)
+    {
+      mdcmAlwaysWarnMacro("JPEGLSCodec::Decode2: len=" << len << " len2=" << len2);
+      if (len > len2)
+      {
+        memset(out_buffer + len2, 0, len - len2);
+      }
+    }
     return true;
   }
   else if (NumberOfDimensions == 3)
@@ -190,7 +146,7 @@ JPEGLSCodec::Decode2(const DataElement & in, char * out_buffer, size_t len)
       return false;
     if (sf->GetNumberOfFragments() != Dimensions[2])
       return false;
-    std::stringstream os;
+    size_t len2{};
     for (unsigned int i = 0; i < sf->GetNumberOfFragments(); ++i)
     {
       const Fragment & frag = sf->GetFragment(i);
@@ -199,94 +155,21 @@ JPEGLSCodec::Decode2(const DataElement & in, char * out_buffer, size_t len)
       const ByteValue * bv = frag.GetByteValue();
       if (!bv)
         return false;
-      size_t totalLen = bv->GetLength();
-      char * mybuffer;
-      try
-      {
-        mybuffer = new char[totalLen];
-      }
-      catch (const std::bad_alloc &)
-      {
+      const size_t totalLen = GetCodestreamLength(bv->GetPointer(), bv->GetLength());
+      const size_t offset = (len2 < len) ? len2 : len;
+      size_t       frame_len{};
+      if (!DecodeByStreamsCommon2(bv->GetPointer(), totalLen, out_buffer + offset, len - offset, frame_len))
         return false;
-      }
-      bv->GetBuffer(mybuffer, bv->GetLength());
-      const unsigned char * pbyteCompressed = reinterpret_cast<const unsigned char *>(mybuffer);
-      while (totalLen > 0 && pbyteCompressed[totalLen - 1] != 0xd9)
-      {
-        --totalLen;
-      }
-      assert(totalLen > 0 && pbyteCompressed[totalLen - 1] == 0xd9);
-      const size_t  cbyteCompressed = totalLen;
-      JlsParameters params = {};
-      if (JpegLsReadHeader(pbyteCompressed, cbyteCompressed, &params, nullptr) != ApiResult::OK)
-      {
-        mdcmAlwaysWarnMacro("Could not parse JPEG-LS header");
-        return false;
-      }
-#ifdef MDCM_PRINT_JPEGLS_PARAMS
-      {
-        std::cout
-          << "\nwidth = " << params.width
-          << "\nheight = " << params.height
-          << "\nbitsPerSample = " << params.bitsPerSample
-          << "\nstride = " << params.stride
-          << "\ncomponents = " << params.components
-          << "\nallowedLossyError = " << params.allowedLossyError << std::endl;
-      }
-#endif
-      // allowedlossyerror == 0 => Lossless
-      LossyFlag = params.allowedLossyError != 0;
-      const size_t tmp0_size =
-        static_cast<size_t>(params.height) * params.width * ((params.bitsPerSample + 7) / 8) * params.components;
-      char * tmp0;
-      try
-      {
-        tmp0 = new char[tmp0_size];
-      }
-      catch (const std::bad_alloc &)
-      {
-        delete[] mybuffer;
-        return false;
-      }
-      char charls_error[256]{};
-      ApiResult result = JpegLsDecode(tmp0, tmp0_size, pbyteCompressed, cbyteCompressed, &params, charls_error);
-      delete[] mybuffer;
-      if (result != ApiResult::OK)
-      {
-        mdcmAlwaysWarnMacro("Could not decode JPEG-LS stream: " << static_cast<int>(result)
-                            << '\n' << charls_error);
-        return false;
-      }
-      os.write(tmp0, tmp0_size);
-      delete[] tmp0;
+      len2 += frame_len;
     }
-    const size_t len2 = os.tellp();
     if (len2 != len)
     {
       mdcmAlwaysWarnMacro("JPEGLSCodec::Decode2: len=" << len << " len2=" << len2);
       if (len > len2)
       {
-        memset(out_buffer, 0, len);
+        memset(out_buffer + len2, 0, len - len2);
       }
     }
-#ifdef MDCM_JPEGLS_USE_RDBUF
-    std::stringbuf * pbuf = os.rdbuf();
-    const long long sgetn_s = pbuf->sgetn(out_buffer, ((len < len2) ? len : len2));
-#if 0
-    std::cout << "JPEGLSCodec: sizes should be the equal: " << len << " " << len2 << " " << sgetn_s << std::endl;
-#endif
-    if (sgetn_s <= 0)
-    {
-      mdcmAlwaysWarnMacro("JPEGLSCodec: pbuf->sgetn returned " << sgetn_s);
-    }
-#else
-    const std::string & tmp0 = os.str();
-    const char * tmp1 = tmp0.data();
-    memcpy(
-      out_buffer,
-      tmp1,
-      ((len < len2) ? len : len2));
-#endif
     return true;
   }
   return false;
@@ -532,8 +415,36 @@ JPEGLSCodec::DecodeByStreamsCommon(const char * buffer, size_t totalLen, std::ve
   return true;
 }
 
+// Length without trailing padding after EOI
+size_t
+JPEGLSCodec::GetCodestreamLength(const char * buffer, size_t totalLen)
+{
+  const unsigned char * p = reinterpret_cast<const unsigned char *>(buffer);
+  while (totalLen > 0 && p[totalLen - 1] != 0xd9)
+  {
+    --totalLen;
+  }
+  return totalLen;
+}
+
+// Decoded length from the header, 0 on error
+size_t
+JPEGLSCodec::GetFrameLength(const char * buffer, size_t totalLen)
+{
+  using namespace charls;
+  JlsParameters params = {};
+  if (JpegLsReadHeader(buffer, totalLen, &params, nullptr) != ApiResult::OK)
+  {
+    mdcmAlwaysWarnMacro("Could not parse JPEG-LS header");
+    return 0;
+  }
+  return static_cast<size_t>(params.height) * params.width * ((params.bitsPerSample + 7) / 8) * params.components;
+}
+
+// Decodes into 'out', only the first 'out_size' bytes if the frame
+// is larger, 'len' is the decoded length.
 bool
-JPEGLSCodec::DecodeByStreamsCommon2(const char * buffer, size_t totalLen, char * out, size_t out_size)
+JPEGLSCodec::DecodeByStreamsCommon2(const char * buffer, size_t totalLen, char * out, size_t out_size, size_t & len)
 {
   using namespace charls;
   const unsigned char * pbyteCompressed = reinterpret_cast<const unsigned char *>(buffer);
@@ -562,25 +473,33 @@ JPEGLSCodec::DecodeByStreamsCommon2(const char * buffer, size_t totalLen, char *
   }
   // allowedlossyerror == 0 => Lossless
   LossyFlag = params.allowedLossyError != 0;
-  const size_t out_size2 =
-    static_cast<size_t>(params.height) * params.width * ((params.bitsPerSample + 7) / 8) * params.components;
-  if (out_size != out_size2)
+  len = static_cast<size_t>(params.height) * params.width * ((params.bitsPerSample + 7) / 8) * params.components;
+  std::vector<char> tmp;
+  char *            dst = out;
+  if (out_size < len)
   {
-    mdcmAlwaysWarnMacro("DecodeByStreamsCommon2: out_size=" << out_size << " out_size2=" << out_size2);
+    try
+    {
+      tmp.resize(len);
+    }
+    catch (const std::bad_alloc &)
+    {
+      return false;
+    }
+    dst = tmp.data();
   }
-  char charls_error[256]{};
-  ApiResult result = JpegLsDecode(out,
-                                  (out_size > out_size2 ? out_size : out_size2),
-                                  pbyteCompressed,
-                                  cbyteCompressed,
-                                  &params,
-                                  charls_error);
+  char      charls_error[256]{};
+  ApiResult result = JpegLsDecode(dst, len, pbyteCompressed, cbyteCompressed, &params, charls_error);
   if (result != ApiResult::OK)
   {
     mdcmAlwaysWarnMacro("Could not decode JPEG-LS stream: " << static_cast<int>(result)
                         << '\n' << charls_error);
     return false;
   }
+  if (dst != out)
+  {
+    memcpy(out, dst, out_size);
+  }
   return true;
 }
 
@@ -78,7 +78,11 @@ private:
   bool
   DecodeByStreamsCommon(const char *, size_t, std::vector<unsigned char> &);
   bool
-  DecodeByStreamsCommon2(const char *, size_t, char *, size_t);
+  DecodeByStreamsCommon2(const char *, size_t, char *, size_t, size_t &);
+  static size_t
+  GetCodestreamLength(const char *, size_t);
+  static size_t
+  GetFrameLength(const char *, size_t);
   bool
   CodeFrameIntoBuffer(char *, size_t, size_t &, const char *, size_t);
   unsigned long long BufferLength{};
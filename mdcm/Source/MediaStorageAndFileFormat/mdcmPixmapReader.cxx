@@ -39,7 +39,9 @@
 namespace mdcm
 {
 
-PixmapReader::PixmapReader() : PixelData(new Pixmap)
+PixmapReader::PixmapReader()
+  : PixelData(new Pixmap)
+  , m_DecodeOptions(ImageHelper::GetDecodeOptions())
 {}
 
 void
@@ -90,6 +92,32 @@ PixmapReader::GetProcessCurves() const
   return m_ProcessCurves;
 }
 
+// Must be set before Read
+void
+PixmapReader::SetDeferPixelData(bool t)
+{
+  m_DeferPixelData = t;
+}
+
+bool
+PixmapReader::GetDeferPixelData() const
+{
+  return m_DeferPixelData;
+}
+
+// Must be set before Read
+void
+PixmapReader::SetDecodeOptions(const DecodeOptions & o)
+{
+  m_DecodeOptions = o;
+}
+
+const DecodeOptions &
+PixmapReader::GetDecodeOptions() const
+{
+  return m_DecodeOptions;
+}
+
 // Valid only after a call to Read
 const Pixmap &
 PixmapReader::GetPixmap() const
@@ -107,7 +135,21 @@ PixmapReader::GetPixmap()
 bool
 PixmapReader::Read()
 {
-  if (!Reader::Read())
+  m_Deferred = nullptr;
+  if (m_DeferPixelData)
+  {
+    m_Deferred = new DeferredPixelData;
+    if (!ReadUpToPixelData(*m_Deferred))
+    {
+      m_Deferred = nullptr;
+    }
+    else if (!CanDeferPixelData())
+    {
+      m_Deferred = nullptr;
+      ResetFile();
+    }
+  }
+  if (!m_Deferred && !Reader::Read())
   {
     return false;
   }
@@ -115,6 +157,7 @@ PixmapReader::Read()
   const DataSet &             ds = F->GetDataSet();
   const TransferSyntax &      ts = header.GetDataSetTransferSyntax();
   PixelData->SetTransferSyntax(ts);
+  PixelData->SetDecodeOptions(m_DecodeOptions);
   bool         res = false;
   MediaStorage ms = header.GetMediaStorage();
   bool         isImage = MediaStorage::IsImage(ms);
@@ -512,6 +555,36 @@ DoOverlays(const DataSet & ds, Pixmap & pixeldata)
   return true;
 }
 
+// Pixel Data is required while reading, e.g. for overlays in Pixel Data
+// or JPEG images without Columns and Rows, also for ACR-NEMA files.
+bool
+PixmapReader::CanDeferPixelData() const
+{
+  const DataSet & ds = F->GetDataSet();
+  if (F->GetHeader().IsEmpty())
+  {
+    return false;
+  }
+  const std::vector<unsigned int> vdims = ImageHelper::GetDimensionsValue(*F);
+  if (vdims[0] == 0 || vdims[1] == 0)
+  {
+    return false;
+  }
+  if (m_ProcessOverlays)
+  {
+    std::vector<uint16_t> overlaylist;
+    const unsigned int    numoverlays = GetNumberOfOverlaysInternal(ds, overlaylist);
+    for (unsigned int x = 0; x < numoverlays; ++x)
+    {
+      if (!ds.FindDataElement(Tag(overlaylist[x], 0x3000)))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 bool
 PixmapReader::ReadImageInternal(const MediaStorage & ms, bool handlepixeldata)
 {
@@ -549,7 +622,7 @@ PixmapReader::ReadImageInternal(const MediaStorage & ms, bool handlepixeldata)
     at.SetFromDataSet(ds);
     pf.SetSamplesPerPixel(at.GetValue());
   }
-  const bool pixeldata_ = ds.FindDataElement(pixeldata);
+  const bool pixeldata_ = m_Deferred || ds.FindDataElement(pixeldata);
   const bool pixeldatad_ = ds.FindDataElement(pixeldatad);
   const bool pixeldataf_ = ds.FindDataElement(pixeldataf);
   if (ms == MediaStorage::ParametricMapStorage)
@@ -852,7 +925,16 @@ PixmapReader::ReadImageInternal(const MediaStorage & ms, bool handlepixeldata)
   // PixelData
   if (handlepixeldata)
   {
-    if (pixeldata_)
+    if (m_Deferred)
+    {
+      // placeholder, Pixel Data is not in the data set
+      DataElement xde(pixeldata);
+      xde.SetVR(m_Deferred->GetVR());
+      PixelData->SetNeedByteSwap(false);
+      PixelData->SetDataElement(xde);
+      PixelData->SetDeferredPixelData(m_Deferred);
+    }
+    else if (pixeldata_)
     {
       const DataElement & xde = ds.GetDataElement(pixeldata);
       bool                need = PixelData->GetTransferSyntax() == TransferSyntax::ImplicitVRBigEndianPrivateGE;
@@ -932,6 +1014,32 @@ PixmapReader::ReadImageInternal(const MediaStorage & ms, bool handlepixeldata)
         return false;
       }
     }
+    // Frame index of encapsulated multi-frame images for Bitmap::GetFrameBuffer
+    if ((m_Deferred ? m_Deferred->IsEncapsulated() : PixelData->GetDataElement().GetSequenceOfFragments() != nullptr) &&
+        PixelData->GetNumberOfDimensions() > 2)
+    {
+      std::vector<unsigned long long> extended_offsets;
+      const Tag                       textendedoffsets(0x7fe0, 0x0001);
+      if (ds.FindDataElement(textendedoffsets))
+      {
+        const ByteValue * bv = ds.GetDataElement(textendedoffsets).GetByteValue();
+        if (bv && bv->GetLength() > 0 && bv->GetLength() % 8 == 0)
+        {
+          const unsigned char * p = reinterpret_cast<const unsigned char *>(bv->GetPointer());
+          extended_offsets.resize(bv->GetLength() / 8);
+          for (size_t x = 0; x < extended_offsets.size(); ++x)
+          {
+            unsigned long long o{};
+            for (unsigned int k = 0; k < 8; ++k)
+            {
+              o |= static_cast<unsigned long long>(p[8 * x + k]) << (8 * k);
+            }
+            extended_offsets[x] = o;
+          }
+        }
+      }
+      PixelData->ComputeFrameIndex(extended_offsets);
+    }
   }
   // LossyImageCompression
   Attribute<0x0028, 0x2110> licat;
@@ -39,6 +39,12 @@ class MediaStorage;
  * See PS 3.3-2008, Table C.7-11b IMAGE PIXEL MACRO ATTRIBUTES for the list of
  * attribute that belong to what mdcm calls a 'Pixmap'
  *
+ * With SetDeferPixelData, Pixel Data is not read, the pixmap reads the
+ * frames from the file when decoded (see DeferredPixelData), memory
+ * is used for the frames being decoded only. The data set has no
+ * Pixel Data and no elements after it then. Used if possible, e.g.
+ * not for deflated or big endian files, else the file is read.
+ *
  */
 class MDCM_EXPORT PixmapReader : public Reader
 {
@@ -61,6 +67,14 @@ public:
   SetProcessCurves(bool);
   bool
   GetProcessCurves() const;
+  void
+  SetDeferPixelData(bool);
+  bool
+  GetDeferPixelData() const;
+  void
+  SetDecodeOptions(const DecodeOptions &);
+  const DecodeOptions &
+  GetDecodeOptions() const;
   const Pixmap &
   GetPixmap() const;
   Pixmap &
@@ -75,11 +89,16 @@ protected:
   ReadImage(const MediaStorage &);
   virtual bool
   ReadACRNEMAImage();
-  SmartPointer<Pixmap> PixelData;
-  bool                 m_AlppySupplementalLUT{};
-  bool                 m_ProcessOverlays{true};
-  bool                 m_ProcessIcons{};
-  bool                 m_ProcessCurves{};
+  bool
+  CanDeferPixelData() const;
+  SmartPointer<Pixmap>            PixelData;
+  SmartPointer<DeferredPixelData> m_Deferred;
+  bool                            m_AlppySupplementalLUT{};
+  bool                            m_ProcessOverlays{true};
+  bool                            m_ProcessIcons{};
+  bool                            m_ProcessCurves{};
+  bool                            m_DeferPixelData{};
+  DecodeOptions                   m_DecodeOptions;
 };
 
 } // end namespace mdcm
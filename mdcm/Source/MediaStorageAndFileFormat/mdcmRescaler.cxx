@@ -23,6 +23,7 @@
 #include "mdcmRescaler.h"
 #include "mdcmTrace.h"
 #include "mdcmTypes.h"
+#include "mdcmPixelKernels.h"
 #include <limits>
 #include <cstring>
 #include <cmath>
@@ -43,6 +44,10 @@ RescaleFunction(TOut *       out,
     mdcmAlwaysWarnMacro("RescaleFunction: s % sizeof(TIn) != 0");
   }
   const size_t size = s / sizeof(TIn);
+  if (PixelKernels::Rescale(out, in, size, slope, intercept))
+  {
+    return;
+  }
   for (size_t i = 0; i < size; ++i)
   {
     out[i] = static_cast<TOut>(slope * in[i] + intercept);
@@ -30,6 +30,13 @@
 #include "mdcmProgressEvent.h"
 #include "mdcmFileNameEvent.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
 #include <utility>
 
 #define stringBinaryVR(type)                                \
@@ -135,61 +142,204 @@ Scanner::ClearTags()
   Tags.clear();
 }
 
+void
+Scanner::SetNumberOfThreads(unsigned int n)
+{
+  NumberOfThreads = n;
+}
+
+unsigned int
+Scanner::GetNumberOfThreads() const
+{
+  return NumberOfThreads;
+}
+
+void
+Scanner::SetProgressCallback(const ProgressCallback & c)
+{
+  Callback = c;
+}
+
 bool
 Scanner::Scan(const std::vector<std::string> & filenames, const Dict & dict)
 {
   this->InvokeEvent(StartEvent());
+  bool completed{true};
   if (!Tags.empty())
   {
     Mappings.clear();
     TagToValue d0;
     Mappings[""] = std::move(d0);
-    const size_t filenames_size = filenames.size();
-    Filenames.clear();
-    for (size_t x = 0; x < filenames_size; ++x)
+    Filenames = filenames;
+    // Find the tag with the highest value (get the one from the end of the std::set)
+    const Tag last = *Tags.crbegin();
+    Progress = 0.0;
+    size_t threads = NumberOfThreads;
+    if (threads == 0)
     {
-      Filenames.push_back(filenames.at(x));
+      threads = std::thread::hardware_concurrency();
     }
-    // Find the tag with the highest value (get the one from the end of the std::set)
-    Tag last;
-    if (!Tags.empty())
+    if (threads > Filenames.size())
     {
-      TagsType::const_reverse_iterator it1 = Tags.rbegin();
-      const Tag &                      publiclast = *it1;
-      last = publiclast;
+      threads = Filenames.size();
     }
-    Progress = 0.0;
-    const double progresstick =
-      (filenames_size > 0) ? 1.0 / static_cast<double>(filenames_size) : 0.0;
-    for (std::vector<std::string>::const_iterator it = Filenames.cbegin(); it != Filenames.cend(); ++it)
+    completed = (threads > 1) ? ScanParallel(last, dict, static_cast<unsigned int>(threads)) : ScanSerial(last, dict);
+  }
+  this->InvokeEvent(EndEvent());
+  return completed;
+}
+
+bool
+Scanner::ScanSerial(const Tag & last, const Dict & dict)
+{
+  const size_t total = Filenames.size();
+  const double progresstick = (total > 0) ? 1.0 / static_cast<double>(total) : 0.0;
+  FileValues   values;
+  for (size_t x = 0; x < total; ++x)
+  {
+    const char * filename = Filenames[x].c_str();
+    if (ReadFile(filename, last, dict, values))
     {
-      Reader       reader;
-      const char * filename = it->c_str();
-      assert(filename);
-      reader.SetFileName(filename);
-      bool read{};
+      AddValues(filename, values);
+    }
+    Progress += progresstick;
+    ProgressEvent pe;
+    pe.SetProgress(Progress);
+    this->InvokeEvent(pe);
+    FileNameEvent fe(filename);
+    this->InvokeEvent(fe);
+    if (Callback && !Callback(x + 1, total))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The calling thread merges the values, invokes the events and the
+// callback file by file in the order of the files, as ScanSerial does,
+// as soon as all files before are read.
+bool
+Scanner::ScanParallel(const Tag & last, const Dict & dict, unsigned int threads)
+{
+  const size_t            total = Filenames.size();
+  std::vector<FileValues> results(total);
+  // 0 - not read yet, 1 - read, 2 - failed
+  std::unique_ptr<std::atomic<unsigned char>[]> states(new std::atomic<unsigned char>[total]);
+  for (size_t x = 0; x < total; ++x)
+  {
+    states[x] = 0;
+  }
+  std::atomic<size_t>       next{};
+  std::atomic<unsigned int> running{};
+  std::atomic<bool>         cancel{};
+  std::mutex                mutex;
+  std::condition_variable   cv;
+  auto                      work = [&]() {
+    for (size_t x = next++; x < total && !cancel; x = next++)
+    {
+      unsigned char state{2};
       try
       {
-        read = reader.ReadUpToTag(last);
+        if (ReadFile(Filenames[x].c_str(), last, dict, results[x]))
+        {
+          state = 1;
+        }
       }
       catch (...)
       {
-        mdcmAlwaysWarnMacro("Failed to read:" << filename);
+        mdcmAlwaysWarnMacro("Failed to scan:" << Filenames[x]);
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        states[x] = state;
       }
-      if (read)
+      cv.notify_one();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --running;
+    }
+    cv.notify_one();
+  };
+  std::vector<std::thread> pool;
+  try
+  {
+    for (unsigned int x = 0; x < threads; ++x)
+    {
+      ++running;
+      pool.emplace_back(work);
+    }
+  }
+  catch (const std::system_error &)
+  {
+    // continue with the threads started
+    --running;
+  }
+  if (pool.empty())
+  {
+    return ScanSerial(last, dict);
+  }
+  const double progresstick = 1.0 / static_cast<double>(total);
+  size_t       x{};
+  while (x < total && !cancel)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait_for(lock, std::chrono::milliseconds(100), [&]() { return states[x] != 0 || running == 0; });
+    }
+    for (; x < total && !cancel && states[x] != 0; ++x)
+    {
+      const char * filename = Filenames[x].c_str();
+      if (states[x] == 1)
       {
-        const File & file = reader.GetFile();
-        ProcessPublicTag(filename, file, dict);
+        AddValues(filename, results[x]);
       }
+      FileValues().swap(results[x]);
       Progress += progresstick;
       ProgressEvent pe;
       pe.SetProgress(Progress);
       this->InvokeEvent(pe);
       FileNameEvent fe(filename);
       this->InvokeEvent(fe);
+      if (Callback && !Callback(x + 1, total))
+      {
+        cancel = true;
+      }
+    }
+    if (running == 0 && x < total && states[x] == 0)
+    {
+      // not expected, all threads finished
+      break;
     }
   }
-  this->InvokeEvent(EndEvent());
+  for (size_t k = 0; k < pool.size(); ++k)
+  {
+    pool[k].join();
+  }
+  return !cancel;
+}
+
+// Thread-safe, may be called in parallel
+bool
+Scanner::ReadFile(const char * filename, const Tag & last, const Dict & dict, FileValues & values) const
+{
+  values.clear();
+  assert(filename);
+  Reader reader;
+  reader.SetFileName(filename);
+  bool read{};
+  try
+  {
+    read = reader.ReadUpToTag(last);
+  }
+  catch (...)
+  {
+    mdcmAlwaysWarnMacro("Failed to read:" << filename);
+  }
+  if (!read)
+    return false;
+  CollectValues(reader.GetFile(), dict, values);
   return true;
 }
 
@@ -352,9 +502,14 @@ Scanner::GetMappingFromTagToValue(const Tag & t, const char * valueref) const
 void
 Scanner::ProcessPublicTag(const char * filename, const File & file, const Dict & dict)
 {
-  if (!(filename && *filename))
-    return;
-  TagToValue &                 mapping = Mappings[filename];
+  FileValues values;
+  CollectValues(file, dict, values);
+  AddValues(filename, values);
+}
+
+void
+Scanner::CollectValues(const File & file, const Dict & dict, FileValues & values) const
+{
   const DataSet &              ds = file.GetDataSet();
   const FileMetaInformation &  header = file.GetHeader();
   const mdcm::TransferSyntax & ts = header.GetDataSetTransferSyntax();
@@ -366,12 +521,7 @@ Scanner::ProcessPublicTag(const char * filename, const File & file, const Dict &
       if (header.FindDataElement(*tag))
       {
         const DataElement & de = header.GetDataElement(*tag);
-        std::string         s(GetString(de, header, implicit, dict));
-        Values.insert(s);
-        if (Values.find(s) != Values.end())
-        {
-          mapping.insert(TagToValue::value_type(*tag, Values.find(s)->c_str()));
-        }
+        values.push_back(FileValues::value_type(*tag, GetString(de, header, implicit, dict)));
       }
     }
     else
@@ -379,17 +529,26 @@ Scanner::ProcessPublicTag(const char * filename, const File & file, const Dict &
       if (ds.FindDataElement(*tag))
       {
         const DataElement & de = ds.GetDataElement(*tag);
-        std::string         s(GetString(de, ds, implicit, dict));
-        Values.insert(s);
-        if (Values.find(s) != Values.end())
-        {
-          mapping.insert(TagToValue::value_type(*tag, Values.find(s)->c_str()));
-        }
+        values.push_back(FileValues::value_type(*tag, GetString(de, ds, implicit, dict)));
       }
     }
   }
 }
 
+// The strings are stored once in Values, shared by all files
+void
+Scanner::AddValues(const char * filename, const FileValues & values)
+{
+  if (!(filename && *filename))
+    return;
+  TagToValue & mapping = Mappings[filename];
+  for (FileValues::const_iterator it = values.cbegin(); it != values.cend(); ++it)
+  {
+    ValuesType::const_iterator v = Values.insert(it->second).first;
+    mapping.insert(TagToValue::value_type(it->first, v->c_str()));
+  }
+}
+
 #if 0
 void Scanner::Print(std::ostream & os) const
 {
@@ -34,6 +34,8 @@
 #include <vector>
 #include <string>
 #include <cstring>
+#include <functional>
+#include <utility>
 
 namespace mdcm
 {
@@ -46,6 +48,11 @@ namespace mdcm
  * IMPORTANT In case of file where tags are not ordered (illegal as
  * per DICOM specification), the output will be missing information.
  *
+ * With more than one thread, see SetNumberOfThreads(), the files are
+ * read by a pool of threads. The values are merged in the calling
+ * thread, in the order of the files, and the events and the progress
+ * callback are invoked there for every file, read or not, as serial.
+ *
  */
 class MDCM_EXPORT Scanner : public Subject
 {
@@ -78,10 +85,22 @@ public:
   typedef MappingType::const_iterator               ConstIterator;
   typedef std::set<std::string>                     ValuesType;
   typedef std::set<Tag>                             TagsType;
+  // Called with the number of files processed and the total number,
+  // returning false cancels the scan.
+  typedef std::function<bool(size_t, size_t)> ProgressCallback;
   void
   AddTag(const Tag &);
   void
   ClearTags();
+  // 0 - all processors, default 1
+  void
+  SetNumberOfThreads(unsigned int);
+  unsigned int
+  GetNumberOfThreads() const;
+  void
+  SetProgressCallback(const ProgressCallback &);
+  // Returns false if the scan was canceled, the files
+  // processed up to the cancel are in the mappings.
   bool
   Scan(const std::vector<std::string> &, const Dict &);
   const std::vector<std::string> &
@@ -134,12 +153,26 @@ protected:
   ProcessPublicTag(const char *, const File &, const Dict &);
 
 private:
+  typedef std::vector<std::pair<Tag, std::string>> FileValues;
+  bool
+  ReadFile(const char *, const Tag &, const Dict &, FileValues &) const;
+  void
+  CollectValues(const File &, const Dict &, FileValues &) const;
+  void
+  AddValues(const char *, const FileValues &);
+  bool
+  ScanSerial(const Tag &, const Dict &);
+  bool
+  ScanParallel(const Tag &, const Dict &, unsigned int);
+
   std::set<Tag>            Tags{};
   ValuesType               Values{};
   std::vector<std::string> Filenames{};
   MappingType              Mappings{};
   double                   Progress{};
   const TagToValue         NoOpTagToValue{};
+  unsigned int             NumberOfThreads{1};
+  ProgressCallback         Callback{};
 };
 
 } // end namespace mdcm
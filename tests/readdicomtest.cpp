@@ -0,0 +1,95 @@
+#include "testutils.h"
+#include "dicomutils.h"
+#include "settingswidget.h"
+#include "structures.h"
+#include <memory>
+#include <vector>
+
+// Files are given in a shuffled order, read_dicom() sorts them by
+// Image Position (Patient) with the values of its first reading,
+// each file is read twice, by read_dicom() and read_series().
+QString test_read_dicom_sorted()
+{
+	const unsigned short rows = 3;
+	const unsigned short columns = 4;
+	const int order[] = { 3, 0, 4, 2, 1 };
+	const int n = sizeof(order) / sizeof(order[0]);
+	const QString dir = TestUtils::make_temp_dir(QString("read_dicom_sorted"));
+	QStringList files;
+	for (int j = 0; j < n; ++j)
+	{
+		const int z = order[j];
+		std::vector<unsigned short> pixels(rows * columns);
+		for (size_t x = 0; x < pixels.size(); ++x)
+		{
+			pixels[x] = static_cast<unsigned short>(z * 1000 + x);
+		}
+		const QString f = dir + QString("/") + QString::number(j) + QString(".dcm");
+		if (!TestUtils::write_mr_slice(
+				f, QString("1.2.826.0.1.3680043.2.1143.2"), j + 1,
+				rows, columns, z * 2.5, pixels))
+		{
+			TestUtils::remove_temp_dir(dir);
+			return QString("can not write ") + f;
+		}
+		files.push_back(f);
+	}
+	std::unique_ptr<SettingsWidget> settings(new SettingsWidget(1.0f));
+	std::vector<ImageVariant*> ivariants;
+	QStringList pdf_files;
+	QStringList stl_files;
+	QStringList video_files;
+	QStringList spectroscopy_files;
+	QStringList sr_files;
+	const unsigned long long files_read_0 = DicomUtils::get_files_read();
+	const QString message = DicomUtils::read_dicom(
+		ivariants,
+		pdf_files,
+		stl_files,
+		video_files,
+		spectroscopy_files,
+		sr_files,
+		dir,
+		files,
+		false,
+		settings.get(),
+		0,
+		0);
+	const unsigned long long files_read =
+		DicomUtils::get_files_read() - files_read_0;
+	TestUtils::remove_temp_dir(dir);
+	QString error;
+	if (ivariants.size() != 1)
+	{
+		error = QString("read_dicom(): ") + QString::number(ivariants.size()) +
+			QString(" image(s) ") + message;
+	}
+	else if (files_read != 2ULL * n)
+	{
+		error = QString::number(files_read) + QString(" reads of ") +
+			QString::number(n) + QString(" files");
+	}
+	else if (ivariants.at(0)->pUS.IsNull() || ivariants.at(0)->di->idimz != n)
+	{
+		error = QString("not a volume of ") + QString::number(n) + QString(" slices");
+	}
+	else
+	{
+		const unsigned short * p = ivariants.at(0)->pUS->GetBufferPointer();
+		for (int z = 0; z < n; ++z)
+		{
+			const unsigned short v = p[z * rows * columns];
+			if (v != z * 1000)
+			{
+				error = QString("slice ") + QString::number(z) +
+					QString(" is not sorted, value ") + QString::number(v);
+				break;
+			}
+		}
+	}
+	for (size_t x = 0; x < ivariants.size(); ++x)
+	{
+		delete ivariants[x];
+	}
+	return error;
+}
@@ -0,0 +1,101 @@
+#include "testutils.h"
+#include "dicomutils.h"
+#include "commonutils.h"
+#include "settingswidget.h"
+#include "structures.h"
+#include <memory>
+
+namespace
+{
+
+// The slices are loaded into one volume in file order,
+// pixel value is slice * 1000 + index in slice.
+QString read_series_test(const QString & name, const int n)
+{
+	const unsigned short rows = 3;
+	const unsigned short columns = 4;
+	const QString dir = TestUtils::make_temp_dir(name);
+	QStringList files;
+	for (int j = 0; j < n; ++j)
+	{
+		std::vector<unsigned short> pixels(rows * columns);
+		for (size_t x = 0; x < pixels.size(); ++x)
+		{
+			pixels[x] = static_cast<unsigned short>(j * 1000 + x);
+		}
+		const QString f = dir + QString("/") + QString::number(j) + QString(".dcm");
+		if (!TestUtils::write_mr_slice(
+				f, QString("1.2.826.0.1.3680043.2.1143.1"), j + 1,
+				rows, columns, j * 2.5, pixels))
+		{
+			TestUtils::remove_temp_dir(dir);
+			return QString("can not write ") + f;
+		}
+		files.push_back(f);
+	}
+	std::unique_ptr<SettingsWidget> settings(new SettingsWidget(1.0f));
+	std::unique_ptr<ImageVariant> ivariant(
+		new ImageVariant(CommonUtils::get_next_id(), false, true, nullptr, 0));
+	bool ok{};
+	const QString message = DicomUtils::read_series(
+		&ok,
+		false,
+		false,
+		false,
+		false,
+		ivariant.get(),
+		files,
+		false,
+		settings.get(),
+		0.01f,
+		true);
+	TestUtils::remove_temp_dir(dir);
+	if (!ok) return QString("read_series(): ") + message;
+	if (ivariant->di->idimx != columns ||
+		ivariant->di->idimy != rows ||
+		ivariant->di->idimz != n)
+	{
+		return QString("wrong dimensions ") +
+			QString::number(ivariant->di->idimx) + QString("x") +
+			QString::number(ivariant->di->idimy) + QString("x") +
+			QString::number(ivariant->di->idimz);
+	}
+	if (ivariant->pUS.IsNull()) return QString("not an unsigned short image");
+	const unsigned short * p = ivariant->pUS->GetBufferPointer();
+	for (int j = 0; j < n; ++j)
+	{
+		for (int x = 0; x < rows * columns; ++x)
+		{
+			const unsigned short v = p[j * rows * columns + x];
+			if (v != j * 1000 + x)
+			{
+				return QString("wrong pixel value ") + QString::number(v) +
+					QString(" in slice ") + QString::number(j);
+			}
+		}
+	}
+	return QString("");
+}
+
+}
+
+QString test_read_series_2_files()
+{
+	return read_series_test(QString("read_series_2_files"), 2);
+}
+
+// More than 2 files, slices are decoded in a pool.
+QString test_read_series_parallel()
+{
+	return read_series_test(QString("read_series_parallel"), 9);
+}
+
+// Files are read through a memory mapping.
+QString test_read_series_mapped()
+{
+	DicomUtils::set_memory_mapping(true);
+	const QString error = read_series_test(QString("read_series_mapped"), 9);
+	DicomUtils::set_memory_mapping(false);
+	return error;
+}
+
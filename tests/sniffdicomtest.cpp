@@ -0,0 +1,110 @@
+#include "testutils.h"
+#include "dicomutils.h"
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+// Element of a data set without preamble and meta information,
+// little endian, 'length' may be more than the size of 'v'.
+void append_element(
+	std::string & s,
+	const unsigned short group,
+	const unsigned short element,
+	const char * vr,
+	const std::string & v,
+	const bool explicit_vr,
+	const unsigned int length)
+{
+	s.push_back(static_cast<char>(group & 0xff));
+	s.push_back(static_cast<char>(group >> 8));
+	s.push_back(static_cast<char>(element & 0xff));
+	s.push_back(static_cast<char>(element >> 8));
+	const std::string vr_(vr);
+	const bool long_vr = (vr_ == "OB" || vr_ == "OW" || vr_ == "SQ" || vr_ == "UN");
+	if (explicit_vr)
+	{
+		s.append(vr_);
+		if (long_vr) s.append(2, '\0');
+	}
+	if (!explicit_vr || long_vr)
+	{
+		s.push_back(static_cast<char>(length & 0xff));
+		s.push_back(static_cast<char>((length >> 8) & 0xff));
+		s.push_back(static_cast<char>((length >> 16) & 0xff));
+		s.push_back(static_cast<char>((length >> 24) & 0xff));
+	}
+	else
+	{
+		s.push_back(static_cast<char>(length & 0xff));
+		s.push_back(static_cast<char>((length >> 8) & 0xff));
+	}
+	s.append(v);
+}
+
+void append_element(
+	std::string & s,
+	const unsigned short group,
+	const unsigned short element,
+	const char * vr,
+	const std::string & v,
+	const bool explicit_vr)
+{
+	append_element(s, group, element, vr, v, explicit_vr, static_cast<unsigned int>(v.size()));
+}
+
+// MR image, 2x2, 16 bits
+std::string make_data_set(const bool explicit_vr)
+{
+	std::string s;
+	append_element(s, 0x0008, 0x0016, "UI", std::string("1.2.840.10008.5.1.4.1.1.4\0", 26), explicit_vr);
+	append_element(s, 0x0008, 0x0060, "CS", "MR", explicit_vr);
+	append_element(s, 0x0010, 0x0010, "PN", "Test^Sniff", explicit_vr);
+	append_element(s, 0x0028, 0x0010, "US", std::string("\2\0", 2), explicit_vr);
+	append_element(s, 0x0028, 0x0011, "US", std::string("\2\0", 2), explicit_vr);
+	append_element(s, 0x7fe0, 0x0010, "OW", std::string(8, '\1'), explicit_vr);
+	return s;
+}
+
+QString check_sniff(const std::string & s, const bool expected)
+{
+	std::istringstream is(s);
+	const bool dicom = DicomUtils::is_dicom_stream(is);
+	if (dicom != expected)
+	{
+		return QString("is_dicom_stream() returned ") +
+			(dicom ? QString("true") : QString("false"));
+	}
+	return QString("");
+}
+
+}
+
+QString test_sniff_explicit_vr()
+{
+	const QString e = check_sniff(make_data_set(true), true);
+	if (!e.isEmpty()) return e;
+	// not a data set
+	return check_sniff(std::string("Not a DICOM file, only some text."), false);
+}
+
+QString test_sniff_implicit_vr()
+{
+	return check_sniff(make_data_set(false), true);
+}
+
+// Pixel Data ends after the end of the file, headers before are valid.
+QString test_sniff_truncated()
+{
+	std::string s;
+	append_element(s, 0x0008, 0x0016, "UI", std::string("1.2.840.10008.5.1.4.1.1.4\0", 26), true);
+	append_element(s, 0x0008, 0x0060, "CS", "MR", true);
+	append_element(s, 0x7fe0, 0x0010, "OW", std::string(16, '\1'), true, 512 * 512 * 2);
+	const QString e = check_sniff(s, true);
+	if (!e.isEmpty()) return e;
+	// the first element must fit in the file
+	std::string s1;
+	append_element(s1, 0x0008, 0x0016, "UI", std::string("1.2.840", 8), true, 26);
+	return check_sniff(s1, false);
+}
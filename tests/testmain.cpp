@@ -0,0 +1,62 @@
+#include <QtGlobal>
+#include <QApplication>
+#include <QString>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "testutils.h"
+
+// Runs the test given as argument, see add_test() in CMakeLists.txt.
+
+namespace
+{
+
+struct TestCase
+{
+	const char * name;
+	QString (*run)();
+};
+
+const TestCase test_cases[] =
+{
+	{ "read_series_2_files", test_read_series_2_files },
+	{ "read_series_parallel", test_read_series_parallel },
+	{ "read_series_mapped", test_read_series_mapped },
+	{ "read_dicom_sorted", test_read_dicom_sorted },
+	{ "sniff_explicit_vr", test_sniff_explicit_vr },
+	{ "sniff_implicit_vr", test_sniff_implicit_vr },
+	{ "sniff_truncated", test_sniff_truncated },
+	{ "window_lut_float", test_window_lut_float },
+	{ "window_lut_double", test_window_lut_double }
+};
+
+}
+
+int main(int argc, char * argv[])
+{
+	if (argc != 2)
+	{
+		std::cout << "Usage: alizams_tests <test>" << std::endl;
+		return 1;
+	}
+#if (QT_VERSION >= QT_VERSION_CHECK(5,0,0))
+#ifndef _WIN32
+	setenv("QT_QPA_PLATFORM", "offscreen", 1);
+#endif
+#endif
+	QApplication app(argc, argv);
+	for (const TestCase & t : test_cases)
+	{
+		if (strcmp(argv[1], t.name) != 0) continue;
+		const QString error = t.run();
+		if (!error.isEmpty())
+		{
+			std::cout << t.name << ": " << error.toStdString() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+	std::cout << "Unknown test " << argv[1] << std::endl;
+	return 1;
+}
+
@@ -0,0 +1,122 @@
+#include "testutils.h"
+#include <QDir>
+#include <QFile>
+#include <QCoreApplication>
+#include <mdcmDataSet.h>
+#include <mdcmDataElement.h>
+#include <mdcmFile.h>
+#include <mdcmFileMetaInformation.h>
+#include <mdcmTransferSyntax.h>
+#include <mdcmUIDGenerator.h>
+#include <mdcmWriter.h>
+#include <string>
+
+namespace
+{
+
+void insert_string(
+	mdcm::DataSet & ds,
+	const mdcm::Tag & t,
+	const mdcm::VR & vr,
+	const std::string & s)
+{
+	std::string v(s);
+	if (v.size() % 2 != 0) v.push_back((vr == mdcm::VR::UI) ? '\0' : ' ');
+	mdcm::DataElement e(t);
+	e.SetVR(vr);
+	e.SetByteValue(v.c_str(), static_cast<uint32_t>(v.size()));
+	ds.Insert(e);
+}
+
+void insert_us(mdcm::DataSet & ds, const mdcm::Tag & t, const unsigned short x)
+{
+	const char v[2] =
+	{
+		static_cast<char>(x & 0xff),
+		static_cast<char>((x >> 8) & 0xff)
+	};
+	mdcm::DataElement e(t);
+	e.SetVR(mdcm::VR::US);
+	e.SetByteValue(v, 2);
+	ds.Insert(e);
+}
+
+}
+
+QString TestUtils::make_temp_dir(const QString & name)
+{
+	const QString p =
+		QDir::tempPath() +
+		QString("/alizams_tests_") +
+		QString::number(QCoreApplication::applicationPid()) +
+		QString("_") +
+		name;
+	remove_temp_dir(p);
+	QDir().mkpath(p);
+	return p;
+}
+
+void TestUtils::remove_temp_dir(const QString & p)
+{
+	QDir dir(p);
+	if (!dir.exists()) return;
+	const QStringList l = dir.entryList(QDir::Files);
+	for (int x = 0; x < l.size(); ++x)
+	{
+		QFile::remove(p + QString("/") + l.at(x));
+	}
+	QDir().rmdir(p);
+}
+
+bool TestUtils::write_mr_slice(
+	const QString & f,
+	const QString & series_uid,
+	const int instance,
+	const unsigned short rows,
+	const unsigned short columns,
+	const double z,
+	const std::vector<unsigned short> & pixels)
+{
+	if (pixels.size() != static_cast<size_t>(rows) * columns) return false;
+	mdcm::UIDGenerator g;
+	mdcm::Writer writer;
+	mdcm::DataSet & ds = writer.GetFile().GetDataSet();
+	insert_string(ds, mdcm::Tag(0x0008,0x0016), mdcm::VR::UI, "1.2.840.10008.5.1.4.1.1.4");
+	insert_string(ds, mdcm::Tag(0x0008,0x0018), mdcm::VR::UI, g.Generate());
+	insert_string(ds, mdcm::Tag(0x0008,0x0060), mdcm::VR::CS, "MR");
+	insert_string(ds, mdcm::Tag(0x0010,0x0010), mdcm::VR::PN, "Test^Series");
+	insert_string(ds, mdcm::Tag(0x0020,0x000d), mdcm::VR::UI, series_uid.toStdString() + ".1");
+	insert_string(ds, mdcm::Tag(0x0020,0x000e), mdcm::VR::UI, series_uid.toStdString());
+	insert_string(ds, mdcm::Tag(0x0020,0x0013), mdcm::VR::IS, std::to_string(instance));
+	insert_string(
+		ds, mdcm::Tag(0x0020,0x0032), mdcm::VR::DS,
+		(QString("0\\0\\") + QString::number(z)).toStdString());
+	insert_string(ds, mdcm::Tag(0x0020,0x0037), mdcm::VR::DS, "1\\0\\0\\0\\1\\0");
+	insert_us(ds, mdcm::Tag(0x0028,0x0002), 1);
+	insert_string(ds, mdcm::Tag(0x0028,0x0004), mdcm::VR::CS, "MONOCHROME2");
+	insert_us(ds, mdcm::Tag(0x0028,0x0010), rows);
+	insert_us(ds, mdcm::Tag(0x0028,0x0011), columns);
+	insert_string(ds, mdcm::Tag(0x0028,0x0030), mdcm::VR::DS, "1\\1");
+	insert_us(ds, mdcm::Tag(0x0028,0x0100), 16);
+	insert_us(ds, mdcm::Tag(0x0028,0x0101), 16);
+	insert_us(ds, mdcm::Tag(0x0028,0x0102), 15);
+	insert_us(ds, mdcm::Tag(0x0028,0x0103), 0);
+	{
+		std::string v;
+		v.reserve(pixels.size() * 2);
+		for (size_t x = 0; x < pixels.size(); ++x)
+		{
+			v.push_back(static_cast<char>(pixels[x] & 0xff));
+			v.push_back(static_cast<char>((pixels[x] >> 8) & 0xff));
+		}
+		mdcm::DataElement e(mdcm::Tag(0x7fe0,0x0010));
+		e.SetVR(mdcm::VR::OW);
+		e.SetByteValue(v.c_str(), static_cast<uint32_t>(v.size()));
+		ds.Insert(e);
+	}
+	writer.GetFile().GetHeader().SetDataSetTransferSyntax(
+		mdcm::TransferSyntax::ExplicitVRLittleEndian);
+	writer.SetFileName(QFile::encodeName(f).constData());
+	return writer.Write();
+}
+
@@ -0,0 +1,38 @@
+#ifndef A_TESTUTILS_H
+#define A_TESTUTILS_H
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+// Helpers of the tests, see testmain.cpp. A test returns
+// an empty string on success, else the error.
+class TestUtils
+{
+public:
+	// Directory for files of one test, created empty.
+	static QString make_temp_dir(const QString&);
+	static void remove_temp_dir(const QString&);
+	// Single-frame MR image, 16 bits unsigned, Explicit VR Little Endian,
+	// axial, z is the 3rd component of Image Position (Patient).
+	static bool write_mr_slice(
+		const QString&,
+		const QString&, // series instance UID
+		const int,      // instance number
+		const unsigned short, const unsigned short, // rows, columns
+		const double,
+		const std::vector<unsigned short>&);
+};
+
+QString test_read_series_2_files();
+QString test_read_series_parallel();
+QString test_read_series_mapped();
+QString test_read_dicom_sorted();
+QString test_sniff_explicit_vr();
+QString test_sniff_implicit_vr();
+QString test_sniff_truncated();
+QString test_window_lut_float();
+QString test_window_lut_double();
+
+#endif
+
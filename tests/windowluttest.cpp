@@ -0,0 +1,151 @@
+#include "testutils.h"
+#include "processimagethreadLUT.hxx"
+#include "windowlutsimd.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace
+{
+
+struct Window
+{
+	double center;
+	double width;
+};
+
+// Odd width, the scalar tail of each row is used too.
+const int columns = 37;
+const int rows = 9;
+
+// Special values first, then values over and around the window.
+template<typename P> void fill_image(
+	const typename itk::Image<P, 2>::Pointer & image,
+	const Window & w)
+{
+	const double wmin = w.center - w.width * 0.5;
+	const double wmax = w.center + w.width * 0.5;
+	const P special[] =
+	{
+		std::numeric_limits<P>::quiet_NaN(),
+		std::numeric_limits<P>::infinity(),
+		-std::numeric_limits<P>::infinity(),
+		std::numeric_limits<P>::max(),
+		std::numeric_limits<P>::lowest(),
+		static_cast<P>(wmin),
+		static_cast<P>(wmax),
+		std::nextafter(static_cast<P>(wmin), std::numeric_limits<P>::infinity()),
+		std::nextafter(static_cast<P>(wmax), std::numeric_limits<P>::infinity()),
+		std::nextafter(static_cast<P>(wmax), -std::numeric_limits<P>::infinity()),
+		static_cast<P>(w.center),
+		static_cast<P>(w.center - 0.5),
+		static_cast<P>(-0.5),
+		static_cast<P>(0)
+	};
+	const size_t n_special = sizeof(special) / sizeof(P);
+	P * p = image->GetBufferPointer();
+	const size_t n = static_cast<size_t>(columns) * rows;
+	unsigned int r = 12345;
+	for (size_t x = 0; x < n; ++x)
+	{
+		if (x < n_special)
+		{
+			p[x] = special[x];
+		}
+		else
+		{
+			r = r * 1103515245u + 12345u;
+			const double t = static_cast<double>((r >> 8) & 0xffff) / 65535.0;
+			p[x] = static_cast<P>(wmin - w.width + t * 3.0 * w.width);
+		}
+	}
+}
+
+template<typename P> std::vector<unsigned char> render(
+	const typename itk::Image<P, 2>::Pointer & image,
+	const Window & w,
+	const short lut,
+	const bool alt_mode,
+	const short lut_function)
+{
+	// NaN pixels are not written
+	std::vector<unsigned char> out(3 * columns * rows, 0x5a);
+	process_image_LUT<itk::Image<P, 2>>(
+		image, out.data(), columns, rows,
+		w.center, w.width, lut, alt_mode, lut_function);
+	return out;
+}
+
+// Output of SSE2 and AVX2 must be the same as of the scalar code,
+// byte by byte, for every LUT, alt mode and linear function.
+template<typename P> QString window_lut_test()
+{
+	typedef itk::Image<P, 2> T;
+	typename T::Pointer image = T::New();
+	typename T::IndexType index;
+	index[0] = 0;
+	index[1] = 0;
+	typename T::SizeType size;
+	size[0] = columns;
+	size[1] = rows;
+	image->SetRegions(typename T::RegionType(index, size));
+	image->Allocate();
+	const Window windows[] =
+	{
+		{ 40.0, 400.0 },
+		{ -1000.5, 3.0 },
+		{ 0.25, 0.5 }, // LINEAR falls back to LINEAR_EXACT
+		{ 100.0, 255.0 }
+	};
+	QString error;
+	for (const Window & w : windows)
+	{
+		fill_image<P>(image, w);
+		for (short lut = 0; lut <= 8; ++lut)
+		{
+			for (short lut_function = 0; lut_function <= 1; ++lut_function)
+			{
+				for (int alt_mode = 0; alt_mode <= 1; ++alt_mode)
+				{
+					WindowLUTSIMD::set_level(0);
+					const std::vector<unsigned char> scalar =
+						render<P>(image, w, lut, alt_mode == 1, lut_function);
+					for (int level = 1; level <= 2; ++level)
+					{
+						if (!WindowLUTSIMD::set_level(level)) continue;
+						const std::vector<unsigned char> out =
+							render<P>(image, w, lut, alt_mode == 1, lut_function);
+						if (memcmp(out.data(), scalar.data(), out.size()) != 0)
+						{
+							error = QString(level == 1 ? "SSE2" : "AVX2") +
+								QString(" differs, window ") +
+								QString::number(w.center) + QString(" ") +
+								QString::number(w.width) +
+								QString(", lut ") + QString::number(lut) +
+								QString(", function ") + QString::number(lut_function) +
+								QString(", alt mode ") + QString::number(alt_mode);
+							WindowLUTSIMD::set_level(-1);
+							return error;
+						}
+					}
+				}
+			}
+		}
+	}
+	WindowLUTSIMD::set_level(-1);
+	return error;
+}
+
+}
+
+QString test_window_lut_float()
+{
+	return window_lut_test<float>();
+}
+
+QString test_window_lut_double()
+{
+	return window_lut_test<double>();
+}
+